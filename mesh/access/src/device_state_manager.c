@@ -77,6 +77,17 @@
  * handle starts after the last nonvirtual handle */
 #define DSM_VIRTUAL_HANDLE_START     DSM_NONVIRTUAL_ADDR_MAX
 
+/** Number of different NID values. */
+#define NID_COUNT                   (PACKET_MESH_NET_NID_MASK + 1)
+
+/** NID index list link for the current network key of a subnet. */
+#define NID_INDEX_LINK_CURRENT      (0)
+/** NID index list link for the updated network key of a subnet. */
+#define NID_INDEX_LINK_UPDATED      (1)
+
+/** Number of different AID values. */
+#define AID_COUNT                   (PACKET_MESH_TRS_ACCESS_AID_MASK + 1)
+
 #if PERSISTENT_STORAGE
 /** Margin to leave on each flash page, to accommodate padding. We'll never pad more than what's
  * required to fit the largest entry. */
@@ -229,6 +240,14 @@ static subnet_t m_subnets[DSM_SUBNET_MAX];
 static appkey_t m_appkeys[DSM_APP_MAX];
 /** Security information associated with each devkey */
 static devkey_t m_devkeys[DSM_DEVICE_MAX];
+/** First subnet with a network key matching each NID, see @ref nid_index_build(). */
+static dsm_handle_t m_nid_index[NID_COUNT];
+/** Next subnet in the same NID index list, for the current and updated network key of each subnet. */
+static dsm_handle_t m_nid_index_next[DSM_SUBNET_MAX][2];
+/** First application key with each AID, see @ref aid_index_build(). */
+static dsm_handle_t m_aid_index[AID_COUNT];
+/** Next application key in the same AID index list. */
+static dsm_handle_t m_aid_index_next[DSM_APP_MAX];
 
 /** Flag indicating whether the device is part of the primary subnet */
 static bool m_has_primary_subnet;
@@ -637,25 +656,23 @@ static dsm_handle_t get_subnet_handle(const nrf_mesh_network_secmat_t * p_secmat
 {
     NRF_MESH_ASSERT(NULL != p_secmat);
 
-    dsm_handle_t retval = DSM_HANDLE_INVALID;
-    for(uint16_t i = 0; i < DSM_SUBNET_MAX; i++)
+    if ((const uint8_t *) p_secmat < (const uint8_t *) &m_subnets[0] ||
+        (const uint8_t *) p_secmat >= (const uint8_t *) &m_subnets[DSM_SUBNET_MAX])
     {
-        if (m_subnets[i].key_refresh_phase != NRF_MESH_KEY_REFRESH_PHASE_0)
-        {
-            if (p_secmat == &m_subnets[i].secmat || p_secmat == &m_subnets[i].secmat_updated)
-            {
-                retval = i;
-                break;
-            }
-        }
-        else if (p_secmat == &m_subnets[i].secmat)
-        {
-            retval = i;
-            break;
-        }
+        return DSM_HANDLE_INVALID;
     }
 
-    return retval;
+    /* Both secmats are inside the subnet structure, so the offset from the start of the array
+     * gives the index of the structure it's in. */
+    dsm_handle_t handle = ((const uint8_t *) p_secmat - (const uint8_t *) &m_subnets[0]) / sizeof(subnet_t);
+    if (p_secmat == &m_subnets[handle].secmat ||
+        (p_secmat == &m_subnets[handle].secmat_updated &&
+         m_subnets[handle].key_refresh_phase != NRF_MESH_KEY_REFRESH_PHASE_0))
+    {
+        return handle;
+    }
+
+    return DSM_HANDLE_INVALID;
 }
 
 /** Returns the index to the m_subnets array for the given beacon info,
@@ -752,23 +769,93 @@ static const nrf_mesh_application_secmat_t * get_devkey_secmat(uint16_t key_addr
 
 static void get_app_secmat(dsm_handle_t subnet_handle, uint8_t aid, const nrf_mesh_application_secmat_t ** pp_app_secmat)
 {
-    uint32_t i = 0;
-    if (*pp_app_secmat != NULL)
+    dsm_handle_t handle;
+    if (*pp_app_secmat == NULL)
+    {
+        handle = m_aid_index[aid & PACKET_MESH_TRS_ACCESS_AID_MASK];
+    }
+    else
     {
         /* Iterate over the proceeding elements */
-        i = get_app_handle(*pp_app_secmat) + 1;
+        handle = get_app_handle(*pp_app_secmat);
+        handle = (handle < DSM_APP_MAX) ? m_aid_index_next[handle] : DSM_HANDLE_INVALID;
     }
-    for (; i < DSM_APP_MAX; i++)
+
+    /* The AID index contains the keys of all subnets, skip the ones bound to other subnets. */
+    while (handle != DSM_HANDLE_INVALID && m_appkeys[handle].subnet_handle != subnet_handle)
     {
-        if (bitfield_get(m_appkey_allocated, i) &&
-            m_appkeys[i].subnet_handle == subnet_handle &&
-            ((m_appkeys[i].secmat.aid & PACKET_MESH_TRS_ACCESS_AID_MASK) == (aid & PACKET_MESH_TRS_ACCESS_AID_MASK)))
+        handle = m_aid_index_next[handle];
+    }
+
+    *pp_app_secmat = (handle == DSM_HANDLE_INVALID) ? NULL : &m_appkeys[handle].secmat;
+}
+
+/**
+ * Rebuilds the index of application keys by AID, used for finding transport decryption
+ * candidates. Each AID has a list of the application keys with a matching AID, in increasing
+ * handle order.
+ *
+ * Must be called whenever an application key is added, removed or replaced.
+ */
+static void aid_index_build(void)
+{
+    for (uint32_t aid = 0; aid < AID_COUNT; ++aid)
+    {
+        m_aid_index[aid] = DSM_HANDLE_INVALID;
+    }
+
+    /* Insert at the front of the lists in decreasing handle order, to keep them sorted. */
+    for (int32_t i = DSM_APP_MAX - 1; i >= 0; --i)
+    {
+        m_aid_index_next[i] = DSM_HANDLE_INVALID;
+        if (bitfield_get(m_appkey_allocated, i))
         {
-            *pp_app_secmat = &m_appkeys[i].secmat;
-            return;
+            uint8_t aid = m_appkeys[i].secmat.aid & PACKET_MESH_TRS_ACCESS_AID_MASK;
+            m_aid_index_next[i] = m_aid_index[aid];
+            m_aid_index[aid] = i;
+        }
+    }
+}
+
+/**
+ * Rebuilds the index of subnets by NID, used for finding network decryption candidates.
+ *
+ * Each NID has a list of the subnets with a network key matching it, in increasing handle order.
+ * During key refresh, a subnet is listed under the NIDs of both its current and updated network
+ * key, using a separate link for each. If both keys have the same NID, the subnet is only listed
+ * once, through the link of the current key.
+ *
+ * Must be called whenever the network keys or key refresh phase of a subnet changes.
+ */
+static void nid_index_build(void)
+{
+    for (uint32_t nid = 0; nid < NID_COUNT; ++nid)
+    {
+        m_nid_index[nid] = DSM_HANDLE_INVALID;
+    }
+
+    /* Insert at the front of the lists in decreasing handle order, to keep them sorted. */
+    for (int32_t i = DSM_SUBNET_MAX - 1; i >= 0; --i)
+    {
+        m_nid_index_next[i][NID_INDEX_LINK_CURRENT] = DSM_HANDLE_INVALID;
+        m_nid_index_next[i][NID_INDEX_LINK_UPDATED] = DSM_HANDLE_INVALID;
+
+        if (!bitfield_get(m_subnet_allocated, i))
+        {
+            continue;
+        }
+
+        uint8_t nid = m_subnets[i].secmat.nid & PACKET_MESH_NET_NID_MASK;
+        m_nid_index_next[i][NID_INDEX_LINK_CURRENT] = m_nid_index[nid];
+        m_nid_index[nid] = i;
+
+        uint8_t nid_updated = m_subnets[i].secmat_updated.nid & PACKET_MESH_NET_NID_MASK;
+        if (m_subnets[i].key_refresh_phase != NRF_MESH_KEY_REFRESH_PHASE_0 && nid_updated != nid)
+        {
+            m_nid_index_next[i][NID_INDEX_LINK_UPDATED] = m_nid_index[nid_updated];
+            m_nid_index[nid_updated] = i;
         }
     }
-    *pp_app_secmat = NULL;
 }
 
 static void subnet_set(mesh_key_index_t net_key_index, const uint8_t * p_key, dsm_handle_t handle)
@@ -791,6 +878,7 @@ static void subnet_set(mesh_key_index_t net_key_index, const uint8_t * p_key, ds
     m_subnets[handle].key_refresh_phase = NRF_MESH_KEY_REFRESH_PHASE_0;
     bitfield_set(m_subnet_allocated, handle);
     bitfield_set(m_subnet_needs_flashing, handle);
+    nid_index_build();
 }
 
 static void appkey_set(mesh_key_index_t app_key_index, dsm_handle_t subnet_handle, const uint8_t * p_key, dsm_handle_t handle)
@@ -804,6 +892,7 @@ static void appkey_set(mesh_key_index_t app_key_index, dsm_handle_t subnet_handl
     m_appkeys[handle].subnet_handle = subnet_handle;
     bitfield_set(m_appkey_allocated, handle);
     bitfield_set(m_appkey_needs_flashing, handle);
+    aid_index_build();
 }
 
 static void devkey_set(uint16_t key_owner, dsm_handle_t subnet_handle, const uint8_t * p_key, dsm_handle_t handle)
@@ -1042,6 +1131,7 @@ static void subnet_to_dsm_entry(uint32_t index, const dsm_flash_entry_t * p_entr
         NRF_MESH_ASSERT(entry_len == ALIGN_VAL(sizeof(dsm_flash_entry_subnet_t), WORD_SIZE));
         memcpy(m_subnets[index].root_key_updated, p_key_data->key_updated, NRF_MESH_KEY_SIZE);
         NRF_MESH_ASSERT(nrf_mesh_keygen_network_secmat(p_key_data->key_updated, &m_subnets[index].secmat_updated) == NRF_SUCCESS);
+        nid_index_build();
     }
     else
     {
@@ -1530,6 +1620,8 @@ void dsm_clear(void)
     m_local_unicast_addr.address_start = NRF_MESH_ADDR_UNASSIGNED;
     m_local_unicast_addr.count = 0;
     m_has_primary_subnet = false;
+    nid_index_build();
+    aid_index_build();
 
 #if PERSISTENT_STORAGE
     reset_flash_area();
@@ -1545,6 +1637,8 @@ void dsm_init(void)
 {
     m_mesh_evt_handler.evt_cb = mesh_evt_handler;
     nrf_mesh_evt_handler_add(&m_mesh_evt_handler);
+    nid_index_build();
+    aid_index_build();
 
 #if PERSISTENT_STORAGE
     m_flash_mem_listener_update_all.callback = flash_mem_listener_callback;
@@ -2063,6 +2157,7 @@ uint32_t dsm_subnet_update(dsm_handle_t subnet_handle, const uint8_t * p_key)
 #endif
 
         m_subnets[subnet_handle].key_refresh_phase = NRF_MESH_KEY_REFRESH_PHASE_1;
+        nid_index_build();
         net_state_key_refresh_phase_changed(m_subnets[subnet_handle].net_key_index,
                                             m_subnets[subnet_handle].beacon.info.secmat_updated.net_id,
                                             NRF_MESH_KEY_REFRESH_PHASE_1);
@@ -2088,6 +2183,7 @@ uint32_t dsm_subnet_update_swap_keys(dsm_handle_t subnet_handle)
     else
     {
         m_subnets[subnet_handle].key_refresh_phase = NRF_MESH_KEY_REFRESH_PHASE_2;
+        nid_index_build();
         net_state_key_refresh_phase_changed(m_subnets[subnet_handle].net_key_index,
                                             m_subnets[subnet_handle].beacon.info.secmat_updated.net_id,
                                             NRF_MESH_KEY_REFRESH_PHASE_2);
@@ -2113,6 +2209,7 @@ uint32_t dsm_subnet_update_commit(dsm_handle_t subnet_handle)
                 sizeof(m_subnets[subnet_handle].beacon.info.secmat));
 
         m_subnets[subnet_handle].key_refresh_phase = NRF_MESH_KEY_REFRESH_PHASE_0;
+        nid_index_build();
         net_state_key_refresh_phase_changed(m_subnets[subnet_handle].net_key_index,
                                             m_subnets[subnet_handle].beacon.info.secmat.net_id,
                                             NRF_MESH_KEY_REFRESH_PHASE_0);
@@ -2131,6 +2228,7 @@ uint32_t dsm_subnet_update_commit(dsm_handle_t subnet_handle)
                 (void) flash_save(DSM_ENTRY_TYPE_APPKEY, i);
             }
         }
+        aid_index_build();
 
         bitfield_set(m_subnet_needs_flashing, subnet_handle);
         (void) flash_save(DSM_ENTRY_TYPE_SUBNET, subnet_handle);
@@ -2168,6 +2266,7 @@ uint32_t dsm_subnet_delete(dsm_handle_t subnet_handle)
     }
 
     bitfield_clear(m_subnet_allocated, subnet_handle);
+    nid_index_build();
     (void) flash_invalidate(DSM_ENTRY_TYPE_SUBNET, subnet_handle);
     return NRF_SUCCESS;
 }
@@ -2342,6 +2441,7 @@ uint32_t dsm_appkey_delete(dsm_handle_t app_handle)
     else
     {
         bitfield_clear(m_appkey_allocated, app_handle);
+        aid_index_build();
         (void) flash_invalidate(DSM_ENTRY_TYPE_APPKEY, app_handle);
         return NRF_SUCCESS;
     }
@@ -2465,42 +2565,54 @@ void nrf_mesh_net_secmat_next_get(uint8_t nid, const nrf_mesh_network_secmat_t *
     NRF_MESH_ASSERT(NULL != pp_secmat);
     NRF_MESH_ASSERT(NULL != pp_secmat_secondary);
 
-    uint32_t i = 0;
-    if (*pp_secmat != NULL)
+    nid &= PACKET_MESH_NET_NID_MASK;
+
+    dsm_handle_t handle;
+    if (*pp_secmat == NULL)
     {
-        i = get_subnet_handle(*pp_secmat) + 1; /* we want to iterate over the proceeding elements */
+        handle = m_nid_index[nid];
+    }
+    else
+    {
+        /* Continue down the list the previous secmat was found through. */
+        handle = get_subnet_handle(*pp_secmat);
+        if (handle != DSM_HANDLE_INVALID)
+        {
+            handle = m_nid_index_next[handle][(*pp_secmat == &m_subnets[handle].secmat_updated)
+                                                  ? NID_INDEX_LINK_UPDATED
+                                                  : NID_INDEX_LINK_CURRENT];
+        }
     }
 
     *pp_secmat = NULL;
     *pp_secmat_secondary = NULL;
-    nid &= PACKET_MESH_NET_NID_MASK;
 
-    for (; i < DSM_SUBNET_MAX; i++)
+    if (handle == DSM_HANDLE_INVALID)
     {
-        if (bitfield_get(m_subnet_allocated, i))
+        return;
+    }
+
+    /* The NID index only contains subnets with a key matching the NID. */
+    const subnet_t * p_subnet = &m_subnets[handle];
+    if (p_subnet->key_refresh_phase != NRF_MESH_KEY_REFRESH_PHASE_0
+            && p_subnet->secmat_updated.nid == nid)
+    {
+        /* If the NIDs for the old and the new network are equal, return both: */
+        if (p_subnet->secmat.nid == nid)
         {
-            /* If the NIDs for the old and the new network are equal, return both: */
-            if (m_subnets[i].key_refresh_phase != NRF_MESH_KEY_REFRESH_PHASE_0
-                    && (m_subnets[i].secmat.nid == nid && m_subnets[i].secmat_updated.nid == nid))
-            {
-                *pp_secmat = &m_subnets[i].secmat;
-                *pp_secmat_secondary = &m_subnets[i].secmat_updated;
-                break;
-            }
-            /* During key refresh, return the updated key if it matches the NID: */
-            else if (m_subnets[i].key_refresh_phase != NRF_MESH_KEY_REFRESH_PHASE_0
-                    && m_subnets[i].secmat_updated.nid == nid)
-            {
-                *pp_secmat = &m_subnets[i].secmat_updated;
-                break;
-            }
-            else if (m_subnets[i].secmat.nid == nid)
-            {
-                *pp_secmat = &m_subnets[i].secmat;
-                break;
-            }
+            *pp_secmat = &p_subnet->secmat;
+            *pp_secmat_secondary = &p_subnet->secmat_updated;
+        }
+        /* During key refresh, return the updated key if it matches the NID: */
+        else
+        {
+            *pp_secmat = &p_subnet->secmat_updated;
         }
     }
+    else
+    {
+        *pp_secmat = &p_subnet->secmat;
+    }
 }
 
 /* returns null via pp_app_secmat if end of search */
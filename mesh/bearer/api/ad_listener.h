@@ -74,7 +74,8 @@ typedef struct
  * Subscribe component to the certain AD.
  *
  * The component shall provide pointer to a listener structure with AD value,
- * priority for the listener and handler.
+ * priority for the listener and handler. Any number of listeners may subscribe to
+ * the same AD value.
  *
  * @warning It is prohibited subscribing one listener twice.
  *
@@ -99,6 +100,7 @@ uint32_t ad_listener_subscribe(ad_listener_t * p_adl);
  * @retval NRF_SUCCESS The listener was unsubscribed successfully.
  * @retval NRF_ERROR_INVALID_PARAM adv_packet_type is incorrect
  * @retval NRF_ERROR_NULL handler is NULL
+ * @retval NRF_ERROR_NOT_FOUND The listener isn't subscribed.
  */
 uint32_t ad_listener_unsubscribe(ad_listener_t * p_adl);
 
@@ -106,7 +108,10 @@ uint32_t ad_listener_unsubscribe(ad_listener_t * p_adl);
  * Process the incoming data from the scanner.
  *
  * The function reads out the received frame from scanner, performs preliminary
- * parsing of AD fields and sends out parsed AD frames to subscribers.
+ * parsing of AD fields and sends out parsed AD frames to subscribers. The listeners
+ * of each AD structure are looked up directly by AD type. Listeners subscribed to the
+ * AD type are called before the ones subscribed to @ref ADL_WILDCARD_AD_TYPE, and listeners of the
+ * same AD type are called in the order they subscribed.
  *
  * @warning The listener shall be subscribed previously.
  *
@@ -134,6 +134,8 @@ struct advertiser_t
     advertiser_tx_complete_cb_t     tx_complete_callback; /**< TX complete callback to call at the end of a completed transmission. */
     bearer_event_sequential_t       tx_complete_event; /**< Bearer event for executing the TX_COMPLETE event outside the radio interrupt. */
     advertiser_tx_complete_params_t tx_complete_params; /**< Parameters of the TX_COMPLETE event. */
+    uint32_t                        queued_count; /**< Number of packets waiting in the packet buffer, only for internal use. */
+    advertiser_t *                  p_next; /**< Next initialized advertiser instance, only for internal use. */
 };
 
 /**
@@ -271,6 +273,15 @@ void advertiser_interval_set(advertiser_t * p_adv, uint32_t interval_ms);
  */
 void advertiser_flush(advertiser_t * p_adv);
 
+/**
+ * Get the number of packets waiting to be advertised, across all advertiser instances.
+ *
+ * The packets that are currently being advertised are not counted.
+ *
+ * @returns The number of queued packets.
+ */
+uint32_t advertiser_queue_depth_get(void);
+
 /**
  * Get the default advertisement address from device factory information structure.
  *
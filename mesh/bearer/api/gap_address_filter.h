@@ -47,6 +47,20 @@
  * @{
  */
 
+/** Maximum lifetime of a learned GAP address, see @ref bearer_filter_gap_addr_learn. */
+#define BEARER_FILTER_GAP_ADDR_LIFETIME_MAX_MS  (30 * 60 * 1000)
+
+/** Statistics of the hashed GAP address set. */
+typedef struct
+{
+    uint32_t lookups;        /**< Number of packets looked up in the address set. */
+    uint32_t hits;           /**< Number of lookups that found the packet's address. */
+    uint32_t expired;        /**< Number of learned addresses removed after their lifetime ran out. */
+    uint32_t learn_failures; /**< Number of addresses that couldn't be learned because the set was full. */
+    uint16_t entries;        /**< Number of addresses currently in the set. */
+    bool     list_hashed;    /**< Whether the address list is looked up in the set, instead of being scanned linearly. */
+} bearer_filter_gap_addr_set_stats_t;
+
 /**
  * Set a whitelist for GAP addresses. Only packets with a GAP address entry in
  * the whitelist will be passed from the radio to the stack for processing.
@@ -54,6 +68,15 @@
  * @note The @p p_addrs parameter must point to a statically allocated list of
  * addresses of at least @p addr_count length.
  *
+ * @note Lists longer than @ref GAP_ADDR_FILTER_LINEAR_MAX are loaded into a
+ * hashed address set, so that a lookup doesn't have to scan the
+ * whole list. Setting a list clears all learned addresses.
+ *
+ * @note The set holds at most @ref GAP_ADDR_FILTER_HASH_SET_CAPACITY addresses,
+ * and longer lists are rejected. To set a list of N addresses, set
+ * @ref GAP_ADDR_FILTER_HASH_SET_SIZE to a power of two of at least 4/3 of N,
+ * plus the number of addresses to learn.
+ *
  * @warning Changing the contents of the whitelist while it's in use may result
  * in unwanted packets being accepted. It is recommended to clear the list
  * before changing it.
@@ -66,6 +89,8 @@
  * filter before changing the type of accept criteria.
  * @retval NRF_ERROR_NULL The @p p_addrs variable was NULL.
  * @retval NRF_ERROR_INVALID_LENGTH The @p addr_count variable was 0.
+ * @retval NRF_ERROR_NO_MEM The list is too long to fit in the hashed address
+ * set.
  */
 uint32_t bearer_filter_gap_addr_whitelist_set(const ble_gap_addr_t * const p_addrs, uint16_t addr_count);
 
@@ -77,6 +102,15 @@ uint32_t bearer_filter_gap_addr_whitelist_set(const ble_gap_addr_t * const p_add
  * @note The @p p_addrs parameter must point to a statically allocated list of
  * addresses of at least @p addr_count length.
  *
+ * @note Lists longer than @ref GAP_ADDR_FILTER_LINEAR_MAX are loaded into a
+ * hashed address set, so that a lookup doesn't have to scan the
+ * whole list. Setting a list clears all learned addresses.
+ *
+ * @note The set holds at most @ref GAP_ADDR_FILTER_HASH_SET_CAPACITY addresses,
+ * and longer lists are rejected. To set a list of N addresses, set
+ * @ref GAP_ADDR_FILTER_HASH_SET_SIZE to a power of two of at least 4/3 of N,
+ * plus the number of addresses to learn.
+ *
  * @warning Changing the contents of the blacklist while it's in use may result
  * in unwanted packets being accepted. It is recommended to clear the list
  * before changing it.
@@ -89,6 +123,8 @@ uint32_t bearer_filter_gap_addr_whitelist_set(const ble_gap_addr_t * const p_add
  * filter before changing the type of accept criteria.
  * @retval NRF_ERROR_NULL The @p p_addrs variable was NULL.
  * @retval NRF_ERROR_INVALID_LENGTH The @p addr_count variable was 0.
+ * @retval NRF_ERROR_NO_MEM The list is too long to fit in the hashed address
+ * set.
  */
 uint32_t bearer_filter_gap_addr_blacklist_set(const ble_gap_addr_t * const p_addrs, uint16_t addr_count);
 
@@ -118,6 +154,28 @@ uint32_t bearer_filter_gap_addr_blacklist_set(const ble_gap_addr_t * const p_add
  */
 uint32_t bearer_filter_gap_addr_range_set(const ble_gap_addr_t * const p_addrs);
 
+/**
+ * Add a single address to the current GAP address whitelist or blacklist,
+ * e.g. to ignore a noisy advertiser for a while.
+ *
+ * The address is stored in the hashed address set, in addition to the list
+ * given to @ref bearer_filter_gap_addr_whitelist_set or
+ * @ref bearer_filter_gap_addr_blacklist_set. Learning an address that is
+ * already in the set refreshes its lifetime.
+ *
+ * @param[in] p_addr      Address to add.
+ * @param[in] lifetime_ms Time until the address is removed again, or 0 to keep
+ * it until the filter is cleared or set again. At most
+ * @ref BEARER_FILTER_GAP_ADDR_LIFETIME_MAX_MS.
+ *
+ * @retval NRF_SUCCESS The address was added.
+ * @retval NRF_ERROR_NULL The @p p_addr variable was NULL.
+ * @retval NRF_ERROR_INVALID_PARAM The @p lifetime_ms is too long.
+ * @retval NRF_ERROR_INVALID_STATE No whitelist or blacklist is in place.
+ * @retval NRF_ERROR_NO_MEM The address set is full.
+ */
+uint32_t bearer_filter_gap_addr_learn(const ble_gap_addr_t * p_addr, uint32_t lifetime_ms);
+
 /**
  * Remove the currently assigned GAP address filter.
  *
@@ -133,6 +191,13 @@ uint32_t bearer_filter_gap_addr_clear(void);
  */
 uint32_t bearer_gap_addr_filtered_amount_get(void);
 
+/**
+ * Read out the statistics of the hashed GAP address set.
+ *
+ * @param[out] p_stats Structure to copy the statistics to.
+ */
+void bearer_filter_gap_addr_set_stats_get(bearer_filter_gap_addr_set_stats_t * p_stats);
+
 /** @} GAP_ADDRESS_FILTER */
 
 #endif /* GAP_ADDRESS_FILTER_H__ */
@@ -89,6 +89,15 @@
 #define SCANNER_BUFFER_SIZE 512
 #endif
 
+/**
+ * Number of packet slots in the scanner RX ring. Set to a power of two to receive into a ring of
+ * fixed size slots instead of the @ref SCANNER_BUFFER_SIZE byte packet buffer. The ring never stops
+ * reception when it's full, it drops the packets instead, see @ref scanner_stats_t.
+ */
+#ifndef SCANNER_RX_RING_SLOT_COUNT
+#define SCANNER_RX_RING_SLOT_COUNT 0
+#endif
+
 /** Buffer size for the experimental Instaburst RX module. */
 #ifndef INSTABURST_RX_BUFFER_SIZE
 #define INSTABURST_RX_BUFFER_SIZE   (1024)
@@ -118,6 +127,63 @@
 
 /** @} end of MESH_CONFIG_BEARER_EVENT */
 
+/**
+ * @defgroup MESH_CONFIG_FILTER_ENGINE Filter engine configuration
+ * Compile time configuration of the scanner filter engine.
+ * @{
+ */
+
+/** Whether the filter engine starts out in compiled mode. */
+#ifndef FILTER_ENGINE_COMPILED_MODE_DEFAULT
+#define FILTER_ENGINE_COMPILED_MODE_DEFAULT 0
+#endif
+
+/**
+ * Maximum number of GAP addresses in a compiled GAP address filter. Longer address lists are
+ * applied through the regular filter handler instead. Must not be larger than the longest list the
+ * GAP address filter accepts, see @ref GAP_ADDR_FILTER_HASH_SET_CAPACITY.
+ */
+#ifndef FILTER_ENGINE_COMPILED_GAP_ADDR_MAX
+#define FILTER_ENGINE_COMPILED_GAP_ADDR_MAX 24
+#endif
+
+/**
+ * Number of slots in the hashed GAP address set. Must be a power of two. At most three quarters of
+ * the slots are used, see @ref GAP_ADDR_FILTER_HASH_SET_CAPACITY. Each slot takes 12 bytes of RAM.
+ *
+ * GAP address lists that don't fit in the set are rejected, so to filter large numbers of
+ * advertisers, e.g. non-mesh beacons, size the set for the longest list plus the learned addresses.
+ */
+#ifndef GAP_ADDR_FILTER_HASH_SET_SIZE
+#define GAP_ADDR_FILTER_HASH_SET_SIZE 32
+#endif
+
+/** Maximum number of addresses in the hashed GAP address set. */
+#define GAP_ADDR_FILTER_HASH_SET_CAPACITY ((GAP_ADDR_FILTER_HASH_SET_SIZE * 3) / 4)
+
+/**
+ * Longest GAP address whitelist or blacklist that is scanned linearly. Longer lists are loaded into
+ * the hashed GAP address set.
+ */
+#ifndef GAP_ADDR_FILTER_LINEAR_MAX
+#define GAP_ADDR_FILTER_LINEAR_MAX 8
+#endif
+
+/** @} end of MESH_CONFIG_FILTER_ENGINE */
+
+/**
+ * @defgroup MESH_CONFIG_SCAN_DUTY_CYCLE Scan duty cycle configuration
+ * Compile time configuration of the adaptive scan duty cycle controller.
+ * @{
+ */
+
+/** Length of the period the scan duty cycle policy is run for. */
+#ifndef SCAN_DUTY_CYCLE_SAMPLE_INTERVAL_MS
+#define SCAN_DUTY_CYCLE_SAMPLE_INTERVAL_MS 1000
+#endif
+
+/** @} end of MESH_CONFIG_SCAN_DUTY_CYCLE */
+
 
 /** @} end of NRF_MESH_CONFIG_BEARER */
 
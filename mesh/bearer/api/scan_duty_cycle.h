@@ -0,0 +1,158 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SCAN_DUTY_CYCLE_H__
+#define SCAN_DUTY_CYCLE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @defgroup SCAN_DUTY_CYCLE Adaptive scan duty cycle
+ * @ingroup MESH_API_GROUP_BEARER
+ * Adapts the scan window to the traffic on air and the TX load.
+ *
+ * Every @ref SCAN_DUTY_CYCLE_SAMPLE_INTERVAL_MS, the controller samples the number of packets
+ * received by the scanner and the number of packets waiting in the advertiser queues, and passes
+ * them to a policy. The policy picks the scan timing for the next period, which is applied with
+ * @ref scanner_config_scan_time_set() if it changed.
+ *
+ * The policy is pluggable. The default policy, @ref scan_duty_cycle_policy_default(), lets
+ * nodes that mostly listen to a quiet channel save energy, without missing traffic when it
+ * picks up.
+ * @{
+ */
+
+/** Measurements from one sample period, passed to the policy. */
+typedef struct
+{
+    uint32_t period_us;      /**< Length of the sample period in microseconds. */
+    uint32_t rx_packets;     /**< Number of packets received by the scanner during the period. */
+    uint32_t tx_queue_depth; /**< Number of packets waiting in the advertiser queues at the end of the period. */
+} scan_duty_cycle_sample_t;
+
+/** Scanner timing parameters, see @ref scanner_config_scan_time_set(). */
+typedef struct
+{
+    uint32_t scan_interval_us; /**< Time between the start of each scan window in microseconds. */
+    uint32_t scan_window_us;   /**< Length of a single scan window in microseconds. */
+} scan_duty_cycle_timing_t;
+
+/**
+ * Scan duty cycle policy.
+ *
+ * Called from the bearer event context at the end of each sample period.
+ *
+ * @param[in]     p_sample  Measurements from the last sample period.
+ * @param[in,out] p_timing  Scan timing used during the last sample period. Set to the timing to use
+ *                          during the next period. Must be a valid scanner timing.
+ * @param[in]     p_context Context pointer given to @ref scan_duty_cycle_start().
+ */
+typedef void (*scan_duty_cycle_policy_t)(const scan_duty_cycle_sample_t * p_sample,
+                                         scan_duty_cycle_timing_t * p_timing,
+                                         void * p_context);
+
+/** Configuration of the default policy, passed as context to @ref scan_duty_cycle_start(). */
+typedef struct
+{
+    uint32_t scan_interval_us; /**< Scan interval in microseconds. Must not be greater than @ref BEARER_SCAN_INT_MAX_MS. */
+    uint32_t window_min_us;    /**< Shortest scan window in microseconds, reached on a quiet channel. Must not be less than @ref BEARER_SCAN_WIN_MIN_MS. */
+    uint32_t window_max_us;    /**< Longest scan window in microseconds, reached on a busy channel. Must not be less than @c window_min_us or greater than @c scan_interval_us. */
+    uint32_t busy_rx_rate;     /**< Number of received packets per second of scanning at or above which the channel is busy. */
+    uint32_t quiet_rx_rate;    /**< Number of received packets per second of scanning at or below which the channel is quiet. Must be lower than @c busy_rx_rate. */
+    uint32_t tx_queue_deep;    /**< Number of queued TX packets at or above which the scan window is shortened. */
+} scan_duty_cycle_default_config_t;
+
+/**
+ * Default scan duty cycle policy.
+ *
+ * - When the advertiser queues are deep, the scan window is halved to make room for transmitting.
+ * - Otherwise, the scan window is doubled when the channel is busy, and shortened by a quarter when
+ *   the channel is quiet.
+ *
+ * The scan window is always kept within the configured limits. The receive rate is measured per
+ * second of scanning, so it doesn't depend on the scan window.
+ *
+ * @param[in]     p_sample  Measurements from the last sample period.
+ * @param[in,out] p_timing  Scan timing used during the last sample period, and during the next.
+ * @param[in]     p_context Pointer to a @ref scan_duty_cycle_default_config_t.
+ */
+void scan_duty_cycle_policy_default(const scan_duty_cycle_sample_t * p_sample,
+                                    scan_duty_cycle_timing_t * p_timing,
+                                    void * p_context);
+
+/**
+ * Start adapting the scan duty cycle.
+ *
+ * Applies the initial timing to the scanner, and runs the policy at the end of each sample period.
+ *
+ * @param[in] policy     Policy picking the scan timing.
+ * @param[in] p_context  Context pointer passed to the policy. Must stay valid until the controller
+ *                       is stopped.
+ * @param[in] p_timing   Initial scan timing.
+ *
+ * @retval NRF_SUCCESS             The controller was started.
+ * @retval NRF_ERROR_NULL          The policy or the initial timing is NULL.
+ * @retval NRF_ERROR_INVALID_PARAM The initial timing isn't a valid scanner timing.
+ * @retval NRF_ERROR_INVALID_STATE The controller is already running.
+ */
+uint32_t scan_duty_cycle_start(scan_duty_cycle_policy_t policy,
+                               void * p_context,
+                               const scan_duty_cycle_timing_t * p_timing);
+
+/**
+ * Stop adapting the scan duty cycle.
+ *
+ * The scanner keeps the last timing picked by the policy.
+ *
+ * @retval NRF_SUCCESS             The controller was stopped.
+ * @retval NRF_ERROR_INVALID_STATE The controller isn't running.
+ */
+uint32_t scan_duty_cycle_stop(void);
+
+/**
+ * Get the scan timing currently picked by the controller.
+ *
+ * @param[out] p_timing Timing structure to fill.
+ *
+ * @retval NRF_SUCCESS             The timing was returned.
+ * @retval NRF_ERROR_INVALID_STATE The controller isn't running.
+ */
+uint32_t scan_duty_cycle_timing_get(scan_duty_cycle_timing_t * p_timing);
+
+/** @} */
+
+#endif /* SCAN_DUTY_CYCLE_H__ */
@@ -73,6 +73,8 @@ typedef struct
     uint32_t successful_receives;           /**< Number of received packets. */
     uint32_t crc_failures;                  /**< Number of CRC failures. */
     uint32_t length_out_of_bounds;          /**< Number of packets with length out of bounds. */
+    uint32_t rx_buffer_stalls;              /**< Number of times reception was paused because the RX packet buffer was full. */
+    uint32_t rx_buffer_drops;               /**< Number of received packets dropped because the RX ring was full. */
 } scanner_stats_t;
 
 /**
@@ -139,6 +141,10 @@ bool scanner_rx_pending(void);
 /**
  * Releases a packet that has previously been returned by scanner_rx().
  *
+ * The packets don't have to be released in the order they were returned. With the RX ring enabled
+ * (@ref SCANNER_RX_RING_SLOT_COUNT), a slot is handed back to the radio once it and all the slots
+ * returned before it have been released.
+ *
  * @param[in]      p_packet  Packet to be released.
  */
 void scanner_packet_release(const scanner_packet_t * p_packet);
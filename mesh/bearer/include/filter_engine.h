@@ -43,6 +43,8 @@
 
 #include "list.h"
 #include "scanner.h"
+#include "bitfield.h"
+#include "nrf_mesh_config_bearer.h"
 
 /**
  * @defgroup FILTER Filter engine
@@ -60,11 +62,89 @@
  */
 typedef bool (* filter_handler_t)(scanner_packet_t * p_packet, void * p_data);
 
+/** GAP address filter modes of a compiled filter. */
+typedef enum
+{
+    FEN_GAP_ADDR_MODE_NONE,      /**< No GAP address filtering. */
+    FEN_GAP_ADDR_MODE_WHITELIST, /**< Address must be in the address set to be accepted. */
+    FEN_GAP_ADDR_MODE_BLACKLIST, /**< Addresses in the address set are rejected. */
+    FEN_GAP_ADDR_MODE_RANGE      /**< Address must be in the range [range[0], range[1]) to be accepted. */
+} fen_gap_addr_mode_t;
+
+/**
+ * Single filter decision merged from all compilable active filters.
+ *
+ * The stages are evaluated in the order they appear in the structure, cheapest first, and the first
+ * stage that rejects the packet increments its filter's counter. A packet that several filters
+ * would reject may therefore be counted by a different filter than in the handler based evaluation.
+ */
+typedef struct
+{
+    struct
+    {
+        bool       enabled;                 /**< Whether the RSSI stage is active. */
+        int8_t     min;                     /**< Lowest accepted RSSI. */
+        uint32_t * p_filtered_count;        /**< Counter of packets rejected by this stage. */
+    } rssi;
+    struct
+    {
+        bool       enabled;                 /**< Whether the advertisement type stage is active. */
+        uint16_t   accepted;                /**< Bitmask of accepted advertisement types. */
+        uint32_t * p_filtered_count;        /**< Counter of packets rejected by this stage. */
+    } adv_type;
+    struct
+    {
+        bool       enabled;                 /**< Whether the AD type stage is active. */
+        bool       whitelist;               /**< Whether @c types is a whitelist. */
+        uint32_t   types[BITFIELD_BLOCK_COUNT(256)]; /**< Bitmap of the listed AD types. */
+        uint32_t * p_filtered_count;        /**< Counter of packets rejected by this stage. */
+        uint32_t * p_invalid_length_count;  /**< Counter of packets with a malformed listed AD structure. */
+    } ad_type;
+    struct
+    {
+        fen_gap_addr_mode_t mode;           /**< GAP address filter mode. */
+        uint16_t            count;          /**< Number of keys in @c keys. */
+        uint64_t            keys[FILTER_ENGINE_COMPILED_GAP_ADDR_MAX]; /**< Address set for the list modes, see @ref fen_gap_addr_key. Sorted by the module. */
+        ble_gap_addr_t      range[2];       /**< Address range for the range mode. */
+        uint32_t *          p_filtered_count; /**< Counter of packets rejected by this stage. */
+    } gap_addr;
+} fen_compiled_filter_t;
+
+/**
+ * Packs a GAP address into a single key for the address set of a compiled filter.
+ *
+ * @param[in] addr_type GAP address type.
+ * @param[in] p_addr    GAP address of @ref BLE_GAP_ADDR_LEN bytes.
+ *
+ * @return The address key.
+ */
+static inline uint64_t fen_gap_addr_key(uint8_t addr_type, const uint8_t * p_addr)
+{
+    uint64_t key = addr_type;
+    for (uint32_t i = 0; i < BLE_GAP_ADDR_LEN; ++i)
+    {
+        key = (key << 8) | p_addr[i];
+    }
+    return key;
+}
+
+/**
+ * Filter compiler, merges the configuration of a filter instance into a compiled filter.
+ *
+ * @param[in,out] p_compiled The compiled filter to merge the configuration into.
+ * @param[in]     p_data     The pointer to a customized data of the filter instance.
+ *
+ * @return true if the filter was merged, false if it has to be applied through its handler.
+ */
+typedef bool (* filter_compile_t)(fen_compiled_filter_t * p_compiled, void * p_data);
+
 /** The filter descriptor. */
 typedef struct
 {
     filter_handler_t handler;    /**< The entrance point into the filtering algorithm of an instance. */
+    filter_compile_t compile;    /**< Optional compiler for the filter instance, see @ref fen_compiled_mode_set. */
     void *           p_data;     /**< Pointer to the customized filter data. */
+    bool             compiled;   /**< Service field, set and used by the module. */
     list_node_t      node;       /**< Service field, set and used by the module. */
 } filter_t;
 
@@ -99,6 +179,35 @@ bool fen_filters_apply(scanner_packet_t * p_packet);
  */
 uint32_t fen_accepted_amount_get(void);
 
+/**
+ * Enables or disables the compiled filter mode.
+ *
+ * In compiled mode, the active filters that provide a compiler are merged into a single decision
+ * that is evaluated once per packet by @ref fen_compiled_filters_apply, before the packet is
+ * queued. The remaining filters are still applied by @ref fen_filters_apply.
+ *
+ * @param[in]  enabled  Whether to use the compiled filter mode.
+ */
+void fen_compiled_mode_set(bool enabled);
+
+/**
+ * Recompiles the active filters after a filter instance changed its configuration.
+ *
+ * Has no effect outside compiled mode.
+ */
+void fen_filters_update(void);
+
+/**
+ * Applies the compiled filter on a received packet.
+ *
+ * @note Safe to call from the radio interrupt.
+ *
+ * @param[in]  p_packet  Pointer to the received packet, with its metadata filled in.
+ *
+ * @return true if packet shall be filtered, false otherwise.
+ */
+bool fen_compiled_filters_apply(const scanner_packet_t * p_packet);
+
 /** @} */
 
 #endif /* FILTER_ENGINE_H__ */
@@ -42,7 +42,11 @@
 
 typedef struct
 {
-    list_node_t * p_list_head;
+    /* Listener chains indexed by AD type. ADL_WILDCARD_AD_TYPE isn't a valid AD type, so its entry
+     * holds the chain of wildcard listeners. */
+    list_node_t * p_dispatch[UINT8_MAX + 1];
+    /* Total number of subscribed listeners. */
+    uint32_t      listener_count;
 #ifdef AD_LISTENER_DEBUG_MODE
     /* To check integrity in case of multiple listeners for one AD type. */
     uint8_t     frame_hash;
@@ -66,23 +70,14 @@ static uint8_t hash_count(const uint8_t * p_data, uint8_t size)
 }
 #endif
 
-static ad_listener_t * item_by_ad_get(list_node_t * p_list, uint8_t ad)
+static void ad_to_filter_add(const ad_listener_t * p_adl)
 {
-    LIST_FOREACH(p_iterator, p_list)
+    if (m_subscribers.p_dispatch[ADL_WILDCARD_AD_TYPE] != NULL)
     {
-        ad_listener_t * p_listener = PARENT_BY_FIELD_GET(ad_listener_t, node, p_iterator);
-
-        if (p_listener->ad_type == ad || p_listener->ad_type == ADL_WILDCARD_AD_TYPE)
-        {
-            return p_listener;
-        }
+        /* All AD types are already in the filter. */
+        return;
     }
 
-    return NULL;
-}
-
-static void ad_to_filter_add(ad_listener_t * p_adl)
-{
     if (p_adl->ad_type == ADL_WILDCARD_AD_TYPE)
     {
         for (uint16_t i = 0; i <= UINT8_MAX; i++)
@@ -90,15 +85,15 @@ static void ad_to_filter_add(ad_listener_t * p_adl)
             bearer_adtype_add(i);
         }
     }
-    else
+    else if (m_subscribers.p_dispatch[p_adl->ad_type] == NULL)
     {
         bearer_adtype_add(p_adl->ad_type);
     }
 }
 
-static void ad_from_filter_remove(ad_listener_t * p_adl)
+static void ad_from_filter_remove(const ad_listener_t * p_adl)
 {
-    if (item_by_ad_get(m_subscribers.p_list_head, ADL_WILDCARD_AD_TYPE) != NULL)
+    if (m_subscribers.p_dispatch[ADL_WILDCARD_AD_TYPE] != NULL)
     {
         return;
     }
@@ -107,18 +102,69 @@ static void ad_from_filter_remove(ad_listener_t * p_adl)
     {
         bearer_adtype_clear();
 
-        LIST_FOREACH(p_iterator, m_subscribers.p_list_head)
+        for (uint16_t i = 0; i <= UINT8_MAX; i++)
         {
-            ad_listener_t * p_listener = PARENT_BY_FIELD_GET(ad_listener_t, node, p_iterator);
-            bearer_adtype_add(p_listener->ad_type);
+            if (m_subscribers.p_dispatch[i] != NULL)
+            {
+                bearer_adtype_add(i);
+            }
         }
     }
-    else
+    else if (m_subscribers.p_dispatch[p_adl->ad_type] == NULL)
     {
         bearer_adtype_remove(p_adl->ad_type);
     }
 }
 
+static list_node_t ** chain_tail_get(list_node_t ** pp_chain, const list_node_t * p_node)
+{
+    while (*pp_chain != NULL)
+    {
+        /* Subscribing the same listener twice would loop the chain. */
+        NRF_MESH_ASSERT(*pp_chain != p_node);
+        pp_chain = &(*pp_chain)->p_next;
+    }
+
+    return pp_chain;
+}
+
+static bool chain_remove(list_node_t ** pp_chain, list_node_t * p_node)
+{
+    for (list_node_t ** pp_item = pp_chain; *pp_item != NULL; pp_item = &(*pp_item)->p_next)
+    {
+        if (*pp_item == p_node)
+        {
+            *pp_item = p_node->p_next;
+            p_node->p_next = NULL;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void chain_dispatch(const list_node_t * p_chain,
+                           ble_packet_type_t adv_type,
+                           const ble_ad_data_t * p_ad_data,
+                           const nrf_mesh_rx_metadata_t * p_metadata)
+{
+    while (p_chain != NULL)
+    {
+        ad_listener_t * p_listener = PARENT_BY_FIELD_GET(ad_listener_t, node, p_chain);
+
+        /* The listener may unsubscribe from within its handler. */
+        p_chain = p_chain->p_next;
+
+        if (adv_type != p_listener->adv_packet_type &&
+            p_listener->adv_packet_type != ADL_WILDCARD_ADV_TYPE)
+        {
+            continue;
+        }
+
+        p_listener->handler(p_ad_data->data, p_ad_data->length - BLE_AD_DATA_OVERHEAD, p_metadata);
+    }
+}
+
 static uint32_t input_param_check(ad_listener_t * p_adl)
 {
     if (p_adl == NULL || p_adl->handler == NULL)
@@ -144,11 +190,14 @@ uint32_t ad_listener_subscribe(ad_listener_t * p_adl)
         return checker;
     }
 
-    bool empty = m_subscribers.p_list_head == NULL;
+    /* Listeners are called in the order they subscribed. */
+    list_node_t ** pp_tail = chain_tail_get(&m_subscribers.p_dispatch[p_adl->ad_type], &p_adl->node);
+
     ad_to_filter_add(p_adl);
-    list_add(&m_subscribers.p_list_head, &p_adl->node);
+    p_adl->node.p_next = NULL;
+    *pp_tail = &p_adl->node;
 
-    if (empty)
+    if (m_subscribers.listener_count++ == 0)
     {
         bearer_adtype_mode_set(AD_FILTER_WHITELIST_MODE);
         bearer_adtype_filtering_set(true);
@@ -166,10 +215,14 @@ uint32_t ad_listener_unsubscribe(ad_listener_t * p_adl)
         return checker;
     }
 
-    list_remove(&m_subscribers.p_list_head, &p_adl->node);
+    if (!chain_remove(&m_subscribers.p_dispatch[p_adl->ad_type], &p_adl->node))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
     ad_from_filter_remove(p_adl);
 
-    if (m_subscribers.p_list_head == NULL)
+    if (--m_subscribers.listener_count == 0)
     {
         bearer_adtype_filtering_set(false);
     }
@@ -183,35 +236,29 @@ void ad_listener_process(ble_packet_type_t adv_type, const uint8_t * p_payload,
     m_subscribers.frame_hash = hash_count(p_payload, payload_length);
 #endif
 
-    for (ble_ad_data_t * p_ad_data = (ble_ad_data_t *)p_payload;
-         (uint8_t *)p_ad_data < &p_payload[payload_length];
+    const uint8_t * p_end = &p_payload[payload_length];
+
+    for (const ble_ad_data_t * p_ad_data = (const ble_ad_data_t *)p_payload;
+         (const uint8_t *)p_ad_data < p_end;
          p_ad_data = packet_ad_type_get_next((ble_ad_data_t *)p_ad_data))
     {
-        list_node_t * p_list = m_subscribers.p_list_head;
-
-        while (p_list != NULL)
+        /* The AD type filter only checks the length of the first matching AD structure. A zero
+         * length ends the significant part of the payload. */
+        if (p_ad_data->length == 0 ||
+            (const uint8_t *)p_ad_data + BLE_AD_DATA_OVERHEAD + p_ad_data->length > p_end)
         {
-            ad_listener_t * p_listener = item_by_ad_get(p_list, p_ad_data->type);
-
-            if (p_listener == NULL)
-            {
-                break;
-            }
-
-            p_list = p_listener->node.p_next;
-
-            if (adv_type != p_listener->adv_packet_type &&
-                p_listener->adv_packet_type != ADL_WILDCARD_ADV_TYPE)
-            {
-                continue;
-            }
+            break;
+        }
 
-            p_listener->handler(p_ad_data->data, p_ad_data->length - BLE_AD_DATA_OVERHEAD, p_metadata);
+        chain_dispatch(m_subscribers.p_dispatch[p_ad_data->type], adv_type, p_ad_data, p_metadata);
+        if (p_ad_data->type != ADL_WILDCARD_AD_TYPE)
+        {
+            chain_dispatch(m_subscribers.p_dispatch[ADL_WILDCARD_AD_TYPE], adv_type, p_ad_data, p_metadata);
+        }
 
 #ifdef AD_LISTENER_DEBUG_MODE
-            uint8_t hash = hash_count(p_payload, payload_length);
-            NRF_MESH_ASSERT(hash == m_subscribers.frame_hash);
+        uint8_t hash = hash_count(p_payload, payload_length);
+        NRF_MESH_ASSERT(hash == m_subscribers.frame_hash);
 #endif
-         }
-     }
+    }
 }
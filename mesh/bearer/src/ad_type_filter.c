@@ -41,6 +41,8 @@
 #include "nrf_mesh_assert.h"
 #include "bitfield.h"
 
+#include <string.h>
+
 /* AD type is 8 bits , so we need 256 bits to encode all possible values as a bit field,
    we will store them as 32 bit numbers (words), thus we need 256/32 words */
 #define FILTER_SIZE BITFIELD_BLOCK_COUNT(256)
@@ -89,11 +91,24 @@ static bool adtype_filter_handle(scanner_packet_t * p_scan_packet, void * p_data
     return filtering;
 }
 
+static bool adtype_filter_compile(fen_compiled_filter_t * p_compiled, void * p_data)
+{
+    (void)p_data;
+
+    p_compiled->ad_type.enabled = true;
+    p_compiled->ad_type.whitelist = (m_adtype_filter.mode == AD_FILTER_WHITELIST_MODE);
+    memcpy(p_compiled->ad_type.types, m_adtype_filter.adtype_filter, sizeof(m_adtype_filter.adtype_filter));
+    p_compiled->ad_type.p_filtered_count = &m_adtype_filter.amount_filtered_adtype_frames;
+    p_compiled->ad_type.p_invalid_length_count = &m_adtype_filter.amount_invalid_length_frames;
+    return true;
+}
+
 void bearer_adtype_filtering_set(bool onoff)
 {
     if (onoff)
     {
         m_adtype_filter.filter.handler = adtype_filter_handle;
+        m_adtype_filter.filter.compile = adtype_filter_compile;
         fen_filter_start(&m_adtype_filter.filter);
     }
     else
@@ -105,16 +120,19 @@ void bearer_adtype_filtering_set(bool onoff)
 void bearer_adtype_add(uint8_t type)
 {
     bitfield_set(m_adtype_filter.adtype_filter, type);
+    fen_filters_update();
 }
 
 void bearer_adtype_remove(uint8_t type)
 {
     bitfield_clear(m_adtype_filter.adtype_filter, type);
+    fen_filters_update();
 }
 
 void bearer_adtype_clear(void)
 {
     bitfield_clear_all(m_adtype_filter.adtype_filter, 256);
+    fen_filters_update();
 }
 
 void bearer_adtype_mode_set(ad_type_mode_t mode)
@@ -122,6 +140,7 @@ void bearer_adtype_mode_set(ad_type_mode_t mode)
     NRF_MESH_ASSERT(mode == AD_FILTER_WHITELIST_MODE || mode == AD_FILTER_BLACKLIST_MODE);
 
     m_adtype_filter.mode = mode;
+    fen_filters_update();
 }
 
 uint32_t bearer_invalid_length_amount_get(void)
@@ -74,11 +74,24 @@ static bool adv_filter_handle(scanner_packet_t * p_scan_packet, void * p_data)
     return filtering;
 }
 
+static bool adv_filter_compile(fen_compiled_filter_t * p_compiled, void * p_data)
+{
+    (void)p_data;
+    uint16_t listed = m_adv_packet_filter.adv_filter;
+
+    p_compiled->adv_type.enabled = true;
+    p_compiled->adv_type.accepted = (m_adv_packet_filter.mode == ADV_FILTER_WHITELIST_MODE ? listed : (uint16_t)~listed) |
+                                    ((uint16_t)1u << BLE_PACKET_TYPE_ADV_NONCONN_IND);
+    p_compiled->adv_type.p_filtered_count = &m_adv_packet_filter.amount_filtered_adv_type_frames;
+    return true;
+}
+
 void bearer_adv_packet_filtering_set(bool onoff)
 {
     if (onoff)
     {
         m_adv_packet_filter.filter.handler = adv_filter_handle;
+        m_adv_packet_filter.filter.compile = adv_filter_compile;
         fen_filter_start(&m_adv_packet_filter.filter);
     }
     else
@@ -90,16 +103,19 @@ void bearer_adv_packet_filtering_set(bool onoff)
 void bearer_adv_packet_remove(ble_packet_type_t type)
 {
     m_adv_packet_filter.adv_filter &= ~((uint16_t)1u << type);
+    fen_filters_update();
 }
 
 void bearer_adv_packet_add(ble_packet_type_t type)
 {
     m_adv_packet_filter.adv_filter |= ((uint16_t)1u << type);
+    fen_filters_update();
 }
 
 void bearer_adv_packet_clear(void)
 {
     m_adv_packet_filter.adv_filter = 0;
+    fen_filters_update();
 }
 
 void bearer_adv_packet_filter_mode_set(adv_packet_filter_mode_t mode)
@@ -108,6 +124,7 @@ void bearer_adv_packet_filter_mode_set(adv_packet_filter_mode_t mode)
                     mode == ADV_FILTER_BLACKLIST_MODE);
 
     m_adv_packet_filter.mode = mode;
+    fen_filters_update();
 }
 
 uint32_t bearer_adv_packet_filtered_amount_get(void)
@@ -51,6 +51,10 @@
 
 static const uint8_t m_ble_adv_channels[] = NRF_MESH_ADV_CHAN_DEFAULT;
 static prng_t m_adv_prng;
+/* Total number of queued packets in all advertiser instances. */
+static uint32_t m_queue_depth;
+/* Instances that have been initialized, so re-initializations can be told apart from the first one. */
+static advertiser_t * mp_advertisers;
 
 static inline bool is_active(const advertiser_t * p_adv)
 {
@@ -159,6 +163,28 @@ static inline bool should_free_current_packet(advertiser_t * p_adv)
     return (should_replace_infinite_packet || packet_has_no_repeats);
 }
 
+static void queue_depth_update(advertiser_t * p_adv, int32_t change)
+{
+    /* Packets are sent and fetched from different IRQ levels. */
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+    p_adv->queued_count += change;
+    m_queue_depth += change;
+    _ENABLE_IRQS(was_masked);
+}
+
+static bool instance_is_initialized(const advertiser_t * p_adv)
+{
+    for (const advertiser_t * p_instance = mp_advertisers; p_instance != NULL; p_instance = p_instance->p_next)
+    {
+        if (p_instance == p_adv)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 static bool next_packet_fetch(advertiser_t * p_adv)
 {
     while (p_adv->p_packet == NULL || should_free_current_packet(p_adv))
@@ -173,6 +199,7 @@ static bool next_packet_fetch(advertiser_t * p_adv)
         packet_buffer_packet_t * p_packet_buf;
         if (packet_buffer_pop(&p_adv->buf, &p_packet_buf) == NRF_SUCCESS)
         {
+            queue_depth_update(p_adv, -1);
             p_adv->p_packet = (adv_packet_t *) p_packet_buf->packet;
             p_adv->broadcast.params.p_packet = &p_adv->p_packet->packet;
         }
@@ -311,6 +338,21 @@ void advertiser_instance_init(advertiser_t * p_adv,
     p_adv->timer.p_context = p_adv;
     p_adv->enabled = false;
 
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+    if (instance_is_initialized(p_adv))
+    {
+        /* Packets queued before a re-initialization are gone with the old buffer. */
+        m_queue_depth -= p_adv->queued_count;
+    }
+    else
+    {
+        p_adv->p_next = mp_advertisers;
+        mp_advertisers = p_adv;
+    }
+    p_adv->queued_count = 0;
+    _ENABLE_IRQS(was_masked);
+
     if (tx_complete_cb != NULL)
     {
         bearer_event_sequential_add(&p_adv->tx_complete_event, tx_complete_event_callback, p_adv);
@@ -370,6 +412,7 @@ void advertiser_packet_send(advertiser_t * p_adv, adv_packet_t * p_packet)
     p_packet->packet.header._rfu3 = 0;
 
     packet_buffer_commit(&p_adv->buf, p_buf_packet, p_buf_packet->size);
+    queue_depth_update(p_adv, 1);
     if (p_adv->enabled && !is_active(p_adv))
     {
         schedule_first_time(&p_adv->timer, p_adv->config.advertisement_interval_us);
@@ -448,6 +491,8 @@ void advertiser_flush(advertiser_t * p_adv)
     /* Stop the sending of the current packet: */
     uint32_t was_masked;
     _DISABLE_IRQS(was_masked);
+    m_queue_depth -= p_adv->queued_count;
+    p_adv->queued_count = 0;
     if (p_adv->p_packet != NULL)
     {
         p_adv->p_packet->config.repeats = 0;
@@ -455,6 +500,11 @@ void advertiser_flush(advertiser_t * p_adv)
     _ENABLE_IRQS(was_masked);
 }
 
+uint32_t advertiser_queue_depth_get(void)
+{
+    return m_queue_depth;
+}
+
 void advertiser_address_default_get(ble_gap_addr_t * p_addr)
 {
     uint32_t hw_addr_type = (NRF_FICR->DEVICEADDRTYPE & FICR_DEVICEADDRTYPE_DEVICEADDRTYPE_Msk);
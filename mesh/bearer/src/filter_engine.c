@@ -35,19 +35,160 @@
  * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include "nrf_mesh_assert.h"
 #include "filter_engine.h"
+#include "packet.h"
 #include "utils.h"
 
 static list_node_t * m_filter_list_head = NULL;
 static uint32_t m_accepted_amount;
 
+static bool m_compiled_mode = FILTER_ENGINE_COMPILED_MODE_DEFAULT;
+/* The compiled filter is read from the radio interrupt, so it's double buffered: a new filter is
+ * compiled into the inactive buffer before the active pointer is swapped over to it. */
+static fen_compiled_filter_t m_compiled_filters[2];
+static const fen_compiled_filter_t * volatile mp_compiled_filter = &m_compiled_filters[0];
+/* Number of active filters that have to be applied through their handler. */
+static uint32_t m_uncompiled_count;
+
+static void gap_addr_keys_sort(uint64_t * p_keys, uint16_t count)
+{
+    /* Insertion sort, the sets are short and only sorted on reconfiguration. */
+    for (uint16_t i = 1; i < count; ++i)
+    {
+        uint64_t key = p_keys[i];
+        uint16_t j = i;
+        while (j > 0 && p_keys[j - 1] > key)
+        {
+            p_keys[j] = p_keys[j - 1];
+            j--;
+        }
+        p_keys[j] = key;
+    }
+}
+
+static bool gap_addr_set_contains(const uint64_t * p_keys, uint16_t count, uint64_t key)
+{
+    uint16_t low = 0;
+    uint16_t high = count;
+
+    while (low < high)
+    {
+        uint16_t mid = low + (high - low) / 2;
+        if (p_keys[mid] == key)
+        {
+            return true;
+        }
+        else if (p_keys[mid] < key)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return false;
+}
+
+static bool compiled_gap_addr_filter(const fen_compiled_filter_t * p_compiled, const packet_t * p_packet)
+{
+    bool filtering;
+
+    switch (p_compiled->gap_addr.mode)
+    {
+        case FEN_GAP_ADDR_MODE_WHITELIST:
+        case FEN_GAP_ADDR_MODE_BLACKLIST:
+            filtering = gap_addr_set_contains(p_compiled->gap_addr.keys,
+                                              p_compiled->gap_addr.count,
+                                              fen_gap_addr_key(p_packet->header.addr_type, p_packet->addr));
+            if (p_compiled->gap_addr.mode == FEN_GAP_ADDR_MODE_WHITELIST)
+            {
+                filtering = !filtering;
+            }
+            break;
+        case FEN_GAP_ADDR_MODE_RANGE:
+            filtering = !((p_packet->header.addr_type == p_compiled->gap_addr.range[0].addr_type) &&
+                          (memcmp(p_compiled->gap_addr.range[0].addr, p_packet->addr, BLE_GAP_ADDR_LEN) <= 0) &&
+                          (memcmp(p_compiled->gap_addr.range[1].addr, p_packet->addr, BLE_GAP_ADDR_LEN) > 0));
+            break;
+        default:
+            return false;
+    }
+
+    if (filtering)
+    {
+        (*p_compiled->gap_addr.p_filtered_count)++;
+    }
+    return filtering;
+}
+
+static bool compiled_ad_type_filter(const fen_compiled_filter_t * p_compiled, const packet_t * p_packet)
+{
+    bool filtering = p_compiled->ad_type.whitelist;
+    uint8_t payload_size = packet_payload_size_get(p_packet);
+
+    for (int i = 0; i + 1 < payload_size;)
+    {
+        uint8_t length = p_packet->payload[i];
+        uint8_t type = p_packet->payload[i + 1];
+
+        if (bitfield_get(p_compiled->ad_type.types, type))
+        {
+            if (length >= payload_size - i)
+            {
+                (*p_compiled->ad_type.p_invalid_length_count)++;
+                return true;
+            }
+            filtering = !filtering;
+            break;
+        }
+
+        i += length + 1;
+    }
+
+    if (filtering)
+    {
+        (*p_compiled->ad_type.p_filtered_count)++;
+    }
+    return filtering;
+}
+
+static void filters_compile(void)
+{
+    fen_compiled_filter_t * p_compiled = (mp_compiled_filter == &m_compiled_filters[0])
+                                             ? &m_compiled_filters[1]
+                                             : &m_compiled_filters[0];
+    memset(p_compiled, 0, sizeof(fen_compiled_filter_t));
+
+    m_uncompiled_count = 0;
+    LIST_FOREACH(p_node, m_filter_list_head)
+    {
+        filter_t * p_filter = PARENT_BY_FIELD_GET(filter_t, node, p_node);
+
+        p_filter->compiled = (m_compiled_mode &&
+                              p_filter->compile != NULL &&
+                              p_filter->compile(p_compiled, p_filter->p_data));
+        if (!p_filter->compiled)
+        {
+            m_uncompiled_count++;
+        }
+    }
+
+    gap_addr_keys_sort(p_compiled->gap_addr.keys, p_compiled->gap_addr.count);
+
+    mp_compiled_filter = p_compiled;
+}
+
 void fen_filter_start(filter_t * p_filter)
 {
     NRF_MESH_ASSERT(p_filter != NULL);
     NRF_MESH_ASSERT(p_filter->handler != NULL);
 
     list_add(&m_filter_list_head, &p_filter->node);
+    filters_compile();
 }
 
 void fen_filter_stop(filter_t * p_filter)
@@ -55,17 +196,22 @@ void fen_filter_stop(filter_t * p_filter)
     NRF_MESH_ASSERT(p_filter != NULL);
 
     list_remove(&m_filter_list_head, &p_filter->node);
+    p_filter->compiled = false;
+    filters_compile();
 }
 
 bool fen_filters_apply(scanner_packet_t * p_packet)
 {
-    LIST_FOREACH(p_node, m_filter_list_head)
+    if (m_uncompiled_count > 0)
     {
-        filter_t * p_filter = PARENT_BY_FIELD_GET(filter_t, node, p_node);
-
-        if (p_filter->handler(p_packet, p_filter->p_data))
+        LIST_FOREACH(p_node, m_filter_list_head)
         {
-            return true;
+            filter_t * p_filter = PARENT_BY_FIELD_GET(filter_t, node, p_node);
+
+            if (!p_filter->compiled && p_filter->handler(p_packet, p_filter->p_data))
+            {
+                return true;
+            }
         }
     }
 
@@ -78,3 +224,48 @@ uint32_t fen_accepted_amount_get(void)
 {
     return m_accepted_amount;
 }
+
+void fen_compiled_mode_set(bool enabled)
+{
+    m_compiled_mode = enabled;
+    filters_compile();
+}
+
+void fen_filters_update(void)
+{
+    if (m_compiled_mode)
+    {
+        filters_compile();
+    }
+}
+
+bool fen_compiled_filters_apply(const scanner_packet_t * p_packet)
+{
+    const fen_compiled_filter_t * p_compiled = mp_compiled_filter;
+    const packet_t * p_adv_packet = &p_packet->packet;
+
+    if (p_compiled->rssi.enabled && p_packet->metadata.rssi < p_compiled->rssi.min)
+    {
+        (*p_compiled->rssi.p_filtered_count)++;
+        return true;
+    }
+
+    if (p_compiled->adv_type.enabled &&
+        !(p_compiled->adv_type.accepted & ((uint16_t)1u << p_adv_packet->header.type)))
+    {
+        (*p_compiled->adv_type.p_filtered_count)++;
+        return true;
+    }
+
+    if (p_compiled->ad_type.enabled && compiled_ad_type_filter(p_compiled, p_adv_packet))
+    {
+        return true;
+    }
+
+    if (compiled_gap_addr_filter(p_compiled, p_adv_packet))
+    {
+        return true;
+    }
+
+    return false;
+}
@@ -35,9 +35,26 @@
  * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include "gap_address_filter.h"
 #include "filter_engine.h"
+#include "bearer_event.h"
 #include "nrf_mesh_assert.h"
+#include "nrf_mesh_config_bearer.h"
+#include "timer.h"
+#include "utils.h"
+
+/** Marks an occupied slot of the hashed address set, the address keys only use the lower 55 bits. */
+#define HASH_SET_SLOT_OCCUPIED  (1ull << 63)
+/** Expiry time of addresses that never expire. */
+#define HASH_SET_EXPIRY_NEVER   (0)
+
+NRF_MESH_STATIC_ASSERT((GAP_ADDR_FILTER_HASH_SET_SIZE & (GAP_ADDR_FILTER_HASH_SET_SIZE - 1)) == 0);
+NRF_MESH_STATIC_ASSERT(GAP_ADDR_FILTER_HASH_SET_CAPACITY < GAP_ADDR_FILTER_HASH_SET_SIZE);
+/* Every list that fits in the compiled filter must be accepted. */
+NRF_MESH_STATIC_ASSERT(FILTER_ENGINE_COMPILED_GAP_ADDR_MAX <= GAP_ADDR_FILTER_HASH_SET_CAPACITY ||
+                       FILTER_ENGINE_COMPILED_GAP_ADDR_MAX <= GAP_ADDR_FILTER_LINEAR_MAX);
 
 /** Types of filters for addresses */
 typedef enum
@@ -48,17 +65,184 @@ typedef enum
     ADDR_FILTER_TYPE_RANGE      /**< Range filter, address must be in range between two addresses. */
 } addr_filter_type_t;
 
+/** Open addressing hash set of address keys, with linear probing. */
+typedef struct
+{
+    uint64_t    keys[GAP_ADDR_FILTER_HASH_SET_SIZE];   /**< Address keys, or 0 for free slots. */
+    timestamp_t expiry[GAP_ADDR_FILTER_HASH_SET_SIZE]; /**< Expiry time of each slot, see @ref HASH_SET_EXPIRY_NEVER. */
+    uint16_t    count;                                 /**< Number of occupied slots. */
+    uint16_t    sweep_index;                           /**< Next slot to check for expiry. */
+    bearer_filter_gap_addr_set_stats_t stats;          /**< Statistics, except the number of entries and the list state. */
+} addr_hash_set_t;
+
 typedef struct
 {
     filter_t               filter;
     const ble_gap_addr_t * p_gap_addr_list;
     uint16_t               count;
     addr_filter_type_t     type;
+    bool                   list_hashed;      /**< Whether the address list was loaded into the hash set. */
+    bool                   addrs_learned;    /**< Whether addresses have been learned since the list was set. */
     uint32_t               amount_filtered_gap_addr_frames;
 } gap_addr_filter_t;
 
 /** Filter for GAP addresses */
 static gap_addr_filter_t m_addr_filter;
+/** Hashed address set, for long address lists and learned addresses. */
+static addr_hash_set_t m_hash_set;
+
+static inline uint32_t hash_set_slot_get(uint64_t key)
+{
+    /* Fibonacci hashing, spreads the address bits over the upper bits of the product. */
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (GAP_ADDR_FILTER_HASH_SET_SIZE - 1);
+}
+
+static inline bool hash_set_is_expired(uint32_t slot, timestamp_t now)
+{
+    return (m_hash_set.expiry[slot] != HASH_SET_EXPIRY_NEVER &&
+            TIMER_OLDER_THAN(m_hash_set.expiry[slot], now));
+}
+
+static uint32_t hash_set_find(uint64_t key)
+{
+    key |= HASH_SET_SLOT_OCCUPIED;
+    /* The set is never full, so the probing always ends at a free slot. */
+    for (uint32_t slot = hash_set_slot_get(key);
+         m_hash_set.keys[slot] != 0;
+         slot = (slot + 1) & (GAP_ADDR_FILTER_HASH_SET_SIZE - 1))
+    {
+        if (m_hash_set.keys[slot] == key)
+        {
+            return slot;
+        }
+    }
+    return GAP_ADDR_FILTER_HASH_SET_SIZE;
+}
+
+static void hash_set_remove(uint32_t slot)
+{
+    /* Backward shift deletion: moves the following entries of the probe sequence into the hole,
+     * so that lookups don't need tombstones. */
+    uint32_t next = slot;
+    for (;;)
+    {
+        m_hash_set.keys[slot] = 0;
+        uint64_t key;
+        uint32_t home;
+        do
+        {
+            next = (next + 1) & (GAP_ADDR_FILTER_HASH_SET_SIZE - 1);
+            key = m_hash_set.keys[next];
+            if (key == 0)
+            {
+                m_hash_set.count--;
+                return;
+            }
+            home = hash_set_slot_get(key & ~HASH_SET_SLOT_OCCUPIED);
+            /* The entry stays if its home slot is cyclically within (slot, next]. */
+        } while ((slot <= next) ? (slot < home && home <= next) : (slot < home || home <= next));
+
+        m_hash_set.keys[slot] = key;
+        m_hash_set.expiry[slot] = m_hash_set.expiry[next];
+        slot = next;
+    }
+}
+
+static void hash_set_expired_remove(timestamp_t now)
+{
+    for (uint32_t slot = 0; slot < GAP_ADDR_FILTER_HASH_SET_SIZE; ++slot)
+    {
+        /* Removal may shift a later entry into this slot, so check it again. */
+        while (m_hash_set.keys[slot] != 0 && hash_set_is_expired(slot, now))
+        {
+            hash_set_remove(slot);
+            m_hash_set.stats.expired++;
+        }
+    }
+}
+
+static uint32_t hash_set_insert(uint64_t key, timestamp_t expiry)
+{
+    uint32_t slot = hash_set_find(key);
+    if (slot < GAP_ADDR_FILTER_HASH_SET_SIZE)
+    {
+        /* Addresses from the address list stay for as long as the list. */
+        if (m_hash_set.expiry[slot] != HASH_SET_EXPIRY_NEVER)
+        {
+            m_hash_set.expiry[slot] = expiry;
+        }
+        return NRF_SUCCESS;
+    }
+
+    if (m_hash_set.count >= GAP_ADDR_FILTER_HASH_SET_CAPACITY)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    for (slot = hash_set_slot_get(key);
+         m_hash_set.keys[slot] != 0;
+         slot = (slot + 1) & (GAP_ADDR_FILTER_HASH_SET_SIZE - 1))
+    {
+    }
+    m_hash_set.keys[slot] = key | HASH_SET_SLOT_OCCUPIED;
+    m_hash_set.expiry[slot] = expiry;
+    m_hash_set.count++;
+    return NRF_SUCCESS;
+}
+
+static void hash_set_clear(void)
+{
+    memset(m_hash_set.keys, 0, sizeof(m_hash_set.keys));
+    m_hash_set.count = 0;
+    m_hash_set.sweep_index = 0;
+}
+
+static bool hash_set_contains(const packet_t * p_packet, timestamp_t now)
+{
+    m_hash_set.stats.lookups++;
+
+    /* Checks one slot per lookup, so that expired addresses are removed before the timestamps
+     * wrap around, even if they're never seen again. */
+    uint32_t sweep_slot = m_hash_set.sweep_index;
+    m_hash_set.sweep_index = (sweep_slot + 1) & (GAP_ADDR_FILTER_HASH_SET_SIZE - 1);
+    if (m_hash_set.keys[sweep_slot] != 0 && hash_set_is_expired(sweep_slot, now))
+    {
+        hash_set_remove(sweep_slot);
+        m_hash_set.stats.expired++;
+    }
+
+    uint32_t slot = hash_set_find(fen_gap_addr_key(p_packet->header.addr_type, p_packet->addr));
+    if (slot == GAP_ADDR_FILTER_HASH_SET_SIZE)
+    {
+        return false;
+    }
+    if (hash_set_is_expired(slot, now))
+    {
+        hash_set_remove(slot);
+        m_hash_set.stats.expired++;
+        return false;
+    }
+
+    m_hash_set.stats.hits++;
+    return true;
+}
+
+static bool address_list_contains(const gap_addr_filter_t * p_filter, const packet_t * p_packet, timestamp_t now)
+{
+    if (!p_filter->list_hashed)
+    {
+        for (uint32_t i = 0; i < p_filter->count; ++i)
+        {
+            if (memcmp(p_filter->p_gap_addr_list[i].addr, p_packet->addr, BLE_GAP_ADDR_LEN) == 0 &&
+                p_packet->header.addr_type == p_filter->p_gap_addr_list[i].addr_type)
+            {
+                return true;
+            }
+        }
+    }
+
+    return (m_hash_set.count > 0 && hash_set_contains(p_packet, now));
+}
 
 static bool gap_address_filter_handle(scanner_packet_t * p_scan_packet, void * p_data)
 {
@@ -73,14 +257,9 @@ static bool gap_address_filter_handle(scanner_packet_t * p_scan_packet, void * p
 
     if (p_filter->type == ADDR_FILTER_TYPE_WHITELIST || p_filter->type == ADDR_FILTER_TYPE_BLACKLIST)
     {
-        for (uint32_t i = 0; i < p_filter->count; ++i)
+        if (address_list_contains(p_filter, p_packet, p_scan_packet->metadata.timestamp))
         {
-            if (memcmp(p_filter->p_gap_addr_list[i].addr, p_packet->addr, BLE_GAP_ADDR_LEN) == 0 &&
-                p_packet->header.addr_type == p_filter->p_gap_addr_list[i].addr_type)
-            {
-                filtering = !filtering;
-                break;
-            }
+            filtering = !filtering;
         }
     }
     else
@@ -101,6 +280,49 @@ static bool gap_address_filter_handle(scanner_packet_t * p_scan_packet, void * p
     return filtering;
 }
 
+static bool gap_address_filter_compile(fen_compiled_filter_t * p_compiled, void * p_data)
+{
+    gap_addr_filter_t * p_filter = (gap_addr_filter_t *)p_data;
+
+    if (p_filter->count > FILTER_ENGINE_COMPILED_GAP_ADDR_MAX || p_filter->addrs_learned)
+    {
+        return false;
+    }
+
+    switch (p_filter->type)
+    {
+        case ADDR_FILTER_TYPE_WHITELIST:
+            p_compiled->gap_addr.mode = FEN_GAP_ADDR_MODE_WHITELIST;
+            break;
+        case ADDR_FILTER_TYPE_BLACKLIST:
+            p_compiled->gap_addr.mode = FEN_GAP_ADDR_MODE_BLACKLIST;
+            break;
+        case ADDR_FILTER_TYPE_RANGE:
+            p_compiled->gap_addr.mode = FEN_GAP_ADDR_MODE_RANGE;
+            break;
+        default:
+            return false;
+    }
+
+    /* The address list is copied, so changes to the user's list require a new call to one of the
+     * set-functions to take effect in compiled mode. */
+    if (p_filter->type == ADDR_FILTER_TYPE_RANGE)
+    {
+        memcpy(p_compiled->gap_addr.range, p_filter->p_gap_addr_list, sizeof(p_compiled->gap_addr.range));
+    }
+    else
+    {
+        for (uint32_t i = 0; i < p_filter->count; ++i)
+        {
+            p_compiled->gap_addr.keys[i] = fen_gap_addr_key(p_filter->p_gap_addr_list[i].addr_type,
+                                                            p_filter->p_gap_addr_list[i].addr);
+        }
+        p_compiled->gap_addr.count = p_filter->count;
+    }
+    p_compiled->gap_addr.p_filtered_count = &p_filter->amount_filtered_gap_addr_frames;
+    return true;
+}
+
 static uint32_t gap_addr_filter_set(const ble_gap_addr_t * const p_addrs,
                                     uint16_t addr_count,
                                     addr_filter_type_t type)
@@ -118,10 +340,32 @@ static uint32_t gap_addr_filter_set(const ble_gap_addr_t * const p_addrs,
     {
         return NRF_ERROR_INVALID_LENGTH;
     }
+    if (type != ADDR_FILTER_TYPE_RANGE &&
+        addr_count > GAP_ADDR_FILTER_LINEAR_MAX &&
+        addr_count > GAP_ADDR_FILTER_HASH_SET_CAPACITY)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
 
+    /* The address set is looked up by the filter handler in the bearer event handler. */
+    bearer_event_critical_section_begin();
     m_addr_filter.type            = type;
     m_addr_filter.count           = addr_count;
+    m_addr_filter.addrs_learned   = false;
+    m_addr_filter.list_hashed     = false;
+    hash_set_clear();
+
+    if (type != ADDR_FILTER_TYPE_RANGE && addr_count > GAP_ADDR_FILTER_LINEAR_MAX)
+    {
+        for (uint32_t i = 0; i < addr_count; ++i)
+        {
+            NRF_MESH_ERROR_CHECK(hash_set_insert(fen_gap_addr_key(p_addrs[i].addr_type, p_addrs[i].addr),
+                                                 HASH_SET_EXPIRY_NEVER));
+        }
+        m_addr_filter.list_hashed = true;
+    }
     m_addr_filter.filter.handler  = gap_address_filter_handle;
+    m_addr_filter.filter.compile  = gap_address_filter_compile;
     m_addr_filter.filter.p_data   = (void *)&m_addr_filter;
 
     if (m_addr_filter.p_gap_addr_list != p_addrs)
@@ -129,6 +373,11 @@ static uint32_t gap_addr_filter_set(const ble_gap_addr_t * const p_addrs,
         m_addr_filter.p_gap_addr_list = p_addrs;
         fen_filter_start(&m_addr_filter.filter);
     }
+    else
+    {
+        fen_filters_update();
+    }
+    bearer_event_critical_section_end();
 
     return NRF_SUCCESS;
 }
@@ -159,6 +408,57 @@ uint32_t bearer_filter_gap_addr_range_set(const ble_gap_addr_t * const p_addrs)
     return gap_addr_filter_set(p_addrs, 2, ADDR_FILTER_TYPE_RANGE);
 }
 
+uint32_t bearer_filter_gap_addr_learn(const ble_gap_addr_t * p_addr, uint32_t lifetime_ms)
+{
+    if (p_addr == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+    if (lifetime_ms > BEARER_FILTER_GAP_ADDR_LIFETIME_MAX_MS)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (m_addr_filter.type != ADDR_FILTER_TYPE_WHITELIST &&
+        m_addr_filter.type != ADDR_FILTER_TYPE_BLACKLIST)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    timestamp_t now = timer_now();
+    timestamp_t expiry = HASH_SET_EXPIRY_NEVER;
+    if (lifetime_ms > 0)
+    {
+        expiry = now + MS_TO_US(lifetime_ms);
+        if (expiry == HASH_SET_EXPIRY_NEVER)
+        {
+            expiry++;
+        }
+    }
+
+    uint64_t key = fen_gap_addr_key(p_addr->addr_type, p_addr->addr);
+    bearer_event_critical_section_begin();
+    uint32_t status = hash_set_insert(key, expiry);
+    if (status == NRF_ERROR_NO_MEM)
+    {
+        hash_set_expired_remove(now);
+        status = hash_set_insert(key, expiry);
+    }
+
+    if (status != NRF_SUCCESS)
+    {
+        m_hash_set.stats.learn_failures++;
+    }
+    else if (!m_addr_filter.addrs_learned)
+    {
+        /* The compiled filter doesn't know about the learned addresses, hand the filter back to
+         * its handler. */
+        m_addr_filter.addrs_learned = true;
+        fen_filters_update();
+    }
+    bearer_event_critical_section_end();
+    return status;
+}
+
 uint32_t bearer_filter_gap_addr_clear(void)
 {
     if (m_addr_filter.type == ADDR_FILTER_TYPE_NONE)
@@ -166,10 +466,15 @@ uint32_t bearer_filter_gap_addr_clear(void)
         return NRF_ERROR_INVALID_STATE;
     }
 
+    bearer_event_critical_section_begin();
     m_addr_filter.type            = ADDR_FILTER_TYPE_NONE;
     m_addr_filter.p_gap_addr_list = NULL;
     m_addr_filter.count           = 0;
+    m_addr_filter.addrs_learned   = false;
+    m_addr_filter.list_hashed     = false;
+    hash_set_clear();
     fen_filter_stop(&m_addr_filter.filter);
+    bearer_event_critical_section_end();
 
     return NRF_SUCCESS;
 }
@@ -178,3 +483,12 @@ uint32_t bearer_gap_addr_filtered_amount_get(void)
 {
     return m_addr_filter.amount_filtered_gap_addr_frames;
 }
+
+void bearer_filter_gap_addr_set_stats_get(bearer_filter_gap_addr_set_stats_t * p_stats)
+{
+    NRF_MESH_ASSERT(p_stats != NULL);
+
+    *p_stats = m_hash_set.stats;
+    p_stats->entries = m_hash_set.count;
+    p_stats->list_hashed = m_addr_filter.list_hashed;
+}
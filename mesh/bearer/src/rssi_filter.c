@@ -62,6 +62,16 @@ static bool rssi_filter_handle(scanner_packet_t * p_scan_packet, void * p_data)
     return false;
 }
 
+static bool rssi_filter_compile(fen_compiled_filter_t * p_compiled, void * p_data)
+{
+    (void)p_data;
+
+    p_compiled->rssi.enabled = true;
+    p_compiled->rssi.min = m_rssi_filter.rssi_filter_val;
+    p_compiled->rssi.p_filtered_count = &m_rssi_filter.amount_filtered_rssi_frames;
+    return true;
+}
+
 void bearer_rssi_filtering_set(int8_t rssi)
 {
     if (rssi < 0)
@@ -69,10 +79,15 @@ void bearer_rssi_filtering_set(int8_t rssi)
         if (m_rssi_filter.rssi_filter_val == 0)
         {
             m_rssi_filter.filter.handler = rssi_filter_handle;
+            m_rssi_filter.filter.compile = rssi_filter_compile;
+            m_rssi_filter.rssi_filter_val = rssi;
             fen_filter_start(&m_rssi_filter.filter);
         }
-
-        m_rssi_filter.rssi_filter_val = rssi;
+        else
+        {
+            m_rssi_filter.rssi_filter_val = rssi;
+            fen_filters_update();
+        }
     }
     else
     {
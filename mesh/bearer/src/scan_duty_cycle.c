@@ -0,0 +1,197 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scan_duty_cycle.h"
+#include "scanner.h"
+#include "advertiser.h"
+#include "timer.h"
+#include "timer_scheduler.h"
+#include "bearer_defines.h"
+#include "nrf_mesh_config_bearer.h"
+#include "nrf_mesh_assert.h"
+#include "nordic_common.h"
+#include "utils.h"
+
+typedef struct
+{
+    bool                     running;
+    scan_duty_cycle_policy_t policy;
+    void *                   p_context;
+    scan_duty_cycle_timing_t timing;
+    timer_event_t            timer;
+    timestamp_t              period_start;
+    uint32_t                 rx_packets;   /**< Scanner receive count at the start of the period. */
+} scan_duty_cycle_t;
+
+static scan_duty_cycle_t m_scan_duty_cycle;
+
+static bool timing_is_valid(const scan_duty_cycle_timing_t * p_timing)
+{
+    return (p_timing->scan_window_us >= MS_TO_US(BEARER_SCAN_WIN_MIN_MS) &&
+            p_timing->scan_window_us <= p_timing->scan_interval_us &&
+            p_timing->scan_interval_us <= MS_TO_US(BEARER_SCAN_INT_MAX_MS));
+}
+
+static void sample_period_end(timestamp_t timestamp, void * p_context)
+{
+    (void) p_context;
+
+    uint32_t rx_packets = scanner_stats_get()->successful_receives;
+    scan_duty_cycle_sample_t sample =
+    {
+        .period_us = timestamp - m_scan_duty_cycle.period_start,
+        .rx_packets = rx_packets - m_scan_duty_cycle.rx_packets,
+        .tx_queue_depth = advertiser_queue_depth_get()
+    };
+    m_scan_duty_cycle.period_start = timestamp;
+    m_scan_duty_cycle.rx_packets = rx_packets;
+
+    scan_duty_cycle_timing_t timing = m_scan_duty_cycle.timing;
+    m_scan_duty_cycle.policy(&sample, &timing, m_scan_duty_cycle.p_context);
+    NRF_MESH_ASSERT(timing_is_valid(&timing));
+
+    /* Changing the scanner timing restarts the scan window, leave it alone if nothing changed. */
+    if (timing.scan_interval_us != m_scan_duty_cycle.timing.scan_interval_us ||
+        timing.scan_window_us != m_scan_duty_cycle.timing.scan_window_us)
+    {
+        m_scan_duty_cycle.timing = timing;
+        scanner_config_scan_time_set(timing.scan_interval_us, timing.scan_window_us);
+    }
+}
+
+void scan_duty_cycle_policy_default(const scan_duty_cycle_sample_t * p_sample,
+                                    scan_duty_cycle_timing_t * p_timing,
+                                    void * p_context)
+{
+    const scan_duty_cycle_default_config_t * p_config = p_context;
+    NRF_MESH_ASSERT(p_config != NULL);
+    NRF_MESH_ASSERT(p_config->quiet_rx_rate < p_config->busy_rx_rate);
+    NRF_MESH_ASSERT(p_config->window_min_us >= MS_TO_US(BEARER_SCAN_WIN_MIN_MS));
+    NRF_MESH_ASSERT(p_config->window_min_us <= p_config->window_max_us);
+    NRF_MESH_ASSERT(p_config->window_max_us <= p_config->scan_interval_us);
+    NRF_MESH_ASSERT(p_config->scan_interval_us <= MS_TO_US(BEARER_SCAN_INT_MAX_MS));
+
+    uint32_t window_us = p_timing->scan_window_us;
+
+    if (p_sample->tx_queue_depth >= p_config->tx_queue_deep)
+    {
+        window_us /= 2;
+    }
+    else
+    {
+        /* Only count the time actually spent scanning, so the rate measures the channel, not the
+         * current scan window. */
+        uint64_t scan_time_us =
+            ((uint64_t) p_sample->period_us * p_timing->scan_window_us) / p_timing->scan_interval_us;
+        uint64_t rx_rate = 0;
+        if (scan_time_us > 0)
+        {
+            rx_rate = ((uint64_t) p_sample->rx_packets * SEC_TO_US(1)) / scan_time_us;
+        }
+
+        if (rx_rate >= p_config->busy_rx_rate)
+        {
+            window_us *= 2;
+        }
+        else if (rx_rate <= p_config->quiet_rx_rate)
+        {
+            window_us -= window_us / 4;
+        }
+    }
+
+    p_timing->scan_interval_us = p_config->scan_interval_us;
+    p_timing->scan_window_us = MIN(MAX(window_us, p_config->window_min_us), p_config->window_max_us);
+}
+
+uint32_t scan_duty_cycle_start(scan_duty_cycle_policy_t policy,
+                               void * p_context,
+                               const scan_duty_cycle_timing_t * p_timing)
+{
+    if (policy == NULL || p_timing == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+    else if (!timing_is_valid(p_timing))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    else if (m_scan_duty_cycle.running)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    m_scan_duty_cycle.running = true;
+    m_scan_duty_cycle.policy = policy;
+    m_scan_duty_cycle.p_context = p_context;
+    m_scan_duty_cycle.timing = *p_timing;
+    scanner_config_scan_time_set(p_timing->scan_interval_us, p_timing->scan_window_us);
+
+    m_scan_duty_cycle.period_start = timer_now();
+    m_scan_duty_cycle.rx_packets = scanner_stats_get()->successful_receives;
+    m_scan_duty_cycle.timer.cb = sample_period_end;
+    m_scan_duty_cycle.timer.p_context = NULL;
+    m_scan_duty_cycle.timer.interval = MS_TO_US(SCAN_DUTY_CYCLE_SAMPLE_INTERVAL_MS);
+    m_scan_duty_cycle.timer.timestamp = m_scan_duty_cycle.period_start + m_scan_duty_cycle.timer.interval;
+    timer_sch_schedule(&m_scan_duty_cycle.timer);
+
+    return NRF_SUCCESS;
+}
+
+uint32_t scan_duty_cycle_stop(void)
+{
+    if (!m_scan_duty_cycle.running)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    timer_sch_abort(&m_scan_duty_cycle.timer);
+    m_scan_duty_cycle.running = false;
+    return NRF_SUCCESS;
+}
+
+uint32_t scan_duty_cycle_timing_get(scan_duty_cycle_timing_t * p_timing)
+{
+    NRF_MESH_ASSERT(p_timing != NULL);
+
+    if (!m_scan_duty_cycle.running)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    *p_timing = m_scan_duty_cycle.timing;
+    return NRF_SUCCESS;
+}
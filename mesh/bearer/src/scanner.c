@@ -48,6 +48,12 @@
 /** Scanner packet overhead (i.e. size of packet if length is 0). */
 #define SCANNER_PACKET_OVERHEAD (offsetof(scanner_packet_t, packet.addr))
 
+#if SCANNER_RX_RING_SLOT_COUNT
+NRF_MESH_STATIC_ASSERT(IS_POWER_OF_2(SCANNER_RX_RING_SLOT_COUNT));
+
+#define SCANNER_RX_RING_INDEX(COUNTER) ((COUNTER) & (SCANNER_RX_RING_SLOT_COUNT - 1))
+#endif
+
 /** Scanner configuration, used to change radio parameters used by the scanner. */
 typedef struct
 {
@@ -73,6 +79,25 @@ typedef enum
     SCAN_WINDOW_STATE_NEXT_CHANNEL
 } scan_window_state_t;
 
+#if SCANNER_RX_RING_SLOT_COUNT
+/**
+ * Ring of packet slots, shared between the radio and the consumer without copying.
+ *
+ * The counters are free running. Slots from @c free to @c read are owned by the consumer, and slots
+ * from @c write onwards are owned by the radio. The radio is the only one to change @c write, and
+ * the consumer is the only one to change @c read and @c free.
+ */
+typedef struct
+{
+    scanner_packet_t  slots[SCANNER_RX_RING_SLOT_COUNT];
+    bool              released[SCANNER_RX_RING_SLOT_COUNT]; /**< Slots released out of order. */
+    volatile uint32_t write;                                /**< Number of slots filled by the radio. */
+    volatile uint32_t read;                                 /**< Number of slots returned by scanner_rx(). */
+    volatile uint32_t free;                                 /**< Number of slots handed back to the radio. */
+    scanner_packet_t  overflow;                             /**< Receives packets to be dropped while all slots are in use. */
+} scanner_rx_ring_t;
+#endif
+
 typedef struct
 {
     scanner_state_t          state;
@@ -81,14 +106,22 @@ typedef struct
     bool                     is_radio_cfg_pending;
     scan_window_state_t      window_state;
     uint8_t                  channel_index;         /**< Index in the channel map */
+#if SCANNER_RX_RING_SLOT_COUNT
+    scanner_packet_t *       p_rx_packet;           /**< Packet the radio is receiving into. */
+#else
     packet_buffer_packet_t * p_buffer_packet;
+#endif
     scanner_stats_t          stats;
     scanner_config_t         config;
     timer_event_t            timer_window_start;
     timer_event_t            timer_window_end;
     bearer_event_flag_t      nrf_mesh_process_flag;
+#if SCANNER_RX_RING_SLOT_COUNT
+    scanner_rx_ring_t        rx_ring;
+#else
     packet_buffer_t          packet_buffer;
     uint8_t                  packet_buffer_data[SCANNER_BUFFER_SIZE];
+#endif
     scanner_rx_callback_t    rx_callback;
 } scanner_t;
 
@@ -120,6 +153,61 @@ static inline bool continuous_scanning(void)
 * Radio operation
 *****************************************************************************/
 
+#if SCANNER_RX_RING_SLOT_COUNT
+
+static inline scanner_packet_t * rx_packet_get(void)
+{
+    return m_scanner.p_rx_packet;
+}
+
+static bool radio_set_packet(void)
+{
+    NRF_MESH_ASSERT(m_scanner.p_rx_packet == NULL);
+
+    scanner_rx_ring_t * p_ring = &m_scanner.rx_ring;
+
+    /* Keep receiving when the ring is full, so the dropped packets can be counted. */
+    if (p_ring->write - p_ring->free < SCANNER_RX_RING_SLOT_COUNT)
+    {
+        m_scanner.p_rx_packet = &p_ring->slots[SCANNER_RX_RING_INDEX(p_ring->write)];
+    }
+    else
+    {
+        m_scanner.p_rx_packet = &p_ring->overflow;
+    }
+
+    NRF_RADIO->PACKETPTR = (uint32_t) &m_scanner.p_rx_packet->packet;
+    return true;
+}
+
+static void rx_packet_commit(void)
+{
+    if (m_scanner.p_rx_packet == &m_scanner.rx_ring.overflow)
+    {
+        m_scanner.stats.rx_buffer_drops++;
+    }
+    else
+    {
+        m_scanner.rx_ring.write++;
+        bearer_event_flag_set(m_scanner.nrf_mesh_process_flag);
+    }
+
+    m_scanner.p_rx_packet = NULL;
+}
+
+static void rx_packet_discard(void)
+{
+    /* The slot is armed again for the next packet. */
+    m_scanner.p_rx_packet = NULL;
+}
+
+#else
+
+static inline scanner_packet_t * rx_packet_get(void)
+{
+    return (scanner_packet_t *) m_scanner.p_buffer_packet->packet;
+}
+
 static bool radio_set_packet(void)
 {
     NRF_MESH_ASSERT(m_scanner.p_buffer_packet == NULL);
@@ -132,11 +220,39 @@ static bool radio_set_packet(void)
         scanner_packet_t * p_packet = (scanner_packet_t *) m_scanner.p_buffer_packet->packet;
         NRF_RADIO->PACKETPTR = (uint32_t) &p_packet->packet;
     }
+    else
+    {
+        m_scanner.stats.rx_buffer_stalls++;
+    }
 
     m_scanner.waiting_for_memory = !got_packet;
     return got_packet;
 }
 
+static void rx_packet_commit(void)
+{
+    scanner_packet_t * p_packet = rx_packet_get();
+
+    packet_buffer_commit(&m_scanner.packet_buffer,
+                         m_scanner.p_buffer_packet,
+                         SCANNER_PACKET_OVERHEAD + p_packet->packet.header.length);
+
+    bearer_event_flag_set(m_scanner.nrf_mesh_process_flag);
+
+    m_scanner.p_buffer_packet = NULL;
+}
+
+static void rx_packet_discard(void)
+{
+    if (m_scanner.p_buffer_packet != NULL)
+    {
+        packet_buffer_free(&m_scanner.packet_buffer, m_scanner.p_buffer_packet);
+        m_scanner.p_buffer_packet = NULL;
+    }
+}
+
+#endif /* SCANNER_RX_RING_SLOT_COUNT */
+
 static void radio_configure(void)
 {
     radio_config_reset();
@@ -182,11 +298,7 @@ static void radio_stop(void)
     NRF_RADIO->TASKS_DISABLE = 1;
     /* clear any end events, to avoid a misfire */
     NRF_RADIO->EVENTS_END = 0;
-    if (m_scanner.p_buffer_packet != NULL)
-    {
-        packet_buffer_free(&m_scanner.packet_buffer, m_scanner.p_buffer_packet);
-        m_scanner.p_buffer_packet = NULL;
-    }
+    rx_packet_discard();
 #if !defined(HOST)
     while (NRF_RADIO->STATE != RADIO_STATE_STATE_Disabled);
 #endif
@@ -214,14 +326,16 @@ static void radio_handle_end_event(void)
     DEBUG_PIN_SCANNER_ON(DEBUG_PIN_SCANNER_END_EVENT);
 
     bool successful_receive = false;
-    scanner_packet_t * p_packet = (scanner_packet_t *) m_scanner.p_buffer_packet->packet;
+    scanner_packet_t * p_packet = rx_packet_get();
 
     if (!NRF_RADIO->CRCSTATUS)
     {
         m_scanner.stats.crc_failures++;
     }
-    else if (p_packet->packet.header.length > m_scanner.config.radio_config.payload_maxlen)
+    else if (p_packet->packet.header.length > m_scanner.config.radio_config.payload_maxlen ||
+             p_packet->packet.header.length < BLE_GAP_ADDR_LEN)
     {
+        /* Packets without a whole GAP address can't be parsed by the compiled filters. */
         m_scanner.stats.length_out_of_bounds++;
     }
     else
@@ -250,19 +364,19 @@ static void radio_handle_end_event(void)
             m_scanner.rx_callback(p_packet);
         }
 
-        packet_buffer_commit(&m_scanner.packet_buffer,
-                             m_scanner.p_buffer_packet,
-                             SCANNER_PACKET_OVERHEAD + p_packet->packet.header.length);
+        /* Rejected packets are released right away, so they never take up room in the RX queue. */
+        successful_receive = !fen_compiled_filters_apply(p_packet);
+    }
 
-        bearer_event_flag_set(m_scanner.nrf_mesh_process_flag);
+    if (successful_receive)
+    {
+        rx_packet_commit();
     }
     else
     {
-        packet_buffer_free(&m_scanner.packet_buffer, m_scanner.p_buffer_packet);
+        rx_packet_discard();
     }
 
-    m_scanner.p_buffer_packet = NULL;
-
     DEBUG_PIN_SCANNER_OFF(DEBUG_PIN_SCANNER_END_EVENT);
 }
 
@@ -432,7 +546,9 @@ void scanner_init(bearer_event_flag_callback_t packet_process_cb)
 {
     memset(&m_scanner, 0, sizeof(m_scanner));
 
+#if !SCANNER_RX_RING_SLOT_COUNT
     packet_buffer_init(&m_scanner.packet_buffer, m_scanner.packet_buffer_data, SCANNER_BUFFER_SIZE);
+#endif
     scanner_config_reset();
     m_scanner.config.radio_config.tx_power = RADIO_POWER_NRF_0DBM;
     m_scanner.config.radio_config.payload_maxlen = RADIO_CONFIG_ADV_MAX_PAYLOAD_SIZE;
@@ -482,6 +598,61 @@ bool scanner_is_enabled(void)
     return (m_scanner.state == SCANNER_STATE_RUNNING);
 }
 
+#if SCANNER_RX_RING_SLOT_COUNT
+
+const scanner_packet_t * scanner_rx(void)
+{
+    scanner_rx_ring_t * p_ring = &m_scanner.rx_ring;
+
+    while (p_ring->read != p_ring->write)
+    {
+        scanner_packet_t * p_packet = &p_ring->slots[SCANNER_RX_RING_INDEX(p_ring->read)];
+        p_ring->read++;
+
+        if (fen_filters_apply(p_packet))
+        {
+            scanner_packet_release(p_packet);
+        }
+        else
+        {
+            return p_packet;
+        }
+    }
+
+    return NULL;
+}
+
+void scanner_packet_release(const scanner_packet_t * p_packet)
+{
+    NRF_MESH_ASSERT(p_packet != NULL);
+
+    scanner_rx_ring_t * p_ring = &m_scanner.rx_ring;
+    uint32_t index = p_packet - &p_ring->slots[0];
+
+    NRF_MESH_ASSERT(index < SCANNER_RX_RING_SLOT_COUNT);
+    /* The slot must be owned by the consumer, and not released already. */
+    NRF_MESH_ASSERT(SCANNER_RX_RING_INDEX(index - p_ring->free) < p_ring->read - p_ring->free);
+    NRF_MESH_ASSERT(!p_ring->released[index]);
+
+    p_ring->released[index] = true;
+
+    /* Hand back the released slots at the start of the consumer's range in one go. */
+    uint32_t free = p_ring->free;
+    while (free != p_ring->read && p_ring->released[SCANNER_RX_RING_INDEX(free)])
+    {
+        p_ring->released[SCANNER_RX_RING_INDEX(free)] = false;
+        free++;
+    }
+    p_ring->free = free;
+}
+
+bool scanner_rx_pending(void)
+{
+    return (m_scanner.rx_ring.read != m_scanner.rx_ring.write);
+}
+
+#else
+
 const scanner_packet_t * scanner_rx(void)
 {
     packet_buffer_packet_t * p_packet;
@@ -512,14 +683,16 @@ void scanner_packet_release(const scanner_packet_t * p_packet)
     }
 }
 
-const scanner_stats_t * scanner_stats_get(void)
+bool scanner_rx_pending(void)
 {
-    return &m_scanner.stats;
+    return packet_buffer_can_pop(&m_scanner.packet_buffer);
 }
 
-bool scanner_rx_pending(void)
+#endif /* SCANNER_RX_RING_SLOT_COUNT */
+
+const scanner_stats_t * scanner_stats_get(void)
 {
-    return packet_buffer_can_pop(&m_scanner.packet_buffer);
+    return &m_scanner.stats;
 }
 
 /*****************************************************************************
@@ -229,6 +229,29 @@
 #define MSG_CACHE_ENTRY_COUNT 32
 #endif
 
+/**
+ * Set to 1 to index the message cache entries and fingerprints in hash tables.
+ *
+ * Looking up a packet in the message cache is done on every received network packet. Without
+ * the hash index, the lookup is a linear search through all entries, which becomes expensive
+ * for large values of @ref MSG_CACHE_ENTRY_COUNT and @ref MSG_CACHE_FINGERPRINT_COUNT. The hash
+ * index makes the lookup time independent of the cache size, at the cost of 4 to 8 bytes of RAM
+ * per cache entry or fingerprint.
+ */
+#ifndef MSG_CACHE_HASH_INDEX_ENABLE
+#define MSG_CACHE_HASH_INDEX_ENABLE 0
+#endif
+
+/**
+ * Number of received network packets to remember by their raw, encrypted contents.
+ *
+ * Incoming packets are checked against these fingerprints before decryption, which lets
+ * repeated transmissions of the same packet be dropped without any AES operations.
+ */
+#ifndef MSG_CACHE_FINGERPRINT_COUNT
+#define MSG_CACHE_FINGERPRINT_COUNT 16
+#endif
+
 /** @} end of MESH_CONFIG_MSG_CACHE */
 
 /**
@@ -271,13 +294,32 @@
 #endif
 
 /**
- * Number of sequence numbers left before allocating the next block. Allocating a new block can
- * take at least 200ms, and the device would be blocked from sending new messages if it runs out.
+ * Minimum number of sequence numbers left before allocating the next block. Allocating a new block
+ * can take at least 200ms, and the device would be blocked from sending new messages if it runs
+ * out. The allocation is started at @ref NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD.
  */
 #ifndef NETWORK_SEQNUM_FLASH_BLOCK_THRESHOLD
 #define NETWORK_SEQNUM_FLASH_BLOCK_THRESHOLD 64
 #endif
 
+/**
+ * Number of sequence numbers left when the allocation of the next block is started. The block is
+ * stored asynchronously, and starting early leaves room for the flash manager to be busy with
+ * other entries during TX bursts without stalling the sender. Sequence numbers that were not yet
+ * used when the device resets are skipped, so this is traded against the IV Update interval.
+ */
+#ifndef NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD
+#define NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD (NETWORK_SEQNUM_FLASH_BLOCK_SIZE / 2)
+#endif
+
+/* Sanity check for NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD */
+#if NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD < NETWORK_SEQNUM_FLASH_BLOCK_THRESHOLD
+#error "The sequence number block must be preallocated at or before NETWORK_SEQNUM_FLASH_BLOCK_THRESHOLD."
+#endif
+#if NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD >= NETWORK_SEQNUM_FLASH_BLOCK_SIZE
+#error "The sequence number block preallocation threshold must be smaller than the block size."
+#endif
+
 /**
  * Number of flash pages reserved for the network flash area.
  */
@@ -285,20 +327,145 @@
 #define NET_FLASH_PAGE_COUNT 1
 #endif
 
+/**
+ * Max number of scanner packets processed in one go. The mesh network packets among them are
+ * screened in place in the scanner buffer first, and then all packets are processed in the order
+ * they were received. Requires the scanner RX ring (@ref SCANNER_RX_RING_SLOT_COUNT), the scanner
+ * packet buffer only lets one packet be processed at a time.
+ */
+#ifndef NETWORK_RX_BATCH_SIZE
+#define NETWORK_RX_BATCH_SIZE 4
+#endif
+
+/**
+ * Number of packets that can wait for room in the relay TX buffer. When the queue is full, the
+ * packet with the lowest TTL is dropped, picking the oldest packet among packets with the same TTL.
+ * Each entry takes about 64 bytes of RAM. Consider a larger queue for nodes that relay a lot of
+ * bursty traffic.
+ */
+#ifndef NETWORK_RELAY_QUEUE_SIZE
+#define NETWORK_RELAY_QUEUE_SIZE 4
+#endif
+
+/**
+ * Default max time a packet can wait in the relay queue in milliseconds. Can be changed at runtime
+ * with @ref NRF_MESH_OPT_NET_RELAY_QUEUE_MAX_AGE_MS.
+ */
+#ifndef NETWORK_RELAY_QUEUE_MAX_AGE_MS_DEFAULT
+#define NETWORK_RELAY_QUEUE_MAX_AGE_MS_DEFAULT 500
+#endif
+
 /** @} end of MESH_CONFIG_NETWORK */
 
 /**
  * @defgroup MESH_CONFIG_TRANSPORT Transport layer configuration
  * @{
  */
-/** Maximum number of concurrent transport SAR sessions, shared by RX and TX. */
+/** Maximum number of concurrent transport SAR sessions, shared by RX and TX. Must be less than 255. */
 #ifndef TRANSPORT_SAR_SESSIONS_MAX
 #define TRANSPORT_SAR_SESSIONS_MAX (4)
 #endif
 
-/** Number of elements in the SAR RX cache, storing the last RX sessions. Must be power of two. */
+/**
+ * Default max number of concurrent SAR sessions with a single peer, counting RX sessions from the
+ * peer and TX sessions to it. Can be changed at runtime with
+ * @ref NRF_MESH_OPT_TRS_SAR_SESSIONS_PER_PEER_MAX.
+ */
+#ifndef TRANSPORT_SAR_SESSIONS_PER_PEER_MAX_DEFAULT
+#define TRANSPORT_SAR_SESSIONS_PER_PEER_MAX_DEFAULT (TRANSPORT_SAR_SESSIONS_MAX)
+#endif
+
+/**
+ * Default number of SAR sessions that can only be used for receiving. Keeps a burst of outgoing
+ * segmented messages from locking out incoming ones. Can be changed at runtime with
+ * @ref NRF_MESH_OPT_TRS_SAR_SESSIONS_RX_RESERVED.
+ */
+#ifndef TRANSPORT_SAR_SESSIONS_RX_RESERVED_DEFAULT
+#define TRANSPORT_SAR_SESSIONS_RX_RESERVED_DEFAULT (0)
+#endif
+
+/**
+ * Number of elements in the SAR RX cache, storing the last RX sessions. Must be power of two, and
+ * less than 65535. Sessions are removed from the cache when a later packet from the same source
+ * shows that no more segments can arrive for them, or when the IV index has moved two steps past
+ * theirs.
+ */
 #ifndef TRANSPORT_SAR_RX_CACHE_LEN
-#define TRANSPORT_SAR_RX_CACHE_LEN (8)
+#define TRANSPORT_SAR_RX_CACHE_LEN (32)
+#endif
+
+/**
+ * Default state of the adaptive SAR retransmission mode. In adaptive mode, the TX retry timeout
+ * for a unicast destination is derived from the measured segment acknowledgment round-trip time
+ * instead of the TTL. Can be changed at runtime with @ref NRF_MESH_OPT_TRS_SAR_TX_RETRY_ADAPTIVE.
+ */
+#ifndef TRANSPORT_SAR_TX_RETRY_ADAPTIVE_DEFAULT
+#define TRANSPORT_SAR_TX_RETRY_ADAPTIVE_DEFAULT (0)
+#endif
+
+/** Number of unicast destinations to keep round-trip time estimates for in adaptive retransmission mode. */
+#ifndef TRANSPORT_SAR_RTT_CACHE_LEN
+#define TRANSPORT_SAR_RTT_CACHE_LEN (8)
+#endif
+
+/**
+ * Default max number of SAR TX segments waiting for transmission at the same time, shared by all TX
+ * sessions. More segments are released as the bearers finish sending them. Can be changed at
+ * runtime with @ref NRF_MESH_OPT_TRS_SAR_TX_WINDOW.
+ */
+#ifndef TRANSPORT_SAR_TX_WINDOW_DEFAULT
+#define TRANSPORT_SAR_TX_WINDOW_DEFAULT (8)
+#endif
+
+/**
+ * Set to 1 to decrypt segmented access messages as their segments arrive, when only one
+ * application key matches the message. The message is authenticated once its last segment
+ * arrives, as the MIC depends on the message length.
+ */
+#ifndef TRANSPORT_SAR_RX_DECRYPT_STREAMING
+#define TRANSPORT_SAR_RX_DECRYPT_STREAMING (1)
+#endif
+
+/**
+ * Set to 1 to allocate SAR payload buffers from the fixed size slabs of the SAR slab allocator by
+ * default, instead of using malloc and free. See @ref SAR_SLAB.
+ */
+#ifndef TRANSPORT_SAR_SLAB_ALLOCATOR
+#define TRANSPORT_SAR_SLAB_ALLOCATOR (0)
+#endif
+
+/** Number of 12 byte slabs in the SAR slab allocator, fitting single segment payloads. */
+#ifndef TRANSPORT_SAR_SLAB_COUNT_12
+#define TRANSPORT_SAR_SLAB_COUNT_12 (8)
+#endif
+
+/** Number of 48 byte slabs in the SAR slab allocator, fitting up to 4 segments. */
+#ifndef TRANSPORT_SAR_SLAB_COUNT_48
+#define TRANSPORT_SAR_SLAB_COUNT_48 (4)
+#endif
+
+/** Number of 96 byte slabs in the SAR slab allocator, fitting up to 8 segments. */
+#ifndef TRANSPORT_SAR_SLAB_COUNT_96
+#define TRANSPORT_SAR_SLAB_COUNT_96 (4)
+#endif
+
+/** Number of 192 byte slabs in the SAR slab allocator, fitting up to 16 segments. */
+#ifndef TRANSPORT_SAR_SLAB_COUNT_192
+#define TRANSPORT_SAR_SLAB_COUNT_192 (2)
+#endif
+
+/** Number of 384 byte slabs in the SAR slab allocator, fitting the largest SAR payloads. */
+#ifndef TRANSPORT_SAR_SLAB_COUNT_384
+#define TRANSPORT_SAR_SLAB_COUNT_384 (2)
+#endif
+
+/**
+ * Number of recently sent segment acknowledgments to remember. A new acknowledgment for the same
+ * session is dropped if it adds no segments, and the previous one was sent less than
+ * @ref NRF_MESH_OPT_TRS_SAR_SEGACK_COALESCE_WINDOW ago.
+ */
+#ifndef TRANSPORT_SAR_SEGACK_HISTORY_LEN
+#define TRANSPORT_SAR_SEGACK_HISTORY_LEN (4)
 #endif
 
 /** Default TTL value for SAR segmentation acknowledgments */
@@ -381,6 +548,26 @@
 #define REPLAY_CACHE_ENTRIES 32
 #endif
 
+/** Reject messages from new sources when the replay protection cache is full. */
+#define REPLAY_CACHE_OVERFLOW_POLICY_REJECT     (0)
+/** Evict the least recently updated entry when the replay protection cache is full. */
+#define REPLAY_CACHE_OVERFLOW_POLICY_EVICT_LRU  (1)
+
+/**
+ * Policy for handling messages from new sources when the replay protection cache is full.
+ *
+ * With @ref REPLAY_CACHE_OVERFLOW_POLICY_REJECT, the messages are dropped and an
+ * @ref NRF_MESH_EVT_RX_FAILED event is reported. With @ref REPLAY_CACHE_OVERFLOW_POLICY_EVICT_LRU,
+ * the entry of the source that was least recently heard from is removed to make room, and an
+ * @ref NRF_MESH_EVT_REPLAY_CACHE_EVICTED event is reported.
+ *
+ * @warning Evicting entries makes the node vulnerable to replay of old messages from the
+ * evicted sources. Only use the eviction policy if the number of peer nodes can not be bounded.
+ */
+#ifndef REPLAY_CACHE_OVERFLOW_POLICY
+#define REPLAY_CACHE_OVERFLOW_POLICY REPLAY_CACHE_OVERFLOW_POLICY_REJECT
+#endif
+
 /** @} end of MESH_CONFIG_REPLAY_CACHE */
 
 /**
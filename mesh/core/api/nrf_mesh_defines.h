@@ -205,6 +205,10 @@
 /** TX retries upper limit (UINT8_MAX). */
 #define TRANSPORT_SAR_TX_RETRIES_MAX                            (255)
 
+/** Segment acknowledgment coalescing window upper limit. Kept below the lowest TX retry timeout, so
+ * that the ack for a retransmission is never suppressed. */
+#define TRANSPORT_SAR_SEGACK_COALESCE_WINDOW_MAX                MS_TO_US(150)
+
 /** Maximum difference in sequence numbers between two SAR segments of the same session (Mesh
  * specification v1.0 section 3.5.3.1) */
 #define TRANSPORT_SAR_SEQNUM_DIFF_MAX                           (8191)
@@ -87,7 +87,9 @@ typedef enum
     /** SAR session failed. */
     NRF_MESH_EVT_SAR_FAILED,
     /** Flash has malfunctioned. */
-    NRF_MESH_EVT_FLASH_FAILED
+    NRF_MESH_EVT_FLASH_FAILED,
+    /** A replay protection cache entry was evicted to make room for a new source. */
+    NRF_MESH_EVT_REPLAY_CACHE_EVICTED
 } nrf_mesh_evt_type_t;
 
 /**
@@ -244,6 +246,19 @@ typedef struct
     nrf_mesh_rx_failed_reason_t reason;
 }nrf_mesh_evt_rx_failed_t;
 
+/**
+ * Replay protection cache entry evicted event structure.
+ *
+ * Only reported when @ref REPLAY_CACHE_OVERFLOW_POLICY is @ref REPLAY_CACHE_OVERFLOW_POLICY_EVICT_LRU.
+ */
+typedef struct
+{
+    /** Unicast address of the source the evicted entry belonged to. */
+    uint16_t src;
+    /** IV index bit of the evicted entry. */
+    uint8_t ivi : 1;
+} nrf_mesh_evt_replay_cache_evicted_t;
+
 /**
  * SAR session cancelled reason codes.
  */
@@ -332,6 +347,8 @@ typedef struct
         nrf_mesh_evt_sar_failed_t               sar_failed;
         /** Flash failed event */
         nrf_mesh_evt_flash_failed_t             flash_failed;
+        /** Replay protection cache entry evicted event. */
+        nrf_mesh_evt_replay_cache_evicted_t     replay_cache_evicted;
     } params;
 } nrf_mesh_evt_t;
 
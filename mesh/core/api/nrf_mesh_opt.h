@@ -78,6 +78,30 @@ typedef enum
     NRF_MESH_OPT_TRS_SAR_SEGACK_TTL,
     /** 32-bit (@ref NRF_MESH_TRANSMIC_SIZE_SMALL) or 64-bit (@ref NRF_MESH_TRANSMIC_SIZE_LARGE) MIC size for transport layer. */
     NRF_MESH_OPT_TRS_SZMIC,
+    /** Max number of concurrent SAR sessions with a single peer, from 1 to @ref TRANSPORT_SAR_SESSIONS_MAX. */
+    NRF_MESH_OPT_TRS_SAR_SESSIONS_PER_PEER_MAX,
+    /** Number of SAR sessions that can't be used for sending, from 0 to @ref TRANSPORT_SAR_SESSIONS_MAX - 1. */
+    NRF_MESH_OPT_TRS_SAR_SESSIONS_RX_RESERVED,
+    /** Number of SAR sessions currently in use. Read only. */
+    NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE,
+    /** Highest number of SAR sessions in use at the same time. Setting it to 0 restarts the count from the current number. */
+    NRF_MESH_OPT_TRS_SAR_SESSIONS_PEAK,
+    /** Number of SAR sessions rejected because all sessions were in use. Can only be set to 0. */
+    NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_NO_MEM,
+    /** Number of SAR sessions rejected by the per peer limit or the RX reservation. Can only be set to 0. */
+    NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_QUOTA,
+    /** Enable (1) / disable (0) TX retry timeouts based on the measured round-trip time to each unicast destination. */
+    NRF_MESH_OPT_TRS_SAR_TX_RETRY_ADAPTIVE,
+    /** Max number of SAR TX segments in flight, from 1 to 32 times @ref TRANSPORT_SAR_SESSIONS_MAX. */
+    NRF_MESH_OPT_TRS_SAR_TX_WINDOW,
+    /** Number of received segments that belonged to a completed SAR session. Can only be set to 0. */
+    NRF_MESH_OPT_TRS_SAR_RX_CACHE_HITS,
+    /** Number of received segments that didn't belong to a completed SAR session. Can only be set to 0. */
+    NRF_MESH_OPT_TRS_SAR_RX_CACHE_MISSES,
+    /** Time window in microseconds, in which a segment acknowledgment that adds no segments to the previous one for the same session is suppressed. Up to @ref TRANSPORT_SAR_SEGACK_COALESCE_WINDOW_MAX, 0 disables the suppression. */
+    NRF_MESH_OPT_TRS_SAR_SEGACK_COALESCE_WINDOW,
+    /** Number of suppressed segment acknowledgments. Can only be set to 0. */
+    NRF_MESH_OPT_TRS_SAR_SEGACK_SUPPRESSED,
     /** Packet relaying enabled (1) or disabled (0). */
     NRF_MESH_OPT_NET_RELAY_ENABLE = NRF_MESH_OPT_NET_START,
     /** Number of retransmits per relayed packet. */
@@ -88,6 +112,14 @@ typedef enum
     NRF_MESH_OPT_NET_NETWORK_TRANSMIT_COUNT,
     /** Interval between retransmitted packets originating from this device in milliseconds. */
     NRF_MESH_OPT_NET_NETWORK_TRANSMIT_INTERVAL_MS,
+    /** Max time a packet can wait in the relay queue in milliseconds. */
+    NRF_MESH_OPT_NET_RELAY_QUEUE_MAX_AGE_MS,
+    /** Number of packets dropped from the relay queue for exceeding the max age. Can only be set to 0. */
+    NRF_MESH_OPT_NET_RELAY_DROPPED_AGE,
+    /** Number of packets evicted from the relay queue in favor of a more valuable packet. Can only be set to 0. */
+    NRF_MESH_OPT_NET_RELAY_DROPPED_EVICTED,
+    /** Number of packets not relayed because the relay queue was full of more valuable packets. Can only be set to 0. */
+    NRF_MESH_OPT_NET_RELAY_DROPPED_QUEUE_FULL,
 } nrf_mesh_opt_id_t;
 
 
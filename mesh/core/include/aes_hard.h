@@ -39,12 +39,66 @@
 
 #include <stdint.h>
 
+#include "nrf_mesh_defines.h"
+
 /**
  * @defgroup AES_HARD AES-ECB encryption API
  * @ingroup MESH_CORE
+ *
+ * On the device, the encryption is done by the ECB hardware module. Host builds use a table-driven
+ * software implementation with the same API.
  * @{
  */
 
+/** Number of 32-bit words in an expanded AES-128 key. */
+#define AES_ROUND_KEY_WORDS (44)
+
+/**
+ * AES-128 key context.
+ *
+ * Holds the key in the form used by the backend, so that several blocks can be encrypted with
+ * the same key without repeating the key expansion.
+ */
+typedef struct
+{
+#if defined(HOST)
+    /** Expanded round keys. */
+    uint32_t round_keys[AES_ROUND_KEY_WORDS];
+#else
+    /** Key, the ECB hardware module does its own key expansion. */
+    uint8_t key[NRF_MESH_KEY_SIZE];
+#endif
+} aes_ctx_t;
+
+/**
+ * Initializes a key context.
+ *
+ * @param[out] p_ctx Key context to initialize.
+ * @param[in]  p_key 128-bit key.
+ */
+void aes_ctx_init(aes_ctx_t * p_ctx, const uint8_t * p_key);
+
+/**
+ * Encrypts a single block with an initialized key context.
+ *
+ * @param[in]  p_ctx         Key context, initialized with @ref aes_ctx_init().
+ * @param[in]  p_clear_text  128-bit message to encrypt.
+ * @param[out] p_cipher_text 128-bit buffer to store the encrypted output. May be the same as
+ *                           @p p_clear_text.
+ */
+void aes_ctx_encrypt(const aes_ctx_t * p_ctx, const uint8_t * p_clear_text, uint8_t * p_cipher_text);
+
+#if defined(HOST)
+/**
+ * Gets the number of blocks encrypted so far.
+ *
+ * Only available in host builds, for profiling the number of AES operations done by the stack.
+ *
+ * @returns Number of blocks encrypted since startup, wrapping on overflow.
+ */
+uint32_t aes_block_count_get(void);
+#endif
+
 /**
  * Encrypts the given clear text using the ECB hardware module.
  *
@@ -79,6 +79,17 @@ typedef struct
     uint8_t   mic_len;                      /**< Length of the message integrity check value. */
 } ccm_soft_data_t;
 
+/**
+ * Keystream position, used to decrypt a message in parts with @ref ccm_soft_keystream_apply.
+ *
+ * Must be zero-initialized before the first part of a message.
+ */
+typedef struct
+{
+    uint16_t counter;   /**< Counter of the keystream block in @c block, or 0 if there is none. */
+    uint8_t block[16];  /**< Last keystream block that was generated. */
+} ccm_soft_keystream_t;
+
 /**
  * Encrypts data with the AES-CCM algorithm.
  *
@@ -96,6 +107,47 @@ void ccm_soft_encrypt(ccm_soft_data_t * p_data);
  */
 void ccm_soft_decrypt(ccm_soft_data_t * p_data, bool * p_mic_passed);
 
+/**
+ * Decrypts data using the AES-CCM algorithm, and checks the MIC against several candidates for
+ * the additional authenticated data.
+ *
+ * The keystream does not depend on the additional data, so the message is only decrypted once,
+ * and each additional candidate only costs an authentication pass.
+ *
+ * @param p_data  Pointer to structure with parameters for decrypting a message. The @c p_a field
+ *                is ignored, and all candidates must be @c a_len long. See @ref ccm_soft_data_t.
+ * @param pp_a    List of additional data candidates.
+ * @param a_count Number of candidates in @p pp_a.
+ *
+ * @returns Index of the first candidate that passed the MIC check, or @p a_count if none did.
+ */
+uint32_t ccm_soft_decrypt_ad_candidates(ccm_soft_data_t * p_data, const uint8_t * const * pp_a, uint32_t a_count);
+
+/**
+ * Applies the AES-CCM keystream to a part of a message, without authenticating it.
+ *
+ * The keystream doesn't depend on the message length, so a message can be decrypted one part at a
+ * time, in any order, before its length is known. Applying the keystream twice restores the input.
+ * The last keystream block is kept in @p p_keystream, so consecutive parts that share a block only
+ * generate it once.
+ *
+ * @param p_data      Pointer to structure with the key, nonce, input (@c p_m), output (@c p_out)
+ *                    and length (@c m_len) of the part. The other fields are ignored.
+ * @param offset      Offset of the part in the message.
+ * @param p_keystream Keystream position for the message.
+ */
+void ccm_soft_keystream_apply(const ccm_soft_data_t * p_data, uint16_t offset, ccm_soft_keystream_t * p_keystream);
+
+/**
+ * Checks the MIC of a message that has already been decrypted with @ref ccm_soft_keystream_apply.
+ *
+ * @param p_data       Pointer to structure with parameters for authenticating the message, where
+ *                     @c p_m is the decrypted message and @c p_mic is the received MIC. The
+ *                     @c p_out field is ignored. See @ref ccm_soft_data_t.
+ * @param p_mic_passed Pointer to bool for storing result of MIC
+ */
+void ccm_soft_decrypted_authenticate(const ccm_soft_data_t * p_data, bool * p_mic_passed);
+
 /**
  * @}
  */
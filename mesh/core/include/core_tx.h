@@ -202,6 +202,17 @@ typedef void (*core_tx_complete_cb_t)(core_tx_role_t role,
  */
 void core_tx_complete_cb_set(core_tx_complete_cb_t tx_complete_callback);
 
+/**
+ * Set the core tx complete callback for relayed packets.
+ *
+ * Transmissions of packets with the @ref CORE_TX_ROLE_RELAY role are reported to this callback
+ * instead of the one set with @ref core_tx_complete_cb_set.
+ *
+ * @param[in] tx_complete_callback Callback to call at the end of a successful transmission of a
+ * relayed packet, or NULL to report relayed packets to the regular callback.
+ */
+void core_tx_relay_complete_cb_set(core_tx_complete_cb_t tx_complete_callback);
+
 /**
  * Allocate a network packet for transmission.
  *
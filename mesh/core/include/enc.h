@@ -156,6 +156,43 @@ void enc_aes_ccm_encrypt(ccm_soft_data_t * const p_ccm_data);
  */
 void enc_aes_ccm_decrypt(ccm_soft_data_t * const p_ccm_data, bool * const p_mic_passed);
 
+/**
+ * Performs an AES-CCM decryption, and authenticates it against several additional data
+ * candidates.
+ *
+ * @param p_ccm_data      Pointer to structure with encryption data. See
+ *                        @ref ccm_soft_data_t. The @c p_a field is ignored.
+ * @param pp_a            List of additional data candidates, each @c a_len long.
+ * @param a_count         Number of candidates in @p pp_a.
+ *
+ * @returns Index of the first candidate that passed the MIC check, or @p a_count if none did.
+ */
+uint32_t enc_aes_ccm_decrypt_ad_candidates(ccm_soft_data_t * const p_ccm_data,
+                                           const uint8_t * const * pp_a,
+                                           uint32_t a_count);
+
+/**
+ * Applies the AES-CCM keystream to a part of a message, without authenticating it.
+ *
+ * @param p_ccm_data      Pointer to structure with the key, nonce, input, output and length of
+ *                        the part. See @ref ccm_soft_data_t.
+ * @param offset          Offset of the part in the message.
+ * @param p_keystream     Keystream position for the message, zero-initialized for a new message.
+ */
+void enc_aes_ccm_keystream_apply(const ccm_soft_data_t * const p_ccm_data,
+                                 uint16_t offset,
+                                 ccm_soft_keystream_t * p_keystream);
+
+/**
+ * Checks the AES-CCM MIC of a message that has already been decrypted with
+ * @ref enc_aes_ccm_keystream_apply.
+ *
+ * @param p_ccm_data      Pointer to structure with the decrypted message in @c p_m. See
+ *                        @ref ccm_soft_data_t.
+ * @param p_mic_passed    Pointer to bool for storing result of MIC check.
+ */
+void enc_aes_ccm_decrypted_authenticate(const ccm_soft_data_t * const p_ccm_data, bool * const p_mic_passed);
+
 
 /**
  * Utility function for generating nonce vector.
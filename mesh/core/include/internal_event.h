@@ -52,6 +52,9 @@
  * @{
  */
 
+/** Resolution of the latency reported in @ref INTERNAL_EVENT_PACKET_RELAY_LATENCY events. */
+#define INTERNAL_EVENT_RELAY_LATENCY_UNIT_US (16)
+
 /** Internal event types. */
 typedef enum
 {
@@ -67,6 +70,7 @@ typedef enum
     INTERNAL_EVENT_FM_ACTION,            /**< Flash Manager Action Completed. */
     INTERNAL_EVENT_FM_DEFRAG,            /**< Flash Manager Defrag Completed. */
     INTERNAL_EVENT_SAR_SUCCESS,          /**< SAR transaction cancelled. */
+    INTERNAL_EVENT_PACKET_RELAY_LATENCY, /**< Time from reception to TX queueing of a relayed packet, in units of @ref INTERNAL_EVENT_RELAY_LATENCY_UNIT_US. */
 
     /** @internal Largest number in the enum. */
     INTERNAL_EVENT__LAST
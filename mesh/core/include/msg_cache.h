@@ -75,6 +75,30 @@ bool msg_cache_entry_exists(uint16_t src_addr, uint32_t sequence_number);
  */
 void msg_cache_entry_add(uint16_t src, uint32_t seq);
 
+/**
+ * Check whether a network packet with the same raw contents has been received before.
+ *
+ * The packet is identified by its unobfuscated and obfuscated header fields, its last four MIC
+ * bytes and its length, which can be checked before the packet is decrypted.
+ *
+ * @param[in] p_net_packet   Encrypted network packet.
+ * @param[in] net_packet_len Length of the network packet.
+ *
+ * @return Returns @c true if the packet has been received before, or @c false otherwise.
+ */
+bool msg_cache_fingerprint_exists(const uint8_t * p_net_packet, uint32_t net_packet_len);
+
+/**
+ * Add the fingerprint of an encrypted network packet to the message cache.
+ *
+ * Should only be called for packets that were successfully decrypted and accepted by the network
+ * layer.
+ *
+ * @param[in] p_net_packet   Encrypted network packet.
+ * @param[in] net_packet_len Length of the network packet.
+ */
+void msg_cache_fingerprint_add(const uint8_t * p_net_packet, uint32_t net_packet_len);
+
 /**
  * Clears all entries from the message cache.
  */
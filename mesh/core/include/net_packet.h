@@ -97,6 +97,33 @@ uint32_t net_packet_decrypt(network_packet_metadata_t * p_net_metadata,
                         packet_mesh_net_packet_t * p_net_decrypted_packet,
                         net_packet_kind_t packet_kind);
 
+/**
+ * Decrypt and verify a network packet, starting with security material that has already been
+ * looked up for the packet's NID.
+ *
+ * Tries @p p_secmat and @p p_secmat_secondary first, and then continues with the following security
+ * materials returned by @ref nrf_mesh_net_secmat_next_get for the NID.
+ *
+ * @param[out] p_net_metadata Metadata structure to fill during decryption.
+ * @param[in] net_packet_len Length of the entire network packet.
+ * @param[in] p_net_encrypted_packet Encrypted network packet.
+ * @param[out] p_net_decrypted_packet Pointer to buffer in which the encrypted
+ *                                    packet is decrypted into.
+ * @param[in] packet_kind Kind of network packet.
+ * @param[in] p_secmat First security material matching the packet's NID, or NULL if there is none.
+ * @param[in] p_secmat_secondary Secondary security material returned with @p p_secmat, or NULL.
+ *
+ * @retval NRF_SUCCESS The packet was successfully decrypted.
+ * @retval NRF_ERROR_NOT_FOUND Couldn't find a network key to decrypt the packet.
+ */
+uint32_t net_packet_secmat_decrypt(network_packet_metadata_t * p_net_metadata,
+                                   uint32_t net_packet_len,
+                                   const packet_mesh_net_packet_t * p_net_encrypted_packet,
+                                   packet_mesh_net_packet_t * p_net_decrypted_packet,
+                                   net_packet_kind_t packet_kind,
+                                   const nrf_mesh_network_secmat_t * p_secmat,
+                                   const nrf_mesh_network_secmat_t * p_secmat_secondary);
+
 /**
  * Encrypt a network packet.
  *
@@ -110,6 +137,23 @@ void net_packet_encrypt(network_packet_metadata_t * p_net_metadata,
                         packet_mesh_net_packet_t * p_net_packet,
                         net_packet_kind_t packet_kind);
 
+/**
+ * Encrypt a decrypted network packet for relaying.
+ *
+ * Copies the header of the decrypted packet into the output packet, updating the TTL field from the
+ * metadata, and encrypts the destination and payload of the decrypted packet directly into the
+ * output packet before obfuscating its header.
+ *
+ * @param[in] p_net_metadata Metadata of the packet to relay, with the TTL of the relayed packet.
+ * @param[in] payload_len Length of the packet payload.
+ * @param[in] p_net_decrypted_packet Decrypted network packet, as returned from @ref net_packet_decrypt.
+ * @param[out] p_net_packet Network packet to encrypt into. Cannot be the same as @p p_net_decrypted_packet.
+ */
+void net_packet_relay_encrypt(const network_packet_metadata_t * p_net_metadata,
+                              uint32_t payload_len,
+                              const packet_mesh_net_packet_t * p_net_decrypted_packet,
+                              packet_mesh_net_packet_t * p_net_packet);
+
 /**
  * Populate the header of the given network packet with the given metadata.
  *
@@ -41,6 +41,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "nrf_mesh.h"
+#include "nrf_mesh_config_core.h"
 
 /**
  * @defgroup NET_STATE Network State Module
@@ -53,6 +54,13 @@
 /** Mask for the IVI field of the network packet. */
 #define NETWORK_IVI_MASK     (0x00000001)
 
+/**
+ * Largest number of sequence numbers that can be reserved in one call to
+ * @ref net_state_seqnum_reserve. Kept within the allocation threshold, so a single reservation can't
+ * skip past the point where the next sequence number block is allocated.
+ */
+#define NETWORK_SEQNUM_RESERVE_MAX (NETWORK_SEQNUM_FLASH_BLOCK_THRESHOLD)
+
 /**
  * Signals for IV update test mode.
  */
@@ -111,6 +119,39 @@ void net_state_reset(void);
  */
 uint32_t net_state_seqnum_alloc(uint32_t * p_seqnum);
 
+/**
+ * Reserves a contiguous range of network sequence numbers.
+ *
+ * Does the same checks as @ref net_state_seqnum_alloc once for the whole range, so a burst of
+ * packets, like the segments of a SAR message, can be numbered without going through them for
+ * every packet. The sequence numbers must be used right away, as any packet allocated with
+ * @ref net_state_seqnum_alloc afterwards gets a higher sequence number. Sequence numbers that end
+ * up unused should be handed back with @ref net_state_seqnum_unreserve.
+ *
+ * @param[in]  count          Number of sequence numbers to reserve.
+ * @param[out] p_first_seqnum Pointer to an integer where the first sequence number of the range is
+ *                            written.
+ *
+ * @retval NRF_SUCCESS             The sequence numbers @c p_first_seqnum to
+ *                                 <tt>p_first_seqnum + count - 1</tt> were reserved.
+ * @retval NRF_ERROR_INVALID_PARAM The count is 0 or larger than @ref NETWORK_SEQNUM_RESERVE_MAX.
+ * @retval NRF_ERROR_FORBIDDEN     There aren't enough sequence numbers available until the next
+ *                                 sequence number block is stored, or the IV index has to be
+ *                                 updated.
+ */
+uint32_t net_state_seqnum_reserve(uint32_t count, uint32_t * p_first_seqnum);
+
+/**
+ * Hands back the unused end of a range reserved with @ref net_state_seqnum_reserve.
+ *
+ * The sequence numbers are only handed back if none have been allocated since the reservation, as
+ * a sequence number can't be used again after a higher one has been sent.
+ *
+ * @param[in] first_seqnum First unused sequence number of the range.
+ * @param[in] count        Number of unused sequence numbers at the end of the range.
+ */
+void net_state_seqnum_unreserve(uint32_t first_seqnum, uint32_t count);
+
 /**
  * Sets the IV Update test mode.
  * @note Mesh Profile Specification v1.0, section 3.10.5.1 details how IV Update Test Mode works.
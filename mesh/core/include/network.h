@@ -59,8 +59,31 @@ typedef struct
 
     /** Pointer to the network data, set in the allocation. */
     uint8_t * p_payload;
+    /** Bearers the packet was allocated on, set in the allocation. */
+    core_tx_bearer_bitmap_t bearers;
 } network_tx_packet_buffer_t;
 
+/** Relay statistics of the network layer. */
+typedef struct
+{
+    /** Number of packets relayed. */
+    uint32_t relayed;
+    /** Number of packets that had to be queued because there was no TX buffer available. */
+    uint32_t no_mem;
+    /** Number of queued packets dropped for exceeding the max relay queue age. */
+    uint32_t dropped_age;
+    /** Number of queued packets dropped to make room for a more valuable packet. */
+    uint32_t dropped_evicted;
+    /** Number of packets dropped because the relay queue was full of more valuable packets. */
+    uint32_t dropped_queue_full;
+    /** Number of relayed packets with a known reception time, included in the latency counters. */
+    uint32_t latency_samples;
+    /** Sum of the time from reception to TX queueing for all latency samples, in microseconds. */
+    uint32_t latency_total_us;
+    /** Longest time from reception to TX queueing of a single relayed packet, in microseconds. */
+    uint32_t latency_max_us;
+} network_relay_stats_t;
+
 /**
  * @defgroup NETWORK Network Layer
  * @ingroup MESH_CORE
@@ -109,6 +132,18 @@ uint32_t network_opt_get(nrf_mesh_opt_id_t id, nrf_mesh_opt_t * p_opt);
  */
 uint32_t network_packet_alloc(network_tx_packet_buffer_t * p_buffer);
 
+/**
+ * Allocates a network packet like @ref network_packet_alloc, but uses the sequence number and IV
+ * index already set in the internal fields of the network metadata, instead of allocating new ones.
+ * The sequence number must have been reserved with @ref net_state_seqnum_reserve.
+ *
+ * @param[in,out] p_buffer Network packet buffer to populate. All user data must be valid.
+ *
+ * @retval NRF_SUCCESS The packet was allocated successfully.
+ * @retval NRF_ERROR_NO_MEM There wasn't enough buffer space to allocate the packet.
+ */
+uint32_t network_packet_alloc_reserved(network_tx_packet_buffer_t * p_buffer);
+
 /**
  * Sends a packet allocated through @ref network_packet_alloc. The network layer is responsible for
  * releasing the memory after use.
@@ -140,6 +175,62 @@ void network_packet_discard(const network_tx_packet_buffer_t * p_buffer);
  */
 uint32_t network_packet_in(const uint8_t * p_packet, uint32_t net_packet_len, const nrf_mesh_rx_metadata_t * p_rx_metadata);
 
+/**
+ * Screens an incoming network packet and adds it to the RX batch, to be processed by
+ * @ref network_packet_batch_in.
+ *
+ * The packet is checked without being decrypted: packets with an invalid length, packets with an
+ * unknown NID and copies of packets already in the batch are dropped. Dropped packets are kept in
+ * the batch, so that processing them returns the same error without any further work.
+ *
+ * The packet is not copied, and must stay valid until the batch is cleared with
+ * @ref network_packet_batch_clear.
+ *
+ * @param[in] p_packet Network packet to add.
+ * @param[in] net_packet_len Length of the network packet.
+ *
+ * @retval NRF_SUCCESS The packet was added to the batch.
+ * @retval NRF_ERROR_NULL The packet pointer was NULL.
+ * @retval NRF_ERROR_NO_MEM The batch is full, the packet was not screened.
+ * @retval NRF_ERROR_INVALID_LENGTH The packet length is invalid.
+ * @retval NRF_ERROR_NOT_FOUND There's no network key matching the packet's NID.
+ * @retval NRF_ERROR_INVALID_STATE The packet is a copy of a packet already in the batch.
+ */
+uint32_t network_packet_batch_add(const uint8_t * p_packet, uint32_t net_packet_len);
+
+/**
+ * Processes an incoming network packet that may have been added to the RX batch.
+ *
+ * Packets in the batch are decrypted with the security material found while screening them, and
+ * packets dropped by the screening are not processed any further. Packets that are not in the batch
+ * are processed with @ref network_packet_in.
+ *
+ * @param[in] p_packet Network packet to process.
+ * @param[in] net_packet_len Length of the network packet.
+ * @param[in] p_rx_metadata RX metadata for the packet the network packet came in.
+ *
+ * @returns The result of the screening if the packet was dropped from the batch, or the result of
+ *          @ref network_packet_in.
+ */
+uint32_t network_packet_batch_in(const uint8_t * p_packet, uint32_t net_packet_len, const nrf_mesh_rx_metadata_t * p_rx_metadata);
+
+/**
+ * Empties the RX batch. Must be called before the buffers of the packets in the batch are released.
+ */
+void network_packet_batch_clear(void);
+
+/**
+ * Gets the relay statistics of the network layer.
+ *
+ * @param[out] p_stats Statistics structure to fill.
+ */
+void network_relay_stats_get(network_relay_stats_t * p_stats);
+
+/**
+ * Resets the relay statistics of the network layer.
+ */
+void network_relay_stats_reset(void);
+
 /** @} */
 
 #endif
@@ -56,12 +56,15 @@ void replay_cache_init(void);
 /**
  * Add an element to the replay protection cache.
  *
+ * If the cache is full, the behavior is decided by @ref REPLAY_CACHE_OVERFLOW_POLICY.
+ *
  * @param[in] src   Source address.
  * @param[in] seqno Message sequence number.
  * @param[in] ivi   IV index bit.
  *
  * @retval NRF_SUCCESS      Successfully added element.
- * @retval NRF_ERROR_NO_MEM No more memory available in the cache.
+ * @retval NRF_ERROR_NO_MEM No more memory available in the cache, and the overflow policy is
+ *                          @ref REPLAY_CACHE_OVERFLOW_POLICY_REJECT.
  */
 uint32_t replay_cache_add(uint16_t src, uint32_t seqno, uint8_t ivi);
 
@@ -0,0 +1,132 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SAR_SLAB_H__
+#define SAR_SLAB_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nrf_mesh_config_core.h"
+
+/**
+ * @defgroup SAR_SLAB SAR slab allocator
+ * @ingroup MESH_CORE
+ * Fixed size buffer pool for transport SAR payloads.
+ *
+ * The pool is split into classes of 12, 48, 96, 192 and 384 byte slabs, matching the payload
+ * sizes of 1, 4, 8, 16 and 32 segment access messages. Each class keeps its own free list, so
+ * allocations and releases run in constant time, and the pool never fragments externally. A
+ * request is served by the smallest class that fits it, or by the next larger class if that one is
+ * exhausted.
+ *
+ * The functions match @ref transport_sar_alloc_t and @ref transport_sar_release_t. The transport
+ * layer uses them by default if @ref TRANSPORT_SAR_SLAB_ALLOCATOR is set, and they can otherwise be
+ * passed to @ref transport_sar_mem_funcs_set() after calling @ref sar_slab_init().
+ * @{
+ */
+
+/** Number of slab size classes. */
+#define SAR_SLAB_CLASS_COUNT (5)
+
+/** Size of the largest slabs, in bytes. */
+#define SAR_SLAB_SIZE_MAX (384)
+
+/** Usage statistics of a single slab size class. */
+typedef struct
+{
+    uint16_t size;        /**< Size of each slab in the class, in bytes. */
+    uint16_t count;       /**< Number of slabs in the class. */
+    uint16_t in_use;      /**< Number of slabs currently allocated. */
+    uint16_t in_use_peak; /**< Highest number of slabs allocated at the same time. */
+    uint32_t allocs;      /**< Number of allocations served by the class. */
+    uint32_t spills;      /**< Number of those allocations that fit a smaller, exhausted class. */
+} sar_slab_class_stats_t;
+
+/**
+ * Usage statistics of the SAR slab allocator.
+ *
+ * The difference between @c reserved_bytes and @c requested_bytes is the internal fragmentation of
+ * the pool: memory that is allocated, but not used by anyone.
+ */
+typedef struct
+{
+    sar_slab_class_stats_t classes[SAR_SLAB_CLASS_COUNT]; /**< Statistics for each class, smallest first. */
+    uint32_t requested_bytes;      /**< Number of bytes currently requested by the users of the pool. */
+    uint32_t reserved_bytes;       /**< Number of bytes in the slabs currently allocated. */
+    uint32_t reserved_bytes_peak;  /**< Highest value of @c reserved_bytes. */
+    uint32_t alloc_failures;       /**< Number of allocations that could not be served. */
+} sar_slab_stats_t;
+
+/**
+ * Initializes the SAR slab allocator, marking all slabs as free and resetting the statistics.
+ *
+ * @warning All buffers allocated before the call must be considered lost.
+ */
+void sar_slab_init(void);
+
+/**
+ * Allocates a buffer from the SAR slab pool.
+ *
+ * @param[in] size Number of bytes to allocate.
+ *
+ * @returns A pointer to a word aligned buffer of at least @p size bytes, or @c NULL if @p size is 0,
+ *          larger than @ref SAR_SLAB_SIZE_MAX, or no fitting slab is free.
+ */
+void * sar_slab_alloc(size_t size);
+
+/**
+ * Releases a buffer allocated with @ref sar_slab_alloc().
+ *
+ * @param[in] p_buffer Buffer to release. Releasing @c NULL has no effect.
+ */
+void sar_slab_release(void * p_buffer);
+
+/**
+ * Gets the usage statistics of the SAR slab allocator.
+ *
+ * @param[out] p_stats Statistics structure to fill.
+ */
+void sar_slab_stats_get(sar_slab_stats_t * p_stats);
+
+/**
+ * Resets the peak values and counters of the statistics. The current usage values are kept.
+ */
+void sar_slab_stats_reset(void);
+
+/** @} */
+
+#endif /* SAR_SLAB_H__ */
@@ -78,6 +78,15 @@
 /** Default number of retries before cancelling SAR TX session. */
 #define TRANSPORT_SAR_TX_RETRIES_DEFAULT (4)
 
+/** Lower limit for the TX retry timeout in adaptive retransmission mode. */
+#define TRANSPORT_SAR_TX_RETRY_ADAPTIVE_MIN_US MS_TO_US(200)
+
+/** Upper limit for the TX retry timeout in adaptive retransmission mode. */
+#define TRANSPORT_SAR_TX_RETRY_ADAPTIVE_MAX_US SEC_TO_US(4)
+
+/** Default time window for suppressing segment acknowledgments without new segments. */
+#define TRANSPORT_SAR_SEGACK_COALESCE_WINDOW_DEFAULT_US MS_TO_US(100)
+
 /** Maximum number of control packet consumers. */
 #define TRANSPORT_CONTROL_PACKET_CONSUMERS_MAX   (1)
 
@@ -124,6 +133,19 @@ typedef struct
     uint8_t ttl; /**< TTL value for the control packet. This is a 7 bit value. */
 } transport_control_packet_t;
 
+/**
+ * Pre-built transmit parameters for a periodic, unsegmented control message.
+ *
+ * Built once with @ref transport_control_tx_template_init, and reused for every message with the
+ * same opcode, addressing and length, such as periodic heartbeats.
+ */
+typedef struct
+{
+    network_packet_metadata_t net; /**< Network metadata, with the destination address resolved. */
+    uint8_t header; /**< Lower transport PDU header. */
+    uint8_t data_len; /**< Length of the control packet data. */
+} transport_control_tx_template_t;
+
 /**
  * Control packet handler callback function.
  *
@@ -169,7 +191,8 @@ void transport_init(const nrf_mesh_init_params_t * p_init_params);
 
 /**
  * Set the SAR buffer allocation and release functions. Defaults to stdlib's
- * malloc and free. The transport layer has to allocate a temporary buffer
+ * malloc and free, or to the @ref SAR_SLAB functions if
+ * @ref TRANSPORT_SAR_SLAB_ALLOCATOR is set. The transport layer has to allocate a temporary buffer
  * for transport packets that span multiple network packets, in order to put
  * them together (RX) or split them (TX). The transport module takes no
  * precautions to prevent overlapping memory regions for different buffers,
@@ -189,7 +212,8 @@ void transport_init(const nrf_mesh_init_params_t * p_init_params);
 uint32_t transport_sar_mem_funcs_set(transport_sar_alloc_t alloc_func, transport_sar_release_t release_func);
 
 /**
- * Reset the SAR buffer allocation and release functions to malloc and free.
+ * Reset the SAR buffer allocation and release functions to their defaults: malloc and free, or
+ * @ref sar_slab_alloc and @ref sar_slab_release if @ref TRANSPORT_SAR_SLAB_ALLOCATOR is set.
  */
 void transport_sar_mem_funcs_reset(void);
 /**
@@ -267,6 +291,42 @@ uint32_t transport_tx(const nrf_mesh_tx_params_t * p_params, uint32_t * const p_
 uint32_t transport_control_tx(const transport_control_packet_t * p_params,
                               nrf_mesh_tx_token_t tx_token);
 
+/**
+ * Build a transmit template for an unsegmented control message.
+ *
+ * The parameters are validated and the transport header and network metadata are built once, so
+ * that @ref transport_control_tx_template_send only has to copy the payload. The template must be
+ * rebuilt if any of the parameters change. The contents of @p p_params->p_data are not stored.
+ *
+ * @param[out] p_template Template to build.
+ * @param[in]  p_params   Transport control packet parameters.
+ *
+ * @retval NRF_SUCCESS              The template was successfully built.
+ * @retval NRF_ERROR_NULL           Null-pointer supplied.
+ * @retval NRF_ERROR_INVALID_ADDR   Invalid address supplied.
+ * @retval NRF_ERROR_INVALID_LENGTH The packet would have to be segmented.
+ * @retval NRF_ERROR_INVALID_PARAM  One or more of the given parameters are out of bounds, or the
+ *                                  packet is reliable.
+ */
+uint32_t transport_control_tx_template_init(transport_control_tx_template_t * p_template,
+                                            const transport_control_packet_t * p_params);
+
+/**
+ * Transmit a control message from a template built with @ref transport_control_tx_template_init.
+ *
+ * @param[in] p_template Transmit template.
+ * @param[in] p_data     Control packet data, of the length given when building the template.
+ * @param[in] tx_token   Token to use in the TX complete event.
+ *
+ * @retval NRF_SUCCESS     The packet was successfully queued for transmission.
+ * @retval NRF_ERROR_NULL  Null-pointer supplied.
+ * @retval NRF_ERROR_NO_MEM Insufficient amount of available memory.
+ * @retval NRF_ERROR_FORBIDDEN Failed to allocate a sequence number from network.
+ */
+uint32_t transport_control_tx_template_send(const transport_control_tx_template_t * p_template,
+                                            const packet_mesh_trs_control_packet_t * p_data,
+                                            nrf_mesh_tx_token_t tx_token);
+
 /**
  * Set transport layer options.
  *
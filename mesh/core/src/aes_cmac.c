@@ -60,13 +60,13 @@ static void my_xor(uint8_t * p_dst, const uint8_t * p_src1, const uint8_t * p_sr
 }
 
 
-void aes_cmac_subkey_generate(const uint8_t * const p_key, uint8_t * p_subkey1_out, uint8_t * p_subkey2_out)
+static void subkey_generate(const aes_ctx_t * p_ctx, uint8_t * p_subkey1_out, uint8_t * p_subkey2_out)
 {
     static const uint8_t Rb[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x87};
 
     memset(m_128buf, 0x00, sizeof(m_128buf));
 
-    aes_encrypt(p_key, m_128buf, m_128buf);
+    aes_ctx_encrypt(p_ctx, m_128buf, m_128buf);
 
     /* Calculate K1 */
     if ((m_128buf[0] & 0x80) == 0)
@@ -91,6 +91,12 @@ void aes_cmac_subkey_generate(const uint8_t * const p_key, uint8_t * p_subkey1_o
     }
 }
 
+void aes_cmac_subkey_generate(const uint8_t * const p_key, uint8_t * p_subkey1_out, uint8_t * p_subkey2_out)
+{
+    aes_ctx_t ctx;
+    aes_ctx_init(&ctx, p_key);
+    subkey_generate(&ctx, p_subkey1_out, p_subkey2_out);
+}
 
 void aes_cmac(const uint8_t * const p_key, const uint8_t * const p_msg, uint16_t msg_len, uint8_t * const p_out)
 {
@@ -98,7 +104,11 @@ void aes_cmac(const uint8_t * const p_key, const uint8_t * const p_msg, uint16_t
 
     //__LOG_XB(LOG_SRC_ENC, LOG_LEVEL_INFO, "CMAC Key", p_key, 16);
 
-    aes_cmac_subkey_generate(p_key, m_subkey1, m_subkey2);
+    /* All blocks are encrypted with the same key, only expand it once. */
+    aes_ctx_t ctx;
+    aes_ctx_init(&ctx, p_key);
+
+    subkey_generate(&ctx, m_subkey1, m_subkey2);
 
     /* First X is zero */
     memset(m_128buf, 0x00, sizeof(m_128buf));
@@ -128,10 +138,10 @@ void aes_cmac(const uint8_t * const p_key, const uint8_t * const p_msg, uint16_t
         /* Y := X XOR M_i     */
         /* X := AES-128(K, Y) */
         utils_xor(m_128buf, m_128buf, &p_msg[i*16], sizeof(m_128buf));
-        aes_encrypt(p_key, m_128buf, m_128buf);
+        aes_ctx_encrypt(&ctx, m_128buf, m_128buf);
     }
 
 
     my_xor(m_128buf, last, m_128buf, 16);
-    aes_encrypt(p_key, m_128buf, p_out);
+    aes_ctx_encrypt(&ctx, m_128buf, p_out);
 }
@@ -45,7 +45,7 @@
 
 #define L_LEN CCM_LENGTH_FIELD_LENGTH
 
-static void ccm_soft_authenticate_blocks(const uint8_t * p_key,
+static void ccm_soft_authenticate_blocks(const aes_ctx_t * p_ctx,
                                          const uint8_t * p_data,
                                          uint16_t data_size,
                                          uint8_t B[16],
@@ -71,16 +71,13 @@ static void ccm_soft_authenticate_blocks(const uint8_t * p_key,
 
         utils_xor(B, X, B, 16);
 
-        aes_encrypt(p_key, B, X);
+        aes_ctx_encrypt(p_ctx, B, X);
     }
 }
 
-static void ccm_soft_authenticate(const ccm_soft_data_t * p_data, uint8_t T[])
+/* Starts the CBC-MAC by authenticating the B0 block and the additional data into X. */
+static void ccm_soft_authenticate_header(const aes_ctx_t * p_ctx, const ccm_soft_data_t * p_data, uint8_t B[16], uint8_t X[16])
 {
-
-    uint8_t B[16];
-    uint8_t X[16];
-
     B[0] = (
         ((p_data->a_len > 0 ? 1 : 0) << 6)        |
         ((((p_data->mic_len - 2)/2) & 0x07) << 3) |
@@ -89,20 +86,38 @@ static void ccm_soft_authenticate(const ccm_soft_data_t * p_data, uint8_t T[])
     memcpy(&B[1], p_data->p_nonce, (15 - L_LEN));
     utils_reverse_memcpy(&B[16-L_LEN], (uint8_t *) &p_data->m_len, L_LEN);
 
-    aes_encrypt(p_data->p_key, B, X);
+    aes_ctx_encrypt(p_ctx, B, X);
 
     if (p_data->a_len > 0)
     {
         utils_reverse_memcpy(&B[0], (uint8_t*) &p_data->a_len, 2);
-        ccm_soft_authenticate_blocks(p_data->p_key, p_data->p_a, p_data->a_len, B, 2, X);
+        ccm_soft_authenticate_blocks(p_ctx, p_data->p_a, p_data->a_len, B, 2, X);
     }
+}
 
-    ccm_soft_authenticate_blocks(p_data->p_key, p_data->p_m, p_data->m_len, B, 0, X);
+static void ccm_soft_authenticate(const aes_ctx_t * p_ctx, const ccm_soft_data_t * p_data, uint8_t T[])
+{
+    uint8_t B[16];
+    uint8_t X[16];
+
+    ccm_soft_authenticate_header(p_ctx, p_data, B, X);
+    ccm_soft_authenticate_blocks(p_ctx, p_data->p_m, p_data->m_len, B, 0, X);
 
     memcpy(T, X, p_data->mic_len);
 }
 
-static void ccm_soft_crypt(const ccm_soft_data_t * p_data, uint8_t * A, uint8_t * S, uint16_t i)
+/* Compares two MICs in constant time, to avoid leaking how much of a forged MIC was correct. */
+static bool ccm_soft_mic_equal(const uint8_t * p_mic1, const uint8_t * p_mic2, uint8_t mic_len)
+{
+    uint8_t diff = 0;
+    for (uint8_t i = 0; i < mic_len; i++)
+    {
+        diff |= p_mic1[i] ^ p_mic2[i];
+    }
+    return (diff == 0);
+}
+
+static void ccm_soft_crypt(const aes_ctx_t * p_ctx, const ccm_soft_data_t * p_data, uint8_t * A, uint8_t * S, uint16_t i)
 {
     uint16_t octets_m = p_data->m_len;
 
@@ -111,7 +126,7 @@ static void ccm_soft_crypt(const ccm_soft_data_t * p_data, uint8_t * A, uint8_t
         i++;
 
         utils_reverse_memcpy(&A[16-L_LEN], (uint8_t *) &i, L_LEN);
-        aes_encrypt(p_data->p_key, A, S);
+        aes_ctx_encrypt(p_ctx, A, S);
 
         if (octets_m < 16)
         {
@@ -137,18 +152,22 @@ void ccm_soft_encrypt(ccm_soft_data_t * p_data)
 
     uint16_t i = 0;
 
-    ccm_soft_authenticate(p_data, T);
+    /* All blocks are encrypted with the same key, only expand it once. */
+    aes_ctx_t ctx;
+    aes_ctx_init(&ctx, p_data->p_key);
+
+    ccm_soft_authenticate(&ctx, p_data, T);
 
     A[0] = ((L_LEN - 1) & 0x07);
 
     memcpy(&A[1], p_data->p_nonce, (15 - L_LEN));
     utils_reverse_memcpy(&A[16 - L_LEN], (uint8_t *) &i, L_LEN);
 
-    aes_encrypt(p_data->p_key, A, S);
+    aes_ctx_encrypt(&ctx, A, S);
 
     utils_xor(p_data->p_mic, T, S, p_data->mic_len);
 
-    ccm_soft_crypt(p_data, A, S, i);
+    ccm_soft_crypt(&ctx, p_data, A, S, i);
 
 #if CCM_DEBUG_MODE_ENABLED
     __LOG_XB(LOG_SRC_CCM, LOG_LEVEL_INFO, "ccm_soft_encrypt: OUT", p_data->p_out, p_data->m_len);
@@ -164,62 +183,154 @@ void ccm_soft_decrypt(ccm_soft_data_t * p_data, bool * p_mic_passed)
 
     uint8_t A[16];
     uint8_t S[16];
-    uint8_t T[p_data->mic_len];
+    uint8_t B[16];
+    uint8_t X[16];
     uint16_t i = 0;
 
-    /* Recreate block ciphers. */
-    A[0] = ((L_LEN - 1) & 0x07);
+    aes_ctx_t ctx;
+    aes_ctx_init(&ctx, p_data->p_key);
 
-    memcpy(&A[1], p_data->p_nonce, (15 - L_LEN));
-    utils_reverse_memcpy(&A[16 - L_LEN], (uint8_t *) &i, L_LEN);
-
-    aes_encrypt(p_data->p_key, A, S);
+    ccm_soft_authenticate_header(&ctx, p_data, B, X);
 
-    utils_xor(S, p_data->p_mic, S, p_data->mic_len);
+    A[0] = ((L_LEN - 1) & 0x07);
+    memcpy(&A[1], p_data->p_nonce, (15 - L_LEN));
 
-    /* Try to decrypt data with ciphers. */
-    ccm_soft_crypt(p_data, A, S, i);
+    /* Decrypt and authenticate in a single pass, so that each block of plaintext is added to the
+     * MAC right after it has been decrypted. */
+    uint16_t offset = 0;
+    while (offset < p_data->m_len)
+    {
+        i++;
+        utils_reverse_memcpy(&A[16 - L_LEN], (uint8_t *) &i, L_LEN);
+        aes_ctx_encrypt(&ctx, A, S);
 
+        uint16_t block_len = p_data->m_len - offset;
+        if (block_len > 16)
+        {
+            block_len = 16;
+        }
 
-    /* Authenticate data */
-    ccm_soft_data_t auth_data;
-    uint8_t mic[p_data->mic_len];
+        utils_xor(p_data->p_out + offset, p_data->p_m + offset, S, block_len);
 
-    auth_data.p_key   = p_data->p_key;
-    auth_data.p_nonce = p_data->p_nonce;
-    auth_data.p_m     = p_data->p_out;
-    auth_data.m_len   = p_data->m_len;
-    auth_data.p_a     = p_data->p_a;
-    auth_data.a_len   = p_data->a_len;
-    auth_data.p_mic   = mic;
-    auth_data.p_out   = NULL;
-    auth_data.mic_len = p_data->mic_len;
+        /* The block is zero padded, which leaves the rest of X unchanged. */
+        utils_xor(X, X, p_data->p_out + offset, block_len);
+        aes_ctx_encrypt(&ctx, X, X);
 
-    ccm_soft_authenticate(&auth_data, T);
+        offset += block_len;
+    }
 
     /* Generate MIC */
     i = 0;
-    A[0] = ((L_LEN - 1) & 0x07);
-
-    memcpy(&A[1], p_data->p_nonce, (15 - L_LEN));
     utils_reverse_memcpy(&A[16 - L_LEN], (uint8_t *) &i, L_LEN);
+    aes_ctx_encrypt(&ctx, A, S);
 
-    aes_encrypt(p_data->p_key, A, S);
-
-    utils_xor(mic, T, S, p_data->mic_len);
+    utils_xor(X, X, S, p_data->mic_len);
 
 #if CCM_DEBUG_MODE_ENABLED
     __LOG_XB(LOG_SRC_CCM, LOG_LEVEL_INFO, "ccm_soft_decrypt: OUT", p_data->p_out, p_data->m_len);
-    __LOG_XB(LOG_SRC_CCM, LOG_LEVEL_INFO, "ccm_soft_decrypt: MIC", mic, p_data->mic_len);
+    __LOG_XB(LOG_SRC_CCM, LOG_LEVEL_INFO, "ccm_soft_decrypt: MIC", X, p_data->mic_len);
 #endif
 
-    *p_mic_passed = memcmp(mic, p_data->p_mic, p_data->mic_len) == 0;
+    *p_mic_passed = ccm_soft_mic_equal(X, p_data->p_mic, p_data->mic_len);
 #if CCM_DEBUG_MODE_ENABLED
     if (!*p_mic_passed)
     {
         /* No MIC match. */
         __LOG_XB(LOG_SRC_CCM, LOG_LEVEL_INFO, "ccm_soft_decrypt: mic_in", p_data->p_mic, p_data->mic_len);
-        __LOG_XB(LOG_SRC_CCM, LOG_LEVEL_INFO, "ccm_soft_decrypt: mic_out", mic, p_data->mic_len);
+        __LOG_XB(LOG_SRC_CCM, LOG_LEVEL_INFO, "ccm_soft_decrypt: mic_out", X, p_data->mic_len);
     }
 #endif
 }
+
+uint32_t ccm_soft_decrypt_ad_candidates(ccm_soft_data_t * p_data, const uint8_t * const * pp_a, uint32_t a_count)
+{
+    uint8_t A[16];
+    uint8_t S[16];
+    uint8_t S0[16];
+    uint8_t T[16];
+    uint16_t i = 0;
+
+    aes_ctx_t ctx;
+    aes_ctx_init(&ctx, p_data->p_key);
+
+    A[0] = ((L_LEN - 1) & 0x07);
+    memcpy(&A[1], p_data->p_nonce, (15 - L_LEN));
+    utils_reverse_memcpy(&A[16 - L_LEN], (uint8_t *) &i, L_LEN);
+    aes_ctx_encrypt(&ctx, A, S0);
+
+    ccm_soft_crypt(&ctx, p_data, A, S, i);
+
+    /* Authenticate the decrypted message with each candidate: */
+    ccm_soft_data_t auth_data = *p_data;
+    auth_data.p_m = p_data->p_out;
+    for (uint32_t candidate = 0; candidate < a_count; candidate++)
+    {
+        auth_data.p_a = pp_a[candidate];
+        ccm_soft_authenticate(&ctx, &auth_data, T);
+        utils_xor(T, T, S0, p_data->mic_len);
+
+        if (ccm_soft_mic_equal(T, p_data->p_mic, p_data->mic_len))
+        {
+            return candidate;
+        }
+    }
+    return a_count;
+}
+
+void ccm_soft_keystream_apply(const ccm_soft_data_t * p_data, uint16_t offset, ccm_soft_keystream_t * p_keystream)
+{
+    uint8_t A[16];
+    aes_ctx_t ctx;
+    bool ctx_ready = false;
+
+    A[0] = ((L_LEN - 1) & 0x07);
+    memcpy(&A[1], p_data->p_nonce, (15 - L_LEN));
+
+    uint16_t done = 0;
+    while (done < p_data->m_len)
+    {
+        /* Keystream block 0 is reserved for the MIC. */
+        uint16_t counter = (offset + done) / 16 + 1;
+        uint16_t block_offset = (offset + done) % 16;
+        if (p_keystream->counter != counter)
+        {
+            if (!ctx_ready)
+            {
+                aes_ctx_init(&ctx, p_data->p_key);
+                ctx_ready = true;
+            }
+            utils_reverse_memcpy(&A[16 - L_LEN], (uint8_t *) &counter, L_LEN);
+            aes_ctx_encrypt(&ctx, A, p_keystream->block);
+            p_keystream->counter = counter;
+        }
+
+        uint16_t len = 16 - block_offset;
+        if (len > p_data->m_len - done)
+        {
+            len = p_data->m_len - done;
+        }
+        utils_xor(p_data->p_out + done, p_data->p_m + done, &p_keystream->block[block_offset], len);
+        done += len;
+    }
+}
+
+void ccm_soft_decrypted_authenticate(const ccm_soft_data_t * p_data, bool * p_mic_passed)
+{
+    uint8_t A[16];
+    uint8_t S0[16];
+    uint8_t T[16];
+    uint16_t i = 0;
+
+    aes_ctx_t ctx;
+    aes_ctx_init(&ctx, p_data->p_key);
+
+    ccm_soft_authenticate(&ctx, p_data, T);
+
+    A[0] = ((L_LEN - 1) & 0x07);
+    memcpy(&A[1], p_data->p_nonce, (15 - L_LEN));
+    utils_reverse_memcpy(&A[16 - L_LEN], (uint8_t *) &i, L_LEN);
+    aes_ctx_encrypt(&ctx, A, S0);
+    utils_xor(T, T, S0, p_data->mic_len);
+
+    *p_mic_passed = ccm_soft_mic_equal(T, p_data->p_mic, p_data->mic_len);
+}
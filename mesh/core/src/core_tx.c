@@ -47,6 +47,7 @@ NRF_MESH_STATIC_ASSERT(sizeof(core_tx_bearer_bitmap_t) * 8 >= CORE_TX_BEARER_COU
 *****************************************************************************/
 
 static core_tx_complete_cb_t m_tx_complete_callback;
+static core_tx_complete_cb_t m_relay_tx_complete_callback;
 
 /** Linked list of all registered bearers. */
 static list_node_t * mp_bearers;
@@ -97,6 +98,11 @@ void core_tx_complete_cb_set(core_tx_complete_cb_t tx_complete_callback)
     m_tx_complete_callback = tx_complete_callback;
 }
 
+void core_tx_relay_complete_cb_set(core_tx_complete_cb_t tx_complete_callback)
+{
+    m_relay_tx_complete_callback = tx_complete_callback;
+}
+
 core_tx_bearer_bitmap_t core_tx_packet_alloc(const core_tx_alloc_params_t * p_params, uint8_t ** pp_packet)
 {
     NRF_MESH_ASSERT(p_params != NULL);
@@ -192,7 +198,11 @@ void core_tx_complete(core_tx_bearer_t * p_bearer,
 {
     NRF_MESH_ASSERT(p_bearer);
 
-    if (m_tx_complete_callback)
+    if (role == CORE_TX_ROLE_RELAY && m_relay_tx_complete_callback)
+    {
+        m_relay_tx_complete_callback(role, p_bearer->bearer_index, timestamp, token);
+    }
+    else if (m_tx_complete_callback)
     {
         m_tx_complete_callback(role, p_bearer->bearer_index, timestamp, token);
     }
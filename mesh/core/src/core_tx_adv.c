@@ -138,7 +138,7 @@ void core_tx_adv_init(void)
 
     m_bearer_roles[CORE_TX_ROLE_RELAY].adv_tx_count = CORE_TX_REPEAT_RELAY_DEFAULT;
     advertiser_instance_init(&m_bearer_roles[CORE_TX_ROLE_RELAY].advertiser,
-                             NULL,
+                             adv_tx_complete_callback,
                              m_relay_adv_packet_buffer,
                              sizeof(m_relay_adv_packet_buffer));
     advertiser_enable(&m_bearer_roles[CORE_TX_ROLE_RELAY].advertiser);
@@ -87,6 +87,25 @@ void enc_aes_ccm_decrypt(ccm_soft_data_t * const p_ccm_data, bool * const p_mic_
     ccm_soft_decrypt(p_ccm_data, p_mic_passed);
 }
 
+uint32_t enc_aes_ccm_decrypt_ad_candidates(ccm_soft_data_t * const p_ccm_data,
+                                           const uint8_t * const * pp_a,
+                                           uint32_t a_count)
+{
+    return ccm_soft_decrypt_ad_candidates(p_ccm_data, pp_a, a_count);
+}
+
+void enc_aes_ccm_keystream_apply(const ccm_soft_data_t * const p_ccm_data,
+                                 uint16_t offset,
+                                 ccm_soft_keystream_t * p_keystream)
+{
+    ccm_soft_keystream_apply(p_ccm_data, offset, p_keystream);
+}
+
+void enc_aes_ccm_decrypted_authenticate(const ccm_soft_data_t * const p_ccm_data, bool * const p_mic_passed)
+{
+    ccm_soft_decrypted_authenticate(p_ccm_data, p_mic_passed);
+}
+
 
 /*********************/
 /* Utility functions */
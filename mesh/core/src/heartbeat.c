@@ -94,6 +94,10 @@ static timer_event_t m_subscription_timer;
 /** Handle core events here */
 static nrf_mesh_evt_handler_t m_hb_core_evt_handler;
 
+/** Transmit template for heartbeat messages, rebuilt when the publication parameters change. */
+static transport_control_tx_template_t m_hb_tx_template;
+static bool m_hb_tx_template_valid;
+
 /** Forward declarations */
 static uint32_t heartbeat_send(heartbeat_publication_information_t * p_hb_pub_info);
 static void heartbeat_subscription_timer_cb(timestamp_t timestamp, void * p_context);
@@ -211,6 +215,16 @@ static void heartbeat_meta_prepare(transport_control_packet_t *             p_tx
     p_tx->ttl          = p_pub_info->p_publication->ttl;
 }
 
+/** Checks whether the transmit template was built for the given publication parameters */
+static bool heartbeat_tx_template_is_current(const heartbeat_publication_information_t * p_pub_info)
+{
+    return (m_hb_tx_template_valid &&
+            m_hb_tx_template.net.src                 == p_pub_info->local_address &&
+            m_hb_tx_template.net.dst.value           == p_pub_info->p_publication->dst &&
+            m_hb_tx_template.net.ttl                 == p_pub_info->p_publication->ttl &&
+            m_hb_tx_template.net.p_security_material == p_pub_info->p_net_secmat);
+}
+
 /** Sends a heartbeat message when timer expires or when triggered */
 static uint32_t heartbeat_send(heartbeat_publication_information_t * p_hb_pub_info)
 {
@@ -252,9 +266,20 @@ static uint32_t heartbeat_send(heartbeat_publication_information_t * p_hb_pub_in
     packet_mesh_trs_control_heartbeat_init_ttl_set(&hb_pdu, p_hb_pub_info->p_publication->ttl);
     packet_mesh_trs_control_heartbeat_features_set(&hb_pdu, active_features);
 
-    heartbeat_meta_prepare(&tx_params, &hb_pdu, PACKET_MESH_TRS_CONTROL_HEARTBEAT_SIZE, p_hb_pub_info);
+    if (!heartbeat_tx_template_is_current(p_hb_pub_info))
+    {
+        heartbeat_meta_prepare(&tx_params, &hb_pdu, PACKET_MESH_TRS_CONTROL_HEARTBEAT_SIZE, p_hb_pub_info);
+
+        uint32_t status = transport_control_tx_template_init(&m_hb_tx_template, &tx_params);
+        m_hb_tx_template_valid = (status == NRF_SUCCESS);
+        if (status != NRF_SUCCESS)
+        {
+            return status;
+        }
+    }
 
-    return (transport_control_tx(&tx_params, (nrf_mesh_tx_token_t) p_hb_pub_info->p_publication->count));
+    return (transport_control_tx_template_send(&m_hb_tx_template, &hb_pdu,
+                                               (nrf_mesh_tx_token_t) p_hb_pub_info->p_publication->count));
 }
 
 /** Callback for the subscription timer. this callback triggers every second. As per
@@ -389,6 +414,7 @@ void heartbeat_init(void)
     NRF_MESH_ASSERT(transport_control_packet_consumer_add(&cp_handler, 1) == NRF_SUCCESS);
 
     m_hb_pending_pub_msg = false;
+    m_hb_tx_template_valid = false;
 
     // Initialize timer event structures
     m_publication_timer.timer.cb = heartbeat_publication_timer_cb;
@@ -35,13 +35,50 @@
  * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <stdbool.h>
+#include <string.h>
 
 #include "msg_cache.h"
 #include "transport.h"
+#include "packet_mesh.h"
 #include "nrf_error.h"
+#include "nrf_mesh_assert.h"
 
 #include "log.h"
 
+/*****************************************************************************
+* Local defines
+*****************************************************************************/
+NRF_MESH_STATIC_ASSERT(MSG_CACHE_FINGERPRINT_COUNT > 0);
+
+/** Number of packet header bytes in a fingerprint: IVI, NID, and the obfuscated CTL, TTL, SEQ and SRC. */
+#define FINGERPRINT_HEADER_SIZE (PACKET_MESH_NET_DST0_OFFSET)
+/** Number of bytes from the end of the packet in a fingerprint, covered by the MIC of any packet. */
+#define FINGERPRINT_MIC_SIZE    (4)
+/** Shortest packet with both the header and the MIC bytes of a fingerprint. */
+#define FINGERPRINT_PACKET_LEN_MIN (PACKET_MESH_NET_PDU_OFFSET + FINGERPRINT_MIC_SIZE)
+
+#if MSG_CACHE_HASH_INDEX_ENABLE
+NRF_MESH_STATIC_ASSERT(MSG_CACHE_ENTRY_COUNT < 0x8000);
+NRF_MESH_STATIC_ASSERT(MSG_CACHE_FINGERPRINT_COUNT < 0x8000);
+
+/* Round twice the entry count up to the nearest power of two, to keep the load factor of a hash
+ * index at or below 50 %. */
+#define HASH_INDEX_BITS_SPREAD(x, shift) ((x) | ((x) >> (shift)))
+#define HASH_INDEX_SIZE_GET(count)                                                                 \
+    (HASH_INDEX_BITS_SPREAD(HASH_INDEX_BITS_SPREAD(HASH_INDEX_BITS_SPREAD(HASH_INDEX_BITS_SPREAD(  \
+        2 * (count) - 1, 1), 2), 4), 8) + 1)
+/** Number of slots in the hash index of the message cache. */
+#define HASH_INDEX_SIZE     HASH_INDEX_SIZE_GET(MSG_CACHE_ENTRY_COUNT)
+/** Mask for wrapping hash index slot numbers. */
+#define HASH_INDEX_MASK     (HASH_INDEX_SIZE - 1)
+/** Number of slots in the hash index of the fingerprints. */
+#define FINGERPRINT_INDEX_SIZE HASH_INDEX_SIZE_GET(MSG_CACHE_FINGERPRINT_COUNT)
+/** Mask for wrapping fingerprint index slot numbers. */
+#define FINGERPRINT_INDEX_MASK (FINGERPRINT_INDEX_SIZE - 1)
+/** Value of unused hash index slots. */
+#define HASH_INDEX_EMPTY    (0xFFFF)
+#endif
+
 /*****************************************************************************
 * Local type definitions
 *****************************************************************************/
@@ -53,6 +90,15 @@ typedef struct
     uint32_t seq;    /**< Sequence number from the packet header. */
 } msg_cache_entry_t;
 
+/** Raw packet contents identifying an encrypted network packet. */
+typedef struct
+{
+    uint32_t hash;                                /**< Hash of the other fields, checked first. */
+    uint8_t length;                               /**< Length of the network packet, or 0 if unused. */
+    uint8_t header[FINGERPRINT_HEADER_SIZE];      /**< Header bytes up to the DST field. */
+    uint8_t mic[FINGERPRINT_MIC_SIZE];            /**< Last bytes of the packet. */
+} msg_cache_fingerprint_t;
+
 /*****************************************************************************
 * Static globals
 *****************************************************************************/
@@ -62,6 +108,160 @@ static msg_cache_entry_t m_msg_cache[MSG_CACHE_ENTRY_COUNT];
 /** Message cache head index */
 static uint32_t m_msg_cache_head = 0;
 
+/** Fingerprints of the most recently decrypted packets. */
+static msg_cache_fingerprint_t m_fingerprints[MSG_CACHE_FINGERPRINT_COUNT];
+
+/** Fingerprint to overwrite next. */
+static uint32_t m_fingerprint_head = 0;
+
+#if MSG_CACHE_HASH_INDEX_ENABLE
+/** Open addressed hash index of the message cache, containing indexes into @ref m_msg_cache. */
+static uint16_t m_hash_index[HASH_INDEX_SIZE];
+
+/** Open addressed hash index of the fingerprints, containing indexes into @ref m_fingerprints. */
+static uint16_t m_fingerprint_index[FINGERPRINT_INDEX_SIZE];
+#endif
+
+/*****************************************************************************
+* Static functions
+*****************************************************************************/
+static bool fingerprint_get(const uint8_t * p_net_packet, uint32_t net_packet_len, msg_cache_fingerprint_t * p_fingerprint)
+{
+    if (net_packet_len < FINGERPRINT_PACKET_LEN_MIN || net_packet_len > PACKET_MESH_NET_MAX_SIZE)
+    {
+        return false;
+    }
+
+    p_fingerprint->length = (uint8_t) net_packet_len;
+    memcpy(p_fingerprint->header, p_net_packet, FINGERPRINT_HEADER_SIZE);
+    memcpy(p_fingerprint->mic, &p_net_packet[net_packet_len - FINGERPRINT_MIC_SIZE], FINGERPRINT_MIC_SIZE);
+
+    /* FNV-1a, the fields are mostly ciphertext already, so it only needs to fold them together. */
+    uint32_t hash = 2166136261u ^ net_packet_len;
+    for (uint32_t i = 0; i < FINGERPRINT_HEADER_SIZE; ++i)
+    {
+        hash = (hash ^ p_fingerprint->header[i]) * 16777619u;
+    }
+    for (uint32_t i = 0; i < FINGERPRINT_MIC_SIZE; ++i)
+    {
+        hash = (hash ^ p_fingerprint->mic[i]) * 16777619u;
+    }
+    p_fingerprint->hash = hash;
+    return true;
+}
+
+static inline bool fingerprint_equal(const msg_cache_fingerprint_t * p_a, const msg_cache_fingerprint_t * p_b)
+{
+    return (p_a->hash == p_b->hash &&
+            p_a->length == p_b->length &&
+            memcmp(p_a->header, p_b->header, FINGERPRINT_HEADER_SIZE) == 0 &&
+            memcmp(p_a->mic, p_b->mic, FINGERPRINT_MIC_SIZE) == 0);
+}
+
+#if MSG_CACHE_HASH_INDEX_ENABLE
+/** Function returning the slot an entry hashes to in its index. */
+typedef uint32_t (*home_slot_get_t)(uint16_t entry_index);
+
+static inline uint32_t hash_slot_get(uint16_t src, uint32_t seq)
+{
+    /* Fibonacci hashing, the upper bits of the product are the best mixed. */
+    uint32_t hash = (seq ^ ((uint32_t) src << 20) ^ ((uint32_t) src >> 12)) * 2654435761u;
+    return (hash >> 16) & HASH_INDEX_MASK;
+}
+
+static uint32_t entry_home_slot_get(uint16_t entry_index)
+{
+    return hash_slot_get(m_msg_cache[entry_index].src, m_msg_cache[entry_index].seq);
+}
+
+static inline uint32_t fingerprint_slot_get(uint32_t fingerprint_hash)
+{
+    /* The FNV hash is well mixed in all bits, but the index size isn't a factor of its range. */
+    return ((fingerprint_hash * 2654435761u) >> 16) & FINGERPRINT_INDEX_MASK;
+}
+
+static uint32_t fingerprint_home_slot_get(uint16_t entry_index)
+{
+    return fingerprint_slot_get(m_fingerprints[entry_index].hash);
+}
+
+static void index_clear(uint16_t * p_index, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        p_index[i] = HASH_INDEX_EMPTY;
+    }
+}
+
+static void index_add(uint16_t * p_index, uint32_t mask, uint32_t slot, uint16_t entry_index)
+{
+    /* The index is never more than half full, so there's always a free slot. */
+    while (p_index[slot] != HASH_INDEX_EMPTY)
+    {
+        slot = (slot + 1) & mask;
+    }
+    p_index[slot] = entry_index;
+}
+
+static void index_remove(uint16_t * p_index, uint32_t mask, uint16_t entry_index, home_slot_get_t home_slot_get)
+{
+    uint32_t slot = home_slot_get(entry_index);
+    while (p_index[slot] != entry_index)
+    {
+        NRF_MESH_ASSERT(p_index[slot] != HASH_INDEX_EMPTY);
+        slot = (slot + 1) & mask;
+    }
+
+    /* Shift the following entries in the probe sequence back, to avoid tombstones. An entry can
+     * only be moved into the freed slot if the freed slot is between its home slot and its
+     * current slot. */
+    uint32_t free_slot = slot;
+    for (;;)
+    {
+        slot = (slot + 1) & mask;
+        if (p_index[slot] == HASH_INDEX_EMPTY)
+        {
+            break;
+        }
+
+        uint32_t home_slot = home_slot_get(p_index[slot]);
+        if (((slot - home_slot) & mask) >= ((slot - free_slot) & mask))
+        {
+            p_index[free_slot] = p_index[slot];
+            free_slot = slot;
+        }
+    }
+    p_index[free_slot] = HASH_INDEX_EMPTY;
+}
+
+static void hash_index_clear(void)
+{
+    index_clear(m_hash_index, HASH_INDEX_SIZE);
+}
+
+static void hash_index_add(uint32_t entry_index)
+{
+    index_add(m_hash_index, HASH_INDEX_MASK, entry_home_slot_get(entry_index), (uint16_t) entry_index);
+}
+
+static void hash_index_remove(uint32_t entry_index)
+{
+    index_remove(m_hash_index, HASH_INDEX_MASK, (uint16_t) entry_index, entry_home_slot_get);
+}
+#endif
+
+static void fingerprints_clear(void)
+{
+    for (uint32_t i = 0; i < MSG_CACHE_FINGERPRINT_COUNT; ++i)
+    {
+        m_fingerprints[i].length = 0;
+    }
+    m_fingerprint_head = 0;
+#if MSG_CACHE_HASH_INDEX_ENABLE
+    index_clear(m_fingerprint_index, FINGERPRINT_INDEX_SIZE);
+#endif
+}
+
 /*****************************************************************************
 * Interface functions
 *****************************************************************************/
@@ -75,10 +275,28 @@ void msg_cache_init(void)
     }
 
     m_msg_cache_head = 0;
+    fingerprints_clear();
+#if MSG_CACHE_HASH_INDEX_ENABLE
+    hash_index_clear();
+#endif
 }
 
 bool msg_cache_entry_exists(uint16_t src_addr, uint32_t sequence_number)
 {
+#if MSG_CACHE_HASH_INDEX_ENABLE
+    for (uint32_t slot = hash_slot_get(src_addr, sequence_number);
+         m_hash_index[slot] != HASH_INDEX_EMPTY;
+         slot = (slot + 1) & HASH_INDEX_MASK)
+    {
+        const msg_cache_entry_t * p_entry = &m_msg_cache[m_hash_index[slot]];
+        if (p_entry->src == src_addr && p_entry->seq == sequence_number)
+        {
+            return true;
+        }
+    }
+
+    return false;
+#else
     /* Search backwards from head */
     uint32_t entry_index = m_msg_cache_head;
     for (uint32_t i = 0; i < MSG_CACHE_ENTRY_COUNT; ++i)
@@ -101,25 +319,102 @@ bool msg_cache_entry_exists(uint16_t src_addr, uint32_t sequence_number)
     }
 
     return false;
+#endif
 }
 
 void msg_cache_entry_add(uint16_t src, uint32_t seq)
 {
+#if MSG_CACHE_HASH_INDEX_ENABLE
+    if (m_msg_cache[m_msg_cache_head].allocated)
+    {
+        hash_index_remove(m_msg_cache_head);
+    }
+#endif
+
     m_msg_cache[m_msg_cache_head].src = src;
     m_msg_cache[m_msg_cache_head].seq = seq;
     m_msg_cache[m_msg_cache_head].allocated = true;
 
+#if MSG_CACHE_HASH_INDEX_ENABLE
+    hash_index_add(m_msg_cache_head);
+#endif
+
     if ((++m_msg_cache_head) == MSG_CACHE_ENTRY_COUNT)
     {
         m_msg_cache_head = 0;
     }
 }
 
+bool msg_cache_fingerprint_exists(const uint8_t * p_net_packet, uint32_t net_packet_len)
+{
+    msg_cache_fingerprint_t fingerprint;
+    if (!fingerprint_get(p_net_packet, net_packet_len, &fingerprint))
+    {
+        return false;
+    }
+
+#if MSG_CACHE_HASH_INDEX_ENABLE
+    for (uint32_t slot = fingerprint_slot_get(fingerprint.hash);
+         m_fingerprint_index[slot] != HASH_INDEX_EMPTY;
+         slot = (slot + 1) & FINGERPRINT_INDEX_MASK)
+    {
+        if (fingerprint_equal(&m_fingerprints[m_fingerprint_index[slot]], &fingerprint))
+        {
+            return true;
+        }
+    }
+#else
+    for (uint32_t i = 0; i < MSG_CACHE_FINGERPRINT_COUNT; ++i)
+    {
+        if (fingerprint_equal(&m_fingerprints[i], &fingerprint))
+        {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+void msg_cache_fingerprint_add(const uint8_t * p_net_packet, uint32_t net_packet_len)
+{
+    msg_cache_fingerprint_t fingerprint;
+    if (!fingerprint_get(p_net_packet, net_packet_len, &fingerprint))
+    {
+        return;
+    }
+
+#if MSG_CACHE_HASH_INDEX_ENABLE
+    if (m_fingerprints[m_fingerprint_head].length != 0)
+    {
+        index_remove(m_fingerprint_index, FINGERPRINT_INDEX_MASK, (uint16_t) m_fingerprint_head, fingerprint_home_slot_get);
+    }
+#endif
+
+    m_fingerprints[m_fingerprint_head] = fingerprint;
+
+#if MSG_CACHE_HASH_INDEX_ENABLE
+    index_add(m_fingerprint_index,
+              FINGERPRINT_INDEX_MASK,
+              fingerprint_slot_get(fingerprint.hash),
+              (uint16_t) m_fingerprint_head);
+#endif
+
+    if ((++m_fingerprint_head) == MSG_CACHE_FINGERPRINT_COUNT)
+    {
+        m_fingerprint_head = 0;
+    }
+}
+
 void msg_cache_clear(void)
 {
     for (uint32_t i = 0; i < MSG_CACHE_ENTRY_COUNT; ++i)
     {
         m_msg_cache[i].allocated = 0;
     }
+    fingerprints_clear();
+
+#if MSG_CACHE_HASH_INDEX_ENABLE
+    hash_index_clear();
+#endif
 }
 
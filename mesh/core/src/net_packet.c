@@ -245,27 +245,53 @@ uint32_t net_packet_decrypt(network_packet_metadata_t * p_net_metadata,
                     p_net_decrypted_packet != NULL &&
                     p_net_decrypted_packet != p_net_encrypted_packet);
 
+    const nrf_mesh_network_secmat_t * p_secmat = NULL;
+    const nrf_mesh_network_secmat_t * p_secmat_secondary = NULL;
+    nrf_mesh_net_secmat_next_get(packet_mesh_net_nid_get(p_net_encrypted_packet), &p_secmat, &p_secmat_secondary);
+
+    return net_packet_secmat_decrypt(p_net_metadata,
+                                     net_packet_len,
+                                     p_net_encrypted_packet,
+                                     p_net_decrypted_packet,
+                                     packet_kind,
+                                     p_secmat,
+                                     p_secmat_secondary);
+}
+
+uint32_t net_packet_secmat_decrypt(network_packet_metadata_t * p_net_metadata,
+                                   uint32_t net_packet_len,
+                                   const packet_mesh_net_packet_t * p_net_encrypted_packet,
+                                   packet_mesh_net_packet_t * p_net_decrypted_packet,
+                                   net_packet_kind_t packet_kind,
+                                   const nrf_mesh_network_secmat_t * p_secmat,
+                                   const nrf_mesh_network_secmat_t * p_secmat_secondary)
+{
+    NRF_MESH_ASSERT(p_net_metadata != NULL && p_net_encrypted_packet != NULL &&
+                    p_net_decrypted_packet != NULL &&
+                    p_net_decrypted_packet != p_net_encrypted_packet);
+
     p_net_metadata->internal.iv_index = net_state_rx_iv_index_get(packet_mesh_net_ivi_get(p_net_encrypted_packet));
     p_net_metadata->p_security_material = NULL;
     uint8_t nid = packet_mesh_net_nid_get(p_net_encrypted_packet);
 
-    const nrf_mesh_network_secmat_t * p_secmat[2] = { NULL, NULL };
-    do {
-        nrf_mesh_net_secmat_next_get(nid, &p_secmat[0], &p_secmat[1]);
-
-        for (uint32_t i = 0; i < ARRAY_SIZE(p_secmat) && p_secmat[i] != NULL; i++)
+    const nrf_mesh_network_secmat_t * p_secmats[2] = { p_secmat, p_secmat_secondary };
+    while (p_secmats[0] != NULL)
+    {
+        for (uint32_t i = 0; i < ARRAY_SIZE(p_secmats) && p_secmats[i] != NULL; i++)
         {
             if (try_decrypt(p_net_metadata,
                             net_packet_len,
                             p_net_encrypted_packet,
                             p_net_decrypted_packet,
-                            p_secmat[i],
+                            p_secmats[i],
                             packet_kind))
             {
                 return NRF_SUCCESS;
             }
         }
-    } while (p_secmat[0] != NULL);
+
+        nrf_mesh_net_secmat_next_get(nid, &p_secmats[0], &p_secmats[1]);
+    }
 
     return NRF_ERROR_NOT_FOUND;
 }
@@ -300,6 +326,42 @@ void net_packet_encrypt(network_packet_metadata_t * p_net_metadata,
     header_obfuscate(p_net_metadata, p_net_packet, p_net_packet);
 }
 
+void net_packet_relay_encrypt(const network_packet_metadata_t * p_net_metadata,
+                              uint32_t payload_len,
+                              const packet_mesh_net_packet_t * p_net_decrypted_packet,
+                              packet_mesh_net_packet_t * p_net_packet)
+{
+    NRF_MESH_ASSERT(p_net_metadata);
+    NRF_MESH_ASSERT(p_net_decrypted_packet);
+    NRF_MESH_ASSERT(p_net_packet);
+    NRF_MESH_ASSERT(p_net_decrypted_packet != p_net_packet);
+    NRF_MESH_ASSERT(p_net_metadata->ttl <= NRF_MESH_TTL_MAX);
+
+    /* The relayed header only differs from the received one in the TTL field. */
+    memcpy(p_net_packet, p_net_decrypted_packet, NET_PACKET_ENCRYPTION_START_OFFSET);
+    packet_mesh_net_ttl_set(p_net_packet, p_net_metadata->ttl);
+
+    uint8_t nonce[CCM_NONCE_LENGTH];
+
+    enc_nonce_generate(p_net_metadata, ENC_NONCE_NET, 0, nonce);
+
+    ccm_soft_data_t ccm_params;
+    ccm_params.mic_len = net_packet_mic_size_get(p_net_metadata->control_packet);
+    ccm_params.p_key   = p_net_metadata->p_security_material->encryption_key;
+    ccm_params.p_nonce = nonce;
+    /* Encrypt straight from the decrypted packet, including the destination field. */
+    ccm_params.p_m     = net_packet_enc_start_get(p_net_decrypted_packet);
+    ccm_params.p_out   = net_packet_enc_start_get(p_net_packet);
+    ccm_params.m_len   = (NET_PACKET_ENCRYPTION_START_PAYLOAD_OVERHEAD + payload_len);
+    ccm_params.a_len   = 0;
+    ccm_params.p_a     = NULL;
+    ccm_params.p_mic   = ccm_params.p_out + ccm_params.m_len;
+
+    enc_aes_ccm_encrypt(&ccm_params);
+
+    header_obfuscate(p_net_metadata, p_net_packet, p_net_packet);
+}
+
 void net_packet_header_set(packet_mesh_net_packet_t * p_net_packet,
                            const network_packet_metadata_t * p_metadata)
 {
@@ -286,6 +286,8 @@ typedef uint32_t net_flash_data_sequence_number_t;
 /** Flash manager handling Network state flash storage. */
 static flash_manager_t m_flash_manager;
 static bool m_seqnum_allocation_in_progress;
+/** Whether the sequence number block allocation is waiting for flash memory. */
+static bool m_seqnum_allocation_waiting;
 /** Flash operation function to call when the memory returns. */
 typedef void (*flash_op_func_t)(void);
 
@@ -296,9 +298,13 @@ static void flash_mem_available(void * p_args)
     func();
 }
 
+static void seqnum_block_allocate_retry(void);
+
 static void seqnum_block_allocate(void)
 {
-    if (!m_seqnum_allocation_in_progress)
+    /* The flash manager calls back when there's memory for the entry, there's no point in trying
+     * again for every packet sent in the meantime. */
+    if (!m_seqnum_allocation_in_progress && !m_seqnum_allocation_waiting)
     {
         uint32_t next_block = m_net_state.seqnum_max_available + NETWORK_SEQNUM_FLASH_BLOCK_SIZE;
         if (next_block <= NETWORK_SEQNUM_MAX + 1)
@@ -308,8 +314,9 @@ static void seqnum_block_allocate(void)
             {
                 /* try again later */
                 static fm_mem_listener_t mem_listener = {.callback = flash_mem_available,
-                                                        .p_args = seqnum_block_allocate};
+                                                        .p_args = seqnum_block_allocate_retry};
                 flash_manager_mem_listener_register(&mem_listener);
+                m_seqnum_allocation_waiting = true;
             }
             else
             {
@@ -321,6 +328,12 @@ static void seqnum_block_allocate(void)
     }
 }
 
+static void seqnum_block_allocate_retry(void)
+{
+    m_seqnum_allocation_waiting = false;
+    seqnum_block_allocate();
+}
+
 static void flash_store_iv_index(void)
 {
     fm_entry_t * p_new_entry = flash_manager_entry_alloc(&m_flash_manager, FLASH_HANDLE_IV_INDEX, sizeof(net_flash_data_iv_index_t));
@@ -525,7 +538,18 @@ void net_state_init(void)
 
 uint32_t net_state_seqnum_alloc(uint32_t * p_seqnum)
 {
-    if (m_net_state.seqnum < m_net_state.seqnum_max_available)
+    return net_state_seqnum_reserve(1, p_seqnum);
+}
+
+uint32_t net_state_seqnum_reserve(uint32_t count, uint32_t * p_first_seqnum)
+{
+    NRF_MESH_ASSERT(p_first_seqnum != NULL);
+    if (count == 0 || count > NETWORK_SEQNUM_RESERVE_MAX)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    if (m_net_state.seqnum + count <= m_net_state.seqnum_max_available)
     {
         /* Check if we've reached the seqnum threshold for a state transition. */
         uint32_t threshold = NETWORK_SEQNUM_IV_UPDATE_START_THRESHOLD;
@@ -540,7 +564,10 @@ uint32_t net_state_seqnum_alloc(uint32_t * p_seqnum)
             ivu_triggered = iv_update_trigger_if_pending();
         }
 
-        if (!ivu_triggered && m_net_state.seqnum >= m_net_state.seqnum_max_available - NETWORK_SEQNUM_FLASH_BLOCK_THRESHOLD)
+        /* Start storing the next block well before running out, so the sender never has to wait
+         * for the flash. */
+        if (!ivu_triggered &&
+            m_net_state.seqnum + count + NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD > m_net_state.seqnum_max_available)
         {
             seqnum_block_allocate();
         }
@@ -548,7 +575,8 @@ uint32_t net_state_seqnum_alloc(uint32_t * p_seqnum)
          * trigger changes to it. */
         uint32_t was_masked;
         _DISABLE_IRQS(was_masked);
-        *p_seqnum = m_net_state.seqnum++;
+        *p_first_seqnum = m_net_state.seqnum;
+        m_net_state.seqnum += count;
         _ENABLE_IRQS(was_masked);
 
         return NRF_SUCCESS;
@@ -560,6 +588,17 @@ uint32_t net_state_seqnum_alloc(uint32_t * p_seqnum)
     }
 }
 
+void net_state_seqnum_unreserve(uint32_t first_seqnum, uint32_t count)
+{
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+    if (m_net_state.seqnum == first_seqnum + count)
+    {
+        m_net_state.seqnum = first_seqnum;
+    }
+    _ENABLE_IRQS(was_masked);
+}
+
 uint32_t net_state_iv_update_start(void)
 {
     uint32_t status;
@@ -58,15 +58,72 @@
 #include "core_tx_adv.h"
 #include "core_tx_instaburst.h"
 #include "heartbeat.h"
+#include "timer.h"
 #include "nrf_mesh_config_bearer.h"
+#include "nordic_common.h"
 #if GATT_PROXY
 #include "proxy.h"
 #endif
+NRF_MESH_STATIC_ASSERT(NETWORK_RELAY_QUEUE_SIZE > 0 && NETWORK_RELAY_QUEUE_SIZE <= UINT8_MAX);
+NRF_MESH_STATIC_ASSERT(NETWORK_RX_BATCH_SIZE > 0 && NETWORK_RX_BATCH_SIZE <= UINT8_MAX);
+
+/** Shortest possible network packet, with an empty transport PDU and the smallest MIC. */
+#define NETWORK_PACKET_LEN_MIN (PACKET_MESH_NET_PDU_OFFSET + 4)
+
+/******************
+ * Local typedefs *
+ ******************/
+
+/** Relay queue entry. */
+typedef struct
+{
+    /** Metadata of the packet, with the TTL of the relayed packet. */
+    network_packet_metadata_t metadata;
+    /** Reception time of the packet, or the time it was queued if it's unknown. */
+    timestamp_t timestamp;
+    /** Whether the timestamp is the reception time of the packet. */
+    bool rx_timestamp_valid;
+    /** Length of the encrypted network packet. */
+    uint8_t length;
+    /** Encrypted network packet. */
+    packet_mesh_net_packet_t packet;
+} relay_queue_entry_t;
+
 /********************
  * Static variables *
  ********************/
 static bool m_relay_enable;
 static nrf_mesh_relay_check_cb_t m_relay_check_cb;
+static network_relay_stats_t m_relay_stats;
+
+/** Packets waiting for room in the relay TX buffer. */
+static struct
+{
+    relay_queue_entry_t entries[NETWORK_RELAY_QUEUE_SIZE];
+    /** Entry indexes. The first @c count indexes are the queued entries, ordered by descending
+     * relay value, the rest are the free entries. */
+    uint8_t order[NETWORK_RELAY_QUEUE_SIZE];
+    /** Number of queued entries. */
+    uint8_t count;
+    /** Max time a packet can wait to be relayed, in microseconds. */
+    uint32_t max_age_us;
+} m_relay_queue;
+
+/** Incoming packets that have been screened, but not decrypted. The packets are not copied, they
+ * stay in the buffer they were received in. */
+static struct
+{
+    struct
+    {
+        const uint8_t * p_packet;
+        /** Security material pair matching the packet's NID, both NULL if the packet was dropped. */
+        const nrf_mesh_network_secmat_t * p_secmat[2];
+        /** Result of the screening, returned when the packet is processed. */
+        uint32_t status;
+        uint8_t length;
+    } packets[NETWORK_RX_BATCH_SIZE];
+    uint8_t count;
+} m_rx_batch;
 /********************
  * Static functions *
  ********************/
@@ -77,7 +134,7 @@ static inline uint32_t m_core_tx_buffer_size_get(const network_packet_metadata_t
            net_packet_mic_size_get(p_net_metadata->control_packet);
 }
 
-static uint32_t allocate_packet(network_tx_packet_buffer_t * p_buffer)
+static uint32_t allocate_packet(network_tx_packet_buffer_t * p_buffer, bool seqnum_alloc)
 {
     packet_mesh_net_packet_t * p_net_packet;
 
@@ -90,10 +147,10 @@ static uint32_t allocate_packet(network_tx_packet_buffer_t * p_buffer)
         .token          = p_buffer->user_data.token
     };
 
-    if (core_tx_packet_alloc(&alloc_params,
-                             (uint8_t **) &p_net_packet) != 0)
+    p_buffer->bearers = core_tx_packet_alloc(&alloc_params, (uint8_t **) &p_net_packet);
+    if (p_buffer->bearers != 0)
     {
-        if (p_buffer->role != CORE_TX_ROLE_RELAY)
+        if (seqnum_alloc)
         {
             p_buffer->user_data.p_metadata->internal.iv_index = net_state_tx_iv_index_get();
             uint32_t status = net_state_seqnum_alloc(&p_buffer->user_data.p_metadata->internal.sequence_number);
@@ -116,38 +173,293 @@ static uint32_t allocate_packet(network_tx_packet_buffer_t * p_buffer)
 }
 
 /**
- * Relay the network packet, if memory is available.
+ * Get the time at which a packet was received.
+ *
+ * @param[in] p_rx_metadata RX metadata of the packet.
+ * @param[out] p_timestamp Reception timestamp of the packet.
+ *
+ * @returns Whether the packet source provides a reception timestamp.
+ */
+static bool rx_timestamp_get(const nrf_mesh_rx_metadata_t * p_rx_metadata, timestamp_t * p_timestamp)
+{
+    switch (p_rx_metadata->source)
+    {
+        case NRF_MESH_RX_SOURCE_SCANNER:
+            *p_timestamp = p_rx_metadata->params.scanner.timestamp;
+            return true;
+        case NRF_MESH_RX_SOURCE_INSTABURST:
+            *p_timestamp = p_rx_metadata->params.instaburst.timestamp;
+            return true;
+        case NRF_MESH_RX_SOURCE_GATT:
+            *p_timestamp = p_rx_metadata->params.gatt.timestamp;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void relay_latency_register(timestamp_t rx_timestamp)
+{
+    uint32_t latency_us = timer_now() - rx_timestamp;
+
+    m_relay_stats.latency_samples++;
+    m_relay_stats.latency_total_us += latency_us;
+    if (latency_us > m_relay_stats.latency_max_us)
+    {
+        m_relay_stats.latency_max_us = latency_us;
+    }
+    __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_PACKET_RELAY_LATENCY,
+                          MIN(latency_us / INTERNAL_EVENT_RELAY_LATENCY_UNIT_US, UINT8_MAX),
+                          0,
+                          NULL);
+}
+
+/**
+ * Check whether a packet is more valuable to relay than a queued packet.
+ *
+ * Packets with more hops left are more valuable, and among packets with the same TTL, the most
+ * recently received packet is the most valuable.
+ *
+ * @param[in] ttl TTL of the packet to compare.
+ * @param[in] timestamp Reception time of the packet to compare.
+ * @param[in] p_entry Queued packet to compare against.
+ *
+ * @returns Whether the packet is more valuable than the queued packet.
+ */
+static inline bool relay_value_is_higher(uint8_t ttl, timestamp_t timestamp, const relay_queue_entry_t * p_entry)
+{
+    return (ttl > p_entry->metadata.ttl ||
+            (ttl == p_entry->metadata.ttl && TIMER_OLDER_THAN(p_entry->timestamp, timestamp)));
+}
+
+/**
+ * Drop all queued packets that have been waiting for longer than the max relay age.
+ *
+ * @param[in] now Current time.
+ */
+static void relay_queue_expire(timestamp_t now)
+{
+    uint8_t expired[NETWORK_RELAY_QUEUE_SIZE];
+    uint32_t expired_count = 0;
+    uint32_t kept_count = 0;
+
+    for (uint32_t i = 0; i < m_relay_queue.count; ++i)
+    {
+        uint8_t index = m_relay_queue.order[i];
+        if (now - m_relay_queue.entries[index].timestamp > m_relay_queue.max_age_us)
+        {
+            expired[expired_count++] = index;
+        }
+        else
+        {
+            m_relay_queue.order[kept_count++] = index;
+        }
+    }
+
+    /* Expired entries are moved to the free part of the order list. */
+    memcpy(&m_relay_queue.order[kept_count], expired, expired_count);
+    m_relay_queue.count = kept_count;
+    m_relay_stats.dropped_age += expired_count;
+}
+
+/**
+ * Allocate a queue entry for a packet, ordered by its relay value.
+ *
+ * If the queue is full, the least valuable queued packet is dropped to make room for the new one,
+ * unless the new packet is the least valuable.
+ *
+ * @param[in] ttl TTL of the packet to relay.
+ * @param[in] timestamp Reception time of the packet to relay.
+ *
+ * @returns A pointer to the queue entry to populate, or NULL if the packet was dropped.
+ */
+static relay_queue_entry_t * relay_queue_entry_alloc(uint8_t ttl, timestamp_t timestamp)
+{
+    uint32_t pos = 0;
+    while (pos < m_relay_queue.count &&
+           !relay_value_is_higher(ttl, timestamp, &m_relay_queue.entries[m_relay_queue.order[pos]]))
+    {
+        pos++;
+    }
+
+    if (m_relay_queue.count == NETWORK_RELAY_QUEUE_SIZE)
+    {
+        if (pos == m_relay_queue.count)
+        {
+            m_relay_stats.dropped_queue_full++;
+            return NULL;
+        }
+        /* Evict the least valuable packet, its entry becomes the first free entry. */
+        m_relay_queue.count--;
+        m_relay_stats.dropped_evicted++;
+    }
+
+    uint8_t index = m_relay_queue.order[m_relay_queue.count];
+    memmove(&m_relay_queue.order[pos + 1], &m_relay_queue.order[pos], m_relay_queue.count - pos);
+    m_relay_queue.order[pos] = index;
+    m_relay_queue.count++;
+
+    m_relay_queue.entries[index].metadata.ttl = ttl;
+    m_relay_queue.entries[index].timestamp = timestamp;
+    return &m_relay_queue.entries[index];
+}
+
+/** Remove the most valuable packet from the relay queue. */
+static void relay_queue_pop(void)
+{
+    NRF_MESH_ASSERT(m_relay_queue.count > 0);
+    uint8_t index = m_relay_queue.order[0];
+    m_relay_queue.count--;
+    memmove(&m_relay_queue.order[0], &m_relay_queue.order[1], m_relay_queue.count);
+    m_relay_queue.order[m_relay_queue.count] = index;
+}
+
+/**
+ * Send a relayed packet that has been copied or encrypted into the allocated TX buffer.
+ *
+ * @param[in] p_net_packet Network packet in the TX buffer.
+ * @param[in] payload_len Length of the network payload.
+ * @param[in] rx_timestamp_valid Whether @p rx_timestamp is the reception time of the packet.
+ * @param[in] rx_timestamp Reception time of the packet.
+ */
+static void relay_packet_send(const packet_mesh_net_packet_t * p_net_packet,
+                              uint8_t payload_len,
+                              bool rx_timestamp_valid,
+                              timestamp_t rx_timestamp)
+{
+    core_tx_packet_send();
+    __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_NET_PACKET_QUEUED_TX, 0, payload_len, packet_mesh_net_payload_get(p_net_packet));
+
+    m_relay_stats.relayed++;
+    if (rx_timestamp_valid)
+    {
+        relay_latency_register(rx_timestamp);
+    }
+}
+
+/** Move as many queued packets as possible to the bearers, in order of relay value. */
+static void relay_queue_flush(void)
+{
+    relay_queue_expire(timer_now());
+
+    while (m_relay_queue.count > 0)
+    {
+        relay_queue_entry_t * p_entry = &m_relay_queue.entries[m_relay_queue.order[0]];
+        const core_tx_alloc_params_t alloc_params =
+        {
+            .role           = CORE_TX_ROLE_RELAY,
+            .net_packet_len = p_entry->length,
+            .p_metadata     = &p_entry->metadata,
+            .token          = CORE_TX_TOKEN_RELAY
+        };
+
+        uint8_t * p_net_packet;
+        if (core_tx_packet_alloc(&alloc_params, &p_net_packet) == 0)
+        {
+            break;
+        }
+
+        memcpy(p_net_packet, p_entry->packet.pdu, p_entry->length);
+        relay_packet_send((const packet_mesh_net_packet_t *) p_net_packet,
+                          p_entry->length - PACKET_MESH_NET_PDU_OFFSET -
+                              net_packet_mic_size_get(p_entry->metadata.control_packet),
+                          p_entry->rx_timestamp_valid,
+                          p_entry->timestamp);
+        relay_queue_pop();
+    }
+}
+
+/** Move queued packets to the TX buffer space freed by a relayed packet. */
+static void relay_tx_complete(core_tx_role_t role, uint32_t bearer_index, uint32_t timestamp, nrf_mesh_tx_token_t token)
+{
+    relay_queue_flush();
+}
+
+/**
+ * Relay the network packet.
+ *
+ * The packet is encrypted directly from the decrypted packet into the TX buffer, reusing its
+ * header with a decremented TTL. If there's no room for the packet in the TX buffer, or other
+ * packets are already waiting to be relayed, the packet is encrypted into the relay queue instead.
  *
  * @param[in] p_net_metadata Network metadata of packet to relay.
- * @param[in,out] p_net_payload Payload of the network packet to relay.
+ * @param[in] p_net_decrypted_packet Decrypted network packet to relay.
  * @param[in] payload_len Length of the network payload.
+ * @param[in] p_rx_metadata RX metadata of the packet to relay.
  */
 static void packet_relay(network_packet_metadata_t * p_net_metadata,
-                         const uint8_t * p_net_payload,
-                         uint8_t payload_len)
+                         const packet_mesh_net_packet_t * p_net_decrypted_packet,
+                         uint8_t payload_len,
+                         const nrf_mesh_rx_metadata_t * p_rx_metadata)
 {
     p_net_metadata->ttl--; /* Subtract this hop */
 
-    network_tx_packet_buffer_t buffer;
-    buffer.user_data.p_metadata = p_net_metadata;
-    buffer.user_data.payload_len = payload_len;
-    buffer.user_data.token = CORE_TX_TOKEN_RELAY;
-    buffer.role = CORE_TX_ROLE_RELAY;
+    timestamp_t now = timer_now();
+    timestamp_t rx_timestamp = now;
+    bool rx_timestamp_valid = (p_rx_metadata != NULL && rx_timestamp_get(p_rx_metadata, &rx_timestamp));
+
+    relay_queue_expire(now);
 
-    if (allocate_packet(&buffer) == NRF_SUCCESS)
+    const core_tx_alloc_params_t alloc_params =
     {
-        memcpy(buffer.p_payload, p_net_payload, payload_len);
-        network_packet_send(&buffer);
-        __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_PACKET_RELAYED, 0, payload_len, p_net_payload);
+        .role           = CORE_TX_ROLE_RELAY,
+        .net_packet_len = m_core_tx_buffer_size_get(p_net_metadata, payload_len), /*lint !e446 Side effect in initializer */
+        .p_metadata     = p_net_metadata,
+        .token          = CORE_TX_TOKEN_RELAY
+    };
+
+    /* Queued packets have already lost the race for the TX buffer, they go first. */
+    packet_mesh_net_packet_t * p_net_packet;
+    if (m_relay_queue.count == 0 &&
+        core_tx_packet_alloc(&alloc_params, (uint8_t **) &p_net_packet) != 0)
+    {
+        net_packet_relay_encrypt(p_net_metadata, payload_len, p_net_decrypted_packet, p_net_packet);
+        relay_packet_send(p_net_packet, payload_len, rx_timestamp_valid, rx_timestamp);
+        __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_PACKET_RELAYED, 0, payload_len, packet_mesh_net_payload_get(p_net_decrypted_packet));
     }
     else
     {
-        __LOG(LOG_SRC_NETWORK, LOG_LEVEL_WARN, "Unable to allocate memory for relay packet.\n");
+        if (m_relay_queue.count == 0)
+        {
+            m_relay_stats.no_mem++;
+        }
+
+        relay_queue_entry_t * p_entry = relay_queue_entry_alloc(p_net_metadata->ttl, rx_timestamp);
+        if (p_entry != NULL)
+        {
+            p_entry->metadata           = *p_net_metadata;
+            p_entry->rx_timestamp_valid = rx_timestamp_valid;
+            p_entry->length             = alloc_params.net_packet_len;
+            net_packet_relay_encrypt(p_net_metadata, payload_len, p_net_decrypted_packet, &p_entry->packet);
+            __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_PACKET_RELAYED, 0, payload_len, packet_mesh_net_payload_get(p_net_decrypted_packet));
+
+            relay_queue_flush();
+        }
+        else
+        {
+            __LOG(LOG_SRC_NETWORK, LOG_LEVEL_WARN, "Relay queue full, dropping packet.\n");
+        }
     }
 
     p_net_metadata->ttl++; /* Revert the change (cannot affect the allocated packet) */
 }
 
+static uint32_t * relay_drop_counter_get(nrf_mesh_opt_id_t id)
+{
+    switch (id)
+    {
+        case NRF_MESH_OPT_NET_RELAY_DROPPED_AGE:
+            return &m_relay_stats.dropped_age;
+        case NRF_MESH_OPT_NET_RELAY_DROPPED_EVICTED:
+            return &m_relay_stats.dropped_evicted;
+        case NRF_MESH_OPT_NET_RELAY_DROPPED_QUEUE_FULL:
+            return &m_relay_stats.dropped_queue_full;
+        default:
+            NRF_MESH_ASSERT(false);
+            return NULL;
+    }
+}
+
 static bool metadata_is_valid(const network_packet_metadata_t * p_net_metadata)
 {
     NRF_MESH_ASSERT(p_net_metadata != NULL);
@@ -213,6 +525,16 @@ void network_init(const nrf_mesh_init_params_t * p_init_params)
     }
 
     m_relay_enable = true;
+    memset(&m_relay_stats, 0, sizeof(m_relay_stats));
+
+    m_relay_queue.count = 0;
+    m_relay_queue.max_age_us = MS_TO_US(NETWORK_RELAY_QUEUE_MAX_AGE_MS_DEFAULT);
+    for (uint32_t i = 0; i < NETWORK_RELAY_QUEUE_SIZE; ++i)
+    {
+        m_relay_queue.order[i] = i;
+    }
+    m_rx_batch.count = 0;
+    core_tx_relay_complete_cb_set(relay_tx_complete);
 
     net_state_init();
     net_state_recover_from_flash();
@@ -277,6 +599,23 @@ uint32_t network_opt_set(nrf_mesh_opt_id_t id, const nrf_mesh_opt_t * p_opt)
                 break;
 #endif
             }
+        case NRF_MESH_OPT_NET_RELAY_QUEUE_MAX_AGE_MS:
+            if (p_opt->opt.val == 0 || p_opt->opt.val > US_TO_MS(UINT32_MAX / 2))
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_relay_queue.max_age_us = MS_TO_US(p_opt->opt.val);
+            break;
+        case NRF_MESH_OPT_NET_RELAY_DROPPED_AGE:
+        case NRF_MESH_OPT_NET_RELAY_DROPPED_EVICTED:
+        case NRF_MESH_OPT_NET_RELAY_DROPPED_QUEUE_FULL:
+            /* The drop counters can only be reset. */
+            if (p_opt->opt.val != 0)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            *relay_drop_counter_get(id) = 0;
+            break;
         default:
             return NRF_ERROR_NOT_FOUND;
     }
@@ -329,6 +668,16 @@ uint32_t network_opt_get(nrf_mesh_opt_id_t id, nrf_mesh_opt_t * p_opt)
 #endif
             p_opt->len = sizeof(p_opt->opt.val);
             break;
+        case NRF_MESH_OPT_NET_RELAY_QUEUE_MAX_AGE_MS:
+            p_opt->opt.val = US_TO_MS(m_relay_queue.max_age_us);
+            p_opt->len = sizeof(p_opt->opt.val);
+            break;
+        case NRF_MESH_OPT_NET_RELAY_DROPPED_AGE:
+        case NRF_MESH_OPT_NET_RELAY_DROPPED_EVICTED:
+        case NRF_MESH_OPT_NET_RELAY_DROPPED_QUEUE_FULL:
+            p_opt->opt.val = *relay_drop_counter_get(id);
+            p_opt->len = sizeof(p_opt->opt.val);
+            break;
         default:
             return NRF_ERROR_NOT_FOUND;
     }
@@ -342,7 +691,16 @@ uint32_t network_packet_alloc(network_tx_packet_buffer_t * p_buffer)
     NRF_MESH_ASSERT(p_buffer->user_data.p_metadata != NULL);
     NRF_MESH_ASSERT(p_buffer->user_data.p_metadata->p_security_material != NULL);
     p_buffer->role = CORE_TX_ROLE_ORIGINATOR;
-    return allocate_packet(p_buffer);
+    return allocate_packet(p_buffer, true);
+}
+
+uint32_t network_packet_alloc_reserved(network_tx_packet_buffer_t * p_buffer)
+{
+    NRF_MESH_ASSERT(p_buffer != NULL);
+    NRF_MESH_ASSERT(p_buffer->user_data.p_metadata != NULL);
+    NRF_MESH_ASSERT(p_buffer->user_data.p_metadata->p_security_material != NULL);
+    p_buffer->role = CORE_TX_ROLE_ORIGINATOR;
+    return allocate_packet(p_buffer, false);
 }
 
 void network_packet_send(const network_tx_packet_buffer_t * p_buffer)
@@ -372,15 +730,31 @@ void network_packet_discard(const network_tx_packet_buffer_t * p_buffer)
     core_tx_packet_discard();
 }
 
-uint32_t network_packet_in(const uint8_t * p_packet, uint32_t net_packet_len, const nrf_mesh_rx_metadata_t * p_rx_metadata)
+/**
+ * Decrypts and processes an incoming network packet.
+ *
+ * @param[in] p_packet Network packet.
+ * @param[in] net_packet_len Length of the network packet.
+ * @param[in] p_rx_metadata RX metadata for the packet.
+ * @param[in] pp_secmat Security material pair already looked up for the packet's NID, or NULL to
+ *                      look it up as part of the decryption.
+ */
+static uint32_t packet_in(const uint8_t * p_packet,
+                          uint32_t net_packet_len,
+                          const nrf_mesh_rx_metadata_t * p_rx_metadata,
+                          const nrf_mesh_network_secmat_t * const * pp_secmat)
 {
-    if (p_packet == NULL)
-    {
-        return NRF_ERROR_NULL;
-    }
     const packet_mesh_net_packet_t * p_net_packet = (const packet_mesh_net_packet_t *) p_packet;
     uint32_t status = NRF_SUCCESS;
 
+    /* Repeated transmissions of a packet we've already decrypted are identical, and can be
+     * dropped without deobfuscating them. */
+    if (msg_cache_fingerprint_exists(p_packet, net_packet_len))
+    {
+        __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_PACKET_DROPPED, PACKET_DROPPED_NETWORK_CACHE, net_packet_len, p_packet);
+        return NRF_ERROR_NOT_FOUND;
+    }
+
     /* Create a target buffer to decrypt into, don't have to allocate a new packet. */
     packet_mesh_net_packet_t net_decrypted_packet;
 
@@ -390,15 +764,31 @@ uint32_t network_packet_in(const uint8_t * p_packet, uint32_t net_packet_len, co
            net_packet_obfuscation_start_get(p_net_packet) - (uint8_t *) p_net_packet);
 
     network_packet_metadata_t net_metadata;
-    status = net_packet_decrypt(&net_metadata,
-                                net_packet_len,
-                                p_net_packet,
-                                &net_decrypted_packet,
-                                NET_PACKET_KIND_TRANSPORT);
+    if (pp_secmat == NULL)
+    {
+        status = net_packet_decrypt(&net_metadata,
+                                    net_packet_len,
+                                    p_net_packet,
+                                    &net_decrypted_packet,
+                                    NET_PACKET_KIND_TRANSPORT);
+    }
+    else
+    {
+        status = net_packet_secmat_decrypt(&net_metadata,
+                                           net_packet_len,
+                                           p_net_packet,
+                                           &net_decrypted_packet,
+                                           NET_PACKET_KIND_TRANSPORT,
+                                           pp_secmat[0],
+                                           pp_secmat[1]);
+    }
     if ((status == NRF_SUCCESS) && metadata_is_valid(&net_metadata))
     {
         NRF_MESH_ASSERT(net_metadata.p_security_material != NULL);
 
+        /* Like the message cache entry, the fingerprint is only recorded for accepted packets. */
+        msg_cache_fingerprint_add(p_packet, net_packet_len);
+
         const uint8_t * p_net_payload = packet_mesh_net_payload_get(&net_decrypted_packet);
 
         uint8_t payload_len = net_packet_payload_len_get(&net_metadata, net_packet_len);
@@ -414,9 +804,119 @@ uint32_t network_packet_in(const uint8_t * p_packet, uint32_t net_packet_len, co
 
         if (should_relay(&net_metadata))
         {
-            packet_relay(&net_metadata, p_net_payload, payload_len);
+            packet_relay(&net_metadata, &net_decrypted_packet, payload_len, p_rx_metadata);
         }
         msg_cache_entry_add(net_metadata.src, net_metadata.internal.sequence_number);
     }
     return status;
 }
+
+uint32_t network_packet_in(const uint8_t * p_packet, uint32_t net_packet_len, const nrf_mesh_rx_metadata_t * p_rx_metadata)
+{
+    if (p_packet == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    return packet_in(p_packet, net_packet_len, p_rx_metadata, NULL);
+}
+
+uint32_t network_packet_batch_add(const uint8_t * p_packet, uint32_t net_packet_len)
+{
+    if (p_packet == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (m_rx_batch.count == NETWORK_RX_BATCH_SIZE)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    uint32_t status = NRF_SUCCESS;
+    const nrf_mesh_network_secmat_t * p_secmat[2] = { NULL, NULL };
+
+    if (net_packet_len < NETWORK_PACKET_LEN_MIN || net_packet_len > PACKET_MESH_NET_MAX_SIZE)
+    {
+        __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_PACKET_DROPPED, PACKET_DROPPED_INVALID_PACKET_LEN, net_packet_len, p_packet);
+        status = NRF_ERROR_INVALID_LENGTH;
+    }
+
+    /* The NID is the only unobfuscated field that can tell whether the packet is for one of our
+     * networks, check it before spending any time on the packet. The decryption starts with the
+     * security material found here. */
+    if (status == NRF_SUCCESS)
+    {
+        nrf_mesh_net_secmat_next_get(packet_mesh_net_nid_get((const packet_mesh_net_packet_t *) p_packet),
+                                     &p_secmat[0],
+                                     &p_secmat[1]);
+        if (p_secmat[0] == NULL)
+        {
+            __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_PACKET_DROPPED, PACKET_DROPPED_INVALID_NETKEY, net_packet_len, p_packet);
+            status = NRF_ERROR_NOT_FOUND;
+        }
+    }
+
+    /* Each advertisement is received on several channels, only keep the first copy. */
+    for (uint32_t i = 0; i < m_rx_batch.count && status == NRF_SUCCESS; ++i)
+    {
+        if (m_rx_batch.packets[i].status == NRF_SUCCESS &&
+            m_rx_batch.packets[i].length == net_packet_len &&
+            memcmp(m_rx_batch.packets[i].p_packet, p_packet, net_packet_len) == 0)
+        {
+            __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_PACKET_DROPPED, PACKET_DROPPED_NETWORK_CACHE, net_packet_len, p_packet);
+            status = NRF_ERROR_INVALID_STATE;
+        }
+    }
+
+    /* Dropped packets are kept in the batch as well, so that they aren't processed any further. */
+    m_rx_batch.packets[m_rx_batch.count].p_packet = p_packet;
+    m_rx_batch.packets[m_rx_batch.count].p_secmat[0] = (status == NRF_SUCCESS) ? p_secmat[0] : NULL;
+    m_rx_batch.packets[m_rx_batch.count].p_secmat[1] = (status == NRF_SUCCESS) ? p_secmat[1] : NULL;
+    m_rx_batch.packets[m_rx_batch.count].status = status;
+    m_rx_batch.packets[m_rx_batch.count].length = net_packet_len;
+    m_rx_batch.count++;
+    return status;
+}
+
+uint32_t network_packet_batch_in(const uint8_t * p_packet, uint32_t net_packet_len, const nrf_mesh_rx_metadata_t * p_rx_metadata)
+{
+    if (p_packet == NULL || p_rx_metadata == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    for (uint32_t i = 0; i < m_rx_batch.count; ++i)
+    {
+        if (m_rx_batch.packets[i].p_packet == p_packet)
+        {
+            if (m_rx_batch.packets[i].status != NRF_SUCCESS)
+            {
+                return m_rx_batch.packets[i].status;
+            }
+
+            /* The security material was looked up when the packet was received, a key change made
+             * by an earlier packet in the batch only applies to the packets received after it. */
+            return packet_in(p_packet, net_packet_len, p_rx_metadata, m_rx_batch.packets[i].p_secmat);
+        }
+    }
+
+    /* Not screened, process it like any other packet. */
+    return network_packet_in(p_packet, net_packet_len, p_rx_metadata);
+}
+
+void network_packet_batch_clear(void)
+{
+    m_rx_batch.count = 0;
+}
+
+void network_relay_stats_get(network_relay_stats_t * p_stats)
+{
+    NRF_MESH_ASSERT(p_stats != NULL);
+    *p_stats = m_relay_stats;
+}
+
+void network_relay_stats_reset(void)
+{
+    memset(&m_relay_stats, 0, sizeof(m_relay_stats));
+}
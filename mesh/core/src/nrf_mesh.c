@@ -39,6 +39,8 @@
 #include "nrf_mesh_events.h"
 #include "nrf_mesh_assert.h"
 #include "nrf_mesh_configure.h"
+#include "nrf_mesh_config_core.h"
+#include "nrf_mesh_config_bearer.h"
 #include "nrf_mesh_utils.h"
 
 #include <string.h>
@@ -82,6 +84,16 @@
 #include "proxy.h"
 #endif  /* GATT_PROXY */
 
+/** Max number of scanner packets held and processed in one go. The packet buffer only lets one
+ * scanner packet out at a time, batching requires the scanner RX ring. */
+#if SCANNER_RX_RING_SLOT_COUNT
+#define SCANNER_RX_BATCH_SIZE NETWORK_RX_BATCH_SIZE
+/* Leave the radio at least one slot to receive into while a batch is being processed. */
+NRF_MESH_STATIC_ASSERT(NETWORK_RX_BATCH_SIZE < SCANNER_RX_RING_SLOT_COUNT);
+#else
+#define SCANNER_RX_BATCH_SIZE 1
+#endif
+
 static bool m_is_enabled;
 static bool m_is_initialized;
 static nrf_mesh_rx_cb_t m_rx_cb;
@@ -128,7 +140,15 @@ static void nrf_mesh_listen(const uint8_t * p_packet,
             if (adv_type == BLE_PACKET_TYPE_ADV_NONCONN_IND ||
                 adv_type == BLE_PACKET_TYPE_ADV_EXT)
             {
-                status = network_packet_in(p_ad_data->data, p_ad_data->length - BLE_AD_DATA_OVERHEAD, p_metadata);
+                if (p_metadata->source == NRF_MESH_RX_SOURCE_SCANNER)
+                {
+                    /* Scanner packets have been screened by scanner_packet_screen(). */
+                    status = network_packet_batch_in(p_ad_data->data, p_ad_data->length - BLE_AD_DATA_OVERHEAD, p_metadata);
+                }
+                else
+                {
+                    status = network_packet_in(p_ad_data->data, p_ad_data->length - BLE_AD_DATA_OVERHEAD, p_metadata);
+                }
 
                 if (status != NRF_SUCCESS)
                 {
@@ -170,49 +190,104 @@ static void nrf_mesh_listen(const uint8_t * p_packet,
     }
 }
 
-static bool scanner_packet_process_cb(void)
+/** Adds the mesh network packets in the scanner packet to the network RX batch. */
+static void scanner_packet_screen(const scanner_packet_t * p_scanner_packet)
 {
-    /* Process all incoming packets: */
-    const scanner_packet_t * p_scanner_packet = scanner_rx();
-
-    if (p_scanner_packet != NULL)
+    /* Same conditions as for the packet to reach network_packet_batch_in() through nrf_mesh_listen(). */
+    if (p_scanner_packet->packet.header.length < BLE_ADV_PACKET_OVERHEAD ||
+        p_scanner_packet->packet.header.type != BLE_PACKET_TYPE_ADV_NONCONN_IND ||
+        p_scanner_packet->metadata.adv_type != BLE_PACKET_TYPE_ADV_NONCONN_IND)
     {
-        nrf_mesh_rx_metadata_t metadata;
+        return;
+    }
 
-        metadata.source = NRF_MESH_RX_SOURCE_SCANNER;
-        metadata.params.scanner = p_scanner_packet->metadata;
+    const uint8_t * p_end = &p_scanner_packet->packet.payload[p_scanner_packet->packet.header.length - BLE_ADV_PACKET_OVERHEAD];
 
-        /* Adv Ext packets in the advertising channels don't have regular advertising data */
-        if (p_scanner_packet->packet.header.length >= BLE_ADV_PACKET_OVERHEAD &&
-            p_scanner_packet->packet.header.type != BLE_PACKET_TYPE_ADV_EXT)
+    for (const ble_ad_data_t * p_ad_data = (const ble_ad_data_t *) p_scanner_packet->packet.payload;
+         (const uint8_t *) p_ad_data < p_end;
+         p_ad_data = packet_ad_type_get_next((ble_ad_data_t *) p_ad_data))
+    {
+        if (p_ad_data->length == 0 ||
+            (const uint8_t *) p_ad_data + BLE_AD_DATA_OVERHEAD + p_ad_data->length > p_end)
         {
-            ad_listener_process((ble_packet_type_t) p_scanner_packet->packet.header.type,
-                                p_scanner_packet->packet.payload,
-                                p_scanner_packet->packet.header.length - BLE_ADV_PACKET_OVERHEAD,
-                                &metadata);
+            break;
         }
 
-        /* Notify the application */
-        if (m_rx_cb)
+        if (p_ad_data->type == AD_TYPE_MESH)
         {
-            nrf_mesh_adv_packet_rx_data_t rx_data;
-            rx_data.p_metadata = &metadata;
-            rx_data.adv_type = p_scanner_packet->packet.header.type;
-            if (p_scanner_packet->packet.header.length > BLE_ADV_PACKET_OVERHEAD)
-            {
-                rx_data.length = p_scanner_packet->packet.header.length - BLE_ADV_PACKET_OVERHEAD;
-                rx_data.p_payload = p_scanner_packet->packet.payload;
-            }
-            else
-            {
-                rx_data.length = 0;
-                rx_data.p_payload = NULL;
-            }
+            /* Packets that are dropped or don't fit in the batch are reported when processed. */
+            (void) network_packet_batch_add(p_ad_data->data, p_ad_data->length - BLE_AD_DATA_OVERHEAD);
+        }
+    }
+}
 
-            m_rx_cb(&rx_data);
+static void scanner_packet_process(const scanner_packet_t * p_scanner_packet, const nrf_mesh_rx_metadata_t * p_metadata)
+{
+    /* Adv Ext packets in the advertising channels don't have regular advertising data */
+    if (p_scanner_packet->packet.header.length >= BLE_ADV_PACKET_OVERHEAD &&
+        p_scanner_packet->packet.header.type != BLE_PACKET_TYPE_ADV_EXT)
+    {
+        ad_listener_process((ble_packet_type_t) p_scanner_packet->packet.header.type,
+                            p_scanner_packet->packet.payload,
+                            p_scanner_packet->packet.header.length - BLE_ADV_PACKET_OVERHEAD,
+                            p_metadata);
+    }
+
+    /* Notify the application */
+    if (m_rx_cb)
+    {
+        nrf_mesh_adv_packet_rx_data_t rx_data;
+        rx_data.p_metadata = p_metadata;
+        rx_data.adv_type = p_scanner_packet->packet.header.type;
+        if (p_scanner_packet->packet.header.length > BLE_ADV_PACKET_OVERHEAD)
+        {
+            rx_data.length = p_scanner_packet->packet.header.length - BLE_ADV_PACKET_OVERHEAD;
+            rx_data.p_payload = p_scanner_packet->packet.payload;
+        }
+        else
+        {
+            rx_data.length = 0;
+            rx_data.p_payload = NULL;
+        }
+
+        m_rx_cb(&rx_data);
+    }
+
+}
+
+static bool scanner_packet_process_cb(void)
+{
+    const scanner_packet_t * p_scanner_packets[SCANNER_RX_BATCH_SIZE];
+    nrf_mesh_rx_metadata_t metadata[SCANNER_RX_BATCH_SIZE];
+    uint32_t count = 0;
+
+    /* Screen the mesh network packets of a batch of incoming packets before any of them is
+     * decrypted. The packets stay in the scanner buffer until the whole batch has been processed. */
+    while (count < SCANNER_RX_BATCH_SIZE)
+    {
+        p_scanner_packets[count] = scanner_rx();
+        if (p_scanner_packets[count] == NULL)
+        {
+            break;
         }
 
-        scanner_packet_release(p_scanner_packet);
+        metadata[count].source = NRF_MESH_RX_SOURCE_SCANNER;
+        metadata[count].params.scanner = p_scanner_packets[count]->metadata;
+        scanner_packet_screen(p_scanner_packets[count]);
+        count++;
+    }
+
+    /* Process the packets in the order they were received. */
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        scanner_packet_process(p_scanner_packets[i], &metadata[i]);
+    }
+
+    network_packet_batch_clear();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        scanner_packet_release(p_scanner_packets[i]);
     }
 
     return !scanner_rx_pending();
@@ -39,21 +39,104 @@
 
 #include "nrf_mesh_defines.h"
 #include "nrf_mesh_config_core.h"
+#include "nrf_mesh_events.h"
 #include "replay_cache.h"
+#include "event.h"
 
 typedef struct
 {
     uint32_t seqno : NETWORK_SEQNUM_BITS;
     uint16_t src;
+#if REPLAY_CACHE_OVERFLOW_POLICY == REPLAY_CACHE_OVERFLOW_POLICY_EVICT_LRU
+    uint32_t last_used; /**< Value of the usage counter when the entry was last updated. */
+#endif
 } replay_cache_entry_t;
 
+/** Replay cache entries for one IV index bit value. */
+typedef struct
+{
+    replay_cache_entry_t entries[REPLAY_CACHE_ENTRIES]; /**< Entries, sorted by source address. */
+    uint16_t count; /**< Number of entries in use. */
+} replay_cache_generation_t;
+
 /**
  * @todo Get memory from elsewhere...
  */
-static replay_cache_entry_t m_replay_cache[2][REPLAY_CACHE_ENTRIES];
+static replay_cache_generation_t m_replay_cache[2];
 
 static uint8_t m_cache_index = 0;
 
+#if REPLAY_CACHE_OVERFLOW_POLICY == REPLAY_CACHE_OVERFLOW_POLICY_EVICT_LRU
+/** Counter incremented on every update, used for finding the least recently used entry. */
+static uint32_t m_usage_counter;
+#endif
+
+/**
+ * Binary search for the entry with the given source address.
+ *
+ * @param[in]  p_generation Generation to search in.
+ * @param[in]  src          Source address to search for.
+ * @param[out] p_index      Index of the entry if found, or the index it should be inserted at to
+ *                          keep the entries sorted.
+ *
+ * @returns Whether the entry was found.
+ */
+static bool entry_find(const replay_cache_generation_t * p_generation, uint16_t src, uint32_t * p_index)
+{
+    uint32_t low = 0;
+    uint32_t high = p_generation->count;
+
+    while (low < high)
+    {
+        uint32_t mid = (low + high) / 2;
+        if (p_generation->entries[mid].src < src)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    *p_index = low;
+    return (low < p_generation->count && p_generation->entries[low].src == src);
+}
+
+#if REPLAY_CACHE_OVERFLOW_POLICY == REPLAY_CACHE_OVERFLOW_POLICY_EVICT_LRU
+static void lru_entry_evict(uint8_t ivi)
+{
+    replay_cache_generation_t * p_generation = &m_replay_cache[ivi];
+    uint32_t lru_index = 0;
+    uint32_t lru_age = 0;
+
+    for (uint32_t i = 0; i < p_generation->count; ++i)
+    {
+        /* Unsigned subtraction handles the wrap-around of the usage counter. */
+        uint32_t age = m_usage_counter - p_generation->entries[i].last_used;
+        if (age > lru_age)
+        {
+            lru_age = age;
+            lru_index = i;
+        }
+    }
+
+    nrf_mesh_evt_t evt =
+        {
+            .type = NRF_MESH_EVT_REPLAY_CACHE_EVICTED,
+            .params.replay_cache_evicted.src = p_generation->entries[lru_index].src,
+            .params.replay_cache_evicted.ivi = ivi
+        };
+
+    p_generation->count--;
+    memmove(&p_generation->entries[lru_index],
+            &p_generation->entries[lru_index + 1],
+            (p_generation->count - lru_index) * sizeof(replay_cache_entry_t));
+
+    event_handle(&evt);
+}
+#endif
+
 void replay_cache_init(void)
 {
     replay_cache_clear();
@@ -61,41 +144,42 @@ void replay_cache_init(void)
 
 uint32_t replay_cache_add(uint16_t src, uint32_t seqno, uint8_t ivi)
 {
-    for (uint_fast8_t i = 0; i < REPLAY_CACHE_ENTRIES; ++i)
+    replay_cache_generation_t * p_generation = &m_replay_cache[ivi];
+    uint32_t index;
+
+    if (!entry_find(p_generation, src, &index))
     {
-        if (m_replay_cache[ivi][i].src == 0)
+        if (p_generation->count == REPLAY_CACHE_ENTRIES)
         {
-            /* Free slot! */
-            m_replay_cache[ivi][i].seqno = seqno;
-            m_replay_cache[ivi][i].src   = src;
-            return NRF_SUCCESS;
+#if REPLAY_CACHE_OVERFLOW_POLICY == REPLAY_CACHE_OVERFLOW_POLICY_EVICT_LRU
+            lru_entry_evict(ivi);
+            (void) entry_find(p_generation, src, &index);
+#else
+            return NRF_ERROR_NO_MEM;
+#endif
         }
 
-        if (m_replay_cache[ivi][i].src == src)
-        {
-            /* Free slot! */
-            m_replay_cache[ivi][i].seqno = seqno;
-            return NRF_SUCCESS;
-        }
+        memmove(&p_generation->entries[index + 1],
+                &p_generation->entries[index],
+                (p_generation->count - index) * sizeof(replay_cache_entry_t));
+        p_generation->entries[index].src = src;
+        p_generation->count++;
     }
 
-    return NRF_ERROR_NO_MEM;
+    p_generation->entries[index].seqno = seqno;
+#if REPLAY_CACHE_OVERFLOW_POLICY == REPLAY_CACHE_OVERFLOW_POLICY_EVICT_LRU
+    p_generation->entries[index].last_used = m_usage_counter++;
+#endif
+    return NRF_SUCCESS;
 }
 
 
 bool replay_cache_has_elem(uint16_t src, uint32_t seqno, uint8_t ivi)
 {
-    for (uint_fast8_t i = 0; i < REPLAY_CACHE_ENTRIES; ++i)
+    uint32_t index;
+    if (entry_find(&m_replay_cache[ivi], src, &index))
     {
-        if (m_replay_cache[ivi][i].src == src)
-        {
-            if (m_replay_cache[ivi][i].seqno < seqno)
-            {
-                return false;
-            }
-
-            return true;
-        }
+        return (m_replay_cache[ivi].entries[index].seqno >= seqno);
     }
 
     /* Not to be added to cache unless successful application decrypt! */
@@ -106,7 +190,7 @@ void replay_cache_on_iv_update(void)
 {
     /* Clear old index */
     m_cache_index = (m_cache_index + 1) & 0x01;
-    memset(m_replay_cache[m_cache_index], 0, sizeof(m_replay_cache[0]));
+    memset(&m_replay_cache[m_cache_index], 0, sizeof(m_replay_cache[0]));
 }
 
 void replay_cache_clear(void)
@@ -0,0 +1,307 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sar_slab.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "nrf_mesh_assert.h"
+#include "toolchain.h"
+#include "utils.h"
+
+/*****************************************************************************
+* Local defines
+*****************************************************************************/
+
+/** Total number of slabs in the pool. */
+#define SAR_SLAB_TOTAL_COUNT (TRANSPORT_SAR_SLAB_COUNT_12 + \
+                              TRANSPORT_SAR_SLAB_COUNT_48 + \
+                              TRANSPORT_SAR_SLAB_COUNT_96 + \
+                              TRANSPORT_SAR_SLAB_COUNT_192 + \
+                              TRANSPORT_SAR_SLAB_COUNT_384)
+
+/** Size of the pool in bytes. */
+#define SAR_SLAB_POOL_SIZE (12 * TRANSPORT_SAR_SLAB_COUNT_12 + \
+                            48 * TRANSPORT_SAR_SLAB_COUNT_48 + \
+                            96 * TRANSPORT_SAR_SLAB_COUNT_96 + \
+                            192 * TRANSPORT_SAR_SLAB_COUNT_192 + \
+                            384 * TRANSPORT_SAR_SLAB_COUNT_384)
+
+/** Marks the end of a free list. */
+#define SAR_SLAB_INDEX_INVALID (0xFFFF)
+
+NRF_MESH_STATIC_ASSERT(SAR_SLAB_TOTAL_COUNT > 0);
+NRF_MESH_STATIC_ASSERT(SAR_SLAB_TOTAL_COUNT < SAR_SLAB_INDEX_INVALID);
+
+/*****************************************************************************
+* Local type definitions
+*****************************************************************************/
+
+/** Slab size class. */
+typedef struct
+{
+    uint8_t * p_start;            /**< First slab of the class. */
+    uint8_t * p_end;              /**< End of the last slab of the class. */
+    uint8_t shift;                /**< Slab size is 3 shifted left by this number of bits. */
+    uint16_t first_index;         /**< Pool index of the first slab of the class. */
+    uint16_t free_head;           /**< Pool index of the first free slab, or @ref SAR_SLAB_INDEX_INVALID. */
+    sar_slab_class_stats_t stats; /**< Usage statistics of the class. */
+} slab_class_t;
+
+/*****************************************************************************
+* Static globals
+*****************************************************************************/
+
+/* The slab sizes are 3 times powers of two, so slab indexes can be found by shifting, and a division by
+ * a constant. */
+static const uint8_t m_class_shifts[SAR_SLAB_CLASS_COUNT] = {2, 4, 5, 6, 7};
+static const uint16_t m_class_sizes[SAR_SLAB_CLASS_COUNT] = {12, 48, 96, 192, SAR_SLAB_SIZE_MAX};
+static const uint16_t m_class_counts[SAR_SLAB_CLASS_COUNT] =
+{
+    TRANSPORT_SAR_SLAB_COUNT_12,
+    TRANSPORT_SAR_SLAB_COUNT_48,
+    TRANSPORT_SAR_SLAB_COUNT_96,
+    TRANSPORT_SAR_SLAB_COUNT_192,
+    TRANSPORT_SAR_SLAB_COUNT_384
+};
+
+/** Slab memory. All slab sizes are multiples of the word size, keeping every slab word aligned. */
+static uint32_t m_pool[SAR_SLAB_POOL_SIZE / sizeof(uint32_t)];
+static slab_class_t m_classes[SAR_SLAB_CLASS_COUNT];
+/** Number of bytes requested for each slab, or 0 if the slab is free. */
+static uint16_t m_requested_len[SAR_SLAB_TOTAL_COUNT];
+
+static uint32_t m_requested_bytes;
+static uint32_t m_reserved_bytes;
+static uint32_t m_reserved_bytes_peak;
+static uint32_t m_alloc_failures;
+
+/*****************************************************************************
+* Static functions
+*****************************************************************************/
+
+static inline uint8_t * slab_get(const slab_class_t * p_class, uint16_t index)
+{
+    return p_class->p_start + (((index - p_class->first_index) * 3) << p_class->shift);
+}
+
+/* The free list link is stored in the first bytes of the free slab itself. */
+static inline uint16_t * slab_next_free_get(const slab_class_t * p_class, uint16_t index)
+{
+    return (uint16_t *) slab_get(p_class, index);
+}
+
+static slab_class_t * class_get_by_buffer(const uint8_t * p_buffer)
+{
+    for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        const slab_class_t * p_class = &m_classes[i];
+        if (p_buffer >= p_class->p_start && p_buffer < p_class->p_end)
+        {
+            return &m_classes[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t class_fit_get(size_t size)
+{
+    uint32_t i = 0;
+    while (m_class_sizes[i] < size)
+    {
+        i++;
+    }
+    return i;
+}
+
+static void * slab_take(slab_class_t * p_class, uint16_t size)
+{
+    uint16_t index = p_class->free_head;
+    uint8_t * p_slab = slab_get(p_class, index);
+    p_class->free_head = *slab_next_free_get(p_class, index);
+
+    m_requested_len[index] = size;
+    m_requested_bytes += size;
+    m_reserved_bytes += p_class->stats.size;
+    if (m_reserved_bytes > m_reserved_bytes_peak)
+    {
+        m_reserved_bytes_peak = m_reserved_bytes;
+    }
+
+    p_class->stats.in_use++;
+    p_class->stats.allocs++;
+    if (p_class->stats.in_use > p_class->stats.in_use_peak)
+    {
+        p_class->stats.in_use_peak = p_class->stats.in_use;
+    }
+    return p_slab;
+}
+
+/*****************************************************************************
+* Interface functions
+*****************************************************************************/
+
+void sar_slab_init(void)
+{
+    uint8_t * p_start = (uint8_t *) m_pool;
+    uint16_t first_index = 0;
+
+    for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        slab_class_t * p_class = &m_classes[i];
+        memset(p_class, 0, sizeof(slab_class_t));
+        p_class->p_start = p_start;
+        p_class->p_end = p_start + m_class_sizes[i] * m_class_counts[i];
+        p_class->shift = m_class_shifts[i];
+        p_class->first_index = first_index;
+        p_class->stats.size = m_class_sizes[i];
+        p_class->stats.count = m_class_counts[i];
+        p_class->free_head = (m_class_counts[i] > 0) ? first_index : SAR_SLAB_INDEX_INVALID;
+
+        for (uint16_t index = first_index; index < first_index + m_class_counts[i]; ++index)
+        {
+            *slab_next_free_get(p_class, index) =
+                (index + 1 < first_index + m_class_counts[i]) ? (index + 1) : SAR_SLAB_INDEX_INVALID;
+        }
+
+        p_start = p_class->p_end;
+        first_index += m_class_counts[i];
+    }
+
+    memset(m_requested_len, 0, sizeof(m_requested_len));
+    m_requested_bytes = 0;
+    m_reserved_bytes = 0;
+    m_reserved_bytes_peak = 0;
+    m_alloc_failures = 0;
+}
+
+void * sar_slab_alloc(size_t size)
+{
+    void * p_buffer = NULL;
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+
+    if (size > 0 && size <= SAR_SLAB_SIZE_MAX)
+    {
+        uint32_t fit = class_fit_get(size);
+        for (uint32_t i = fit; i < SAR_SLAB_CLASS_COUNT; ++i)
+        {
+            if (m_classes[i].free_head != SAR_SLAB_INDEX_INVALID)
+            {
+                p_buffer = slab_take(&m_classes[i], (uint16_t) size);
+                if (i != fit)
+                {
+                    m_classes[i].stats.spills++;
+                }
+                break;
+            }
+        }
+    }
+
+    if (p_buffer == NULL)
+    {
+        m_alloc_failures++;
+    }
+
+    _ENABLE_IRQS(was_masked);
+    return p_buffer;
+}
+
+void sar_slab_release(void * p_buffer)
+{
+    if (p_buffer == NULL)
+    {
+        return;
+    }
+
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+
+    slab_class_t * p_class = class_get_by_buffer(p_buffer);
+    NRF_MESH_ASSERT(p_class != NULL);
+
+    uint32_t offset = (uint32_t) ((uint8_t *) p_buffer - p_class->p_start);
+    uint32_t slab = (offset >> p_class->shift) / 3;
+    NRF_MESH_ASSERT(offset == ((slab * 3) << p_class->shift));
+    uint16_t index = (uint16_t) (p_class->first_index + slab);
+    /* Catches double releases: */
+    NRF_MESH_ASSERT(m_requested_len[index] != 0);
+
+    m_requested_bytes -= m_requested_len[index];
+    m_reserved_bytes -= p_class->stats.size;
+    m_requested_len[index] = 0;
+    p_class->stats.in_use--;
+
+    *slab_next_free_get(p_class, index) = p_class->free_head;
+    p_class->free_head = index;
+
+    _ENABLE_IRQS(was_masked);
+}
+
+void sar_slab_stats_get(sar_slab_stats_t * p_stats)
+{
+    NRF_MESH_ASSERT(p_stats != NULL);
+
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+    for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        p_stats->classes[i] = m_classes[i].stats;
+    }
+    p_stats->requested_bytes = m_requested_bytes;
+    p_stats->reserved_bytes = m_reserved_bytes;
+    p_stats->reserved_bytes_peak = m_reserved_bytes_peak;
+    p_stats->alloc_failures = m_alloc_failures;
+    _ENABLE_IRQS(was_masked);
+}
+
+void sar_slab_stats_reset(void)
+{
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+    for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        m_classes[i].stats.in_use_peak = m_classes[i].stats.in_use;
+        m_classes[i].stats.allocs = 0;
+        m_classes[i].stats.spills = 0;
+    }
+    m_reserved_bytes_peak = m_reserved_bytes;
+    m_alloc_failures = 0;
+    _ENABLE_IRQS(was_masked);
+}
@@ -42,6 +42,7 @@
 
 #include <nrf_error.h>
 
+#include "nordic_common.h"
 #include "utils.h"
 #include "log.h"
 #include "enc.h"
@@ -59,6 +60,7 @@
 #include "nrf_mesh_utils.h"
 #include "nrf_mesh_externs.h"
 #include "packet_mesh.h"
+#include "sar_slab.h"
 
 /*********************
  * Local definitions *
@@ -72,6 +74,14 @@
 #define TRANSPORT_UNSEG_PDU_LEN(control) ((control) ? PACKET_MESH_TRS_UNSEG_CONTROL_PDU_MAX_SIZE : PACKET_MESH_TRS_UNSEG_ACCESS_PDU_MAX_SIZE)
 
 #define SAR_TOKEN ((nrf_mesh_tx_token_t) 0x5E65E65E)
+/** Token for SAR TX segments, counted against the TX window when they're done. */
+#define SAR_SEGMENT_TOKEN ((nrf_mesh_tx_token_t) 0x5E65E65F)
+
+/** Upper limit for the number of SAR TX segments in flight. */
+#define TRANSPORT_SAR_TX_WINDOW_MAX (TRANSPORT_SAR_SEGMENT_COUNT_MAX * TRANSPORT_SAR_SESSIONS_MAX)
+
+/** Number of virtual address labels authenticated for each decryption of a packet. */
+#define VIRTUAL_LABEL_BATCH_SIZE (4)
 
 NRF_MESH_STATIC_ASSERT(IS_POWER_OF_2(TRANSPORT_SAR_RX_CACHE_LEN));
 /* The SEQZERO mask must be (power of two - 1) to work as a mask (ie if a bit in the mask is set to
@@ -79,6 +89,27 @@ NRF_MESH_STATIC_ASSERT(IS_POWER_OF_2(TRANSPORT_SAR_RX_CACHE_LEN));
 NRF_MESH_STATIC_ASSERT(IS_POWER_OF_2(TRANSPORT_SAR_SEQZERO_MASK + 1));
 
 #define TRANSPORT_SAR_RX_CACHE_LEN_MASK    (TRANSPORT_SAR_RX_CACHE_LEN - 1)
+/** Index marking the end of a SAR RX cache list. */
+#define SAR_RX_CACHE_INDEX_INVALID  (0xFFFF)
+NRF_MESH_STATIC_ASSERT(TRANSPORT_SAR_RX_CACHE_LEN < SAR_RX_CACHE_INDEX_INVALID);
+
+/** Index marking the end of a SAR session list. */
+#define SAR_SESSION_INDEX_INVALID   (0xFF)
+NRF_MESH_STATIC_ASSERT(TRANSPORT_SAR_SESSIONS_MAX > 0 && TRANSPORT_SAR_SESSIONS_MAX < SAR_SESSION_INDEX_INVALID);
+NRF_MESH_STATIC_ASSERT(TRANSPORT_SAR_SESSIONS_PER_PEER_MAX_DEFAULT > 0 &&
+                       TRANSPORT_SAR_SESSIONS_PER_PEER_MAX_DEFAULT <= TRANSPORT_SAR_SESSIONS_MAX);
+NRF_MESH_STATIC_ASSERT(TRANSPORT_SAR_SESSIONS_RX_RESERVED_DEFAULT < TRANSPORT_SAR_SESSIONS_MAX);
+NRF_MESH_STATIC_ASSERT(TRANSPORT_SAR_TX_WINDOW_DEFAULT > 0 && TRANSPORT_SAR_TX_WINDOW_DEFAULT <= TRANSPORT_SAR_TX_WINDOW_MAX);
+
+/* Round the session count up to the nearest power of two to get the number of lookup buckets. */
+#define SAR_SESSION_BUCKETS_0       (TRANSPORT_SAR_SESSIONS_MAX - 1)
+#define SAR_SESSION_BUCKETS_1       (SAR_SESSION_BUCKETS_0 | (SAR_SESSION_BUCKETS_0 >> 1))
+#define SAR_SESSION_BUCKETS_2       (SAR_SESSION_BUCKETS_1 | (SAR_SESSION_BUCKETS_1 >> 2))
+#define SAR_SESSION_BUCKETS_3       (SAR_SESSION_BUCKETS_2 | (SAR_SESSION_BUCKETS_2 >> 4))
+/** Number of buckets in the SAR session lookup table. */
+#define SAR_SESSION_BUCKETS         (SAR_SESSION_BUCKETS_3 + 1)
+/** Mask for wrapping SAR session bucket numbers. */
+#define SAR_SESSION_BUCKETS_MASK    (SAR_SESSION_BUCKETS - 1)
 /*********************
  * Local types *
  *********************/
@@ -98,6 +129,9 @@ typedef struct
     uint8_t tx_retries;                    /**< Number of retries before cancelling SAR session. */
     uint8_t segack_ttl; /**< Default TTL value for segment acknowledgement messages. */
     uint8_t szmic;      /**< Use 32- or 64-bit MIC for application payload. */
+    bool tx_retry_adaptive; /**< Derive the TX retry timeout from the measured round-trip time. */
+    uint16_t tx_window; /**< Max number of SAR TX segments in flight. */
+    timestamp_t segack_coalesce_window; /**< Time in which an ack without new segments is suppressed. */
 } transport_config_t;
 
 typedef struct
@@ -172,6 +206,8 @@ typedef struct
                 uint8_t  retries;               /**< Number of retries left. */
                 bool payload_encrypted;         /**< Flag indicating whether the payload has been encrypted. */
                 bool seqzero_is_set;         /**< Flag indicating whether the seqzero has been set. */
+                bool retransmitted;             /**< Flag indicating whether any segment has been sent more than once. */
+                timestamp_t sent_time;          /**< Time of the last segment transmission. */
                 nrf_mesh_tx_token_t token;      /**< TX Token set by the user. */
             } tx;
             /** Fields that are only valid for RX-sesssions */
@@ -180,6 +216,14 @@ typedef struct
                 /** Acknowledgement timer */
                 timer_event_t ack_timer;
                 sar_ack_state_t ack_state;
+#if TRANSPORT_SAR_RX_DECRYPT_STREAMING
+                /** Application key used to decrypt the segments as they arrive, or NULL if the
+                 * message is decrypted when it's complete. */
+                const nrf_mesh_application_secmat_t * p_stream_secmat;
+                /** Keystream position for the segments decrypted so far. */
+                ccm_soft_keystream_t keystream;
+                uint8_t nonce[CCM_NONCE_LENGTH];
+#endif
             } rx;
         } params;
     } session;
@@ -187,40 +231,105 @@ typedef struct
     * Re-segmented SAR payload with 4 byte MIC at the end.
     */
     uint8_t * payload;
+    /** Next session in the same lookup bucket, or the next free session if inactive. */
+    uint8_t next;
 } trs_sar_ctx_t;
 
+/** SAR session admission parameters and occupancy statistics. */
+typedef struct
+{
+    uint8_t per_peer_max;      /**< Max number of sessions with a single peer. */
+    uint8_t rx_reserved;       /**< Number of sessions TX can't use. */
+    uint8_t free_count;        /**< Number of sessions in the free list. */
+    uint8_t peak;              /**< Highest number of sessions in use at the same time. */
+    uint32_t rejected_no_mem;  /**< Sessions rejected because all sessions were in use. */
+    uint32_t rejected_quota;   /**< Sessions rejected by the admission policy. */
+} sar_session_pool_t;
+
+/** Round-trip time estimate for a unicast destination, as in RFC 6298. */
+typedef struct
+{
+    uint16_t dst;         /**< Destination address, or @ref NRF_MESH_ADDR_UNASSIGNED if unused. */
+    uint8_t backoff;      /**< Number of times the retry timeout has been doubled since the last sample. */
+    timestamp_t srtt;     /**< Smoothed round-trip time. */
+    timestamp_t rttvar;   /**< Round-trip time variation. */
+} sar_rtt_estimate_t;
+
+/** Sequence numbers reserved for a burst of SAR segments. */
+typedef struct
+{
+    uint32_t next;     /**< Next reserved sequence number. */
+    uint32_t count;    /**< Number of reserved sequence numbers left. */
+    uint32_t iv_index; /**< IV index the sequence numbers were reserved in. */
+} sar_tx_seqnums_t;
+
 /** Completed SAR session, used to cache previous sessions. */
 typedef struct
 {
     bool successful;
-    uint8_t ivi;
     uint16_t src;
+    /** Next session in the same lookup bucket, or the next free session if unused. */
+    uint16_t next;
+    uint32_t iv_index;
     uint32_t seqauth_seqnum;
 } completed_sar_session_t;
 
-/** A consumer of control packets. */
+/** Recently sent segment acknowledgment. */
 typedef struct
 {
-    const transport_control_packet_handler_t * p_handlers; /**< List of opcodes and their handler functions. */
-    uint32_t handler_count; /**< Number of handlers. */
-} control_packet_consumer_t;
+    uint16_t peer;         /**< Source of the acknowledged session, or @ref NRF_MESH_ADDR_UNASSIGNED if unused. */
+    uint16_t seq_zero;     /**< SeqZero of the acknowledged session. */
+    uint32_t block_ack;    /**< Acknowledged segments. */
+    timestamp_t sent_time; /**< Time the acknowledgment was sent. */
+} sar_ack_sent_t;
+
 /********************
  * Static variables *
  ********************/
 
 static transport_config_t m_trs_config;
 static trs_sar_ctx_t m_trs_sar_sessions[TRANSPORT_SAR_SESSIONS_MAX];
+/** Active SAR sessions, chained by peer address and direction. */
+static uint8_t m_sar_session_buckets[SAR_SESSION_BUCKETS];
+/** First session of the free session list. */
+static uint8_t m_sar_session_free_head;
+static sar_session_pool_t m_sar_session_pool;
 
 static transport_sar_alloc_t    m_sar_alloc;   /**< Allocation function for SAR packets. */
 static transport_sar_release_t  m_sar_release; /**< Release function for SAR packets. */
 
 static uint32_t m_sar_session_cache_head;
 static completed_sar_session_t m_sar_session_cache[TRANSPORT_SAR_RX_CACHE_LEN];
+/** Completed sessions, chained by source address. */
+static uint16_t m_sar_session_cache_buckets[TRANSPORT_SAR_RX_CACHE_LEN];
+/** First entry of the unused completed session list. */
+static uint16_t m_sar_session_cache_free_head;
+static uint32_t m_sar_session_cache_hits;
+static uint32_t m_sar_session_cache_misses;
+
+static sar_ack_sent_t m_sar_acks_sent[TRANSPORT_SAR_SEGACK_HISTORY_LEN];
+static uint32_t m_sar_acks_sent_head;
+static uint32_t m_sar_acks_suppressed;
+/** Whether any RX session has an ack waiting for room in the TX queue. */
+static bool m_sar_ack_pending;
+
+/** Number of SAR TX segments given to the network layer that haven't been sent on all their bearers yet. */
+static uint32_t m_sar_tx_in_flight;
+/** Number of SAR TX segments queued in each bearer that the bearer hasn't sent yet. */
+static uint16_t m_sar_tx_bearer_queued[CORE_TX_BEARER_COUNT_MAX];
+/** Whether any SAR TX segment has finished since the last retry timeout. */
+static bool m_sar_tx_progress;
+/** Next session to send a segment from when sharing the TX window. */
+static uint32_t m_sar_tx_next_session;
+
+static uint32_t m_sar_rtt_estimate_head;
+static sar_rtt_estimate_t m_sar_rtt_estimates[TRANSPORT_SAR_RTT_CACHE_LEN];
 
 /** Flag used to trigger SAR processing. */
 static bearer_event_flag_t m_sar_process_flag;
 
-static control_packet_consumer_t m_control_packet_consumers[TRANSPORT_CONTROL_PACKET_CONSUMERS_MAX];
+/** Control packet callbacks, indexed by opcode. */
+static transport_control_packet_callback_t m_control_packet_callbacks[TRANSPORT_CONTROL_PACKET_OPCODE_MAX + 1];
 static uint32_t m_control_packet_consumer_count;
 /********************
  * Static functions *
@@ -233,12 +342,14 @@ static void abort_timeout(timestamp_t timestamp, void * p_context);
 static inline uint32_t block_ack_full(transport_packet_metadata_t * p_metadata)
 {
     NRF_MESH_ASSERT(p_metadata->segmented);
-    return ((1u << (p_metadata->segmentation.last_segment + 1)) - 1);
+    /* Shifting down avoids an undefined shift by 32 for messages with 32 segments. */
+    return (UINT32_MAX >> (31 - p_metadata->segmentation.last_segment));
 }
 static void upper_transport_packet_in(const uint8_t * p_upper_trs_packet,
                                       uint32_t upper_trs_packet_len,
                                       transport_packet_metadata_t * p_metadata,
                                       const nrf_mesh_rx_metadata_t * p_rx_metadata);
+static void sar_rx_packet_in(trs_sar_ctx_t * p_sar_ctx, const nrf_mesh_rx_metadata_t * p_rx_metadata);
 
 static uint32_t seqauth_sequence_number_get(uint32_t seqnum, uint16_t seqzero)
 {
@@ -285,54 +396,367 @@ static inline uint32_t tx_retry_timer_delay_get(uint8_t ttl)
     return m_trs_config.tx_retry_base_timeout + m_trs_config.tx_retry_per_hop_addition * ttl;
 }
 
+static sar_rtt_estimate_t * sar_rtt_estimate_get(uint16_t dst)
+{
+    for (uint32_t i = 0; i < TRANSPORT_SAR_RTT_CACHE_LEN; ++i)
+    {
+        if (m_sar_rtt_estimates[i].dst == dst)
+        {
+            return &m_sar_rtt_estimates[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Add a round-trip time sample for a destination. The smoothing factors are the ones recommended
+ * by RFC 6298 (1/8 for the round-trip time, 1/4 for the variation).
+ *
+ * @param[in] dst    Unicast destination address.
+ * @param[in] sample Time from the last segment transmission until the acknowledgment arrived.
+ */
+static void sar_rtt_sample_add(uint16_t dst, timestamp_t sample)
+{
+    sar_rtt_estimate_t * p_estimate = sar_rtt_estimate_get(dst);
+    if (p_estimate == NULL)
+    {
+        p_estimate = &m_sar_rtt_estimates[m_sar_rtt_estimate_head];
+        m_sar_rtt_estimate_head = (m_sar_rtt_estimate_head + 1) % TRANSPORT_SAR_RTT_CACHE_LEN;
+        p_estimate->dst = dst;
+        p_estimate->srtt = sample;
+        p_estimate->rttvar = sample / 2;
+    }
+    else
+    {
+        timestamp_t deviation = (sample > p_estimate->srtt) ? (sample - p_estimate->srtt) : (p_estimate->srtt - sample);
+        p_estimate->rttvar = p_estimate->rttvar - p_estimate->rttvar / 4 + deviation / 4;
+        p_estimate->srtt = p_estimate->srtt - p_estimate->srtt / 8 + sample / 8;
+    }
+    p_estimate->backoff = 0;
+}
+
+static uint32_t sar_rtt_retry_timer_delay_get(const sar_rtt_estimate_t * p_estimate)
+{
+    uint32_t delay = p_estimate->srtt + 4 * p_estimate->rttvar;
+    for (uint32_t i = 0; i < p_estimate->backoff && delay < TRANSPORT_SAR_TX_RETRY_ADAPTIVE_MAX_US; ++i)
+    {
+        delay *= 2;
+    }
+
+    if (delay < TRANSPORT_SAR_TX_RETRY_ADAPTIVE_MIN_US)
+    {
+        return TRANSPORT_SAR_TX_RETRY_ADAPTIVE_MIN_US;
+    }
+    else if (delay > TRANSPORT_SAR_TX_RETRY_ADAPTIVE_MAX_US)
+    {
+        return TRANSPORT_SAR_TX_RETRY_ADAPTIVE_MAX_US;
+    }
+    return delay;
+}
+
+/**
+ * Get the TX retry timer delay for a session in adaptive mode.
+ *
+ * @param[in] p_sar_ctx TX session to get the delay for.
+ *
+ * @returns The retry delay, or 0 if there's no round-trip time estimate for the destination.
+ */
+static uint32_t sar_tx_adaptive_delay_get(const trs_sar_ctx_t * p_sar_ctx)
+{
+    if (!m_trs_config.tx_retry_adaptive ||
+        p_sar_ctx->metadata.net.dst.type != NRF_MESH_ADDRESS_TYPE_UNICAST)
+    {
+        return 0;
+    }
+
+    const sar_rtt_estimate_t * p_estimate = sar_rtt_estimate_get(p_sar_ctx->metadata.net.dst.value);
+    return (p_estimate == NULL) ? 0 : sar_rtt_retry_timer_delay_get(p_estimate);
+}
+
+static inline uint16_t * sar_rx_cache_bucket_get(uint16_t src)
+{
+    return &m_sar_session_cache_buckets[((src * 2654435761u) >> 16) & TRANSPORT_SAR_RX_CACHE_LEN_MASK];
+}
+
+static void sar_rx_cache_init(void)
+{
+    for (uint32_t i = 0; i < TRANSPORT_SAR_RX_CACHE_LEN; ++i)
+    {
+        m_sar_session_cache_buckets[i] = SAR_RX_CACHE_INDEX_INVALID;
+        m_sar_session_cache[i].next = (i + 1 < TRANSPORT_SAR_RX_CACHE_LEN) ? i + 1 : SAR_RX_CACHE_INDEX_INVALID;
+    }
+    m_sar_session_cache_free_head = 0;
+    m_sar_session_cache_head = 0;
+    m_sar_session_cache_hits = 0;
+    m_sar_session_cache_misses = 0;
+}
+
 /**
- * Check whether the RX SAR session has been handled before. As the sessions are stored in a FIFO
- * cache manner, getting a pointer to the completed session.
+ * Check whether a completed session can still get segments.
  *
- * @param[in] p_metadata Metadata to check for.
+ * @param[in] p_session       Completed session to check.
+ * @param[in] src             Source address of the received packet.
+ * @param[in] iv_index        IV index of the received packet.
+ * @param[in] sequence_number Sequence number of the received packet.
+ *
+ * @returns Whether the session has expired, and can be removed from the cache.
+ */
+static bool sar_rx_cache_entry_expired(const completed_sar_session_t * p_session,
+                                       uint16_t src,
+                                       uint32_t iv_index,
+                                       uint32_t sequence_number)
+{
+    if (p_session->iv_index + 1 < iv_index)
+    {
+        /* The network layer no longer accepts packets with the session's IV index. */
+        return true;
+    }
+
+    /* All segments of a session have sequence numbers within TRANSPORT_SAR_SEQNUM_DIFF_MAX of its
+     * SeqAuth, and the replay protection drops anything older than the current packet. */
+    return (p_session->src == src &&
+            p_session->iv_index == iv_index &&
+            p_session->seqauth_seqnum + TRANSPORT_SAR_SEQNUM_DIFF_MAX < sequence_number);
+}
+
+/**
+ * Check whether the RX SAR session has been handled before. Expired sessions found along the way
+ * are removed from the cache.
+ *
+ * @param[in]  p_metadata    Metadata to check for.
+ * @param[out] p_superseded  Set to whether a later session from the same source has been handled.
  *
  * @retval Pointer to the completed session from the cache if there is. NULL otherwise.
  */
-static completed_sar_session_t * sar_rx_session_previously_handled(const transport_packet_metadata_t * p_metadata)
+static completed_sar_session_t * sar_rx_session_previously_handled(const transport_packet_metadata_t * p_metadata,
+                                                                   bool * p_superseded)
 {
     NRF_MESH_ASSERT(p_metadata->segmented);
 
     uint16_t src = p_metadata->net.src;
-    uint8_t ivi = p_metadata->net.internal.iv_index & NETWORK_IVI_MASK;
-    uint32_t seqauth_seqnum = seqauth_sequence_number_get(p_metadata->net.internal.sequence_number,
+    uint32_t iv_index = p_metadata->net.internal.iv_index;
+    uint32_t sequence_number = p_metadata->net.internal.sequence_number;
+    uint32_t seqauth_seqnum = seqauth_sequence_number_get(sequence_number,
                                                           p_metadata->segmentation.seq_zero);
 
-    for (uint32_t i = 0; i < TRANSPORT_SAR_RX_CACHE_LEN; ++i)
+    *p_superseded = false;
+
+    /* Sessions are added to the front of the bucket, so later sessions come first. */
+    uint16_t * p_index = sar_rx_cache_bucket_get(src);
+    while (*p_index != SAR_RX_CACHE_INDEX_INVALID)
     {
-        if (seqauth_seqnum == m_sar_session_cache[i].seqauth_seqnum &&
-            src == m_sar_session_cache[i].src &&
-            ivi == m_sar_session_cache[i].ivi)
+        completed_sar_session_t * p_session = &m_sar_session_cache[*p_index];
+        if (seqauth_seqnum == p_session->seqauth_seqnum &&
+            src == p_session->src &&
+            iv_index == p_session->iv_index)
+        {
+            m_sar_session_cache_hits++;
+            return p_session;
+        }
+
+        if (src == p_session->src &&
+            (p_session->iv_index > iv_index ||
+             (p_session->iv_index == iv_index && p_session->seqauth_seqnum > seqauth_seqnum)))
+        {
+            *p_superseded = true;
+        }
+
+        if (sar_rx_cache_entry_expired(p_session, src, iv_index, sequence_number))
+        {
+            uint16_t index = *p_index;
+            *p_index = p_session->next;
+            p_session->next = m_sar_session_cache_free_head;
+            m_sar_session_cache_free_head = index;
+        }
+        else
         {
-            return &m_sar_session_cache[i];
+            p_index = &p_session->next;
         }
     }
+
+    m_sar_session_cache_misses++;
     return NULL;
 }
 
-
 /**
- * Places completed SAR session into the session cache.
+ * Take an entry from the completed session cache, evicting the oldest entries first once there
+ * are no unused ones left.
  *
- * @param[in] p_metadata SAR metadata handled.
- * @param[in] succeeded  The session has been succeeded or not.
+ * @returns Index of an unused cache entry.
  */
+static uint16_t sar_rx_cache_entry_get(void)
+{
+    uint16_t index = m_sar_session_cache_free_head;
+    if (index != SAR_RX_CACHE_INDEX_INVALID)
+    {
+        m_sar_session_cache_free_head = m_sar_session_cache[index].next;
+        return index;
+    }
+
+    index = m_sar_session_cache_head++ & TRANSPORT_SAR_RX_CACHE_LEN_MASK;
+    uint16_t * p_index = sar_rx_cache_bucket_get(m_sar_session_cache[index].src);
+    while (*p_index != index)
+    {
+        NRF_MESH_ASSERT(*p_index != SAR_RX_CACHE_INDEX_INVALID);
+        p_index = &m_sar_session_cache[*p_index].next;
+    }
+    *p_index = m_sar_session_cache[index].next;
+    return index;
+}
+
 static void sar_rx_session_mark_as_handled(const transport_packet_metadata_t * p_metadata, bool succeeded)
 {
     NRF_MESH_ASSERT(p_metadata->segmented);
 
-    completed_sar_session_t * p_completed_session = &m_sar_session_cache[m_sar_session_cache_head++ &
-                                                                         TRANSPORT_SAR_RX_CACHE_LEN_MASK];
+    uint16_t index = sar_rx_cache_entry_get();
+    completed_sar_session_t * p_completed_session = &m_sar_session_cache[index];
 
     p_completed_session->src = p_metadata->net.src;
     p_completed_session->seqauth_seqnum = seqauth_sequence_number_get(p_metadata->net.internal.sequence_number,
                                                                       p_metadata->segmentation.seq_zero);
-    p_completed_session->ivi = p_metadata->net.internal.iv_index & NETWORK_IVI_MASK;
+    p_completed_session->iv_index = p_metadata->net.internal.iv_index;
     p_completed_session->successful = succeeded;
+
+    uint16_t * p_bucket = sar_rx_cache_bucket_get(p_completed_session->src);
+    p_completed_session->next = *p_bucket;
+    *p_bucket = index;
+}
+
+static inline uint16_t sar_ctx_peer_get(const trs_sar_ctx_t * p_sar_ctx)
+{
+    return (p_sar_ctx->session.session_type == TRS_SAR_SESSION_RX ? p_sar_ctx->metadata.net.src
+                                                                 : p_sar_ctx->metadata.net.dst.value);
+}
+
+static inline uint32_t sar_session_bucket_get(uint16_t peer, trs_sar_session_t session_type)
+{
+    /* Fibonacci hashing, the upper bits of the product are the best mixed. */
+    uint32_t hash = ((((uint32_t) peer) << 1) | (session_type == TRS_SAR_SESSION_RX)) * 2654435761u;
+    return (hash >> 16) & SAR_SESSION_BUCKETS_MASK;
+}
+
+static void sar_session_pool_init(void)
+{
+    for (uint32_t i = 0; i < SAR_SESSION_BUCKETS; ++i)
+    {
+        m_sar_session_buckets[i] = SAR_SESSION_INDEX_INVALID;
+    }
+
+    for (uint32_t i = 0; i < TRANSPORT_SAR_SESSIONS_MAX; ++i)
+    {
+        m_trs_sar_sessions[i].next = (i + 1 < TRANSPORT_SAR_SESSIONS_MAX) ? i + 1 : SAR_SESSION_INDEX_INVALID;
+    }
+    m_sar_session_free_head = 0;
+
+    memset(&m_sar_session_pool, 0, sizeof(m_sar_session_pool));
+    m_sar_session_pool.per_peer_max = TRANSPORT_SAR_SESSIONS_PER_PEER_MAX_DEFAULT;
+    m_sar_session_pool.rx_reserved  = TRANSPORT_SAR_SESSIONS_RX_RESERVED_DEFAULT;
+    m_sar_session_pool.free_count   = TRANSPORT_SAR_SESSIONS_MAX;
+}
+
+/** Counts the active sessions in both directions with the given peer. */
+static uint32_t sar_session_peer_count_get(uint16_t peer)
+{
+    const trs_sar_session_t session_types[] = {TRS_SAR_SESSION_RX, TRS_SAR_SESSION_TX};
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < ARRAY_SIZE(session_types); ++i)
+    {
+        for (uint8_t index = m_sar_session_buckets[sar_session_bucket_get(peer, session_types[i])];
+             index != SAR_SESSION_INDEX_INVALID;
+             index = m_trs_sar_sessions[index].next)
+        {
+            if (m_trs_sar_sessions[index].session.session_type == session_types[i] &&
+                sar_ctx_peer_get(&m_trs_sar_sessions[index]) == peer)
+            {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * Takes an inactive session from the pool, if the admission policy allows a new session with the
+ * given peer.
+ *
+ * @param[in] peer         Source address of an RX session, or destination address of a TX session.
+ * @param[in] session_type Type of session to admit.
+ *
+ * @returns An inactive session that must be passed to either @ref sar_session_link or
+ * @ref sar_session_put, or NULL if the session was rejected.
+ */
+static trs_sar_ctx_t * sar_session_get(uint16_t peer, trs_sar_session_t session_type)
+{
+    trs_sar_ctx_t * p_sar_ctx = NULL;
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+    if (m_sar_session_pool.free_count == 0)
+    {
+        m_sar_session_pool.rejected_no_mem++;
+    }
+    else if ((session_type == TRS_SAR_SESSION_TX &&
+              m_sar_session_pool.free_count <= m_sar_session_pool.rx_reserved) ||
+             sar_session_peer_count_get(peer) >= m_sar_session_pool.per_peer_max)
+    {
+        m_sar_session_pool.rejected_quota++;
+    }
+    else
+    {
+        p_sar_ctx = &m_trs_sar_sessions[m_sar_session_free_head];
+        m_sar_session_free_head = p_sar_ctx->next;
+        m_sar_session_pool.free_count--;
+
+        uint8_t active = TRANSPORT_SAR_SESSIONS_MAX - m_sar_session_pool.free_count;
+        if (active > m_sar_session_pool.peak)
+        {
+            m_sar_session_pool.peak = active;
+        }
+    }
+    _ENABLE_IRQS(was_masked);
+    return p_sar_ctx;
+}
+
+/** Returns an inactive session to the pool. */
+static void sar_session_put(trs_sar_ctx_t * p_sar_ctx)
+{
+    NRF_MESH_ASSERT(p_sar_ctx->session.session_type == TRS_SAR_SESSION_INACTIVE);
+
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+    p_sar_ctx->next = m_sar_session_free_head;
+    m_sar_session_free_head = (uint8_t) (p_sar_ctx - &m_trs_sar_sessions[0]);
+    m_sar_session_pool.free_count++;
+    _ENABLE_IRQS(was_masked);
+}
+
+/** Makes an allocated session available for lookup. */
+static void sar_session_link(trs_sar_ctx_t * p_sar_ctx)
+{
+    uint32_t bucket = sar_session_bucket_get(sar_ctx_peer_get(p_sar_ctx), p_sar_ctx->session.session_type);
+
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+    p_sar_ctx->next = m_sar_session_buckets[bucket];
+    m_sar_session_buckets[bucket] = (uint8_t) (p_sar_ctx - &m_trs_sar_sessions[0]);
+    _ENABLE_IRQS(was_masked);
+}
+
+/** Removes an active session from the lookup table. */
+static void sar_session_unlink(trs_sar_ctx_t * p_sar_ctx)
+{
+    uint8_t index = (uint8_t) (p_sar_ctx - &m_trs_sar_sessions[0]);
+    uint32_t bucket = sar_session_bucket_get(sar_ctx_peer_get(p_sar_ctx), p_sar_ctx->session.session_type);
+
+    uint32_t was_masked;
+    _DISABLE_IRQS(was_masked);
+    uint8_t * p_link = &m_sar_session_buckets[bucket];
+    while (*p_link != index)
+    {
+        NRF_MESH_ASSERT(*p_link != SAR_SESSION_INDEX_INVALID);
+        p_link = &m_trs_sar_sessions[*p_link].next;
+    }
+    *p_link = p_sar_ctx->next;
+    _ENABLE_IRQS(was_masked);
 }
 
 /**
@@ -372,12 +796,13 @@ static bool sar_ctx_alloc(trs_sar_ctx_t * p_sar_ctx,
         p_sar_ctx->session.params.tx.retries = m_trs_config.tx_retries;
         p_sar_ctx->session.params.tx.payload_encrypted = false;
         p_sar_ctx->session.params.tx.seqzero_is_set = false;
+        p_sar_ctx->session.params.tx.retransmitted = false;
         p_sar_ctx->session.params.tx.start_index = 0;
         /* Set the TX token to indicate a SAR packet, use the SAR-TX token to keep the user-token.
          * This way we'll know that we got a TX complete on a SAR packet, so we can forward the TX
          * complete when the entire SAR packet is done. */
         p_sar_ctx->session.params.tx.token = p_metadata->token;
-        p_sar_ctx->metadata.token = SAR_TOKEN;
+        p_sar_ctx->metadata.token = SAR_SEGMENT_TOKEN;
         p_sar_ctx->timer_event.cb = retry_timeout;
         p_sar_ctx->timer_event.p_context = p_sar_ctx;
     }
@@ -404,7 +829,9 @@ static void sar_ctx_free(trs_sar_ctx_t * p_sar_ctx)
     {
         timer_sch_abort(&p_sar_ctx->session.params.rx.ack_timer);
     }
+    sar_session_unlink(p_sar_ctx);
     p_sar_ctx->session.session_type = TRS_SAR_SESSION_INACTIVE;
+    sar_session_put(p_sar_ctx);
     net_state_iv_index_lock(false);
 }
 
@@ -458,7 +885,12 @@ static void tx_retry_timer_reset(trs_sar_ctx_t * p_sar_ctx)
 {
     NRF_MESH_ASSERT(p_sar_ctx->session.session_type == TRS_SAR_SESSION_TX);
 
-    if (p_sar_ctx->metadata.net.dst.type == NRF_MESH_ADDRESS_TYPE_UNICAST)
+    uint32_t adaptive_delay = sar_tx_adaptive_delay_get(p_sar_ctx);
+    if (adaptive_delay != 0)
+    {
+        p_sar_ctx->timer_event.interval = adaptive_delay;
+    }
+    else if (p_sar_ctx->metadata.net.dst.type == NRF_MESH_ADDRESS_TYPE_UNICAST)
     {
         p_sar_ctx->timer_event.interval = tx_retry_timer_delay_get(p_sar_ctx->metadata.net.ttl);
     }
@@ -498,6 +930,7 @@ static void trs_packet_header_build(const transport_packet_metadata_t * p_metada
 static uint32_t upper_trs_packet_alloc(transport_packet_metadata_t * p_metadata,
                                         network_tx_packet_buffer_t * p_net_buf,
                                         uint32_t transport_data_len,
+                                        bool seqnum_reserved,
                                         uint8_t ** pp_upper_trs_payload)
 {
     uint32_t header_len = (p_metadata->segmented ?
@@ -506,7 +939,9 @@ static uint32_t upper_trs_packet_alloc(transport_packet_metadata_t * p_metadata,
     p_net_buf->user_data.payload_len = header_len + transport_data_len;
     p_net_buf->user_data.p_metadata = &p_metadata->net;
     p_net_buf->user_data.token = p_metadata->token;
-    uint32_t status = network_packet_alloc(p_net_buf);
+    uint32_t status = (seqnum_reserved ?
+                       network_packet_alloc_reserved(p_net_buf) :
+                       network_packet_alloc(p_net_buf));
     if (status == NRF_SUCCESS)
     {
         *pp_upper_trs_payload = &p_net_buf->p_payload[header_len];
@@ -514,16 +949,58 @@ static uint32_t upper_trs_packet_alloc(transport_packet_metadata_t * p_metadata,
     return status;
 }
 
+static void sar_ack_history_init(void)
+{
+    for (uint32_t i = 0; i < TRANSPORT_SAR_SEGACK_HISTORY_LEN; ++i)
+    {
+        m_sar_acks_sent[i].peer = NRF_MESH_ADDR_UNASSIGNED;
+    }
+    m_sar_acks_sent_head = 0;
+    m_sar_acks_suppressed = 0;
+    m_sar_ack_pending = false;
+}
+
+static sar_ack_sent_t * sar_ack_history_get(uint16_t peer, uint16_t seq_zero)
+{
+    for (uint32_t i = 0; i < TRANSPORT_SAR_SEGACK_HISTORY_LEN; ++i)
+    {
+        if (m_sar_acks_sent[i].peer == peer && m_sar_acks_sent[i].seq_zero == seq_zero)
+        {
+            return &m_sar_acks_sent[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Check whether an ack adds nothing to the previous ack for the same session.
+ *
+ * An ack is redundant if it doesn't acknowledge any new segments, and the previous ack was sent so
+ * recently that the sender can't have retransmitted anything in response to it yet. Block ack 0
+ * tells the sender that the session was rejected, and is only redundant after another rejection.
+ */
+static bool sar_ack_is_redundant(const sar_ack_sent_t * p_prev_ack, uint32_t block_ack, timestamp_t now)
+{
+    return (p_prev_ack != NULL &&
+            (block_ack & ~p_prev_ack->block_ack) == 0 &&
+            (block_ack == 0) == (p_prev_ack->block_ack == 0) &&
+            now - p_prev_ack->sent_time < m_trs_config.segack_coalesce_window);
+}
+
 /**
  * Ack the SAR session.
  *
  * @note Enforces specification rule saying only to ack if the destination address is a unicast
  * address (Mesh Profile Specification v1.0, section 3.5.3.4).
  *
+ * @note Acks that are redundant with a recently sent ack are suppressed, see
+ * @ref sar_ack_is_redundant.
+ *
  * @param[in] p_metadata Metadata of the SAR session to ack.
  * @param[in] block_ack Ack bitfield value.
  *
- * @retval NRF_SUCCESS The ack was successful, or the session was not directed to a unicast address.
+ * @retval NRF_SUCCESS The ack was successful or suppressed, or the session was not directed to a
+ *                     unicast address.
  * @retval NRF_ERROR_NO_MEM
  */
 static uint32_t sar_ack_send(const transport_packet_metadata_t * p_metadata, uint32_t block_ack)
@@ -532,6 +1009,14 @@ static uint32_t sar_ack_send(const transport_packet_metadata_t * p_metadata, uin
     uint32_t status = NRF_SUCCESS;
     if (p_metadata->net.dst.type == NRF_MESH_ADDRESS_TYPE_UNICAST)
     {
+        timestamp_t now = timer_now();
+        sar_ack_sent_t * p_prev_ack = sar_ack_history_get(p_metadata->net.src, p_metadata->segmentation.seq_zero);
+        if (sar_ack_is_redundant(p_prev_ack, block_ack, now))
+        {
+            m_sar_acks_suppressed++;
+            return NRF_SUCCESS;
+        }
+
         packet_mesh_trs_control_packet_t packet_buffer;
         memset(&packet_buffer, 0, sizeof(packet_buffer));
         packet_mesh_trs_control_segack_seqzero_set(&packet_buffer, p_metadata->segmentation.seq_zero);
@@ -562,40 +1047,221 @@ static uint32_t sar_ack_send(const transport_packet_metadata_t * p_metadata, uin
         if (status == NRF_SUCCESS)
         {
             __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_ACK_QUEUED, 0, PACKET_MESH_TRS_CONTROL_SEGACK_SIZE, &packet_buffer);
+
+            if (p_prev_ack == NULL)
+            {
+                p_prev_ack = &m_sar_acks_sent[m_sar_acks_sent_head++ % TRANSPORT_SAR_SEGACK_HISTORY_LEN];
+                p_prev_ack->peer = p_metadata->net.src;
+                p_prev_ack->seq_zero = p_metadata->segmentation.seq_zero;
+            }
+            p_prev_ack->block_ack = block_ack;
+            p_prev_ack->sent_time = now;
         }
     }
     return status;
 }
 
+/**
+ * Finds the TX session acknowledged by the given segment acknowledgment.
+ *
+ * @param[in] p_metadata Metadata of the acknowledgment, sent by the TX session's destination.
+ * @param[in] seq_zero   SeqZero of the acknowledged session.
+ */
 static trs_sar_ctx_t * sar_active_tx_ctx_get(transport_packet_metadata_t * p_metadata, uint16_t seq_zero)
 {
-    for (int i = 0; i < TRANSPORT_SAR_SESSIONS_MAX; i++)
+    for (uint8_t index = m_sar_session_buckets[sar_session_bucket_get(p_metadata->net.src, TRS_SAR_SESSION_TX)];
+         index != SAR_SESSION_INDEX_INVALID;
+         index = m_trs_sar_sessions[index].next)
     {
-        if (m_trs_sar_sessions[i].session.session_type == TRS_SAR_SESSION_TX &&
-            m_trs_sar_sessions[i].metadata.net.src == p_metadata->net.dst.value &&
-            m_trs_sar_sessions[i].metadata.segmentation.seq_zero == seq_zero)
+        trs_sar_ctx_t * p_sar_ctx = &m_trs_sar_sessions[index];
+        if (p_sar_ctx->session.session_type == TRS_SAR_SESSION_TX &&
+            p_sar_ctx->session.params.tx.seqzero_is_set &&
+            p_sar_ctx->metadata.net.dst.value == p_metadata->net.src &&
+            p_sar_ctx->metadata.net.src == p_metadata->net.dst.value &&
+            p_sar_ctx->metadata.segmentation.seq_zero == seq_zero)
         {
-            return &m_trs_sar_sessions[i];
+            return p_sar_ctx;
         }
     }
 
     return NULL;
 }
 
+/**
+ * Finds the RX session from the source of the given segment.
+ *
+ * A peer only has one RX session at the time, so the lookup doesn't include the SeqZero. This lets
+ * the caller tell a segment from an older session from one that replaces the current session.
+ */
 static trs_sar_ctx_t * sar_active_rx_ctx_get(transport_packet_metadata_t * p_metadata)
 {
-    for (int i = 0; i < TRANSPORT_SAR_SESSIONS_MAX; i++)
+    for (uint8_t index = m_sar_session_buckets[sar_session_bucket_get(p_metadata->net.src, TRS_SAR_SESSION_RX)];
+         index != SAR_SESSION_INDEX_INVALID;
+         index = m_trs_sar_sessions[index].next)
     {
-        if (m_trs_sar_sessions[i].session.session_type == TRS_SAR_SESSION_RX &&
-            m_trs_sar_sessions[i].metadata.net.src == p_metadata->net.src)
+        trs_sar_ctx_t * p_sar_ctx = &m_trs_sar_sessions[index];
+        if (p_sar_ctx->session.session_type == TRS_SAR_SESSION_RX &&
+            p_sar_ctx->metadata.net.src == p_metadata->net.src)
         {
-            return &m_trs_sar_sessions[i];
+            return p_sar_ctx;
         }
     }
 
     return NULL;
 }
 
+/**
+ * Creates a SAR session, if the admission policy allows it and there's memory for the payload.
+ *
+ * @param[in] p_metadata   Metadata of the session.
+ * @param[in] session_type Type of session to create.
+ * @param[in] length       Length of the session payload, including the MIC.
+ *
+ * @returns The new session, or NULL if it couldn't be created.
+ */
+static trs_sar_ctx_t * sar_ctx_create(const transport_packet_metadata_t * p_metadata,
+                                      trs_sar_session_t session_type,
+                                      uint32_t length)
+{
+    uint16_t peer = (session_type == TRS_SAR_SESSION_RX ? p_metadata->net.src : p_metadata->net.dst.value);
+    trs_sar_ctx_t * p_sar_ctx = sar_session_get(peer, session_type);
+    if (p_sar_ctx == NULL)
+    {
+        return NULL;
+    }
+
+    if (!sar_ctx_alloc(p_sar_ctx, p_metadata, session_type, length))
+    {
+        sar_session_put(p_sar_ctx);
+        return NULL;
+    }
+
+    sar_session_link(p_sar_ctx);
+    return p_sar_ctx;
+}
+
+#if TRANSPORT_SAR_RX_DECRYPT_STREAMING
+/**
+ * Prepare an RX session for decrypting its segments as they arrive.
+ *
+ * The keystream depends on the key, so this is only done if there's a single application key
+ * candidate. Virtual destinations are decrypted on completion, as the label is part of the MIC
+ * calculation, and there can be several label candidates.
+ *
+ * @param[in,out] p_sar_ctx RX session to prepare.
+ */
+static void sar_rx_stream_start(trs_sar_ctx_t * p_sar_ctx)
+{
+    const transport_packet_metadata_t * p_metadata = &p_sar_ctx->metadata;
+    p_sar_ctx->session.params.rx.p_stream_secmat = NULL;
+
+    if (p_metadata->net.control_packet ||
+        !p_metadata->type.access.using_app_key ||
+        p_metadata->net.dst.type == NRF_MESH_ADDRESS_TYPE_VIRTUAL)
+    {
+        return;
+    }
+
+    const nrf_mesh_application_secmat_t * p_secmat = NULL;
+    nrf_mesh_app_secmat_next_get(p_metadata->net.p_security_material,
+                                 p_metadata->type.access.app_key_id,
+                                 &p_secmat);
+    if (p_secmat == NULL)
+    {
+        return;
+    }
+
+    const nrf_mesh_application_secmat_t * p_next_secmat = p_secmat;
+    nrf_mesh_app_secmat_next_get(p_metadata->net.p_security_material,
+                                 p_metadata->type.access.app_key_id,
+                                 &p_next_secmat);
+    if (p_next_secmat != NULL)
+    {
+        return;
+    }
+
+    /* The session metadata already has the SeqAuth sequence number. */
+    enc_nonce_generate(&p_metadata->net,
+                       ENC_NONCE_APP,
+                       (p_metadata->mic_size == PACKET_MESH_TRS_TRANSMIC_LARGE_SIZE),
+                       p_sar_ctx->session.params.rx.nonce);
+    memset(&p_sar_ctx->session.params.rx.keystream, 0, sizeof(p_sar_ctx->session.params.rx.keystream));
+    p_sar_ctx->session.params.rx.p_stream_secmat = p_secmat;
+}
+
+/**
+ * Apply the keystream of a streamed RX session to a part of its payload.
+ *
+ * @param[in,out] p_sar_ctx RX session to decrypt.
+ * @param[in]     offset    Offset of the part in the payload.
+ * @param[in]     length    Length of the part.
+ */
+static void sar_rx_stream_crypt(trs_sar_ctx_t * p_sar_ctx, uint32_t offset, uint32_t length)
+{
+    ccm_soft_data_t ccm_data;
+    memset(&ccm_data, 0, sizeof(ccm_data));
+    ccm_data.p_key   = p_sar_ctx->session.params.rx.p_stream_secmat->key;
+    ccm_data.p_nonce = p_sar_ctx->session.params.rx.nonce;
+    ccm_data.p_m     = &p_sar_ctx->payload[offset];
+    ccm_data.p_out   = &p_sar_ctx->payload[offset];
+    ccm_data.m_len   = length;
+    enc_aes_ccm_keystream_apply(&ccm_data, offset, &p_sar_ctx->session.params.rx.keystream);
+}
+
+/**
+ * Decrypt a received segment, unless it might contain MIC bytes.
+ *
+ * The MIC can span the last two segments, and the message length isn't known until the last one
+ * arrives, so those are left for @ref sar_rx_stream_finish.
+ */
+static void sar_rx_stream_segment_in(trs_sar_ctx_t * p_sar_ctx, uint8_t segment_offset)
+{
+    if (p_sar_ctx->session.params.rx.p_stream_secmat != NULL &&
+        segment_offset + 2 <= p_sar_ctx->metadata.segmentation.last_segment)
+    {
+        sar_rx_stream_crypt(p_sar_ctx,
+                            segment_offset * TRANSPORT_SAR_PDU_LEN(false),
+                            TRANSPORT_SAR_PDU_LEN(false));
+    }
+}
+
+/**
+ * Decrypt the rest of a complete streamed RX session, and authenticate it.
+ *
+ * @param[in,out] p_sar_ctx RX session to finish.
+ *
+ * @returns Whether the message passed the MIC check. If it didn't, the payload is restored to its
+ * encrypted form.
+ */
+static bool sar_rx_stream_finish(trs_sar_ctx_t * p_sar_ctx)
+{
+    uint32_t message_len = p_sar_ctx->session.length - p_sar_ctx->metadata.mic_size;
+    uint32_t streamed_len = 0;
+    if (p_sar_ctx->metadata.segmentation.last_segment >= 2)
+    {
+        streamed_len = (p_sar_ctx->metadata.segmentation.last_segment - 1) * TRANSPORT_SAR_PDU_LEN(false);
+    }
+    sar_rx_stream_crypt(p_sar_ctx, streamed_len, message_len - streamed_len);
+
+    ccm_soft_data_t ccm_data;
+    memset(&ccm_data, 0, sizeof(ccm_data));
+    ccm_data.p_key   = p_sar_ctx->session.params.rx.p_stream_secmat->key;
+    ccm_data.p_nonce = p_sar_ctx->session.params.rx.nonce;
+    ccm_data.p_m     = p_sar_ctx->payload;
+    ccm_data.m_len   = message_len;
+    ccm_data.p_mic   = &p_sar_ctx->payload[message_len];
+    ccm_data.mic_len = p_sar_ctx->metadata.mic_size;
+
+    bool mic_passed = false;
+    enc_aes_ccm_decrypted_authenticate(&ccm_data, &mic_passed);
+    if (!mic_passed)
+    {
+        sar_rx_stream_crypt(p_sar_ctx, 0, message_len);
+    }
+    return mic_passed;
+}
+#endif /* TRANSPORT_SAR_RX_DECRYPT_STREAMING */
+
 static trs_sar_ctx_t * sar_rx_ctx_create(transport_packet_metadata_t * p_metadata)
 {
     uint32_t total_length = (p_metadata->segmentation.last_segment + 1) *
@@ -607,22 +1273,14 @@ static trs_sar_ctx_t * sar_rx_ctx_create(transport_packet_metadata_t * p_metadat
         return NULL;
     }
 
-
-    /* Check if the packet is part of an ongoing transaction. */
-    for (int i = 0; i < TRANSPORT_SAR_SESSIONS_MAX; ++i)
+    trs_sar_ctx_t * p_sar_ctx = sar_ctx_create(p_metadata, TRS_SAR_SESSION_RX, total_length);
+#if TRANSPORT_SAR_RX_DECRYPT_STREAMING
+    if (p_sar_ctx != NULL)
     {
-        if (m_trs_sar_sessions[i].session.session_type == TRS_SAR_SESSION_INACTIVE)
-        {
-            if (!sar_ctx_alloc(&m_trs_sar_sessions[i], p_metadata, TRS_SAR_SESSION_RX, total_length))
-            {
-                break;
-            }
-
-            return &m_trs_sar_sessions[i];
-        }
+        sar_rx_stream_start(p_sar_ctx);
     }
-
-    return NULL;
+#endif
+    return p_sar_ctx;
 }
 
 static void trs_sar_seg_packet_in(const uint8_t * p_segment_payload,
@@ -647,10 +1305,16 @@ static void trs_sar_seg_packet_in(const uint8_t * p_segment_payload,
     }
 
     /* Look for session in the cache */
-    completed_sar_session_t * p_completed_session = sar_rx_session_previously_handled(p_metadata);
+    bool superseded;
+    completed_sar_session_t * p_completed_session = sar_rx_session_previously_handled(p_metadata, &superseded);
     if (NULL != p_completed_session)
     {
-        if (p_completed_session->successful)
+        if (superseded)
+        {
+            /* The sender has started a later session, so it's no longer waiting for this ack. */
+            m_sar_acks_suppressed++;
+        }
+        else if (p_completed_session->successful)
         {
             /* Already successfully processed this session. */
             (void) sar_ack_send(p_metadata, block_ack_full(p_metadata));
@@ -709,6 +1373,9 @@ static void trs_sar_seg_packet_in(const uint8_t * p_segment_payload,
                                TRANSPORT_SAR_PDU_LEN(p_metadata->net.control_packet)],
            p_segment_payload,
            segment_len);
+#if TRANSPORT_SAR_RX_DECRYPT_STREAMING
+    sar_rx_stream_segment_in(p_sar_ctx, p_metadata->segmentation.segment_offset);
+#endif
 
     if (p_sar_ctx->session.block_ack == block_ack_full(&p_sar_ctx->metadata))
     {
@@ -717,16 +1384,17 @@ static void trs_sar_seg_packet_in(const uint8_t * p_segment_payload,
         uint32_t ack_status = sar_ack_send(&p_sar_ctx->metadata, p_sar_ctx->session.block_ack);
 
         /* All packets have arrived */
-        upper_transport_packet_in(p_sar_ctx->payload,
-                                p_sar_ctx->session.length,
-                                &p_sar_ctx->metadata,
-                                p_rx_metadata);
+        sar_rx_packet_in(p_sar_ctx, p_rx_metadata);
 
         if (ack_status == NRF_SUCCESS)
         {
             p_sar_ctx->session.params.rx.ack_state = SAR_ACK_STATE_IDLE;
             sar_ctx_rx_complete(p_sar_ctx);
         }
+        else
+        {
+            m_sar_ack_pending = true;
+        }
     }
 }
 
@@ -745,6 +1413,52 @@ static bool test_transport_decrypt(const nrf_mesh_application_secmat_t * p_app_s
     return mic_passed;
 }
 
+/**
+ * Tries to decrypt a packet to a virtual address with all matching application keys and virtual
+ * address labels.
+ *
+ * The label is only used as additional data, so each application key decrypts the packet once
+ * for a whole batch of labels, and only the authentication is repeated for each label.
+ */
+static uint32_t virtual_dst_decrypt(transport_packet_metadata_t * p_metadata, ccm_soft_data_t * p_ccm_data)
+{
+    /* The first matching label has already been looked up by the caller. */
+    nrf_mesh_address_t label_iter = p_metadata->net.dst;
+    bool labels_left = true;
+
+    while (labels_left)
+    {
+        const uint8_t * p_labels[VIRTUAL_LABEL_BATCH_SIZE];
+        uint32_t label_count = 0;
+        do
+        {
+            p_labels[label_count++] = label_iter.p_virtual_uuid;
+            labels_left = nrf_mesh_rx_address_get(label_iter.value, &label_iter);
+        } while (labels_left && label_count < VIRTUAL_LABEL_BATCH_SIZE);
+
+        p_metadata->p_security_material = NULL;
+        for (nrf_mesh_app_secmat_next_get(p_metadata->net.p_security_material,
+                                          p_metadata->type.access.app_key_id,
+                                          &p_metadata->p_security_material);
+             p_metadata->p_security_material != NULL;
+             nrf_mesh_app_secmat_next_get(p_metadata->net.p_security_material,
+                                          p_metadata->type.access.app_key_id,
+                                          &p_metadata->p_security_material))
+        {
+            p_ccm_data->p_key = p_metadata->p_security_material->key;
+            uint32_t label_index = enc_aes_ccm_decrypt_ad_candidates(p_ccm_data, p_labels, label_count);
+            if (label_index < label_count)
+            {
+                p_metadata->net.dst.p_virtual_uuid = p_labels[label_index];
+                __LOG(LOG_SRC_TRANSPORT, LOG_LEVEL_INFO, "Message decrypted\n");
+                return NRF_SUCCESS;
+            }
+        }
+    }
+
+    return NRF_ERROR_NOT_FOUND;
+}
+
 static void upper_trs_packet_encrypt(const uint8_t * p_unencrypted_upper_trs_packet,
                                      uint8_t * p_encrypted_upper_trs_packet,
                                      uint32_t upper_trs_payload_len,
@@ -874,6 +1588,7 @@ static uint32_t unsegmented_packet_tx(transport_packet_metadata_t * p_metadata,
     uint32_t status = upper_trs_packet_alloc(p_metadata,
                                              &net_buf,
                                              payload_len + p_metadata->mic_size,
+                                             false,
                                              &p_packet_buffer_payload);
     if (status == NRF_SUCCESS)
     {
@@ -893,7 +1608,63 @@ static uint32_t unsegmented_packet_tx(transport_packet_metadata_t * p_metadata,
     return status;
 }
 
-static bool sar_segment_send(trs_sar_ctx_t * p_sar_ctx, uint32_t segment_index)
+/**
+ * Count a SAR TX segment as in flight until all the bearers it was queued on have sent it.
+ *
+ * Every bearer sends its packets in the order they were queued, so the segments that are still in
+ * flight are the last ones queued on the bearer with the most segments left to send.
+ *
+ * @param[in] bearers Bearers the segment was queued on.
+ */
+static void sar_tx_in_flight_add(core_tx_bearer_bitmap_t bearers)
+{
+    bearer_event_critical_section_begin();
+    for (uint32_t i = 0; i < CORE_TX_BEARER_COUNT_MAX; ++i)
+    {
+        if (bearers & (1u << i))
+        {
+            m_sar_tx_bearer_queued[i]++;
+            m_sar_tx_in_flight = MAX(m_sar_tx_in_flight, m_sar_tx_bearer_queued[i]);
+        }
+    }
+    bearer_event_critical_section_end();
+}
+
+/**
+ * Count a SAR TX segment as sent on one of its bearers.
+ *
+ * @param[in] bearer_index Index of the bearer that sent the segment.
+ */
+static void sar_tx_in_flight_remove(uint32_t bearer_index)
+{
+    NRF_MESH_ASSERT(bearer_index < CORE_TX_BEARER_COUNT_MAX);
+    bearer_event_critical_section_begin();
+    /* The retry timeout forgets the queued segments if their TX completes were lost. */
+    if (m_sar_tx_bearer_queued[bearer_index] > 0)
+    {
+        m_sar_tx_bearer_queued[bearer_index]--;
+
+        m_sar_tx_in_flight = 0;
+        for (uint32_t i = 0; i < CORE_TX_BEARER_COUNT_MAX; ++i)
+        {
+            m_sar_tx_in_flight = MAX(m_sar_tx_in_flight, m_sar_tx_bearer_queued[i]);
+        }
+    }
+    bearer_event_critical_section_end();
+}
+
+/**
+ * Forget all SAR TX segments in flight.
+ */
+static void sar_tx_in_flight_reset(void)
+{
+    bearer_event_critical_section_begin();
+    m_sar_tx_in_flight = 0;
+    memset(m_sar_tx_bearer_queued, 0, sizeof(m_sar_tx_bearer_queued));
+    bearer_event_critical_section_end();
+}
+
+static bool sar_segment_send(trs_sar_ctx_t * p_sar_ctx, uint32_t segment_index, sar_tx_seqnums_t * p_seqnums)
 {
     uint32_t segment_len = TRANSPORT_SAR_PDU_LEN(p_sar_ctx->metadata.net.control_packet);
     uint32_t payload_offset = segment_len * segment_index;
@@ -904,15 +1675,26 @@ static bool sar_segment_send(trs_sar_ctx_t * p_sar_ctx, uint32_t segment_index)
         segment_len = p_sar_ctx->session.length - payload_offset;
     }
 
+    if (p_seqnums->count == 0)
+    {
+        return false;
+    }
+
     p_sar_ctx->metadata.segmentation.segment_offset = segment_index;
+    p_sar_ctx->metadata.net.internal.sequence_number = p_seqnums->next;
+    p_sar_ctx->metadata.net.internal.iv_index = p_seqnums->iv_index;
     network_tx_packet_buffer_t net_buf;
     uint8_t * p_segment_payload;
     uint32_t status = upper_trs_packet_alloc(&p_sar_ctx->metadata,
                                              &net_buf,
                                              segment_len,
+                                             true,
                                              &p_segment_payload);
     if (status == NRF_SUCCESS)
     {
+        p_seqnums->next++;
+        p_seqnums->count--;
+
         if (segment_index == 0 && !p_sar_ctx->session.params.tx.seqzero_is_set)
         {
             p_sar_ctx->metadata.segmentation.seq_zero =
@@ -934,6 +1716,8 @@ static bool sar_segment_send(trs_sar_ctx_t * p_sar_ctx, uint32_t segment_index)
 
         trs_packet_header_build(&p_sar_ctx->metadata, (packet_mesh_trs_packet_t *) net_buf.p_payload);
         memcpy(p_segment_payload, &p_sar_ctx->payload[payload_offset], segment_len);
+        /* Count the segment before it's sent, as the bearers may complete it right away. */
+        sar_tx_in_flight_add(net_buf.bearers);
         network_packet_send(&net_buf);
     }
 
@@ -941,15 +1725,20 @@ static bool sar_segment_send(trs_sar_ctx_t * p_sar_ctx, uint32_t segment_index)
 }
 
 /**
- * Send SAR segments.
+ * Send the next unacknowledged segment of a TX session, if the TX window has room for it.
  *
- * @param[in,out] p_sar_ctx SAR context to send segments of.
+ * @param[in,out] p_sar_ctx SAR context to send a segment of.
+ * @param[in,out] p_seqnums Sequence numbers reserved for the current burst.
  *
- * @returns Number of segments sent.
+ * @returns Whether a segment was sent.
  */
-static uint32_t trs_sar_packet_out(trs_sar_ctx_t * p_sar_ctx)
+static bool trs_sar_segment_next_send(trs_sar_ctx_t * p_sar_ctx, sar_tx_seqnums_t * p_seqnums)
 {
-    uint32_t sent_segments = 0;
+    if (m_sar_tx_in_flight >= m_trs_config.tx_window)
+    {
+        return false;
+    }
+
     /* Starts at start_index if, e.g., there was no memory available last round. */
     for (uint8_t i = p_sar_ctx->session.params.tx.start_index;
          i <= p_sar_ctx->metadata.segmentation.last_segment;
@@ -958,18 +1747,109 @@ static uint32_t trs_sar_packet_out(trs_sar_ctx_t * p_sar_ctx)
         if ((p_sar_ctx->session.block_ack & (1u << i)) == 0)
         {
             /* packet hasn't been acked yet */
-            if (sar_segment_send(p_sar_ctx, i))
-            {
-                sent_segments++;
-                /* Set the start index to the next packet, so we know where to pick up in case of failure: */
-                p_sar_ctx->session.params.tx.start_index = i + 1;
-            }
-            else
+            if (!sar_segment_send(p_sar_ctx, i, p_seqnums))
             {
-                break;
+                return false;
             }
+
+            /* Set the start index to the next packet, so we know where to pick up next time: */
+            p_sar_ctx->session.params.tx.start_index = i + 1;
+            p_sar_ctx->session.params.tx.sent_time = timer_now();
+            return true;
+        }
+    }
+
+    p_sar_ctx->session.params.tx.start_index = p_sar_ctx->metadata.segmentation.last_segment + 1;
+    return false;
+}
+
+/**
+ * Get the number of segments a TX session has left to send in the current round.
+ *
+ * @param[in] p_sar_ctx SAR context to count the segments of.
+ *
+ * @returns Number of unacknowledged segments from the session's start index.
+ */
+static uint32_t sar_tx_segments_unsent_count(const trs_sar_ctx_t * p_sar_ctx)
+{
+    uint32_t count = 0;
+    for (uint32_t i = p_sar_ctx->session.params.tx.start_index;
+         i <= p_sar_ctx->metadata.segmentation.last_segment;
+         ++i)
+    {
+        if ((p_sar_ctx->session.block_ack & (1u << i)) == 0)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Reserve sequence numbers for a burst of segments in one go, instead of allocating them one by one.
+ *
+ * The reservation is limited by the room in the TX window. Sequence numbers that are left when the
+ * burst ends, for instance because the TX queue is full, are handed back by @ref sar_tx_burst_end.
+ *
+ * @param[in] segment_count Number of segments that are ready to be sent.
+ * @param[out] p_seqnums Sequence numbers reserved for the burst.
+ *
+ * @returns Whether any sequence numbers were reserved.
+ */
+static bool sar_tx_burst_begin(uint32_t segment_count, sar_tx_seqnums_t * p_seqnums)
+{
+    if (m_sar_tx_in_flight >= m_trs_config.tx_window)
+    {
+        return false;
+    }
+
+    segment_count = MIN(segment_count, m_trs_config.tx_window - m_sar_tx_in_flight);
+    segment_count = MIN(segment_count, NETWORK_SEQNUM_RESERVE_MAX);
+    if (segment_count == 0 ||
+        net_state_seqnum_reserve(segment_count, &p_seqnums->next) != NRF_SUCCESS)
+    {
+        return false;
+    }
+
+    /* Read the IV index after the reservation, as it may trigger an IV update. */
+    p_seqnums->iv_index = net_state_tx_iv_index_get();
+    p_seqnums->count = segment_count;
+    return true;
+}
+
+static void sar_tx_burst_end(sar_tx_seqnums_t * p_seqnums)
+{
+    if (p_seqnums->count > 0)
+    {
+        net_state_seqnum_unreserve(p_seqnums->next, p_seqnums->count);
+        p_seqnums->count = 0;
+    }
+}
+
+/**
+ * Send SAR segments, until all unacknowledged segments are sent or the TX window is full.
+ *
+ * @note May be called from the application, so the burst is protected against the SAR processing
+ * in the bearer event handler, which sends segments of the same sessions.
+ *
+ * @param[in,out] p_sar_ctx SAR context to send segments of.
+ *
+ * @returns Number of segments sent.
+ */
+static uint32_t trs_sar_packet_out(trs_sar_ctx_t * p_sar_ctx)
+{
+    uint32_t sent_segments = 0;
+    sar_tx_seqnums_t seqnums;
+    bearer_event_critical_section_begin();
+    if (sar_tx_burst_begin(sar_tx_segments_unsent_count(p_sar_ctx), &seqnums))
+    {
+        while (trs_sar_segment_next_send(p_sar_ctx, &seqnums))
+        {
+            sent_segments++;
         }
+        sar_tx_burst_end(&seqnums);
     }
+    bearer_event_critical_section_end();
     return sent_segments;
 }
 
@@ -982,24 +1862,8 @@ static uint32_t segmented_packet_tx(const transport_packet_metadata_t * p_metada
     {
         return NRF_ERROR_INVALID_LENGTH;
     }
-    trs_sar_ctx_t * p_sar_ctx = NULL;
-    uint32_t was_masked;
-    _DISABLE_IRQS(was_masked); //TODO: Can this be changed to bearer_event_critical_section, or removed all-together?
-    for (int i = 0; i < TRANSPORT_SAR_SESSIONS_MAX; ++i)
-    {
-        if (m_trs_sar_sessions[i].session.session_type == TRS_SAR_SESSION_INACTIVE)
-        {
-            p_sar_ctx = &m_trs_sar_sessions[i];
-            break;
-        }
-    }
-    _ENABLE_IRQS(was_masked);
-
-    if (p_sar_ctx == NULL)
-    {
-        return NRF_ERROR_NO_MEM;
-    }
-    if (sar_ctx_alloc(p_sar_ctx, p_metadata, TRS_SAR_SESSION_TX, packet_length))
+    trs_sar_ctx_t * p_sar_ctx = sar_ctx_create(p_metadata, TRS_SAR_SESSION_TX, packet_length);
+    if (p_sar_ctx != NULL)
     {
         memcpy(p_sar_ctx->payload, p_payload, payload_len);
 
@@ -1021,24 +1885,59 @@ static uint32_t segmented_packet_tx(const transport_packet_metadata_t * p_metada
 }
 
 
-/** Process ongoing SAR TX sessions. */
+/**
+ * Process ongoing SAR TX sessions.
+ *
+ * The active sessions take turns sending one segment at a time, so that long sessions can't keep
+ * the TX window to themselves.
+ */
 static void trs_sar_tx_process(void)
 {
-    /* Loop through all active sessions and (re-)transmit remaining packets. */
+    uint32_t segment_count = 0;
     for (uint32_t i = 0; i < TRANSPORT_SAR_SESSIONS_MAX; ++i)
     {
         if (m_trs_sar_sessions[i].session.session_type == TRS_SAR_SESSION_TX)
         {
-            if (trs_sar_packet_out(&m_trs_sar_sessions[i]) != 0)
+            segment_count += sar_tx_segments_unsent_count(&m_trs_sar_sessions[i]);
+        }
+    }
+
+    sar_tx_seqnums_t seqnums;
+    if (!sar_tx_burst_begin(segment_count, &seqnums))
+    {
+        return;
+    }
+
+    bool segment_sent;
+    do
+    {
+        segment_sent = false;
+        for (uint32_t i = 0;
+             i < TRANSPORT_SAR_SESSIONS_MAX && m_sar_tx_in_flight < m_trs_config.tx_window;
+             ++i)
+        {
+            trs_sar_ctx_t * p_sar_ctx = &m_trs_sar_sessions[m_sar_tx_next_session];
+            m_sar_tx_next_session = (m_sar_tx_next_session + 1) % TRANSPORT_SAR_SESSIONS_MAX;
+
+            if (p_sar_ctx->session.session_type == TRS_SAR_SESSION_TX &&
+                trs_sar_segment_next_send(p_sar_ctx, &seqnums))
             {
-                tx_retry_timer_reset(&m_trs_sar_sessions[i]);
+                tx_retry_timer_reset(p_sar_ctx);
+                segment_sent = true;
             }
         }
-    }
+    } while (segment_sent && m_sar_tx_in_flight < m_trs_config.tx_window);
+    sar_tx_burst_end(&seqnums);
 }
 
 static void trs_sar_rx_process(void)
 {
+    if (!m_sar_ack_pending)
+    {
+        return;
+    }
+
+    m_sar_ack_pending = false;
     for (uint32_t i = 0; i < TRANSPORT_SAR_SESSIONS_MAX; ++i)
     {
         if (m_trs_sar_sessions[i].session.session_type == TRS_SAR_SESSION_RX &&
@@ -1052,6 +1951,10 @@ static void trs_sar_rx_process(void)
                     sar_ctx_rx_complete(&m_trs_sar_sessions[i]);
                 }
             }
+            else
+            {
+                m_sar_ack_pending = true;
+            }
         }
     }
 }
@@ -1101,29 +2004,26 @@ static uint32_t upper_trs_packet_decrypt(transport_packet_metadata_t * p_metadat
 
     if (p_metadata->type.access.using_app_key)
     {
-        do {
-            if (p_metadata->net.dst.type == NRF_MESH_ADDRESS_TYPE_VIRTUAL)
-            {
-                ccm_data.p_a = p_metadata->net.dst.p_virtual_uuid;
-            }
+        if (p_metadata->net.dst.type == NRF_MESH_ADDRESS_TYPE_VIRTUAL)
+        {
+            return virtual_dst_decrypt(p_metadata, &ccm_data);
+        }
 
-            /* Application key */
-            p_metadata->p_security_material = NULL;
-            for (nrf_mesh_app_secmat_next_get(p_metadata->net.p_security_material,
-                                              p_metadata->type.access.app_key_id,
-                                              &p_metadata->p_security_material);
-                 p_metadata->p_security_material != NULL;
-                 nrf_mesh_app_secmat_next_get(p_metadata->net.p_security_material,
-                                              p_metadata->type.access.app_key_id,
-                                              &p_metadata->p_security_material))
+        /* Application key */
+        p_metadata->p_security_material = NULL;
+        for (nrf_mesh_app_secmat_next_get(p_metadata->net.p_security_material,
+                                          p_metadata->type.access.app_key_id,
+                                          &p_metadata->p_security_material);
+             p_metadata->p_security_material != NULL;
+             nrf_mesh_app_secmat_next_get(p_metadata->net.p_security_material,
+                                          p_metadata->type.access.app_key_id,
+                                          &p_metadata->p_security_material))
+        {
+            if (test_transport_decrypt(p_metadata->p_security_material, &ccm_data))
             {
-                if (test_transport_decrypt(p_metadata->p_security_material, &ccm_data))
-                {
-                    return NRF_SUCCESS;
-                }
+                return NRF_SUCCESS;
             }
-        } while (p_metadata->net.dst.type == NRF_MESH_ADDRESS_TYPE_VIRTUAL &&
-                 nrf_mesh_rx_address_get(p_metadata->net.dst.value, &p_metadata->net.dst));
+        }
     }
     else
     {
@@ -1207,6 +2107,18 @@ static void segack_packet_in(const packet_mesh_trs_control_packet_t * p_trs_cont
     {
         __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_TRS_ACK_RECEIVED, 0, control_packet_len, p_trs_control_packet);
 
+        bool new_segments_acked = ((block_ack & ~p_sar_ctx->session.block_ack) != 0);
+        timestamp_t time_since_send = 0;
+        if (m_trs_config.tx_retry_adaptive && new_segments_acked)
+        {
+            time_since_send = timer_now() - p_sar_ctx->session.params.tx.sent_time;
+            /* Only sessions without retransmissions give unambiguous samples (Karn's algorithm). */
+            if (!p_sar_ctx->session.params.tx.retransmitted)
+            {
+                sar_rtt_sample_add(p_sar_ctx->metadata.net.dst.value, time_since_send);
+            }
+        }
+
         p_sar_ctx->session.block_ack |= block_ack;
         if (block_ack == 0)
         {
@@ -1223,28 +2135,26 @@ static void segack_packet_in(const packet_mesh_trs_control_packet_t * p_trs_cont
              * is a valid acknowledgment for the segmented message, then the lower transport layer
              * shall reset the segment transmission timer and retransmit all unacknowledged Lower
              * Transport PDUs." */
-             p_sar_ctx->session.params.tx.start_index = 0;
-             (void) trs_sar_packet_out(p_sar_ctx); /* Ignore return, as we'll reset the retry timer regardless. */
-             tx_retry_timer_reset(p_sar_ctx);
+            uint32_t adaptive_delay = sar_tx_adaptive_delay_get(p_sar_ctx);
+            if (adaptive_delay != 0 && !new_segments_acked &&
+                TIMER_OLDER_THAN(timer_now(), p_sar_ctx->session.params.tx.sent_time + adaptive_delay / 2))
+            {
+                /* The ack doesn't report any progress, and was most likely sent before our last
+                 * retransmission arrived. Let the retry timer handle it instead of repeating the
+                 * segments that are still in flight. */
+                return;
+            }
+            p_sar_ctx->session.params.tx.start_index = 0;
+            p_sar_ctx->session.params.tx.retransmitted = true;
+            (void) trs_sar_packet_out(p_sar_ctx); /* Ignore return, as we'll reset the retry timer regardless. */
+            tx_retry_timer_reset(p_sar_ctx);
         }
     }
 }
 
-static transport_control_packet_callback_t control_packet_callback_get(transport_control_opcode_t opcode)
+static inline transport_control_packet_callback_t control_packet_callback_get(transport_control_opcode_t opcode)
 {
-    for (uint32_t consumer = 0; consumer < m_control_packet_consumer_count; ++consumer)
-    {
-        const control_packet_consumer_t * p_consumer = &m_control_packet_consumers[consumer];
-        for (uint32_t handler = 0; handler < p_consumer->handler_count; ++handler)
-        {
-            const transport_control_packet_handler_t * p_handler = &p_consumer->p_handlers[handler];
-            if (p_handler->opcode == opcode)
-            {
-                return p_handler->callback;
-            }
-        }
-    }
-    return NULL;
+    return m_control_packet_callbacks[(uint8_t) opcode & TRANSPORT_CONTROL_PACKET_OPCODE_MAX];
 }
 
 static void transport_control_packet_in(const packet_mesh_trs_control_packet_t * p_trs_control_packet,
@@ -1280,6 +2190,27 @@ static void transport_control_packet_in(const packet_mesh_trs_control_packet_t *
     }
 }
 
+static void access_message_deliver(const uint8_t * p_message,
+                                   uint32_t message_len,
+                                   const transport_packet_metadata_t * p_metadata,
+                                   const nrf_mesh_rx_metadata_t * p_rx_metadata)
+{
+    nrf_mesh_address_t src_address = {.type = NRF_MESH_ADDRESS_TYPE_UNICAST,
+                                    .value = p_metadata->net.src,
+                                    .p_virtual_uuid = NULL};
+    nrf_mesh_evt_t rx_event;
+    rx_event.type = NRF_MESH_EVT_MESSAGE_RECEIVED;
+    rx_event.params.message.p_buffer = p_message;
+    rx_event.params.message.length = message_len;
+    rx_event.params.message.src = src_address;
+    rx_event.params.message.dst = p_metadata->net.dst;
+    rx_event.params.message.ttl = p_metadata->net.ttl;
+    rx_event.params.message.secmat.p_net = p_metadata->net.p_security_material;
+    rx_event.params.message.secmat.p_app = p_metadata->p_security_material;
+    rx_event.params.message.p_metadata = p_rx_metadata;
+    event_handle(&rx_event);
+}
+
 static void upper_transport_access_packet_in(const uint8_t * p_upper_trs_packet,
                                              uint32_t upper_trs_packet_len,
                                              transport_packet_metadata_t * p_metadata,
@@ -1295,20 +2226,7 @@ static void upper_transport_access_packet_in(const uint8_t * p_upper_trs_packet,
                                 upper_trs_packet_len - p_metadata->mic_size,
                                 p_upper_trs_packet);
 
-        nrf_mesh_address_t src_address = {.type = NRF_MESH_ADDRESS_TYPE_UNICAST,
-                                        .value = p_metadata->net.src,
-                                        .p_virtual_uuid = NULL};
-        nrf_mesh_evt_t rx_event;
-        rx_event.type = NRF_MESH_EVT_MESSAGE_RECEIVED;
-        rx_event.params.message.p_buffer = decrypt_buffer;
-        rx_event.params.message.length = upper_trs_packet_len - p_metadata->mic_size;
-        rx_event.params.message.src = src_address;
-        rx_event.params.message.dst = p_metadata->net.dst;
-        rx_event.params.message.ttl = p_metadata->net.ttl;
-        rx_event.params.message.secmat.p_net = p_metadata->net.p_security_material;
-        rx_event.params.message.secmat.p_app = p_metadata->p_security_material;
-        rx_event.params.message.p_metadata = p_rx_metadata;
-        event_handle(&rx_event);
+        access_message_deliver(decrypt_buffer, upper_trs_packet_len - p_metadata->mic_size, p_metadata, p_rx_metadata);
     }
     else
     {
@@ -1340,6 +2258,35 @@ static void upper_transport_packet_in(const uint8_t * p_upper_trs_packet,
     }
 }
 
+/** Process the message of a complete RX session. */
+static void sar_rx_packet_in(trs_sar_ctx_t * p_sar_ctx, const nrf_mesh_rx_metadata_t * p_rx_metadata)
+{
+#if TRANSPORT_SAR_RX_DECRYPT_STREAMING
+    if (p_sar_ctx->session.params.rx.p_stream_secmat != NULL)
+    {
+        if (sar_rx_stream_finish(p_sar_ctx))
+        {
+            __LOG(LOG_SRC_TRANSPORT, LOG_LEVEL_INFO, "Message decrypted\n");
+            p_sar_ctx->metadata.p_security_material = p_sar_ctx->session.params.rx.p_stream_secmat;
+            __INTERNAL_EVENT_PUSH(INTERNAL_EVENT_DECRYPT_TRS,
+                                  0,
+                                  p_sar_ctx->session.length - p_sar_ctx->metadata.mic_size,
+                                  p_sar_ctx->payload);
+            access_message_deliver(p_sar_ctx->payload,
+                                   p_sar_ctx->session.length - p_sar_ctx->metadata.mic_size,
+                                   &p_sar_ctx->metadata,
+                                   p_rx_metadata);
+            return;
+        }
+        /* The application keys may have changed during the session. Try all of them. */
+    }
+#endif
+    upper_transport_packet_in(p_sar_ctx->payload,
+                              p_sar_ctx->session.length,
+                              &p_sar_ctx->metadata,
+                              p_rx_metadata);
+}
+
 static void ack_timeout(timestamp_t timestamp, void * p_context)
 {
     trs_sar_ctx_t * p_sar_ctx = p_context;
@@ -1349,6 +2296,10 @@ static void ack_timeout(timestamp_t timestamp, void * p_context)
     {
         p_sar_ctx->session.params.rx.ack_state = SAR_ACK_STATE_IDLE;
     }
+    else
+    {
+        m_sar_ack_pending = true;
+    }
 }
 
 static void retry_timeout(timestamp_t timestamp, void * p_context)
@@ -1373,7 +2324,31 @@ static void retry_timeout(timestamp_t timestamp, void * p_context)
     {
         p_sar_ctx->session.params.tx.retries--;
         p_sar_ctx->session.params.tx.start_index = 0;
+        p_sar_ctx->session.params.tx.retransmitted = true;
+        if (m_sar_tx_in_flight >= m_trs_config.tx_window && !m_sar_tx_progress)
+        {
+            /* No segments have finished for a whole retry period, so the ones we're waiting for
+             * must have been dropped without a TX complete, e.g. by a GATT bearer that
+             * disconnected. */
+            sar_tx_in_flight_reset();
+        }
+        m_sar_tx_progress = false;
         (void) trs_sar_packet_out(p_sar_ctx);/* Ignore return, as the timer will be rescheduled regardless. */
+
+        if (m_trs_config.tx_retry_adaptive &&
+            p_sar_ctx->metadata.net.dst.type == NRF_MESH_ADDRESS_TYPE_UNICAST)
+        {
+            /* Back off until the next valid round-trip time sample. */
+            sar_rtt_estimate_t * p_estimate = sar_rtt_estimate_get(p_sar_ctx->metadata.net.dst.value);
+            if (p_estimate != NULL)
+            {
+                if (p_estimate->backoff < UINT8_MAX)
+                {
+                    p_estimate->backoff++;
+                }
+                p_sar_ctx->timer_event.interval = sar_rtt_retry_timer_delay_get(p_estimate);
+            }
+        }
     }
 }
 
@@ -1385,7 +2360,12 @@ static void abort_timeout(timestamp_t timestamp, void * p_context)
 
 static void tx_complete(core_tx_role_t role, uint32_t bearer_index, uint32_t timestamp, nrf_mesh_tx_token_t token)
 {
-    if (role == CORE_TX_ROLE_ORIGINATOR && token != SAR_TOKEN)
+    if (token == SAR_SEGMENT_TOKEN)
+    {
+        sar_tx_in_flight_remove(bearer_index);
+        m_sar_tx_progress = true;
+    }
+    else if (role == CORE_TX_ROLE_ORIGINATOR && token != SAR_TOKEN)
     {
         /* This tx complete came from the application. */
         nrf_mesh_evt_t evt;
@@ -1396,7 +2376,7 @@ static void tx_complete(core_tx_role_t role, uint32_t bearer_index, uint32_t tim
     bearer_event_flag_set(m_sar_process_flag);
 }
 
-static uint32_t upper_transport_tx(transport_packet_metadata_t * p_metadata, const uint8_t * p_data, uint32_t data_len)
+static uint32_t upper_transport_tx_metadata_check(const transport_packet_metadata_t * p_metadata)
 {
     if (nrf_mesh_address_type_get(p_metadata->net.src) != NRF_MESH_ADDRESS_TYPE_UNICAST ||
         p_metadata->net.dst.type == NRF_MESH_ADDRESS_TYPE_INVALID ||
@@ -1408,6 +2388,16 @@ static uint32_t upper_transport_tx(transport_packet_metadata_t * p_metadata, con
     {
         return NRF_ERROR_INVALID_PARAM;
     }
+    return NRF_SUCCESS;
+}
+
+static uint32_t upper_transport_tx(transport_packet_metadata_t * p_metadata, const uint8_t * p_data, uint32_t data_len)
+{
+    uint32_t status = upper_transport_tx_metadata_check(p_metadata);
+    if (status != NRF_SUCCESS)
+    {
+        return status;
+    }
 
     if (p_metadata->segmented)
     {
@@ -1418,19 +2408,52 @@ static uint32_t upper_transport_tx(transport_packet_metadata_t * p_metadata, con
         return unsegmented_packet_tx(p_metadata, p_data, data_len);
     }
 }
+
+static uint32_t control_tx_params_check(const transport_control_packet_t * p_params)
+{
+    if (p_params == NULL ||
+        p_params->p_data == NULL ||
+        p_params->p_net_secmat == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+    if (p_params->dst.type == NRF_MESH_ADDRESS_TYPE_VIRTUAL ||
+        p_params->dst.type == NRF_MESH_ADDRESS_TYPE_INVALID)
+    {
+        return NRF_ERROR_INVALID_ADDR;
+    }
+    if ((uint8_t) p_params->opcode > TRANSPORT_CONTROL_PACKET_OPCODE_MAX)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    return NRF_SUCCESS;
+}
 /**************
  * Public API *
  **************/
 void transport_init(const nrf_mesh_init_params_t * p_init_params)
 {
+#if TRANSPORT_SAR_SLAB_ALLOCATOR
+    sar_slab_init();
+#endif
     transport_sar_mem_funcs_reset();
 
     memset(&m_trs_sar_sessions[0], 0, sizeof(m_trs_sar_sessions));
+    sar_session_pool_init();
 
     replay_cache_init();
 
-    m_sar_session_cache_head = 0;
     memset(m_sar_session_cache, 0, sizeof(m_sar_session_cache));
+    sar_rx_cache_init();
+
+    m_sar_rtt_estimate_head = 0;
+    memset(m_sar_rtt_estimates, 0, sizeof(m_sar_rtt_estimates));
+
+    sar_ack_history_init();
+
+    sar_tx_in_flight_reset();
+    m_sar_tx_progress = false;
+    m_sar_tx_next_session = 0;
 
     m_trs_config.rx_timeout                = TRANSPORT_SAR_RX_TIMEOUT_DEFAULT_US;
     m_trs_config.rx_ack_base_timeout       = TRANSPORT_SAR_RX_ACK_BASE_TIMEOUT_DEFAULT_US;
@@ -1440,8 +2463,12 @@ void transport_init(const nrf_mesh_init_params_t * p_init_params)
     m_trs_config.tx_retries                = TRANSPORT_SAR_TX_RETRIES_DEFAULT;
     m_trs_config.szmic                     = NRF_MESH_TRANSMIC_SIZE_SMALL;
     m_trs_config.segack_ttl                = TRANSPORT_SAR_SEGACK_TTL_DEFAULT;
+    m_trs_config.tx_retry_adaptive         = TRANSPORT_SAR_TX_RETRY_ADAPTIVE_DEFAULT;
+    m_trs_config.tx_window                 = TRANSPORT_SAR_TX_WINDOW_DEFAULT;
+    m_trs_config.segack_coalesce_window    = TRANSPORT_SAR_SEGACK_COALESCE_WINDOW_DEFAULT_US;
     m_sar_process_flag = bearer_event_flag_add(transport_sar_process);
     m_control_packet_consumer_count = 0;
+    memset(m_control_packet_callbacks, 0, sizeof(m_control_packet_callbacks));
 
     core_tx_complete_cb_set(tx_complete);
 
@@ -1469,7 +2496,11 @@ uint32_t transport_sar_mem_funcs_set(transport_sar_alloc_t alloc_func, transport
 
 void transport_sar_mem_funcs_reset(void)
 {
+#if TRANSPORT_SAR_SLAB_ALLOCATOR
+    NRF_MESH_ERROR_CHECK(transport_sar_mem_funcs_set(sar_slab_alloc, sar_slab_release));
+#else
     NRF_MESH_ERROR_CHECK(transport_sar_mem_funcs_set(malloc, free));
+#endif
 }
 
 uint32_t transport_packet_in(const packet_mesh_trs_packet_t * p_packet,
@@ -1570,26 +2601,81 @@ uint32_t transport_tx(const nrf_mesh_tx_params_t * p_params, uint32_t * const p_
 
 uint32_t transport_control_tx(const transport_control_packet_t * p_params, nrf_mesh_tx_token_t tx_token)
 {
-    if (p_params == NULL ||
-        p_params->p_data == NULL ||
-        p_params->p_net_secmat == NULL)
+    uint32_t status = control_tx_params_check(p_params);
+    if (status != NRF_SUCCESS)
+    {
+        return status;
+    }
+
+    transport_packet_metadata_t metadata;
+    transport_metadata_from_control_tx_params(&metadata, p_params, tx_token);
+
+    return upper_transport_tx(&metadata, p_params->p_data->pdu, p_params->data_len);
+}
+
+uint32_t transport_control_tx_template_init(transport_control_tx_template_t * p_template,
+                                            const transport_control_packet_t * p_params)
+{
+    if (p_template == NULL)
     {
         return NRF_ERROR_NULL;
     }
-    if (p_params->dst.type == NRF_MESH_ADDRESS_TYPE_VIRTUAL ||
-        p_params->dst.type == NRF_MESH_ADDRESS_TYPE_INVALID)
+    uint32_t status = control_tx_params_check(p_params);
+    if (status != NRF_SUCCESS)
     {
-        return NRF_ERROR_INVALID_ADDR;
+        return status;
     }
-    if ((uint8_t) p_params->opcode > TRANSPORT_CONTROL_PACKET_OPCODE_MAX)
+
+    transport_packet_metadata_t metadata;
+    transport_metadata_from_control_tx_params(&metadata, p_params, 0);
+    if (p_params->reliable)
     {
         return NRF_ERROR_INVALID_PARAM;
     }
+    if (metadata.segmented)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    status = upper_transport_tx_metadata_check(&metadata);
+    if (status != NRF_SUCCESS)
+    {
+        return status;
+    }
 
-    transport_packet_metadata_t metadata;
-    transport_metadata_from_control_tx_params(&metadata, p_params, tx_token);
+    packet_mesh_trs_packet_t header;
+    memset(&header, 0, PACKET_MESH_TRS_UNSEG_PDU_OFFSET);
+    trs_packet_header_build(&metadata, &header);
 
-    return upper_transport_tx(&metadata, p_params->p_data->pdu, p_params->data_len);
+    p_template->net = metadata.net;
+    p_template->header = header.pdu[0];
+    p_template->data_len = p_params->data_len;
+    return NRF_SUCCESS;
+}
+
+uint32_t transport_control_tx_template_send(const transport_control_tx_template_t * p_template,
+                                            const packet_mesh_trs_control_packet_t * p_data,
+                                            nrf_mesh_tx_token_t tx_token)
+{
+    if (p_template == NULL || p_data == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    /* The network layer writes the sequence number into the metadata, keep the template untouched. */
+    network_packet_metadata_t net_metadata = p_template->net;
+    network_tx_packet_buffer_t net_buf;
+    net_buf.user_data.payload_len = PACKET_MESH_TRS_UNSEG_PDU_OFFSET + p_template->data_len;
+    net_buf.user_data.p_metadata = &net_metadata;
+    net_buf.user_data.token = tx_token;
+
+    uint32_t status = network_packet_alloc(&net_buf);
+    if (status == NRF_SUCCESS)
+    {
+        net_buf.p_payload[0] = p_template->header;
+        memcpy(&net_buf.p_payload[PACKET_MESH_TRS_UNSEG_PDU_OFFSET], p_data->pdu, p_template->data_len);
+        network_packet_send(&net_buf);
+    }
+    return status;
 }
 
 uint32_t transport_opt_set(nrf_mesh_opt_id_t id, const nrf_mesh_opt_t * const p_opt)
@@ -1675,6 +2761,99 @@ uint32_t transport_opt_set(nrf_mesh_opt_id_t id, const nrf_mesh_opt_t * const p_
             m_trs_config.szmic = p_opt->opt.val;
             break;
 
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_PER_PEER_MAX:
+            if (p_opt->opt.val < 1 || p_opt->opt.val > TRANSPORT_SAR_SESSIONS_MAX)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_sar_session_pool.per_peer_max = (uint8_t) p_opt->opt.val;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_RX_RESERVED:
+            if (p_opt->opt.val >= TRANSPORT_SAR_SESSIONS_MAX)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_sar_session_pool.rx_reserved = (uint8_t) p_opt->opt.val;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_PEAK:
+            if (p_opt->opt.val != 0)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_sar_session_pool.peak = TRANSPORT_SAR_SESSIONS_MAX - m_sar_session_pool.free_count;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_NO_MEM:
+            if (p_opt->opt.val != 0)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_sar_session_pool.rejected_no_mem = 0;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_QUOTA:
+            if (p_opt->opt.val != 0)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_sar_session_pool.rejected_quota = 0;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE:
+            return NRF_ERROR_INVALID_PARAM;
+
+        case NRF_MESH_OPT_TRS_SAR_TX_RETRY_ADAPTIVE:
+            if (p_opt->opt.val > 1)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_trs_config.tx_retry_adaptive = (p_opt->opt.val == 1);
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_TX_WINDOW:
+            if (p_opt->opt.val < 1 || p_opt->opt.val > TRANSPORT_SAR_TX_WINDOW_MAX)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_trs_config.tx_window = (uint16_t) p_opt->opt.val;
+            /* Release more segments right away if the window got bigger. */
+            bearer_event_flag_set(m_sar_process_flag);
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_RX_CACHE_HITS:
+            if (p_opt->opt.val != 0)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_sar_session_cache_hits = 0;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_RX_CACHE_MISSES:
+            if (p_opt->opt.val != 0)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_sar_session_cache_misses = 0;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SEGACK_COALESCE_WINDOW:
+            if (p_opt->opt.val > TRANSPORT_SAR_SEGACK_COALESCE_WINDOW_MAX)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_trs_config.segack_coalesce_window = p_opt->opt.val;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SEGACK_SUPPRESSED:
+            if (p_opt->opt.val != 0)
+            {
+                return NRF_ERROR_INVALID_PARAM;
+            }
+            m_sar_acks_suppressed = 0;
+            break;
+
         default:
             return NRF_ERROR_NOT_FOUND;
     }
@@ -1723,6 +2902,54 @@ uint32_t transport_opt_get(nrf_mesh_opt_id_t id, nrf_mesh_opt_t * const p_opt)
             p_opt->opt.val = m_trs_config.szmic;
             break;
 
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_PER_PEER_MAX:
+            p_opt->opt.val = m_sar_session_pool.per_peer_max;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_RX_RESERVED:
+            p_opt->opt.val = m_sar_session_pool.rx_reserved;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE:
+            p_opt->opt.val = TRANSPORT_SAR_SESSIONS_MAX - m_sar_session_pool.free_count;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_PEAK:
+            p_opt->opt.val = m_sar_session_pool.peak;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_NO_MEM:
+            p_opt->opt.val = m_sar_session_pool.rejected_no_mem;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_QUOTA:
+            p_opt->opt.val = m_sar_session_pool.rejected_quota;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_TX_RETRY_ADAPTIVE:
+            p_opt->opt.val = m_trs_config.tx_retry_adaptive;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_TX_WINDOW:
+            p_opt->opt.val = m_trs_config.tx_window;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_RX_CACHE_HITS:
+            p_opt->opt.val = m_sar_session_cache_hits;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_RX_CACHE_MISSES:
+            p_opt->opt.val = m_sar_session_cache_misses;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SEGACK_COALESCE_WINDOW:
+            p_opt->opt.val = m_trs_config.segack_coalesce_window;
+            break;
+
+        case NRF_MESH_OPT_TRS_SAR_SEGACK_SUPPRESSED:
+            p_opt->opt.val = m_sar_acks_suppressed;
+            break;
+
         default:
             return NRF_ERROR_NOT_FOUND;
     }
@@ -1759,8 +2986,14 @@ uint32_t transport_control_packet_consumer_add(const transport_control_packet_ha
         }
     }
 
-    m_control_packet_consumers[m_control_packet_consumer_count].p_handlers = p_handlers;
-    m_control_packet_consumers[m_control_packet_consumer_count].handler_count = handler_count;
+    for (uint32_t i = 0; i < handler_count; ++i)
+    {
+        /* The first handler for an opcode wins, as with a linear search through the handlers. */
+        if (m_control_packet_callbacks[p_handlers[i].opcode] == NULL)
+        {
+            m_control_packet_callbacks[p_handlers[i].opcode] = p_handlers[i].callback;
+        }
+    }
     m_control_packet_consumer_count++;
     return NRF_SUCCESS;
 }
@@ -0,0 +1,119 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "benchmark.h"
+
+uint64_t benchmark_timestamp_ns(void)
+{
+    struct timespec now;
+    (void) clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+void benchmark_throughput_report(const char * p_benchmark,
+                                 const char * p_case,
+                                 uint32_t param,
+                                 uint64_t operations,
+                                 uint64_t elapsed_ns)
+{
+    double ops_per_sec = (elapsed_ns > 0) ? ((double) operations * 1e9) / (double) elapsed_ns : 0.0;
+
+    printf("{\"benchmark\": \"%s\", \"case\": \"%s\", \"param\": %u, \"operations\": %llu, "
+           "\"elapsed_ns\": %llu, \"ops_per_sec\": %.0f}\n",
+           p_benchmark,
+           p_case,
+           param,
+           (unsigned long long) operations,
+           (unsigned long long) elapsed_ns,
+           ops_per_sec);
+}
+
+void benchmark_metric_report(const char * p_benchmark,
+                             const char * p_case,
+                             uint32_t param,
+                             const char * p_metric,
+                             double value)
+{
+    printf("{\"benchmark\": \"%s\", \"case\": \"%s\", \"param\": %u, \"metric\": \"%s\", \"value\": %.2f}\n",
+           p_benchmark,
+           p_case,
+           param,
+           p_metric,
+           value);
+}
+
+static int sample_compare(const void * p_a, const void * p_b)
+{
+    uint64_t a = *(const uint64_t *) p_a;
+    uint64_t b = *(const uint64_t *) p_b;
+    return (a > b) - (a < b);
+}
+
+/* Nearest-rank percentile of a sorted sample set. */
+static uint64_t percentile_get(const uint64_t * p_sorted, uint32_t count, uint32_t percent)
+{
+    uint32_t rank = (uint32_t) (((uint64_t) count * percent + 99) / 100);
+    return p_sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+void benchmark_latency_report(const char * p_benchmark,
+                              const char * p_case,
+                              uint32_t param,
+                              uint64_t * p_samples_ns,
+                              uint32_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    qsort(p_samples_ns, count, sizeof(p_samples_ns[0]), sample_compare);
+
+    printf("{\"benchmark\": \"%s\", \"case\": \"%s\", \"param\": %u, \"samples\": %u, "
+           "\"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu}\n",
+           p_benchmark,
+           p_case,
+           param,
+           count,
+           (unsigned long long) percentile_get(p_samples_ns, count, 50),
+           (unsigned long long) percentile_get(p_samples_ns, count, 99),
+           (unsigned long long) p_samples_ns[count - 1]);
+}
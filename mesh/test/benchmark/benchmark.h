@@ -0,0 +1,109 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BENCHMARK_H__
+#define BENCHMARK_H__
+
+#include <stdint.h>
+
+/**
+ * @defgroup BENCHMARK Host side benchmark library
+ * Utilities for timing host builds of the mesh modules.
+ *
+ * Results are printed to stdout as one JSON object per line, so that they can be collected and
+ * compared between runs by a script.
+ * @{
+ */
+
+/**
+ * Gets a monotonic timestamp.
+ *
+ * @returns Current time in nanoseconds, relative to an arbitrary point in time.
+ */
+uint64_t benchmark_timestamp_ns(void);
+
+/**
+ * Reports the throughput of a benchmark case.
+ *
+ * @param[in] p_benchmark Name of the benchmark.
+ * @param[in] p_case      Name of the case within the benchmark.
+ * @param[in] param       Parameter the case was run with, e.g. a table size.
+ * @param[in] operations  Number of operations executed.
+ * @param[in] elapsed_ns  Time spent executing the operations, in nanoseconds.
+ */
+void benchmark_throughput_report(const char * p_benchmark,
+                                 const char * p_case,
+                                 uint32_t param,
+                                 uint64_t operations,
+                                 uint64_t elapsed_ns);
+
+/**
+ * Reports a measured value of a benchmark case, e.g. the number of operations of some kind
+ * needed per iteration.
+ *
+ * @param[in] p_benchmark Name of the benchmark.
+ * @param[in] p_case      Name of the case within the benchmark.
+ * @param[in] param       Parameter the case was run with, e.g. a table size.
+ * @param[in] p_metric    Name of the measured value.
+ * @param[in] value       Measured value.
+ */
+void benchmark_metric_report(const char * p_benchmark,
+                             const char * p_case,
+                             uint32_t param,
+                             const char * p_metric,
+                             double value);
+
+/**
+ * Reports the latency distribution of a benchmark case.
+ *
+ * @note The samples are sorted in place.
+ *
+ * @param[in]     p_benchmark  Name of the benchmark.
+ * @param[in]     p_case       Name of the case within the benchmark.
+ * @param[in]     param        Parameter the case was run with, e.g. a table size.
+ * @param[in,out] p_samples_ns Latency of each operation, in nanoseconds.
+ * @param[in]     count        Number of samples in @p p_samples_ns.
+ */
+void benchmark_latency_report(const char * p_benchmark,
+                              const char * p_case,
+                              uint32_t param,
+                              uint64_t * p_samples_ns,
+                              uint32_t count);
+
+/** @} */
+
+#endif /* BENCHMARK_H__ */
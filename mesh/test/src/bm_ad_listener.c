@@ -0,0 +1,139 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "ad_listener.h"
+#include "packet.h"
+#include "nordic_common.h"
+
+/* Number of packets to parse for each case: */
+#define BENCHMARK_PACKETS   (4000000)
+/* Number of listeners for AD types that don't occur in the packets: */
+#define OTHER_LISTENERS     (16)
+
+static uint32_t m_dispatched;
+
+void mesh_assertion_handler(uint32_t pc)
+{
+    printf("Assertion at PC = %.08x\n", pc);
+    exit(1);
+}
+
+static void ad_handler(const uint8_t * p_packet, uint32_t ad_packet_length, const nrf_mesh_rx_metadata_t * p_metadata)
+{
+    m_dispatched++;
+}
+
+static ad_listener_t m_mesh_listeners[] =
+{
+    {.ad_type = AD_TYPE_MESH,   .adv_packet_type = BLE_PACKET_TYPE_ADV_NONCONN_IND, .handler = ad_handler},
+    {.ad_type = AD_TYPE_BEACON, .adv_packet_type = BLE_PACKET_TYPE_ADV_NONCONN_IND, .handler = ad_handler},
+    {.ad_type = AD_TYPE_PB_ADV, .adv_packet_type = BLE_PACKET_TYPE_ADV_NONCONN_IND, .handler = ad_handler},
+};
+static ad_listener_t m_other_listeners[OTHER_LISTENERS];
+static ad_listener_t m_wildcard_listener =
+{
+    .ad_type = ADL_WILDCARD_AD_TYPE,
+    .adv_packet_type = ADL_WILDCARD_ADV_TYPE,
+    .handler = ad_handler
+};
+
+/* A mesh packet with a flags AD structure in front, as sent by some proxy capable devices, and a
+ * few non-mesh AD structures in the end. */
+static const uint8_t m_payload[] =
+{
+    2, 0x01, 0x06,
+    17, AD_TYPE_MESH, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    3, 0x03, 0x28, 0x18,
+    5, 0xFF, 0x59, 0x00, 0x01, 0x02,
+};
+#define PAYLOAD_AD_STRUCTURES   (4)
+
+static void benchmark_process(const char * p_case, uint32_t listener_count, uint32_t expected_dispatches)
+{
+    nrf_mesh_rx_metadata_t metadata;
+    memset(&metadata, 0, sizeof(metadata));
+    metadata.source = NRF_MESH_RX_SOURCE_SCANNER;
+
+    m_dispatched = 0;
+
+    uint64_t start = benchmark_timestamp_ns();
+    for (uint32_t i = 0; i < BENCHMARK_PACKETS; ++i)
+    {
+        ad_listener_process(BLE_PACKET_TYPE_ADV_NONCONN_IND, m_payload, sizeof(m_payload), &metadata);
+    }
+    uint64_t elapsed = benchmark_timestamp_ns() - start;
+
+    if (m_dispatched != expected_dispatches * BENCHMARK_PACKETS)
+    {
+        printf("Unexpected number of dispatches: %u\n", m_dispatched);
+        exit(1);
+    }
+
+    benchmark_throughput_report("ad_listener", p_case, listener_count, BENCHMARK_PACKETS, elapsed);
+    benchmark_metric_report("ad_listener", p_case, listener_count, "ad_structures_per_sec",
+                            (double) BENCHMARK_PACKETS * PAYLOAD_AD_STRUCTURES * 1e9 / elapsed);
+}
+
+int main(void)
+{
+    for (uint32_t i = 0; i < ARRAY_SIZE(m_mesh_listeners); ++i)
+    {
+        (void) ad_listener_subscribe(&m_mesh_listeners[i]);
+    }
+    benchmark_process("mesh_listeners", ARRAY_SIZE(m_mesh_listeners), 1);
+
+    /* Listeners for AD types that aren't in the packet, e.g. application specific beacons. */
+    for (uint32_t i = 0; i < OTHER_LISTENERS; ++i)
+    {
+        m_other_listeners[i].ad_type = 0x80 + i;
+        m_other_listeners[i].adv_packet_type = ADL_WILDCARD_ADV_TYPE;
+        m_other_listeners[i].handler = ad_handler;
+        (void) ad_listener_subscribe(&m_other_listeners[i]);
+    }
+    benchmark_process("other_listeners", ARRAY_SIZE(m_mesh_listeners) + OTHER_LISTENERS, 1);
+
+    (void) ad_listener_subscribe(&m_wildcard_listener);
+    benchmark_process("wildcard_listener", ARRAY_SIZE(m_mesh_listeners) + OTHER_LISTENERS + 1,
+                      1 + PAYLOAD_AD_STRUCTURES);
+    return 0;
+}
@@ -0,0 +1,185 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "aes.h"
+#include "ccm_soft.h"
+#include "utils.h"
+#include "nordic_common.h"
+
+#define BENCHMARK_NAME "ccm"
+
+/* Number of packets to decrypt for each case: */
+#define BENCHMARK_PACKETS   (200000)
+
+/* Largest message to benchmark: */
+#define MESSAGE_LEN_MAX     (384)
+
+#define MIC_LEN             (4)
+
+static const uint8_t m_key[]   = { 0xac, 0x16, 0x1f, 0x58, 0x9e, 0x5d, 0xe7, 0x45, 0x6d, 0x2c, 0x1a, 0x5f, 0x49, 0x72, 0x12, 0x6b };
+static const uint8_t m_nonce[] = { 0x07, 0x01, 0x02, 0x03, 0x04, 0x05, 0x26, 0xd2, 0xa6, 0x9d, 0xa0, 0x82, 0xe0 };
+
+static uint8_t m_encrypted[MESSAGE_LEN_MAX + MIC_LEN];
+static uint8_t m_decrypted[MESSAGE_LEN_MAX];
+
+typedef void (*decrypt_func_t)(ccm_soft_data_t * p_data, bool * p_mic_passed);
+
+void mesh_assertion_handler(uint32_t pc)
+{
+    printf("Assertion at PC = %.08x\n", pc);
+    exit(1);
+}
+
+static void cbc_mac_blocks(const aes_ctx_t * p_ctx, const uint8_t * p_data, uint16_t len, uint8_t X[16])
+{
+    for (uint16_t offset = 0; offset < len; offset += 16)
+    {
+        uint16_t block_len = MIN(16, len - offset);
+        utils_xor(X, X, &p_data[offset], block_len);
+        aes_ctx_encrypt(p_ctx, X, X);
+    }
+}
+
+/* Decryption the way ccm_soft_decrypt() used to do it: the full payload is decrypted first, then
+ * authenticated in a second pass, generating the S0 block twice. Only used as a reference. */
+static void two_pass_decrypt(ccm_soft_data_t * p_data, bool * p_mic_passed)
+{
+    uint8_t A[16];
+    uint8_t S[16];
+    uint8_t X[16];
+    uint16_t i = 0;
+
+    aes_ctx_t ctx;
+    aes_ctx_init(&ctx, p_data->p_key);
+
+    A[0] = CCM_LENGTH_FIELD_LENGTH - 1;
+    memcpy(&A[1], p_data->p_nonce, CCM_NONCE_LENGTH);
+    utils_reverse_memcpy(&A[16 - CCM_LENGTH_FIELD_LENGTH], (uint8_t *) &i, CCM_LENGTH_FIELD_LENGTH);
+    aes_ctx_encrypt(&ctx, A, S);
+
+    for (uint16_t offset = 0; offset < p_data->m_len; offset += 16)
+    {
+        i++;
+        utils_reverse_memcpy(&A[16 - CCM_LENGTH_FIELD_LENGTH], (uint8_t *) &i, CCM_LENGTH_FIELD_LENGTH);
+        aes_ctx_encrypt(&ctx, A, S);
+        utils_xor(&p_data->p_out[offset], &p_data->p_m[offset], S, MIN(16, p_data->m_len - offset));
+    }
+
+    uint8_t B[16];
+    B[0] = (((p_data->mic_len - 2) / 2) << 3) | (CCM_LENGTH_FIELD_LENGTH - 1);
+    memcpy(&B[1], p_data->p_nonce, CCM_NONCE_LENGTH);
+    utils_reverse_memcpy(&B[16 - CCM_LENGTH_FIELD_LENGTH], (uint8_t *) &p_data->m_len, CCM_LENGTH_FIELD_LENGTH);
+    aes_ctx_encrypt(&ctx, B, X);
+    cbc_mac_blocks(&ctx, p_data->p_out, p_data->m_len, X);
+
+    i = 0;
+    utils_reverse_memcpy(&A[16 - CCM_LENGTH_FIELD_LENGTH], (uint8_t *) &i, CCM_LENGTH_FIELD_LENGTH);
+    aes_ctx_encrypt(&ctx, A, S);
+    utils_xor(X, X, S, p_data->mic_len);
+
+    *p_mic_passed = (memcmp(X, p_data->p_mic, p_data->mic_len) == 0);
+}
+
+static void benchmark_decrypt(const char * p_case, decrypt_func_t decrypt, uint16_t message_len, bool valid_mic)
+{
+    uint8_t message[MESSAGE_LEN_MAX];
+    for (uint16_t i = 0; i < message_len; ++i)
+    {
+        message[i] = (uint8_t) i;
+    }
+
+    ccm_soft_data_t data =
+    {
+        .p_key   = m_key,
+        .p_nonce = m_nonce,
+        .p_m     = message,
+        .m_len   = message_len,
+        .p_a     = NULL,
+        .a_len   = 0,
+        .p_out   = m_encrypted,
+        .p_mic   = &m_encrypted[message_len],
+        .mic_len = MIC_LEN
+    };
+    ccm_soft_encrypt(&data);
+    if (!valid_mic)
+    {
+        data.p_mic[0] ^= 0x01;
+    }
+
+    data.p_m   = m_encrypted;
+    data.p_out = m_decrypted;
+
+    uint32_t mic_passed_count = 0;
+    uint32_t block_count = aes_block_count_get();
+    uint64_t start = benchmark_timestamp_ns();
+    for (uint32_t i = 0; i < BENCHMARK_PACKETS; ++i)
+    {
+        bool mic_passed;
+        decrypt(&data, &mic_passed);
+        mic_passed_count += mic_passed;
+    }
+    uint64_t elapsed = benchmark_timestamp_ns() - start;
+    block_count = aes_block_count_get() - block_count;
+
+    if (mic_passed_count != (valid_mic ? BENCHMARK_PACKETS : 0))
+    {
+        printf("Unexpected MIC check result in %s\n", p_case);
+        exit(1);
+    }
+
+    benchmark_throughput_report(BENCHMARK_NAME, p_case, message_len, BENCHMARK_PACKETS, elapsed);
+    benchmark_metric_report(BENCHMARK_NAME, p_case, message_len, "aes_blocks_per_packet",
+                            (double) block_count / BENCHMARK_PACKETS);
+}
+
+int main(void)
+{
+    /* Unsegmented network PDUs, and a full segmented access message: */
+    const uint16_t message_lengths[] = {9, 16, 29, 380};
+    for (uint32_t i = 0; i < sizeof(message_lengths) / sizeof(message_lengths[0]); ++i)
+    {
+        benchmark_decrypt("decrypt", ccm_soft_decrypt, message_lengths[i], true);
+        benchmark_decrypt("decrypt_mic_fail", ccm_soft_decrypt, message_lengths[i], false);
+        benchmark_decrypt("decrypt_two_pass", two_pass_decrypt, message_lengths[i], true);
+    }
+    return 0;
+}
@@ -0,0 +1,240 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "filter_engine.h"
+#include "gap_address_filter.h"
+#include "ad_type_filter.h"
+#include "rssi_filter.h"
+#include "adv_packet_filter.h"
+#include "packet.h"
+#include "timer.h"
+#include "bearer_event.h"
+#include "nordic_common.h"
+
+/* Number of packets to classify for each case: */
+#define BENCHMARK_PACKETS   (4000000)
+/* Number of distinct packets cycled through, must be a power of two: */
+#define PACKET_POOL_SIZE    (256)
+/* Largest GAP address blacklist of the address set cases: */
+#define GAP_ADDR_SET_MAX    (2048)
+
+#if GAP_ADDR_FILTER_LINEAR_MAX >= GAP_ADDR_SET_MAX
+#define GAP_ADDR_SET_CASE   "gap_blacklist_linear"
+#else
+#define GAP_ADDR_SET_CASE   "gap_blacklist_hashed"
+#endif
+
+static scanner_packet_t m_packets[PACKET_POOL_SIZE];
+static scanner_packet_t m_gap_addr_packets[PACKET_POOL_SIZE];
+static ble_gap_addr_t m_gap_addrs[GAP_ADDR_SET_MAX];
+
+void mesh_assertion_handler(uint32_t pc)
+{
+    printf("Assertion at PC = %.08x\n", pc);
+    exit(1);
+}
+
+timestamp_t timer_now(void)
+{
+    return 0;
+}
+
+void bearer_event_critical_section_begin(void) {}
+void bearer_event_critical_section_end(void) {}
+
+static void gap_addrs_init(void)
+{
+    for (uint32_t i = 0; i < ARRAY_SIZE(m_gap_addrs); ++i)
+    {
+        m_gap_addrs[i].addr_type = BLE_GAP_ADDR_TYPE_RANDOM_STATIC;
+        memset(m_gap_addrs[i].addr, 0xC0, BLE_GAP_ADDR_LEN);
+        m_gap_addrs[i].addr[0] = (uint8_t) i;
+        m_gap_addrs[i].addr[1] = (uint8_t) (i >> 8);
+    }
+}
+
+static void packets_init(void)
+{
+    static const ble_packet_type_t types[] = {BLE_PACKET_TYPE_ADV_NONCONN_IND,
+                                              BLE_PACKET_TYPE_ADV_NONCONN_IND,
+                                              BLE_PACKET_TYPE_ADV_IND,
+                                              BLE_PACKET_TYPE_SCAN_RSP};
+    static const uint8_t ad_types[] = {AD_TYPE_MESH, AD_TYPE_BEACON, AD_TYPE_PB_ADV, 0xFF};
+
+    /* A mix of mesh traffic and other advertisers, most of which make it to the last filter. */
+    for (uint32_t i = 0; i < PACKET_POOL_SIZE; ++i)
+    {
+        packet_t * p_packet = &m_packets[i].packet;
+
+        memset(&m_packets[i], 0, sizeof(m_packets[i]));
+        m_packets[i].metadata.rssi = -40 - (int8_t) (i % 50);
+        p_packet->header.type = types[(i >> 1) & 0x03];
+        p_packet->header.addr_type = 1;
+        p_packet->header.length = BLE_GAP_ADDR_LEN + 31;
+        memset(p_packet->addr, 0xC0, BLE_GAP_ADDR_LEN);
+        p_packet->addr[0] = (uint8_t) (i * 7);
+
+        /* A flags AD structure in front of the one the AD type filter is looking for: */
+        p_packet->payload[0] = 2;
+        p_packet->payload[1] = 0x01;
+        p_packet->payload[2] = 0x06;
+        p_packet->payload[3] = 27;
+        p_packet->payload[4] = ad_types[(i >> 3) & 0x03];
+    }
+}
+
+static void gap_addr_packets_init(uint16_t gap_addr_count)
+{
+    /* Every other packet comes from a listed advertiser, so both hits and misses are timed. */
+    for (uint32_t i = 0; i < PACKET_POOL_SIZE; ++i)
+    {
+        m_gap_addr_packets[i] = m_packets[i];
+        if (i & 1)
+        {
+            memcpy(m_gap_addr_packets[i].packet.addr,
+                   m_gap_addrs[((i >> 1) * 7919) % gap_addr_count].addr,
+                   BLE_GAP_ADDR_LEN);
+        }
+    }
+}
+
+static void filters_setup(uint16_t gap_addr_count)
+{
+    bearer_rssi_filtering_set(-80);
+
+    bearer_adv_packet_filter_mode_set(ADV_FILTER_WHITELIST_MODE);
+    bearer_adv_packet_add(BLE_PACKET_TYPE_ADV_IND);
+    bearer_adv_packet_filtering_set(true);
+
+    bearer_adtype_mode_set(AD_FILTER_WHITELIST_MODE);
+    bearer_adtype_add(AD_TYPE_MESH);
+    bearer_adtype_add(AD_TYPE_BEACON);
+    bearer_adtype_add(AD_TYPE_PB_ADV);
+    bearer_adtype_filtering_set(true);
+
+    (void) bearer_filter_gap_addr_blacklist_set(m_gap_addrs, gap_addr_count);
+}
+
+static void filters_teardown(void)
+{
+    (void) bearer_filter_gap_addr_clear();
+    bearer_adtype_filtering_set(false);
+    bearer_adv_packet_filtering_set(false);
+    bearer_rssi_filtering_set(0);
+}
+
+static void benchmark_classify(const char * p_case, bool compiled, uint16_t gap_addr_count)
+{
+    fen_compiled_mode_set(compiled);
+    filters_setup(gap_addr_count);
+
+    uint32_t accepted = 0;
+
+    uint64_t start = benchmark_timestamp_ns();
+    for (uint32_t i = 0; i < BENCHMARK_PACKETS; ++i)
+    {
+        scanner_packet_t * p_packet = &m_packets[i & (PACKET_POOL_SIZE - 1)];
+        if (!(compiled && fen_compiled_filters_apply(p_packet)) && !fen_filters_apply(p_packet))
+        {
+            accepted++;
+        }
+    }
+    uint64_t elapsed = benchmark_timestamp_ns() - start;
+
+    filters_teardown();
+
+    benchmark_throughput_report("filters", p_case, gap_addr_count, BENCHMARK_PACKETS, elapsed);
+    benchmark_metric_report("filters", p_case, gap_addr_count, "accepted_ratio",
+                            (double) accepted / BENCHMARK_PACKETS);
+}
+
+static void benchmark_gap_addr_set(uint16_t gap_addr_count)
+{
+    /* Models a gateway ignoring a large number of known non-mesh advertisers. */
+    fen_compiled_mode_set(false);
+    gap_addr_packets_init(gap_addr_count);
+    (void) bearer_filter_gap_addr_blacklist_set(m_gap_addrs, gap_addr_count);
+
+    uint32_t accepted = 0;
+
+    uint64_t start = benchmark_timestamp_ns();
+    for (uint32_t i = 0; i < BENCHMARK_PACKETS; ++i)
+    {
+        if (!fen_filters_apply(&m_gap_addr_packets[i & (PACKET_POOL_SIZE - 1)]))
+        {
+            accepted++;
+        }
+    }
+    uint64_t elapsed = benchmark_timestamp_ns() - start;
+
+    (void) bearer_filter_gap_addr_clear();
+
+    benchmark_throughput_report("filters", GAP_ADDR_SET_CASE, gap_addr_count, BENCHMARK_PACKETS, elapsed);
+    benchmark_metric_report("filters", GAP_ADDR_SET_CASE, gap_addr_count, "accepted_ratio",
+                            (double) accepted / BENCHMARK_PACKETS);
+}
+
+int main(void)
+{
+    static const uint16_t gap_addr_counts[] = {1, 8, FILTER_ENGINE_COMPILED_GAP_ADDR_MAX};
+
+    gap_addrs_init();
+    packets_init();
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(gap_addr_counts); ++i)
+    {
+        benchmark_classify("list", false, gap_addr_counts[i]);
+        benchmark_classify("compiled", true, gap_addr_counts[i]);
+    }
+
+    static const uint16_t gap_addr_set_counts[] = {16, 256, GAP_ADDR_SET_MAX};
+    for (uint32_t i = 0; i < ARRAY_SIZE(gap_addr_set_counts); ++i)
+    {
+        if (gap_addr_set_counts[i] <= GAP_ADDR_FILTER_HASH_SET_CAPACITY ||
+            gap_addr_set_counts[i] <= GAP_ADDR_FILTER_LINEAR_MAX)
+        {
+            benchmark_gap_addr_set(gap_addr_set_counts[i]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "benchmark.h"
+#include "msg_cache.h"
+#include "nrf_mesh_config_core.h"
+
+/* Number of lookups to run for each case: */
+#define BENCHMARK_LOOKUPS   (1000000)
+
+#if MSG_CACHE_HASH_INDEX_ENABLE
+#define BENCHMARK_NAME "msg_cache_hash_index"
+#else
+#define BENCHMARK_NAME "msg_cache"
+#endif
+
+/* Sequence numbers are spaced out to make the source addresses of the hits and misses overlap: */
+#define SEQ_BASE            (0x010000)
+
+void mesh_assertion_handler(uint32_t pc)
+{
+    printf("Assertion at PC = %.08x\n", pc);
+    exit(1);
+}
+
+static void cache_fill(void)
+{
+    msg_cache_init();
+    for (uint32_t i = 0; i < MSG_CACHE_ENTRY_COUNT; ++i)
+    {
+        msg_cache_entry_add(0x0001 + (i & 0xFF), SEQ_BASE + i);
+    }
+}
+
+static void benchmark_lookup(const char * p_case, bool hit)
+{
+    cache_fill();
+
+    /* Prevents the compiler from optimizing out the lookups. */
+    volatile uint32_t found = 0;
+    const uint32_t seq_offset = hit ? 0 : MSG_CACHE_ENTRY_COUNT;
+
+    uint64_t start = benchmark_timestamp_ns();
+    for (uint32_t i = 0; i < BENCHMARK_LOOKUPS; ++i)
+    {
+        uint32_t entry = i % MSG_CACHE_ENTRY_COUNT;
+        found += msg_cache_entry_exists(0x0001 + (entry & 0xFF), SEQ_BASE + seq_offset + entry);
+    }
+    uint64_t elapsed = benchmark_timestamp_ns() - start;
+
+    if (found != (hit ? BENCHMARK_LOOKUPS : 0))
+    {
+        printf("Unexpected number of cache hits: %u\n", found);
+        exit(1);
+    }
+
+    benchmark_throughput_report(BENCHMARK_NAME, p_case, MSG_CACHE_ENTRY_COUNT, BENCHMARK_LOOKUPS, elapsed);
+}
+
+static void benchmark_receive(void)
+{
+    /* Models the network layer receiving new packets: a lookup that misses, followed by an
+     * addition that evicts the oldest entry. */
+    cache_fill();
+
+    uint64_t start = benchmark_timestamp_ns();
+    for (uint32_t i = 0; i < BENCHMARK_LOOKUPS; ++i)
+    {
+        uint16_t src = 0x0001 + (i & 0xFF);
+        uint32_t seq = SEQ_BASE + MSG_CACHE_ENTRY_COUNT + i;
+        if (!msg_cache_entry_exists(src, seq))
+        {
+            msg_cache_entry_add(src, seq);
+        }
+    }
+    uint64_t elapsed = benchmark_timestamp_ns() - start;
+
+    benchmark_throughput_report(BENCHMARK_NAME, "receive", MSG_CACHE_ENTRY_COUNT, BENCHMARK_LOOKUPS, elapsed);
+}
+
+int main(void)
+{
+    benchmark_lookup("lookup_hit", true);
+    benchmark_lookup("lookup_miss", false);
+    benchmark_receive();
+    return 0;
+}
@@ -0,0 +1,261 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "network.h"
+#include "net_packet.h"
+#include "net_state.h"
+#include "net_beacon.h"
+#include "msg_cache.h"
+#include "transport.h"
+#include "core_tx.h"
+#include "core_tx_adv.h"
+#include "heartbeat.h"
+#include "rand.h"
+#include "timer.h"
+#include "aes.h"
+#include "nrf_mesh_externs.h"
+#include "log.h"
+#include "nrf_mesh_config_core.h"
+#include "nordic_common.h"
+
+#define BENCHMARK_NAME "network_rx"
+
+/* Number of passes over the recorded stream for each case: */
+#define BENCHMARK_PASSES        (2000)
+
+/* Number of different packets in the stream. Larger than the message cache, so that every pass
+ * over the stream behaves like the first one. */
+#define STREAM_UNIQUE_PACKETS   (4 * MSG_CACHE_ENTRY_COUNT)
+
+/* Every advertisement is picked up on all three advertising channels: */
+#define STREAM_COPIES           (3)
+
+/* One in every STREAM_FOREIGN_INTERVAL packets belongs to another network: */
+#define STREAM_FOREIGN_INTERVAL (4)
+
+#define STREAM_LENGTH_MAX       (STREAM_UNIQUE_PACKETS * (STREAM_COPIES + 1))
+
+#define PAYLOAD_LEN             (11)
+#define PACKET_LEN              (PACKET_MESH_NET_PDU_OFFSET + PAYLOAD_LEN + 4)
+
+typedef struct
+{
+    uint8_t length;
+    packet_mesh_net_packet_t packet;
+} recorded_packet_t;
+
+static nrf_mesh_network_secmat_t m_secmat;
+static recorded_packet_t m_stream[STREAM_LENGTH_MAX];
+static uint32_t m_stream_length;
+static uint32_t m_transport_rx_count;
+
+void mesh_assertion_handler(uint32_t pc)
+{
+    printf("Assertion at PC = %.08x\n", pc);
+    exit(1);
+}
+
+/*****************************************************************************
+* Stubbed dependencies
+*****************************************************************************/
+void nrf_mesh_net_secmat_next_get(uint8_t nid, const nrf_mesh_network_secmat_t ** pp_secmat,
+            const nrf_mesh_network_secmat_t ** pp_secmat_secondary)
+{
+    *pp_secmat = (*pp_secmat == NULL && nid == m_secmat.nid) ? &m_secmat : NULL;
+    *pp_secmat_secondary = NULL;
+}
+
+bool nrf_mesh_rx_address_get(uint16_t address, nrf_mesh_address_t * p_address)
+{
+    return false;
+}
+
+uint32_t transport_packet_in(const packet_mesh_trs_packet_t * p_packet,
+                             uint32_t trs_packet_len,
+                             const network_packet_metadata_t * p_net_metadata,
+                             const nrf_mesh_rx_metadata_t * p_rx_metadata)
+{
+    m_transport_rx_count++;
+    return NRF_SUCCESS;
+}
+
+uint32_t net_state_rx_iv_index_get(uint8_t ivi)
+{
+    return 0;
+}
+
+/* The recorded packets are never relayed, so the TX path and the state modules are only touched
+ * during initialization. */
+void net_state_init(void) {}
+void net_state_recover_from_flash(void) {}
+void net_beacon_init(void) {}
+uint32_t net_state_seqnum_alloc(uint32_t * p_seqnum) { return NRF_ERROR_FORBIDDEN; }
+uint32_t net_state_tx_iv_index_get(void) { return 0; }
+core_tx_bearer_bitmap_t core_tx_packet_alloc(const core_tx_alloc_params_t * p_params, uint8_t ** pp_packet) { return 0; }
+void core_tx_packet_send(void) {}
+void core_tx_packet_discard(void) {}
+void core_tx_relay_complete_cb_set(core_tx_complete_cb_t tx_complete_callback) {}
+uint8_t core_tx_adv_count_get(core_tx_role_t role) { return 0; }
+void core_tx_adv_count_set(core_tx_role_t role, uint8_t tx_count) {}
+uint32_t core_tx_adv_interval_get(core_tx_role_t role) { return 0; }
+void core_tx_adv_interval_set(core_tx_role_t role, uint32_t interval_ms) {}
+void heartbeat_on_feature_change_trigger(uint16_t hb_trigger) {}
+void rand_hw_rng_get(uint8_t * p_result, uint16_t len) { memset(p_result, 0, len); }
+timestamp_t timer_now(void) { return 0; }
+
+/*****************************************************************************
+* Benchmark
+*****************************************************************************/
+static void packet_record(uint8_t nid, uint16_t src, uint32_t seq)
+{
+    network_packet_metadata_t metadata;
+    memset(&metadata, 0, sizeof(metadata));
+    metadata.dst.type                 = NRF_MESH_ADDRESS_TYPE_GROUP;
+    metadata.dst.value                = 0xC001;
+    metadata.src                      = src;
+    metadata.ttl                      = 0;
+    metadata.control_packet           = false;
+    metadata.internal.sequence_number = seq;
+    metadata.internal.iv_index        = 0;
+    nrf_mesh_network_secmat_t secmat = m_secmat;
+    secmat.nid = nid;
+    metadata.p_security_material = &secmat;
+
+    recorded_packet_t * p_recorded = &m_stream[m_stream_length++];
+    p_recorded->length = PACKET_LEN;
+    net_packet_header_set(&p_recorded->packet, &metadata);
+    for (uint32_t i = 0; i < PAYLOAD_LEN; ++i)
+    {
+        p_recorded->packet.pdu[PACKET_MESH_NET_PDU_OFFSET + i] = (uint8_t) (seq + i);
+    }
+    net_packet_encrypt(&metadata, PAYLOAD_LEN, &p_recorded->packet, NET_PACKET_KIND_TRANSPORT);
+}
+
+static void stream_record(void)
+{
+    memset(m_secmat.encryption_key, 0x5A, NRF_MESH_KEY_SIZE);
+    memset(m_secmat.privacy_key, 0xA5, NRF_MESH_KEY_SIZE);
+    m_secmat.nid = 0x68;
+
+    m_stream_length = 0;
+    for (uint32_t i = 0; i < STREAM_UNIQUE_PACKETS; ++i)
+    {
+        if ((i % STREAM_FOREIGN_INTERVAL) == 0)
+        {
+            packet_record(m_secmat.nid ^ 0x01, 0x0100, i);
+        }
+        packet_record(m_secmat.nid, 0x0001 + (i & 0x7F), i);
+        for (uint32_t j = 1; j < STREAM_COPIES; ++j)
+        {
+            m_stream[m_stream_length] = m_stream[m_stream_length - 1];
+            m_stream_length++;
+        }
+    }
+}
+
+static void stream_in_single(const nrf_mesh_rx_metadata_t * p_rx_metadata)
+{
+    for (uint32_t i = 0; i < m_stream_length; ++i)
+    {
+        (void) network_packet_in(m_stream[i].packet.pdu, m_stream[i].length, p_rx_metadata);
+    }
+}
+
+static void stream_in_batched(const nrf_mesh_rx_metadata_t * p_rx_metadata)
+{
+    for (uint32_t i = 0; i < m_stream_length; i += NETWORK_RX_BATCH_SIZE)
+    {
+        uint32_t end = MIN(i + NETWORK_RX_BATCH_SIZE, m_stream_length);
+        for (uint32_t j = i; j < end; ++j)
+        {
+            (void) network_packet_batch_add(m_stream[j].packet.pdu, m_stream[j].length);
+        }
+        for (uint32_t j = i; j < end; ++j)
+        {
+            (void) network_packet_batch_in(m_stream[j].packet.pdu, m_stream[j].length, p_rx_metadata);
+        }
+        network_packet_batch_clear();
+    }
+}
+
+static void benchmark_stream(const char * p_case, void (*stream_in)(const nrf_mesh_rx_metadata_t *))
+{
+    nrf_mesh_rx_metadata_t rx_metadata;
+    memset(&rx_metadata, 0, sizeof(rx_metadata));
+    rx_metadata.source = NRF_MESH_RX_SOURCE_SCANNER;
+
+    msg_cache_init();
+    m_transport_rx_count = 0;
+
+    uint32_t block_count = aes_block_count_get();
+    uint64_t start = benchmark_timestamp_ns();
+    for (uint32_t i = 0; i < BENCHMARK_PASSES; ++i)
+    {
+        stream_in(&rx_metadata);
+    }
+    uint64_t elapsed = benchmark_timestamp_ns() - start;
+    block_count = aes_block_count_get() - block_count;
+
+    if (m_transport_rx_count != BENCHMARK_PASSES * STREAM_UNIQUE_PACKETS)
+    {
+        printf("Unexpected number of packets delivered in %s: %u\n", p_case, m_transport_rx_count);
+        exit(1);
+    }
+
+    uint64_t packets = (uint64_t) BENCHMARK_PASSES * m_stream_length;
+    benchmark_throughput_report(BENCHMARK_NAME, p_case, NETWORK_RX_BATCH_SIZE, packets, elapsed);
+    benchmark_metric_report(BENCHMARK_NAME, p_case, NETWORK_RX_BATCH_SIZE, "aes_blocks_per_packet",
+                            (double) block_count / packets);
+}
+
+int main(void)
+{
+    /* Duplicates are expected to fail, don't time the warnings. */
+    __LOG_INIT(LOG_SRC_NETWORK, LOG_LEVEL_ERROR, LOG_CALLBACK_DEFAULT);
+    network_init(NULL);
+    stream_record();
+
+    benchmark_stream("single", stream_in_single);
+    benchmark_stream("batched", stream_in_batched);
+    return 0;
+}
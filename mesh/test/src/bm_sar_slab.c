@@ -0,0 +1,138 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "sar_slab.h"
+#include "packet_mgr.h"
+#include "nordic_common.h"
+
+/* Number of allocations to run for each case: */
+#define BENCHMARK_ALLOCS    (1000000)
+
+#define BENCHMARK_NAME      "sar_slab"
+
+/* Max number of SAR buffers kept alive at the same time, like concurrent SAR sessions: */
+#define BENCHMARK_SESSIONS_MAX  (16)
+
+/* SAR payload sizes, in a mix of mostly short messages with an occasional long one: */
+static const uint16_t m_sizes[] = {12, 20, 8, 36, 12, 60, 150, 24, 12, 380, 48, 96, 12, 200, 30, 11};
+
+void mesh_assertion_handler(uint32_t pc)
+{
+    printf("Assertion at PC = %.08x\n", pc);
+    exit(1);
+}
+
+static void * packet_mgr_alloc_wrapper(size_t size)
+{
+    packet_generic_t * p_buffer;
+    return (packet_mgr_alloc(&p_buffer, size) == NRF_SUCCESS) ? p_buffer : NULL;
+}
+
+static void packet_mgr_release_wrapper(void * p_buffer)
+{
+    packet_mgr_free(p_buffer);
+}
+
+/* Runs the SAR buffer workload: each allocation replaces the oldest live buffer. */
+static void benchmark_allocator(const char * p_case, uint32_t sessions, void * (*alloc)(size_t), void (*release)(void *))
+{
+    void * p_buffers[BENCHMARK_SESSIONS_MAX] = {NULL};
+    uint32_t failures = 0;
+
+    uint32_t session = 0;
+    uint32_t size_index = 0;
+    uint64_t start = benchmark_timestamp_ns();
+    for (uint32_t i = 0; i < BENCHMARK_ALLOCS; ++i)
+    {
+        if (p_buffers[session] != NULL)
+        {
+            release(p_buffers[session]);
+        }
+
+        p_buffers[session] = alloc(m_sizes[size_index]);
+        if (p_buffers[session] == NULL)
+        {
+            failures++;
+        }
+
+        session = (session + 1 < sessions) ? (session + 1) : 0;
+        size_index = (size_index + 1 < ARRAY_SIZE(m_sizes)) ? (size_index + 1) : 0;
+    }
+    uint64_t elapsed = benchmark_timestamp_ns() - start;
+
+    for (uint32_t i = 0; i < sessions; ++i)
+    {
+        if (p_buffers[i] != NULL)
+        {
+            release(p_buffers[i]);
+        }
+    }
+
+    benchmark_throughput_report(BENCHMARK_NAME, p_case, sessions, BENCHMARK_ALLOCS, elapsed);
+    benchmark_metric_report(BENCHMARK_NAME, p_case, sessions, "alloc_failures", failures);
+}
+
+int main(void)
+{
+    nrf_mesh_init_params_t init_params;
+    memset(&init_params, 0, sizeof(init_params));
+
+    for (uint32_t sessions = 4; sessions <= BENCHMARK_SESSIONS_MAX; sessions *= 2)
+    {
+        packet_mgr_init(&init_params);
+        benchmark_allocator("packet_mgr", sessions, packet_mgr_alloc_wrapper, packet_mgr_release_wrapper);
+
+        sar_slab_init();
+        benchmark_allocator("slab", sessions, sar_slab_alloc, sar_slab_release);
+
+        sar_slab_stats_t stats;
+        sar_slab_stats_get(&stats);
+        benchmark_metric_report(BENCHMARK_NAME, "slab", sessions, "reserved_bytes_peak", stats.reserved_bytes_peak);
+        for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+        {
+            char metric[32];
+            (void) snprintf(metric, sizeof(metric), "spills_%u", stats.classes[i].size);
+            benchmark_metric_report(BENCHMARK_NAME, "slab", sessions, metric, stats.classes[i].spills);
+        }
+    }
+    return 0;
+}
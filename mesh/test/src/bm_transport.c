@@ -0,0 +1,428 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "transport.h"
+#include "network.h"
+#include "net_state.h"
+#include "net_beacon.h"
+#include "msg_cache.h"
+#include "replay_cache.h"
+#include "bearer_event.h"
+#include "core_tx.h"
+#include "core_tx_adv.h"
+#include "event.h"
+#include "heartbeat.h"
+#include "rand.h"
+#include "timer.h"
+#include "timer_scheduler.h"
+#include "aes.h"
+#include "nrf_mesh_externs.h"
+#include "log.h"
+#include "nordic_common.h"
+
+#define BENCHMARK_NAME "transport"
+
+/* Number of messages sent end-to-end in each case: */
+#define BENCHMARK_MESSAGES      (500)
+
+#define SRC_ADDR                (0x0001)
+#define DST_ADDR                (0x0002)
+#define APP_KEY_AID             (0x15)
+
+/* Largest number of application keys with the same AID on the receiving side. */
+#define APP_KEY_COUNT_MAX       (8)
+
+/* Every segment of the largest message, and its acknowledgment: */
+#define LOOPBACK_QUEUE_LENGTH   (64)
+
+/* Time between two packets on the simulated bearer. */
+#define LOOPBACK_PACKET_INTERVAL_US (10000)
+
+typedef struct
+{
+    core_tx_role_t role;
+    nrf_mesh_tx_token_t token;
+    uint16_t src;
+    uint8_t length;
+    uint8_t packet[PACKET_MESH_NET_MAX_SIZE];
+} loopback_packet_t;
+
+/** Bearer that hands every sent packet back to the network layer, as if it was received by the
+ * other node. */
+static struct
+{
+    loopback_packet_t queue[LOOPBACK_QUEUE_LENGTH];
+    uint32_t head;
+    uint32_t count;
+    loopback_packet_t * p_allocated;
+    core_tx_complete_cb_t tx_complete_cb;
+    core_tx_complete_cb_t relay_tx_complete_cb;
+} m_loopback;
+
+/* The node receiving the current packet. Both nodes share one stack instance, but the network layer
+ * drops packets from its own addresses. */
+static uint16_t m_local_address;
+
+static bearer_event_flag_callback_t m_flag_callback;
+static bool m_flag_pending;
+static timestamp_t m_time_now;
+
+static nrf_mesh_network_secmat_t m_net_secmat;
+static nrf_mesh_application_secmat_t m_app_secmat[APP_KEY_COUNT_MAX];
+static uint32_t m_app_key_count;
+
+static uint32_t m_messages_received;
+static uint64_t m_message_received_time;
+
+static uint64_t m_latency_samples[BENCHMARK_MESSAGES];
+
+void mesh_assertion_handler(uint32_t pc)
+{
+    printf("Assertion at PC = %.08x\n", pc);
+    exit(1);
+}
+
+/*****************************************************************************
+* Loopback bearer
+*****************************************************************************/
+void core_tx_complete_cb_set(core_tx_complete_cb_t tx_complete_callback)
+{
+    m_loopback.tx_complete_cb = tx_complete_callback;
+}
+
+void core_tx_relay_complete_cb_set(core_tx_complete_cb_t tx_complete_callback)
+{
+    m_loopback.relay_tx_complete_cb = tx_complete_callback;
+}
+
+core_tx_bearer_bitmap_t core_tx_packet_alloc(const core_tx_alloc_params_t * p_params, uint8_t ** pp_packet)
+{
+    if (m_loopback.count == LOOPBACK_QUEUE_LENGTH ||
+        p_params->net_packet_len > PACKET_MESH_NET_MAX_SIZE)
+    {
+        return 0;
+    }
+
+    loopback_packet_t * p_packet = &m_loopback.queue[(m_loopback.head + m_loopback.count) % LOOPBACK_QUEUE_LENGTH];
+    p_packet->role   = p_params->role;
+    p_packet->token  = p_params->token;
+    p_packet->src    = p_params->p_metadata->src;
+    p_packet->length = p_params->net_packet_len;
+    m_loopback.p_allocated = p_packet;
+    *pp_packet = p_packet->packet;
+    return 1;
+}
+
+void core_tx_packet_send(void)
+{
+    m_loopback.p_allocated = NULL;
+    m_loopback.count++;
+}
+
+void core_tx_packet_discard(void)
+{
+    m_loopback.p_allocated = NULL;
+}
+
+/* Delivers the next packet on the bearer. The TX complete callback runs before the packet is
+ * received, as it would on a radio. */
+static void loopback_packet_deliver(void)
+{
+    /* Copied out, the receiver may queue new packets in the same slot. */
+    loopback_packet_t packet = m_loopback.queue[m_loopback.head];
+    m_loopback.head = (m_loopback.head + 1) % LOOPBACK_QUEUE_LENGTH;
+    m_loopback.count--;
+    m_time_now += LOOPBACK_PACKET_INTERVAL_US;
+
+    if (packet.role == CORE_TX_ROLE_RELAY)
+    {
+        m_loopback.relay_tx_complete_cb(packet.role, 0, m_time_now, packet.token);
+    }
+    else
+    {
+        m_loopback.tx_complete_cb(packet.role, 0, m_time_now, packet.token);
+    }
+
+    m_local_address = (packet.src == SRC_ADDR) ? DST_ADDR : SRC_ADDR;
+    nrf_mesh_rx_metadata_t rx_metadata;
+    memset(&rx_metadata, 0, sizeof(rx_metadata));
+    rx_metadata.source = NRF_MESH_RX_SOURCE_SCANNER;
+    (void) network_packet_in(packet.packet, packet.length, &rx_metadata);
+}
+
+/* Runs the bearer and the deferred transport processing until both are idle. */
+static void loopback_run(void)
+{
+    while (m_loopback.count > 0 || m_flag_pending)
+    {
+        if (m_flag_pending)
+        {
+            m_flag_pending = false;
+            if (!m_flag_callback())
+            {
+                m_flag_pending = true;
+            }
+        }
+
+        if (m_loopback.count > 0)
+        {
+            loopback_packet_deliver();
+        }
+    }
+}
+
+/*****************************************************************************
+* Stubbed dependencies
+*****************************************************************************/
+bearer_event_flag_t bearer_event_flag_add(bearer_event_flag_callback_t callback)
+{
+    m_flag_callback = callback;
+    return 0;
+}
+
+void bearer_event_flag_set(bearer_event_flag_t flag)
+{
+    m_flag_pending = true;
+}
+
+void bearer_event_critical_section_begin(void) {}
+void bearer_event_critical_section_end(void) {}
+
+void event_handle(const nrf_mesh_evt_t * p_evt)
+{
+    if (p_evt->type == NRF_MESH_EVT_MESSAGE_RECEIVED)
+    {
+        m_message_received_time = benchmark_timestamp_ns();
+        m_messages_received++;
+    }
+}
+
+void nrf_mesh_net_secmat_next_get(uint8_t nid, const nrf_mesh_network_secmat_t ** pp_secmat,
+            const nrf_mesh_network_secmat_t ** pp_secmat_secondary)
+{
+    *pp_secmat = (*pp_secmat == NULL && nid == m_net_secmat.nid) ? &m_net_secmat : NULL;
+    *pp_secmat_secondary = NULL;
+}
+
+/* The key the sender uses is the last one tried, so every key count is a worst case. */
+void nrf_mesh_app_secmat_next_get(const nrf_mesh_network_secmat_t * p_network_secmat,
+        uint8_t aid, const nrf_mesh_application_secmat_t ** pp_app_secmat)
+{
+    if (aid != APP_KEY_AID)
+    {
+        *pp_app_secmat = NULL;
+    }
+    else if (*pp_app_secmat == NULL)
+    {
+        *pp_app_secmat = &m_app_secmat[APP_KEY_COUNT_MAX - m_app_key_count];
+    }
+    else if (*pp_app_secmat == &m_app_secmat[APP_KEY_COUNT_MAX - 1])
+    {
+        *pp_app_secmat = NULL;
+    }
+    else
+    {
+        (*pp_app_secmat)++;
+    }
+}
+
+void nrf_mesh_devkey_secmat_get(uint16_t owner_addr, const nrf_mesh_application_secmat_t ** pp_devkey_secmat)
+{
+    *pp_devkey_secmat = NULL;
+}
+
+bool nrf_mesh_rx_address_get(uint16_t address, nrf_mesh_address_t * p_address)
+{
+    if (address != m_local_address)
+    {
+        return false;
+    }
+    p_address->type = NRF_MESH_ADDRESS_TYPE_UNICAST;
+    p_address->value = address;
+    p_address->p_virtual_uuid = NULL;
+    return true;
+}
+
+static uint32_t m_seqnum;
+
+uint32_t net_state_seqnum_alloc(uint32_t * p_seqnum)
+{
+    *p_seqnum = m_seqnum++;
+    return NRF_SUCCESS;
+}
+
+uint32_t net_state_seqnum_reserve(uint32_t count, uint32_t * p_first_seqnum)
+{
+    *p_first_seqnum = m_seqnum;
+    m_seqnum += count;
+    return NRF_SUCCESS;
+}
+
+void net_state_seqnum_unreserve(uint32_t first_seqnum, uint32_t count)
+{
+    if (m_seqnum == first_seqnum + count)
+    {
+        m_seqnum = first_seqnum;
+    }
+}
+
+/* Every message comes from a new sequence number, the replay protection is not measured. */
+void replay_cache_init(void) {}
+bool replay_cache_has_elem(uint16_t src, uint32_t seqno, uint8_t ivi) { return false; }
+uint32_t replay_cache_add(uint16_t src, uint32_t seqno, uint8_t ivi) { return NRF_SUCCESS; }
+
+/* Acknowledgments arrive long before any of the SAR timers expire. */
+void timer_sch_reschedule(timer_event_t * p_timer_evt, timestamp_t new_timestamp) {}
+void timer_sch_abort(timer_event_t * p_timer_evt) {}
+timestamp_t timer_now(void) { return m_time_now; }
+
+void net_state_init(void) {}
+void net_state_recover_from_flash(void) {}
+void net_state_iv_index_lock(bool lock) {}
+uint32_t net_state_tx_iv_index_get(void) { return 0; }
+uint32_t net_state_rx_iv_index_get(uint8_t ivi) { return 0; }
+void net_beacon_init(void) {}
+uint8_t core_tx_adv_count_get(core_tx_role_t role) { return 0; }
+void core_tx_adv_count_set(core_tx_role_t role, uint8_t tx_count) {}
+uint32_t core_tx_adv_interval_get(core_tx_role_t role) { return 0; }
+void core_tx_adv_interval_set(core_tx_role_t role, uint32_t interval_ms) {}
+void heartbeat_on_feature_change_trigger(uint16_t hb_trigger) {}
+void rand_hw_rng_get(uint8_t * p_result, uint16_t len) { memset(p_result, 0, len); }
+
+/*****************************************************************************
+* Benchmark
+*****************************************************************************/
+static void keys_init(void)
+{
+    memset(m_net_secmat.encryption_key, 0x5A, NRF_MESH_KEY_SIZE);
+    memset(m_net_secmat.privacy_key, 0xA5, NRF_MESH_KEY_SIZE);
+    m_net_secmat.nid = 0x68;
+
+    for (uint32_t i = 0; i < APP_KEY_COUNT_MAX; ++i)
+    {
+        m_app_secmat[i].is_device_key = false;
+        m_app_secmat[i].aid = APP_KEY_AID;
+        memset(m_app_secmat[i].key, 0x10 + i, NRF_MESH_KEY_SIZE);
+    }
+}
+
+static void benchmark_messages(uint16_t message_len, uint32_t app_key_count)
+{
+    static uint8_t data[NRF_MESH_SEG_PAYLOAD_SIZE_MAX];
+    for (uint32_t i = 0; i < message_len; ++i)
+    {
+        data[i] = (uint8_t) i;
+    }
+
+    m_app_key_count = app_key_count;
+
+    nrf_mesh_tx_params_t tx_params;
+    memset(&tx_params, 0, sizeof(tx_params));
+    tx_params.dst.type                    = NRF_MESH_ADDRESS_TYPE_UNICAST;
+    tx_params.dst.value                   = DST_ADDR;
+    tx_params.src                         = SRC_ADDR;
+    tx_params.ttl                         = 1;
+    tx_params.transmic_size               = NRF_MESH_TRANSMIC_SIZE_SMALL;
+    tx_params.p_data                      = data;
+    tx_params.data_len                    = message_len;
+    tx_params.security_material.p_net     = &m_net_secmat;
+    tx_params.security_material.p_app     = &m_app_secmat[APP_KEY_COUNT_MAX - 1];
+
+    msg_cache_init();
+    m_messages_received = 0;
+
+    uint32_t block_count = aes_block_count_get();
+    uint64_t start = benchmark_timestamp_ns();
+    for (uint32_t i = 0; i < BENCHMARK_MESSAGES; ++i)
+    {
+        uint32_t packet_reference;
+        uint32_t received = m_messages_received;
+        uint64_t sent_time = benchmark_timestamp_ns();
+        uint32_t status = transport_tx(&tx_params, &packet_reference);
+        if (status != NRF_SUCCESS)
+        {
+            printf("transport_tx failed with %u for %u byte messages\n", status, message_len);
+            exit(1);
+        }
+
+        loopback_run();
+        if (m_messages_received != received + 1)
+        {
+            printf("Message %u of %u bytes was not received\n", i, message_len);
+            exit(1);
+        }
+        m_latency_samples[i] = m_message_received_time - sent_time;
+    }
+    uint64_t elapsed = benchmark_timestamp_ns() - start;
+    block_count = aes_block_count_get() - block_count;
+
+    char case_name[32];
+    (void) snprintf(case_name, sizeof(case_name), "%s_keys_%u",
+                    (message_len > NRF_MESH_UNSEG_PAYLOAD_SIZE_MAX) ? "segmented" : "unsegmented",
+                    app_key_count);
+
+    benchmark_throughput_report(BENCHMARK_NAME, case_name, message_len, BENCHMARK_MESSAGES, elapsed);
+    benchmark_metric_report(BENCHMARK_NAME, case_name, message_len, "aes_blocks_per_message",
+                            (double) block_count / BENCHMARK_MESSAGES);
+    benchmark_latency_report(BENCHMARK_NAME, case_name, message_len, m_latency_samples, BENCHMARK_MESSAGES);
+}
+
+int main(void)
+{
+    static const uint16_t message_lengths[] = {8, NRF_MESH_UNSEG_PAYLOAD_SIZE_MAX, 24, 96, NRF_MESH_SEG_PAYLOAD_SIZE_MAX};
+    static const uint32_t app_key_counts[] = {1, 4, APP_KEY_COUNT_MAX};
+
+    __LOG_INIT(LOG_SRC_TRANSPORT | LOG_SRC_NETWORK, LOG_LEVEL_ERROR, LOG_CALLBACK_DEFAULT);
+    keys_init();
+    network_init(NULL);
+    transport_init(NULL);
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(message_lengths); ++i)
+    {
+        for (uint32_t j = 0; j < ARRAY_SIZE(app_key_counts); ++j)
+        {
+            benchmark_messages(message_lengths[i], app_key_counts[j]);
+        }
+    }
+    return 0;
+}
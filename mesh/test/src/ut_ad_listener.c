@@ -36,13 +36,13 @@
  */
 
 #include "ad_listener.h"
+#include "nordic_common.h"
 
 #include "unity.h"
 #include "cmock.h"
 #include "test_assert.h"
 
 #include "ad_type_filter_mock.h"
-#include "list_mock.h"
 
 #define INCORRECT_ADV         0xEBu
 #define TEST_AD               AD_TYPE_MESH
@@ -64,57 +64,8 @@ static uint8_t m_test_cnt;
 static uint8_t m_pb_adv_cnt;
 static uint8_t m_beacon_cnt;
 static uint8_t m_wildcard_cnt;
-static list_node_t ** mpp_head;
-
-static void ll_insert(list_node_t * p_prev, list_node_t * p_next)
-{
-    p_next->p_next = p_prev->p_next;
-    p_prev->p_next = p_next;
-}
-
-static void list_add_cb(list_node_t ** pp_head, list_node_t * p_new, int num_calls)
-{
-    (void)num_calls;
-    mpp_head = pp_head;
-
-    if (*pp_head == NULL)
-    {
-        *pp_head = p_new;
-        p_new->p_next = NULL;
-        return;
-    }
-
-    list_node_t * p_node = *pp_head;
-    while (p_node->p_next != NULL)
-    {
-        p_node = p_node->p_next;
-    }
-
-    ll_insert(p_node, p_new);
-}
-
-static uint32_t list_remove_cb(list_node_t ** pp_head, list_node_t * p_node, int num_calls)
-{
-    (void)num_calls;
-
-    if (p_node == *pp_head)
-    {
-        *pp_head = p_node->p_next;
-        p_node->p_next = NULL;
-        return NRF_SUCCESS;
-    }
-
-    list_node_t * p_item = *pp_head;
-    while (p_item->p_next != NULL && p_item->p_next != p_node)
-    {
-        p_item = p_item->p_next;
-    }
-
-    p_item->p_next = p_node->p_next;
-    p_node->p_next = NULL;
-
-    return NRF_SUCCESS;
-}
+static uint8_t m_second_test_cnt;
+static uint8_t m_test_cnt_at_second_test;
 
 static void dummy(const uint8_t * p_packet,
                   uint32_t ad_packet_length,
@@ -199,6 +150,19 @@ static void wildcard_cb(const uint8_t * p_packet,
    m_wildcard_cnt++;
 }
 
+static void second_test_cb(const uint8_t * p_packet,
+                           uint32_t ad_packet_length,
+                           const nrf_mesh_rx_metadata_t * p_metadata)
+{
+    (void)p_metadata;
+    uint8_t example[] = {TEST_AD_PAYLOAD};
+
+    TEST_ASSERT_TRUE(TEST_AD_PAYLOAD_LEN == ad_packet_length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(example, p_packet, TEST_AD_PAYLOAD_LEN);
+    m_test_cnt_at_second_test = m_test_cnt;
+    m_second_test_cnt++;
+}
+
 static void corrupt_cb(const uint8_t * p_packet,
                        uint32_t ad_packet_length,
                        const nrf_mesh_rx_metadata_t * p_metadata)
@@ -228,21 +192,28 @@ static void scanner_packet_init(scanner_packet_t * p_pkt, uint8_t * payload, uin
     memcpy(p_pkt->packet.payload, payload, length);
 }
 
+static void listeners_unsubscribe(ad_listener_t * p_adl, uint32_t count)
+{
+    bearer_adtype_add_Ignore();
+    bearer_adtype_remove_Ignore();
+    bearer_adtype_clear_Ignore();
+    bearer_adtype_filtering_set_Ignore();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        TEST_ASSERT_EQUAL(NRF_SUCCESS, ad_listener_unsubscribe(&p_adl[i]));
+    }
+}
+
 void setUp(void)
 {
     ad_type_filter_mock_Init();
-    list_mock_Init();
-
-    list_add_StubWithCallback(list_add_cb);
-    list_remove_StubWithCallback(list_remove_cb);
 }
 
 void tearDown(void)
 {
     ad_type_filter_mock_Verify();
     ad_type_filter_mock_Destroy();
-    list_mock_Verify();
-    list_mock_Destroy();
 }
 
 void test_incoming_param_checker(void)
@@ -268,9 +239,10 @@ void test_incoming_param_checker(void)
     bearer_adtype_add_Ignore();
     bearer_adtype_mode_set_ExpectAnyArgs();
     bearer_adtype_filtering_set_ExpectAnyArgs();
-    list_add_Ignore();
 
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(p_adl));
+
+    listeners_unsubscribe(p_adl, 1);
 }
 
 void test_ad_filter_set(void)
@@ -292,7 +264,6 @@ void test_ad_filter_set(void)
     bearer_adtype_add_Expect(TEST_AD);
     bearer_adtype_mode_set_Expect(AD_FILTER_WHITELIST_MODE);
     bearer_adtype_filtering_set_Expect(true);
-    list_add_Expect(mpp_head, &adl1.node);
 
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl1));
 
@@ -300,12 +271,11 @@ void test_ad_filter_set(void)
     {
         bearer_adtype_add_Expect(i);
     }
-    list_add_Expect(mpp_head, &adl2.node);
 
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl2));
 
-    // clean up queue
-    *mpp_head = NULL;
+    listeners_unsubscribe(&adl2, 1);
+    listeners_unsubscribe(&adl1, 1);
 }
 
 void test_simple_unsubscription(void)
@@ -320,11 +290,9 @@ void test_simple_unsubscription(void)
     bearer_adtype_add_Ignore();
     bearer_adtype_mode_set_Ignore();
     bearer_adtype_filtering_set_Ignore();
-    list_add_Expect(mpp_head, &adl.node);
 
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl));
 
-    list_remove_ExpectAndReturn(mpp_head, &adl.node, NRF_SUCCESS);
     bearer_adtype_remove_Expect(TEST_AD);
     bearer_adtype_filtering_set_Expect(false);
 
@@ -343,11 +311,9 @@ void test_wildcard_unsubscription(void)
     bearer_adtype_add_Ignore();
     bearer_adtype_mode_set_Ignore();
     bearer_adtype_filtering_set_Ignore();
-    list_add_Expect(mpp_head, &adl.node);
 
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl));
 
-    list_remove_ExpectAndReturn(mpp_head, &adl.node, NRF_SUCCESS);
     bearer_adtype_clear_Expect();
     bearer_adtype_filtering_set_Expect(false);
 
@@ -381,26 +347,20 @@ void test_mixed_unsubscription(void)
     bearer_adtype_mode_set_Ignore();
     bearer_adtype_filtering_set_Ignore();
 
-    list_add_Expect(mpp_head, &adl1.node);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl1));
-    list_add_Expect(mpp_head, &adl2.node);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl2));
-    list_add_Expect(mpp_head, &adl3.node);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl3));
 
-    list_remove_ExpectAndReturn(mpp_head, &adl2.node, NRF_SUCCESS);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_unsubscribe(&adl2));
 
     bearer_adtype_clear_Expect();
     bearer_adtype_add_Expect(TEST_AD);
 
-    list_remove_ExpectAndReturn(mpp_head, &adl3.node, NRF_SUCCESS);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_unsubscribe(&adl3));
 
     bearer_adtype_remove_Expect(TEST_AD);
     bearer_adtype_filtering_set_Expect(false);
 
-    list_remove_ExpectAndReturn(mpp_head, &adl1.node, NRF_SUCCESS);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_unsubscribe(&adl1));
 }
 
@@ -435,7 +395,6 @@ void test_simple_listener_many_frames_process(void)
     bearer_adtype_mode_set_Ignore();
     bearer_adtype_filtering_set_Ignore();
 
-    list_add_Expect(mpp_head, &adl.node);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl));
 
     m_test_cnt = 0;
@@ -449,8 +408,7 @@ void test_simple_listener_many_frames_process(void)
 
     TEST_ASSERT_EQUAL_INT8(SEND_CYCLE_AMOUNT, m_test_cnt);
 
-    // clean up queue
-    *mpp_head = NULL;
+    listeners_unsubscribe(&adl, 1);
 }
 
 void test_wildcard_listener_many_frames_process(void)
@@ -484,7 +442,6 @@ void test_wildcard_listener_many_frames_process(void)
     bearer_adtype_mode_set_Ignore();
     bearer_adtype_filtering_set_Ignore();
 
-    list_add_Expect(mpp_head, &adl.node);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl));
 
     m_wildcard_cnt = 0;
@@ -498,8 +455,7 @@ void test_wildcard_listener_many_frames_process(void)
 
     TEST_ASSERT_EQUAL_INT8(3 * SEND_CYCLE_AMOUNT, m_wildcard_cnt);
 
-    // clean up queue
-    *mpp_head = NULL;
+    listeners_unsubscribe(&adl, 1);
 }
 
 void test_many_listeners_many_frames_process(void)
@@ -552,7 +508,6 @@ void test_many_listeners_many_frames_process(void)
 
     for (uint8_t i = 0; i < 4; i++)
     {
-        list_add_Expect(mpp_head, &adl[i].node);
         TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl[i]));
     }
 
@@ -573,8 +528,7 @@ void test_many_listeners_many_frames_process(void)
     TEST_ASSERT_EQUAL_INT8(SEND_CYCLE_AMOUNT, m_beacon_cnt);
     TEST_ASSERT_EQUAL_INT8(3 * SEND_CYCLE_AMOUNT, m_wildcard_cnt);
 
-    // clean up queue
-    *mpp_head = NULL;
+    listeners_unsubscribe(adl, 4);
 }
 
 void test_hash_check(void)
@@ -600,15 +554,13 @@ void test_hash_check(void)
     bearer_adtype_mode_set_Ignore();
     bearer_adtype_filtering_set_Ignore();
 
-    list_add_Expect(mpp_head, &adl.node);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl));
 
     nrf_mesh_rx_metadata_t metadata = {.source         = NRF_MESH_RX_SOURCE_SCANNER,
                                         .params.scanner = pkt.metadata};
     TEST_NRF_MESH_ASSERT_EXPECT(ad_listener_process(pkt.packet.header.type, pkt.packet.payload, sizeof(payload), &metadata));
 
-    // clean up queue
-    *mpp_head = NULL;
+    listeners_unsubscribe(&adl, 1);
 }
 
 void test_empty_ad_skip(void)
@@ -629,7 +581,6 @@ void test_empty_ad_skip(void)
     bearer_adtype_mode_set_Ignore();
     bearer_adtype_filtering_set_Ignore();
 
-    list_add_Expect(mpp_head, &adl.node);
     TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl));
 
     m_wildcard_cnt = 0;
@@ -643,6 +594,145 @@ void test_empty_ad_skip(void)
 
     TEST_ASSERT_EQUAL_INT8(0, m_wildcard_cnt);
 
-    // clean up queue
-    *mpp_head = NULL;
+    listeners_unsubscribe(&adl, 1);
+}
+
+void test_many_listeners_same_ad_process(void)
+{
+    ad_listener_t adl[] =
+    {
+        {
+            .handler = ad_test_cb,
+            .ad_type = TEST_AD,
+            .adv_packet_type = BLE_PACKET_TYPE_ADV_NONCONN_IND
+        },
+        {
+            .handler = second_test_cb,
+            .ad_type = TEST_AD,
+            .adv_packet_type = ADL_WILDCARD_ADV_TYPE
+        },
+        {
+            .handler = second_test_cb,
+            .ad_type = TEST_AD,
+            .adv_packet_type = BLE_PACKET_TYPE_ADV_IND
+        }
+    };
+
+    uint8_t payload[] =
+    {
+        1 + PB_ADV_AD_PAYLOAD_LEN,
+        AD_TYPE_PB_ADV,
+        PB_ADV_AD_PAYLOAD,
+
+        1 + TEST_AD_PAYLOAD_LEN,
+        TEST_AD,
+        TEST_AD_PAYLOAD
+    };
+
+    scanner_packet_t pkt;
+    scanner_packet_init(&pkt, payload, sizeof(payload));
+
+    /* Only the first listener of an AD type adds it to the filter. */
+    bearer_adtype_add_Expect(TEST_AD);
+    bearer_adtype_mode_set_Expect(AD_FILTER_WHITELIST_MODE);
+    bearer_adtype_filtering_set_Expect(true);
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(adl); i++)
+    {
+        TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl[i]));
+    }
+
+    m_test_cnt = 0;
+    m_second_test_cnt = 0;
+
+    nrf_mesh_rx_metadata_t metadata = {.source         = NRF_MESH_RX_SOURCE_SCANNER,
+                                       .params.scanner = pkt.metadata};
+    ad_listener_process(pkt.packet.header.type, pkt.packet.payload, sizeof(payload), &metadata);
+
+    TEST_ASSERT_EQUAL_INT8(1, m_test_cnt);
+    TEST_ASSERT_EQUAL_INT8(1, m_second_test_cnt);
+    /* The listeners are called in the order they subscribed. */
+    TEST_ASSERT_EQUAL_INT8(1, m_test_cnt_at_second_test);
+
+    /* The AD type stays in the filter until its last listener is gone. */
+    TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_unsubscribe(&adl[1]));
+    ad_type_filter_mock_Verify();
+
+    ad_listener_process(pkt.packet.header.type, pkt.packet.payload, sizeof(payload), &metadata);
+
+    TEST_ASSERT_EQUAL_INT8(2, m_test_cnt);
+    TEST_ASSERT_EQUAL_INT8(1, m_second_test_cnt);
+
+    TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_unsubscribe(&adl[0]));
+    ad_type_filter_mock_Verify();
+
+    bearer_adtype_remove_Expect(TEST_AD);
+    bearer_adtype_filtering_set_Expect(false);
+    TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_unsubscribe(&adl[2]));
+
+    ad_listener_process(pkt.packet.header.type, pkt.packet.payload, sizeof(payload), &metadata);
+
+    TEST_ASSERT_EQUAL_INT8(2, m_test_cnt);
+    TEST_ASSERT_EQUAL_INT8(1, m_second_test_cnt);
+}
+
+void test_unsubscribe_not_subscribed(void)
+{
+    ad_listener_t adl[] =
+    {
+        {
+            .handler = dummy,
+            .ad_type = TEST_AD,
+            .adv_packet_type = ADL_WILDCARD_ADV_TYPE
+        },
+        {
+            .handler = dummy,
+            .ad_type = TEST_AD,
+            .adv_packet_type = ADL_WILDCARD_ADV_TYPE
+        }
+    };
+
+    TEST_ASSERT_TRUE(NRF_ERROR_NOT_FOUND == ad_listener_unsubscribe(&adl[0]));
+
+    bearer_adtype_add_Expect(TEST_AD);
+    bearer_adtype_mode_set_Expect(AD_FILTER_WHITELIST_MODE);
+    bearer_adtype_filtering_set_Expect(true);
+    TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl[0]));
+
+    TEST_ASSERT_TRUE(NRF_ERROR_NOT_FOUND == ad_listener_unsubscribe(&adl[1]));
+
+    bearer_adtype_remove_Expect(TEST_AD);
+    bearer_adtype_filtering_set_Expect(false);
+    TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_unsubscribe(&adl[0]));
+
+    TEST_ASSERT_TRUE(NRF_ERROR_NOT_FOUND == ad_listener_unsubscribe(&adl[0]));
+}
+
+void test_subscribe_twice(void)
+{
+    ad_listener_t adl[] =
+    {
+        {
+            .handler = dummy,
+            .ad_type = TEST_AD,
+            .adv_packet_type = ADL_WILDCARD_ADV_TYPE
+        },
+        {
+            .handler = dummy,
+            .ad_type = TEST_AD,
+            .adv_packet_type = ADL_WILDCARD_ADV_TYPE
+        }
+    };
+
+    bearer_adtype_add_Expect(TEST_AD);
+    bearer_adtype_mode_set_Expect(AD_FILTER_WHITELIST_MODE);
+    bearer_adtype_filtering_set_Expect(true);
+    TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl[0]));
+    TEST_ASSERT_TRUE(NRF_SUCCESS == ad_listener_subscribe(&adl[1]));
+
+    /* Both at the head and further down the chain: */
+    TEST_NRF_MESH_ASSERT_EXPECT(ad_listener_subscribe(&adl[0]));
+    TEST_NRF_MESH_ASSERT_EXPECT(ad_listener_subscribe(&adl[1]));
+
+    listeners_unsubscribe(adl, ARRAY_SIZE(adl));
 }
@@ -209,7 +209,7 @@ void test_init(void)
 
 void test_instance_init(void)
 {
-    advertiser_t advertiser;
+    static advertiser_t advertiser;
     init_advertiser(&advertiser);
     TEST_ASSERT_FALSE(advertiser.enabled);
     TEST_ASSERT_NULL(advertiser.broadcast.params.p_packet);
@@ -660,3 +660,60 @@ void test_flush(void)
     packet_buffer_flush_Expect(&m_adv.buf);
     advertiser_flush(&m_adv);
 }
+
+void test_queue_depth(void)
+{
+    init_advertiser(&m_adv);
+    packet_buffer_packet_t * p_packet_buf = (packet_buffer_packet_t *) m_packet_buffer;
+    adv_packet_t * p_adv_packet = (adv_packet_t *) p_packet_buf->packet;
+    p_adv_packet->config.repeats = 1;
+
+    /* The other tests wipe their advertisers with packets still queued, only check the changes. */
+    uint32_t depth = advertiser_queue_depth_get();
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        packet_buffer_commit_Expect(&m_adv.buf, p_packet_buf, p_packet_buf->size);
+        advertiser_packet_send(&m_adv, p_adv_packet);
+        TEST_ASSERT_EQUAL(depth + i + 1, advertiser_queue_depth_get());
+    }
+
+    /* The packet being advertised is no longer in the queue. */
+    m_adv.enabled = true;
+    trigger_adv_evt(p_packet_buf, 1000, false, 0, 0);
+    TEST_ASSERT_EQUAL(depth + 2, advertiser_queue_depth_get());
+    TEST_ASSERT_EQUAL(2, m_adv.queued_count);
+
+    packet_buffer_flush_Expect(&m_adv.buf);
+    advertiser_flush(&m_adv);
+    TEST_ASSERT_EQUAL(depth, advertiser_queue_depth_get());
+    TEST_ASSERT_EQUAL(0, m_adv.queued_count);
+
+    /* Re-initializing an advertiser drops its queued packets from the depth. */
+    m_adv.enabled = false;
+    p_adv_packet->config.repeats = 1;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        packet_buffer_commit_Expect(&m_adv.buf, p_packet_buf, p_packet_buf->size);
+        advertiser_packet_send(&m_adv, p_adv_packet);
+    }
+    TEST_ASSERT_EQUAL(depth + 2, advertiser_queue_depth_get());
+
+    packet_buffer_init_Expect(&m_adv.buf, m_packet_buffer, BUF_SIZE);
+    bearer_event_sequential_add_Ignore();
+    advertiser_instance_init(&m_adv, tx_complete_cb, m_packet_buffer, BUF_SIZE);
+    TEST_ASSERT_EQUAL(depth, advertiser_queue_depth_get());
+    TEST_ASSERT_EQUAL(0, m_adv.queued_count);
+
+    packet_buffer_init_Expect(&m_adv.buf, m_packet_buffer, BUF_SIZE);
+    advertiser_instance_init(&m_adv, tx_complete_cb, m_packet_buffer, BUF_SIZE);
+    TEST_ASSERT_EQUAL(depth, advertiser_queue_depth_get());
+
+    /* The first initialization doesn't depend on the contents of the instance. */
+    static advertiser_t adv;
+    memset(&adv, 0xAB, sizeof(adv));
+    packet_buffer_init_Expect(&adv.buf, m_packet_buffer, BUF_SIZE);
+    advertiser_instance_init(&adv, tx_complete_cb, m_packet_buffer, BUF_SIZE);
+    TEST_ASSERT_EQUAL(depth, advertiser_queue_depth_get());
+    TEST_ASSERT_EQUAL(0, adv.queued_count);
+}
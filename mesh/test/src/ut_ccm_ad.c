@@ -209,3 +209,32 @@ void test_tv18(void)
 
     TEST_ASSERT_EQUAL_HEX8_ARRAY(tv18_in, m_out_buffer, sizeof(tv18_in));
 }
+
+void test_ad_candidates(void)
+{
+    const uint8_t wrong_ad[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x08};
+    uint8_t decrypted[sizeof(tv1_in)];
+
+    ccm_data.p_key   = tv1_key;
+    ccm_data.p_nonce = tv1_nonce;
+    ccm_data.p_m     = &tv1_out[tv1_adlen];
+    ccm_data.m_len   = sizeof(tv1_in) - tv1_adlen;
+    ccm_data.p_a     = NULL;
+    ccm_data.a_len   = tv1_adlen;
+    ccm_data.p_mic   = &tv1_out[sizeof(tv1_in)];
+    ccm_data.p_out   = decrypted;
+    ccm_data.mic_len = sizeof(tv1_out) - sizeof(tv1_in);
+
+    /* The candidate with the right additional data is found, regardless of its position: */
+    const uint8_t * p_candidates[] = {wrong_ad, wrong_ad, tv1_in};
+    TEST_ASSERT_EQUAL(2, ccm_soft_decrypt_ad_candidates(&ccm_data, p_candidates, 3));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&tv1_in[tv1_adlen], decrypted, sizeof(tv1_in) - tv1_adlen);
+
+    p_candidates[0] = tv1_in;
+    TEST_ASSERT_EQUAL(0, ccm_soft_decrypt_ad_candidates(&ccm_data, p_candidates, 3));
+
+    /* No candidates match: */
+    p_candidates[0] = wrong_ad;
+    TEST_ASSERT_EQUAL(2, ccm_soft_decrypt_ad_candidates(&ccm_data, p_candidates, 2));
+    TEST_ASSERT_EQUAL(0, ccm_soft_decrypt_ad_candidates(&ccm_data, p_candidates, 0));
+}
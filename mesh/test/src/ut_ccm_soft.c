@@ -104,3 +104,112 @@ void test_ccm_soft_decrypt(void)
     TEST_ASSERT_EQUAL(true, mic_passed);
     TEST_ASSERT_EQUAL_HEX8_ARRAY(m_unencrypted, output, sizeof(m_encrypted) - MIC_LEN);
 }
+
+void test_ccm_soft_decrypt_multiblock(void)
+{
+    uint8_t message[40];
+    uint8_t encrypted[sizeof(message) + 8];
+    for (uint32_t i = 0; i < sizeof(message); i++)
+    {
+        message[i] = i;
+    }
+
+    ccm_soft_data_t data =
+    {
+        .p_key   = m_key,
+        .p_nonce = m_nonce,
+        .p_m     = message,
+        .m_len   = sizeof(message),
+        .mic_len = 8,
+        .p_mic   = &encrypted[sizeof(message)],
+        .p_out   = encrypted
+    };
+    ccm_soft_encrypt(&data);
+
+    /* Decrypt in place: */
+    uint8_t buffer[sizeof(encrypted)];
+    memcpy(buffer, encrypted, sizeof(encrypted));
+    data.p_m   = buffer;
+    data.p_out = buffer;
+    data.p_mic = &buffer[sizeof(message)];
+
+    bool mic_passed = false;
+    ccm_soft_decrypt(&data, &mic_passed);
+    TEST_ASSERT_EQUAL(true, mic_passed);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(message, buffer, sizeof(message));
+
+    /* Any change to the payload or the MIC must be rejected: */
+    const uint32_t tampered_bytes[] = {0, 17, sizeof(message) - 1, sizeof(message), sizeof(encrypted) - 1};
+    for (uint32_t i = 0; i < sizeof(tampered_bytes) / sizeof(tampered_bytes[0]); i++)
+    {
+        memcpy(buffer, encrypted, sizeof(encrypted));
+        buffer[tampered_bytes[i]] ^= 0x01;
+
+        mic_passed = true;
+        ccm_soft_decrypt(&data, &mic_passed);
+        TEST_ASSERT_EQUAL(false, mic_passed);
+    }
+}
+
+void test_ccm_soft_decrypt_in_parts(void)
+{
+    uint8_t message[41];
+    uint8_t encrypted[sizeof(message) + MIC_LEN];
+    for (uint32_t i = 0; i < sizeof(message); i++)
+    {
+        message[i] = 0xA0 + i;
+    }
+
+    ccm_soft_data_t data =
+    {
+        .p_key   = m_key,
+        .p_nonce = m_nonce,
+        .p_m     = message,
+        .m_len   = sizeof(message),
+        .mic_len = MIC_LEN,
+        .p_mic   = &encrypted[sizeof(message)],
+        .p_out   = encrypted
+    };
+    ccm_soft_encrypt(&data);
+
+    /* Decrypt in place, in segment sized parts, out of order: */
+    const uint16_t part_offsets[] = {24, 0, 36, 12};
+    uint8_t buffer[sizeof(encrypted)];
+    memcpy(buffer, encrypted, sizeof(encrypted));
+    ccm_soft_keystream_t keystream = {0};
+    for (uint32_t i = 0; i < sizeof(part_offsets) / sizeof(part_offsets[0]); i++)
+    {
+        ccm_soft_data_t part = data;
+        part.p_m   = &buffer[part_offsets[i]];
+        part.p_out = &buffer[part_offsets[i]];
+        part.m_len = (part_offsets[i] + 12 > sizeof(message)) ? sizeof(message) - part_offsets[i] : 12;
+        ccm_soft_keystream_apply(&part, part_offsets[i], &keystream);
+    }
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(message, buffer, sizeof(message));
+
+    data.p_m   = buffer;
+    data.p_out = NULL;
+    data.p_mic = &buffer[sizeof(message)];
+    bool mic_passed = false;
+    ccm_soft_decrypted_authenticate(&data, &mic_passed);
+    TEST_ASSERT_EQUAL(true, mic_passed);
+
+    /* Applying the keystream again restores the encrypted message: */
+    data.p_out = buffer;
+    data.m_len = sizeof(message);
+    ccm_soft_keystream_apply(&data, 0, &keystream);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(encrypted, buffer, sizeof(encrypted));
+
+    /* Any change to the payload or the MIC must be rejected: */
+    const uint32_t tampered_bytes[] = {0, 17, sizeof(message) - 1, sizeof(message), sizeof(encrypted) - 1};
+    for (uint32_t i = 0; i < sizeof(tampered_bytes) / sizeof(tampered_bytes[0]); i++)
+    {
+        memcpy(buffer, encrypted, sizeof(encrypted));
+        ccm_soft_keystream_apply(&data, 0, &keystream);
+        buffer[tampered_bytes[i]] ^= 0x01;
+
+        mic_passed = true;
+        ccm_soft_decrypted_authenticate(&data, &mic_passed);
+        TEST_ASSERT_EQUAL(false, mic_passed);
+    }
+}
@@ -165,6 +165,18 @@ void tx_complete_cb(core_tx_role_t role,
     m_tx_complete_expect.calls--;
 }
 
+static uint32_t m_relay_tx_complete_calls;
+
+static void relay_tx_complete_cb(core_tx_role_t role,
+                                 uint32_t bearer_index,
+                                 uint32_t timestamp,
+                                 nrf_mesh_tx_token_t token)
+{
+    TEST_ASSERT_EQUAL(CORE_TX_ROLE_RELAY, role);
+    TEST_ASSERT_EQUAL(CORE_TX_TOKEN_RELAY, token);
+    m_relay_tx_complete_calls++;
+}
+
 static void setup_bearer(void)
 {
     m_interface.packet_alloc = packet_alloc;
@@ -423,6 +435,27 @@ void test_tx_complete(void)
     core_tx_complete(&m_bearer, CORE_TX_ROLE_ORIGINATOR, 1234, TOKEN);
     TEST_ASSERT_EQUAL(0, m_tx_complete_expect.calls);
 
+    /* Relayed packets go to the regular callback until a relay callback is set: */
+    m_tx_complete_expect.calls = 1;
+    m_tx_complete_expect.role  = CORE_TX_ROLE_RELAY;
+    m_tx_complete_expect.token = CORE_TX_TOKEN_RELAY;
+    core_tx_complete(&m_bearer, CORE_TX_ROLE_RELAY, 1234, CORE_TX_TOKEN_RELAY);
+    TEST_ASSERT_EQUAL(0, m_tx_complete_expect.calls);
+
+    m_relay_tx_complete_calls = 0;
+    core_tx_relay_complete_cb_set(relay_tx_complete_cb);
+    core_tx_complete(&m_bearer, CORE_TX_ROLE_RELAY, 1234, CORE_TX_TOKEN_RELAY);
+    TEST_ASSERT_EQUAL(1, m_relay_tx_complete_calls);
+
+    /* The originator packets still go to the regular callback: */
+    m_tx_complete_expect.calls = 1;
+    m_tx_complete_expect.role  = CORE_TX_ROLE_ORIGINATOR;
+    m_tx_complete_expect.token = TOKEN;
+    core_tx_complete(&m_bearer, CORE_TX_ROLE_ORIGINATOR, 1234, TOKEN);
+    TEST_ASSERT_EQUAL(0, m_tx_complete_expect.calls);
+    TEST_ASSERT_EQUAL(1, m_relay_tx_complete_calls);
+    core_tx_relay_complete_cb_set(NULL);
+
     /* Clear it, should go back to not doing anything. */
     core_tx_complete_cb_set(NULL);
     core_tx_complete(&m_bearer, CORE_TX_ROLE_ORIGINATOR, 1234, TOKEN);
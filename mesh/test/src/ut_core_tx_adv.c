@@ -204,10 +204,9 @@ void test_tx_complete(void)
 {
     test_init();
 
-    /* Only the originator-advertiser will have a callback, so we'll test with that one: */
+    /* Both roles report TX complete, the relay role to let the network layer flush its relay queue: */
     TEST_ASSERT_NOT_NULL(mp_advertisers[CORE_TX_ROLE_ORIGINATOR]->tx_complete_callback);
-    /* Verify the above claim: */
-    TEST_ASSERT_NULL(mp_advertisers[CORE_TX_ROLE_RELAY]->tx_complete_callback);
+    TEST_ASSERT_NOT_NULL(mp_advertisers[CORE_TX_ROLE_RELAY]->tx_complete_callback);
 
     adv_packet_t packet;
     packet.token = TOKEN;
@@ -216,6 +215,10 @@ void test_tx_complete(void)
     core_tx_complete_Expect(mp_bearer, CORE_TX_ROLE_ORIGINATOR, 1234, TOKEN);
     mp_advertisers[CORE_TX_ROLE_ORIGINATOR]->tx_complete_callback(
         mp_advertisers[CORE_TX_ROLE_ORIGINATOR], packet.token, 1234);
+
+    core_tx_complete_Expect(mp_bearer, CORE_TX_ROLE_RELAY, 5678, CORE_TX_TOKEN_RELAY);
+    mp_advertisers[CORE_TX_ROLE_RELAY]->tx_complete_callback(
+        mp_advertisers[CORE_TX_ROLE_RELAY], CORE_TX_TOKEN_RELAY, 5678);
 }
 
 void test_config(void)
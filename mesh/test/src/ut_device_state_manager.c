@@ -2789,3 +2789,105 @@ void test_invalid_address_lookup(void)
 #endif
 }
 
+
+static void net_secmat_list_verify(uint8_t nid, const nrf_mesh_network_secmat_t * const * pp_expected, uint32_t count)
+{
+    const nrf_mesh_network_secmat_t * p_secmat = NULL;
+    const nrf_mesh_network_secmat_t * p_secmat_secondary = NULL;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        nrf_mesh_net_secmat_next_get(nid, &p_secmat, &p_secmat_secondary);
+        TEST_ASSERT_NOT_NULL(p_secmat);
+        TEST_ASSERT_NULL(p_secmat_secondary);
+        TEST_ASSERT_EQUAL_HEX8(nid, p_secmat->nid);
+        TEST_ASSERT_EQUAL_HEX8(pp_expected[i]->nid, p_secmat->nid);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(pp_expected[i]->encryption_key, p_secmat->encryption_key, NRF_MESH_KEY_SIZE);
+    }
+    nrf_mesh_net_secmat_next_get(nid, &p_secmat, &p_secmat_secondary);
+    TEST_ASSERT_EQUAL_PTR_MESSAGE(NULL, p_secmat, "Found more networks than expected");
+    TEST_ASSERT_NULL(p_secmat_secondary);
+}
+
+void test_net_secmat_nid_lookup(void)
+{
+    /* Three subnets, where two share a NID, and the third one changes to that NID during key refresh. */
+    struct
+    {
+        uint8_t key[NRF_MESH_KEY_SIZE];
+        nrf_mesh_network_secmat_t secmat;
+        dsm_handle_t handle;
+    } net[3];
+    uint8_t new_key[NRF_MESH_KEY_SIZE];
+    nrf_mesh_network_secmat_t new_secmat;
+    nrf_mesh_beacon_secmat_t beacon_secmat;
+    memset(&beacon_secmat, 0, sizeof(beacon_secmat));
+
+    const uint8_t nids[] = {0x05, 0x07, 0x05};
+    for (uint32_t i = 0; i < ARRAY_SIZE(net); ++i)
+    {
+        memset(net[i].key, i + 1, NRF_MESH_KEY_SIZE);
+        memset(&net[i].secmat, i + 1, sizeof(net[i].secmat));
+        net[i].secmat.nid = nids[i];
+
+        nrf_mesh_keygen_network_secmat_ExpectAndReturn(net[i].key, NULL, NRF_SUCCESS);
+        nrf_mesh_keygen_network_secmat_IgnoreArg_p_secmat();
+        nrf_mesh_keygen_network_secmat_ReturnMemThruPtr_p_secmat(&net[i].secmat, sizeof(net[i].secmat));
+        nrf_mesh_keygen_beacon_secmat_ExpectAndReturn(net[i].key, NULL, NRF_SUCCESS);
+        nrf_mesh_keygen_beacon_secmat_IgnoreArg_p_secmat();
+        nrf_mesh_keygen_beacon_secmat_ReturnMemThruPtr_p_secmat(&beacon_secmat, sizeof(beacon_secmat));
+        flash_expect_subnet(net[i].key, i);
+        TEST_ASSERT_EQUAL(NRF_SUCCESS, dsm_subnet_add(i, net[i].key, &net[i].handle));
+    }
+
+    {
+        const nrf_mesh_network_secmat_t * p_expected[] = {&net[0].secmat, &net[2].secmat};
+        net_secmat_list_verify(0x05, p_expected, ARRAY_SIZE(p_expected));
+    }
+    {
+        const nrf_mesh_network_secmat_t * p_expected[] = {&net[1].secmat};
+        net_secmat_list_verify(0x07, p_expected, ARRAY_SIZE(p_expected));
+    }
+    net_secmat_list_verify(0x06, NULL, 0);
+
+    /* Start key refresh on the second subnet, moving it to the shared NID: */
+    memset(new_key, 0xAA, NRF_MESH_KEY_SIZE);
+    memset(&new_secmat, 0xAA, sizeof(new_secmat));
+    new_secmat.nid = 0x05;
+    nrf_mesh_keygen_network_secmat_ExpectAndReturn(new_key, NULL, NRF_SUCCESS);
+    nrf_mesh_keygen_network_secmat_IgnoreArg_p_secmat();
+    nrf_mesh_keygen_network_secmat_ReturnMemThruPtr_p_secmat(&new_secmat, sizeof(new_secmat));
+    nrf_mesh_keygen_beacon_secmat_ExpectAndReturn(new_key, NULL, NRF_SUCCESS);
+    nrf_mesh_keygen_beacon_secmat_IgnoreArg_p_secmat();
+    nrf_mesh_keygen_beacon_secmat_ReturnMemThruPtr_p_secmat(&beacon_secmat, sizeof(beacon_secmat));
+    flash_expect_subnet_update(net[1].key, new_key, 1, NRF_MESH_KEY_REFRESH_PHASE_1, net[1].handle);
+    net_state_key_refresh_phase_changed_Expect(1, beacon_secmat.net_id, NRF_MESH_KEY_REFRESH_PHASE_1);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, dsm_subnet_update(1, new_key));
+
+    /* Both keys of the refreshing subnet are reachable through their own NID, in subnet order: */
+    {
+        const nrf_mesh_network_secmat_t * p_expected[] = {&net[0].secmat, &new_secmat, &net[2].secmat};
+        net_secmat_list_verify(0x05, p_expected, ARRAY_SIZE(p_expected));
+    }
+    {
+        const nrf_mesh_network_secmat_t * p_expected[] = {&net[1].secmat};
+        net_secmat_list_verify(0x07, p_expected, ARRAY_SIZE(p_expected));
+    }
+
+    /* The old key is no longer used for receiving after the key refresh is committed: */
+    net_state_key_refresh_phase_changed_Expect(1, beacon_secmat.net_id, NRF_MESH_KEY_REFRESH_PHASE_0);
+    flash_expect_subnet(new_key, 1);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, dsm_subnet_update_commit(net[1].handle));
+    {
+        const nrf_mesh_network_secmat_t * p_expected[] = {&net[0].secmat, &new_secmat, &net[2].secmat};
+        net_secmat_list_verify(0x05, p_expected, ARRAY_SIZE(p_expected));
+    }
+    net_secmat_list_verify(0x07, NULL, 0);
+
+    /* Deleted subnets are removed from the lookup: */
+    flash_invalidate_expect(DSM_HANDLE_TO_FLASH_HANDLE(DSM_FLASH_GROUP_SUBNETS, net[0].handle));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, dsm_subnet_delete(net[0].handle));
+    {
+        const nrf_mesh_network_secmat_t * p_expected[] = {&new_secmat, &net[2].secmat};
+        net_secmat_list_verify(0x05, p_expected, ARRAY_SIZE(p_expected));
+    }
+}
@@ -44,6 +44,10 @@
 #include "ad_type_filter.h"
 #include "rssi_filter.h"
 #include "adv_packet_filter.h"
+#include "nordic_common.h"
+
+#include "timer_mock.h"
+#include "bearer_event_mock.h"
 
 typedef enum
 {
@@ -67,12 +71,21 @@ static packet_t test_packet = {.header = {BLE_PACKET_TYPE_ADV_NONCONN_IND, 0, 1,
 
 void setUp(void)
 {
+    timer_mock_Init();
+    bearer_event_mock_Init();
+    bearer_event_critical_section_begin_Ignore();
+    bearer_event_critical_section_end_Ignore();
     test_packet.payload[0] = 30;
     test_packet.payload[1] = AD_TYPE_MESH;
 }
 
 void tearDown(void)
-{}
+{
+    timer_mock_Verify();
+    timer_mock_Destroy();
+    bearer_event_mock_Verify();
+    bearer_event_mock_Destroy();
+}
 
 static void all_ad_types_add(void)
 {
@@ -767,3 +780,304 @@ void test_adv_packet_filtering(void)
     /* switch off BLE packet type filter */
     bearer_adv_packet_filtering_set(false);
 }
+
+static void compiled_test_packet_build(scanner_packet_t * p_scanner_packet,
+                                       const ble_gap_addr_t * p_filter_list,
+                                       uint32_t index)
+{
+    static const ble_packet_type_t types[] = {BLE_PACKET_TYPE_ADV_IND,
+                                              BLE_PACKET_TYPE_ADV_NONCONN_IND,
+                                              BLE_PACKET_TYPE_SCAN_REQ,
+                                              BLE_PACKET_TYPE_ADV_DIRECT_IND};
+    packet_t * p_packet = &p_scanner_packet->packet;
+    uint32_t addr_index = (index >> 3) & 0x07;
+
+    memcpy(p_packet, &test_packet, sizeof(packet_t));
+    p_scanner_packet->metadata.rssi = (index & 0x01) ? -50 : -70;
+    p_packet->header.type = types[(index >> 1) & 0x03];
+    /* The first half of the addresses are in the filter list, the second half differ in one byte. */
+    memcpy(p_packet->addr, p_filter_list[addr_index & 0x03].addr, BLE_GAP_ADDR_LEN);
+    p_packet->header.addr_type = p_filter_list[addr_index & 0x03].addr_type;
+    if (addr_index & 0x04)
+    {
+        p_packet->addr[0]++;
+    }
+    p_packet->payload[1] = ((index >> 6) & 0x01) ? AD_TYPE_MESH : AD_TYPE_BEACON;
+    if ((index >> 7) & 0x01)
+    {
+        /* AD structure overflowing the packet */
+        p_packet->payload[0] = 40;
+    }
+}
+
+static void filter_counters_get(uint32_t * p_counters)
+{
+    p_counters[ACCEPTED_COUNTER]          = fen_accepted_amount_get();
+    p_counters[INVALID_LENGTH_COUNTER]    = bearer_invalid_length_amount_get();
+    p_counters[FILTERED_AD_TYPE_COUNTER]  = bearer_adtype_filtered_amount_get();
+    p_counters[FILTERED_ADV_TYPE_COUNTER] = bearer_adv_packet_filtered_amount_get();
+    p_counters[FILTERED_GAP_ADDR_COUNTER] = bearer_gap_addr_filtered_amount_get();
+    p_counters[FILTERED_RSSI_COUNTER]     = bearer_rssi_filtered_amount_get();
+}
+
+void test_compiled_filtering(void)
+{
+    scanner_packet_t scanner_packet;
+    bool expected[256];
+    uint32_t counters_before[FILTERED_RSSI_COUNTER + 1];
+    uint32_t counters_list[FILTERED_RSSI_COUNTER + 1];
+    uint32_t counters_compiled[FILTERED_RSSI_COUNTER + 1];
+
+    /* Deliberately unsorted, the compiled filter keeps its own sorted copy. */
+    ble_gap_addr_t filter_list[4];
+    for (uint32_t i = 0; i < ARRAY_SIZE(filter_list); i++)
+    {
+        filter_list[i].addr_type = i & 0x01;
+        memset(filter_list[i].addr, 0xF0 - 0x10 * i, BLE_GAP_ADDR_LEN);
+    }
+
+    bearer_rssi_filtering_set(-60);
+    bearer_adv_packet_filter_mode_set(ADV_FILTER_WHITELIST_MODE);
+    bearer_adv_packet_clear();
+    bearer_adv_packet_add(BLE_PACKET_TYPE_ADV_IND);
+    bearer_adv_packet_filtering_set(true);
+    bearer_adtype_mode_set(AD_FILTER_WHITELIST_MODE);
+    bearer_adtype_clear();
+    bearer_adtype_add(AD_TYPE_MESH);
+    bearer_adtype_filtering_set(true);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_whitelist_set(filter_list, ARRAY_SIZE(filter_list)));
+
+    /* Compiled filter is inactive outside compiled mode. */
+    compiled_test_packet_build(&scanner_packet, filter_list, 0);
+    TEST_ASSERT_FALSE(fen_compiled_filters_apply(&scanner_packet));
+
+    /* Reference decisions of the filter handlers. */
+    filter_counters_get(counters_before);
+    for (uint32_t i = 0; i < ARRAY_SIZE(expected); i++)
+    {
+        compiled_test_packet_build(&scanner_packet, filter_list, i);
+        expected[i] = fen_filters_apply(&scanner_packet);
+    }
+    filter_counters_get(counters_list);
+    for (uint32_t i = 0; i < ARRAY_SIZE(counters_list); i++)
+    {
+        counters_list[i] -= counters_before[i];
+    }
+
+    /* The compiled filter must make the same decisions. All filters are compiled, so the handlers
+     * have nothing left to reject. */
+    fen_compiled_mode_set(true);
+    filter_counters_get(counters_before);
+    for (uint32_t i = 0; i < ARRAY_SIZE(expected); i++)
+    {
+        compiled_test_packet_build(&scanner_packet, filter_list, i);
+        bool filtered = fen_compiled_filters_apply(&scanner_packet);
+        if (!filtered)
+        {
+            TEST_ASSERT_FALSE(fen_filters_apply(&scanner_packet));
+        }
+        TEST_ASSERT_EQUAL_MESSAGE(expected[i], filtered, "Compiled decision");
+    }
+    filter_counters_get(counters_compiled);
+    uint32_t rejected_list = 0;
+    uint32_t rejected_compiled = 0;
+    for (uint32_t i = 0; i < ARRAY_SIZE(counters_compiled); i++)
+    {
+        counters_compiled[i] -= counters_before[i];
+        if (i != ACCEPTED_COUNTER)
+        {
+            rejected_list += counters_list[i];
+            rejected_compiled += counters_compiled[i];
+        }
+    }
+    /* Packets rejected by several filters may be counted by another filter than in list mode,
+     * as the compiled stages run in a fixed order. */
+    TEST_ASSERT_EQUAL(counters_list[ACCEPTED_COUNTER], counters_compiled[ACCEPTED_COUNTER]);
+    TEST_ASSERT_EQUAL(rejected_list, rejected_compiled);
+
+    /* Configuration changes are picked up in compiled mode. */
+    compiled_test_packet_build(&scanner_packet, filter_list, 0x41);
+    TEST_ASSERT_FALSE(fen_compiled_filters_apply(&scanner_packet));
+    bearer_adv_packet_remove(BLE_PACKET_TYPE_ADV_IND);
+    TEST_ASSERT_TRUE(fen_compiled_filters_apply(&scanner_packet));
+    bearer_adv_packet_add(BLE_PACKET_TYPE_ADV_IND);
+    bearer_rssi_filtering_set(-40);
+    TEST_ASSERT_TRUE(fen_compiled_filters_apply(&scanner_packet));
+    bearer_rssi_filtering_set(0);
+    TEST_ASSERT_FALSE(fen_compiled_filters_apply(&scanner_packet));
+
+    /* Address lists with learned addresses are applied by the handler. */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_clear());
+    ble_gap_addr_t other_addr;
+    memset(&other_addr, 0, sizeof(other_addr));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_whitelist_set(&other_addr, 1));
+    TEST_ASSERT_TRUE(fen_compiled_filters_apply(&scanner_packet));
+    timer_now_ExpectAndReturn(0);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_learn(&filter_list[1], 0));
+    TEST_ASSERT_FALSE(fen_compiled_filters_apply(&scanner_packet));
+    TEST_ASSERT_TRUE(fen_filters_apply(&scanner_packet));
+
+    /* Leaving compiled mode hands all filters back to the handlers. */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_clear());
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_whitelist_set(filter_list, ARRAY_SIZE(filter_list)));
+    fen_compiled_mode_set(false);
+    TEST_ASSERT_FALSE(fen_compiled_filters_apply(&scanner_packet));
+    bearer_adv_packet_remove(BLE_PACKET_TYPE_ADV_IND);
+    TEST_ASSERT_TRUE(fen_filters_apply(&scanner_packet));
+
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_clear());
+    bearer_adtype_filtering_set(false);
+    bearer_adv_packet_filtering_set(false);
+}
+
+static void set_test_addr_build(ble_gap_addr_t * p_addr, uint32_t index)
+{
+    p_addr->addr_type = index & 0x01;
+    memset(p_addr->addr, 0x5A, BLE_GAP_ADDR_LEN);
+    p_addr->addr[0] = (uint8_t) index;
+    p_addr->addr[3] = (uint8_t) (index >> 8);
+}
+
+static bool addr_filtered(scanner_packet_t * p_scanner_packet, const ble_gap_addr_t * p_addr, timestamp_t timestamp)
+{
+    p_scanner_packet->packet.header.addr_type = p_addr->addr_type;
+    memcpy(p_scanner_packet->packet.addr, p_addr->addr, BLE_GAP_ADDR_LEN);
+    p_scanner_packet->metadata.timestamp = timestamp;
+    return fen_filters_apply(p_scanner_packet);
+}
+
+void test_gap_address_set(void)
+{
+    scanner_packet_t scanner_packet;
+    bearer_filter_gap_addr_set_stats_t stats;
+    bearer_filter_gap_addr_set_stats_t stats_before;
+    ble_gap_addr_t filter_list[GAP_ADDR_FILTER_LINEAR_MAX + 4];
+    ble_gap_addr_t addr;
+
+    memcpy(&scanner_packet.packet, &test_packet, sizeof(packet_t));
+    for (uint32_t i = 0; i < ARRAY_SIZE(filter_list); i++)
+    {
+        set_test_addr_build(&filter_list[i], i);
+    }
+
+    /* Learning requires a list filter. */
+    set_test_addr_build(&addr, 0x100);
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_STATE, bearer_filter_gap_addr_learn(&addr, 0));
+
+    /* The statistics are kept for the lifetime of the module. */
+    bearer_filter_gap_addr_set_stats_get(&stats_before);
+
+    /* Long lists are loaded into the address set. */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_blacklist_set(filter_list, ARRAY_SIZE(filter_list)));
+    bearer_filter_gap_addr_set_stats_get(&stats);
+    TEST_ASSERT_EQUAL(ARRAY_SIZE(filter_list), stats.entries);
+    TEST_ASSERT_TRUE(stats.list_hashed);
+    TEST_ASSERT_EQUAL(0, stats.lookups - stats_before.lookups);
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(filter_list); i++)
+    {
+        TEST_ASSERT_TRUE(addr_filtered(&scanner_packet, &filter_list[i], 0));
+    }
+    TEST_ASSERT_FALSE(addr_filtered(&scanner_packet, &addr, 0));
+    bearer_filter_gap_addr_set_stats_get(&stats);
+    TEST_ASSERT_EQUAL(ARRAY_SIZE(filter_list) + 1, stats.lookups - stats_before.lookups);
+    TEST_ASSERT_EQUAL(ARRAY_SIZE(filter_list), stats.hits - stats_before.hits);
+
+    /* Learned addresses are filtered until their lifetime runs out. */
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, bearer_filter_gap_addr_learn(NULL, 0));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, bearer_filter_gap_addr_learn(&addr, BEARER_FILTER_GAP_ADDR_LIFETIME_MAX_MS + 1));
+    timer_now_ExpectAndReturn(1000);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_learn(&addr, 100));
+    TEST_ASSERT_TRUE(addr_filtered(&scanner_packet, &addr, 1000 + 99999));
+    TEST_ASSERT_FALSE(addr_filtered(&scanner_packet, &addr, 1000 + 100001));
+    bearer_filter_gap_addr_set_stats_get(&stats);
+    TEST_ASSERT_EQUAL(1, stats.expired - stats_before.expired);
+    TEST_ASSERT_EQUAL(ARRAY_SIZE(filter_list), stats.entries);
+
+    /* Learning a listed address doesn't make it expire. */
+    timer_now_ExpectAndReturn(1000);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_learn(&filter_list[0], 100));
+    TEST_ASSERT_TRUE(addr_filtered(&scanner_packet, &filter_list[0], 1000 + 200000));
+
+    /* Fill the set up with short lived addresses. */
+    uint32_t learned = 0;
+    for (uint32_t status = NRF_SUCCESS; status == NRF_SUCCESS; learned++)
+    {
+        set_test_addr_build(&addr, 0x200 + learned);
+        timer_now_ExpectAndReturn(2000);
+        status = bearer_filter_gap_addr_learn(&addr, 10);
+    }
+    learned--;
+    TEST_ASSERT_EQUAL(GAP_ADDR_FILTER_HASH_SET_CAPACITY - ARRAY_SIZE(filter_list), learned);
+    bearer_filter_gap_addr_set_stats_get(&stats);
+    TEST_ASSERT_EQUAL(1, stats.learn_failures - stats_before.learn_failures);
+    TEST_ASSERT_EQUAL(GAP_ADDR_FILTER_HASH_SET_CAPACITY, stats.entries);
+    for (uint32_t i = 0; i < learned; i++)
+    {
+        set_test_addr_build(&addr, 0x200 + i);
+        TEST_ASSERT_TRUE(addr_filtered(&scanner_packet, &addr, 2000));
+    }
+
+    /* Once they've expired, a full set makes room by dropping them, and the listed addresses
+     * survive the removals. */
+    set_test_addr_build(&addr, 0x300);
+    timer_now_ExpectAndReturn(2000 + 10001);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_learn(&addr, 0));
+    bearer_filter_gap_addr_set_stats_get(&stats);
+    TEST_ASSERT_EQUAL(1 + learned, stats.expired - stats_before.expired);
+    TEST_ASSERT_EQUAL(ARRAY_SIZE(filter_list) + 1, stats.entries);
+    for (uint32_t i = 0; i < ARRAY_SIZE(filter_list); i++)
+    {
+        TEST_ASSERT_TRUE(addr_filtered(&scanner_packet, &filter_list[i], 2000 + 10001));
+    }
+    TEST_ASSERT_TRUE(addr_filtered(&scanner_packet, &addr, 0x80000000));
+    for (uint32_t i = 0; i < learned; i++)
+    {
+        set_test_addr_build(&addr, 0x200 + i);
+        TEST_ASSERT_FALSE(addr_filtered(&scanner_packet, &addr, 2000 + 10001));
+    }
+
+    /* Setting the list again forgets the learned addresses. */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_clear());
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_whitelist_set(filter_list, ARRAY_SIZE(filter_list)));
+    bearer_filter_gap_addr_set_stats_get(&stats);
+    TEST_ASSERT_EQUAL(ARRAY_SIZE(filter_list), stats.entries);
+    set_test_addr_build(&addr, 0x300);
+    TEST_ASSERT_TRUE(addr_filtered(&scanner_packet, &addr, 0));
+    for (uint32_t i = 0; i < ARRAY_SIZE(filter_list); i++)
+    {
+        TEST_ASSERT_FALSE(addr_filtered(&scanner_packet, &filter_list[i], 0));
+    }
+
+    /* Learned addresses are accepted by a whitelist. */
+    timer_now_ExpectAndReturn(0);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_learn(&addr, 0));
+    TEST_ASSERT_FALSE(addr_filtered(&scanner_packet, &addr, 0));
+
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_clear());
+    bearer_filter_gap_addr_set_stats_get(&stats);
+    TEST_ASSERT_EQUAL(0, stats.entries);
+    TEST_ASSERT_FALSE(stats.list_hashed);
+
+    /* Short lists are scanned linearly. */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_blacklist_set(filter_list, GAP_ADDR_FILTER_LINEAR_MAX));
+    bearer_filter_gap_addr_set_stats_get(&stats);
+    TEST_ASSERT_EQUAL(0, stats.entries);
+    TEST_ASSERT_FALSE(stats.list_hashed);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_clear());
+
+    static ble_gap_addr_t long_list[GAP_ADDR_FILTER_HASH_SET_CAPACITY + 1];
+    for (uint32_t i = 0; i < ARRAY_SIZE(long_list); i++)
+    {
+        set_test_addr_build(&long_list[i], i);
+    }
+    /* Lists that don't fit in the set are rejected, and the previous filter stays in place. */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_blacklist_set(long_list, GAP_ADDR_FILTER_HASH_SET_CAPACITY));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, bearer_filter_gap_addr_blacklist_set(long_list, ARRAY_SIZE(long_list)));
+    bearer_filter_gap_addr_set_stats_get(&stats);
+    TEST_ASSERT_EQUAL(GAP_ADDR_FILTER_HASH_SET_CAPACITY, stats.entries);
+    TEST_ASSERT_TRUE(stats.list_hashed);
+    TEST_ASSERT_TRUE(addr_filtered(&scanner_packet, &long_list[GAP_ADDR_FILTER_HASH_SET_CAPACITY - 1], 0));
+    TEST_ASSERT_FALSE(addr_filtered(&scanner_packet, &long_list[GAP_ADDR_FILTER_HASH_SET_CAPACITY], 0));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, bearer_filter_gap_addr_clear());
+}
@@ -102,6 +102,7 @@ static const transport_control_packet_t * mp_transport_control_tx_p_params;
 static nrf_mesh_tx_token_t m_tcp_tx_token;
 static uint32_t m_transport_control_tx_stub_cnt;
 static uint32_t m_exp_transport_control_tx_stub_cnt;
+static uint32_t m_transport_control_tx_template_init_stub_cnt;
 static packet_mesh_trs_control_packet_t  m_generated_hb_pdu;
 static uint8_t m_generated_hb_pdu_len;
 
@@ -147,24 +148,54 @@ static void timer_sch_reschedule_stub(timer_event_t * p_event, timestamp_t next_
     m_timer_sch_reschedule_stub_cnt++;
 }
 
-static uint32_t transport_control_tx_stub(const transport_control_packet_t * p_params, nrf_mesh_tx_token_t tx_token, int count)
+static uint32_t transport_control_tx_template_init_stub(transport_control_tx_template_t * p_template,
+                                                       const transport_control_packet_t * p_params,
+                                                       int count)
 {
     mp_transport_control_tx_p_params = p_params;
-    m_tcp_tx_token = tx_token;
-    m_transport_control_tx_stub_cnt++;
-
-    memcpy(m_generated_hb_pdu.pdu, p_params->p_data, p_params->data_len);
-    m_generated_hb_pdu_len = p_params->data_len;
+    m_transport_control_tx_template_init_stub_cnt++;
 
     // test the transport packet's key parameters match the publication settings
-    // ?? todo: fix: test_pub_params = heartbeat_publication_get();
+    TEST_ASSERT_EQUAL(TRANSPORT_CONTROL_OPCODE_HEARTBEAT, p_params->opcode);
+    TEST_ASSERT_FALSE(p_params->reliable);
     TEST_ASSERT_EQUAL(m_heartbeat_publication.ttl, p_params->ttl);
     TEST_ASSERT_TRUE((p_params->dst.type == NRF_MESH_ADDRESS_TYPE_UNICAST) || (p_params->dst.type == NRF_MESH_ADDRESS_TYPE_GROUP));
     TEST_ASSERT_EQUAL(m_heartbeat_publication.dst, p_params->dst.value);
 
+    memset(p_template, 0, sizeof(*p_template));
+    p_template->net.src                 = p_params->src;
+    p_template->net.dst                 = p_params->dst;
+    p_template->net.ttl                 = p_params->ttl;
+    p_template->net.p_security_material = p_params->p_net_secmat;
+    p_template->net.control_packet      = true;
+    p_template->data_len                = p_params->data_len;
     return NRF_SUCCESS;
 }
 
+static uint32_t transport_control_tx_template_send_stub(const transport_control_tx_template_t * p_template,
+                                                       const packet_mesh_trs_control_packet_t * p_data,
+                                                       nrf_mesh_tx_token_t tx_token,
+                                                       int count)
+{
+    m_tcp_tx_token = tx_token;
+    m_transport_control_tx_stub_cnt++;
+
+    memcpy(m_generated_hb_pdu.pdu, p_data, p_template->data_len);
+    m_generated_hb_pdu_len = p_template->data_len;
+
+    // the template must still match the publication settings
+    TEST_ASSERT_EQUAL(m_heartbeat_publication.ttl, p_template->net.ttl);
+    TEST_ASSERT_EQUAL(m_heartbeat_publication.dst, p_template->net.dst.value);
+
+    return NRF_SUCCESS;
+}
+
+static void helper_transport_control_tx_stub_set(void)
+{
+    transport_control_tx_template_init_StubWithCallback(transport_control_tx_template_init_stub);
+    transport_control_tx_template_send_StubWithCallback(transport_control_tx_template_send_stub);
+}
+
 static uint32_t transport_control_packet_consumer_add_stub(const transport_control_packet_handler_t * p_handlers, uint32_t handler_count, int count)
 {
     m_transport_hb_opcode_handler = *p_handlers;
@@ -331,6 +362,7 @@ void setUp(void)
 
     m_transport_control_tx_stub_cnt = 0;
     m_exp_transport_control_tx_stub_cnt = 0;
+    m_transport_control_tx_template_init_stub_cnt = 0;
 }
 
 void tearDown(void)
@@ -602,7 +634,7 @@ void test_heartbeat_core_evt_cb_indirect_feat_change(void)
     nrf_mesh_opt_get_IgnoreArg_p_opt();
     nrf_mesh_opt_get_ReturnThruPtr_p_opt(&relay_opt);
 
-    transport_control_tx_StubWithCallback(transport_control_tx_stub);
+    helper_transport_control_tx_stub_set();
     event_handler_remove_ExpectAnyArgs();
     event_handle_stub(&m_tx_complete_evt);
     TEST_ASSERT_EQUAL(m_transport_control_tx_stub_cnt, 1);
@@ -645,7 +677,7 @@ void test_heartbeat_core_evt_cb_indirect_pub_change(void)
 
     // trigger core_evt_cb, to de-register event handler
     packet_mesh_trs_control_packet_t expected_pdu;
-    transport_control_tx_StubWithCallback(transport_control_tx_stub);
+    helper_transport_control_tx_stub_set();
     event_handler_remove_ExpectAnyArgs();
     event_handle_stub(&m_tx_complete_evt);
     TEST_ASSERT_EQUAL(m_transport_control_tx_stub_cnt, 1);
@@ -745,7 +777,7 @@ void test_heartbeat_functionality_periodic_publish_short(void)
     // Send 10 heartbeats
     for (uint16_t i = 0; i < init_pub_cnt ; i++)
     {
-        transport_control_tx_StubWithCallback(transport_control_tx_stub);
+        helper_transport_control_tx_stub_set();
         nrf_mesh_opt_get_ExpectAndReturn(NRF_MESH_OPT_NET_RELAY_ENABLE, NULL, NRF_SUCCESS);
         nrf_mesh_opt_get_IgnoreArg_p_opt();
         nrf_mesh_opt_get_ReturnThruPtr_p_opt(&relay_opt);
@@ -791,6 +823,55 @@ void test_heartbeat_functionality_periodic_publish_short(void)
     mp_timer_event->cb(timestamp, mp_timer_event->p_context);
 }
 
+/** Indirect TEST: The transmit template is only rebuilt when the publication parameters change */
+void test_heartbeat_tx_template_reuse(void)
+{
+    uint8_t init_pub_cnt = 4;
+    uint8_t init_pub_per = 10;
+
+    helper_do_heartbeat_init(ut_mock_config_server_hb_pub_params_get_ret_success,
+                             ut_mock_config_server_hb_pub_count_dec);
+
+    m_heartbeat_publication.dst          = UT_ADDRESS_UNICAST_SAMPLE;
+    m_heartbeat_publication.count        = init_pub_cnt;
+    m_heartbeat_publication.period       = init_pub_per;
+    m_heartbeat_publication.ttl          = 0x10;
+    m_heartbeat_publication.features     = 0;
+    m_heartbeat_publication.netkey_index = 0;
+    timer_now_ExpectAndReturn(TIME_0);
+    RESCHEDULE_EXPECT(TIME_0 + SEC_TO_US(m_heartbeat_publication.period));
+    event_handler_add_StubWithCallback(event_handler_add_stub);
+
+    heartbeat_publication_state_updated();
+
+    helper_ut_check_event_handler_add_called();
+
+    timestamp_t timestamp = TIME_0 + SEC_TO_US(m_heartbeat_publication.period);
+    helper_transport_control_tx_stub_set();
+
+    for (uint16_t i = 0; i < init_pub_cnt; i++)
+    {
+        if (i == 2)
+        {
+            // Changing the TTL invalidates the template
+            m_heartbeat_publication.ttl = 0x11;
+        }
+
+        RESCHEDULE_EXPECT(timestamp + SEC_TO_US(m_heartbeat_publication.period));
+        if (i == init_pub_cnt - 1)
+        {
+            timer_sch_abort_ExpectAnyArgs();
+        }
+        mp_timer_event->cb(timestamp, mp_timer_event->p_context);
+        helper_ut_check_transport_control_tx_stub_called();
+        TEST_ASSERT_EQUAL_HEX8(m_heartbeat_publication.ttl, m_generated_hb_pdu.pdu[0]);
+        TEST_ASSERT_EQUAL(init_pub_cnt - i, m_tcp_tx_token);
+        timestamp += SEC_TO_US(m_heartbeat_publication.period);
+    }
+
+    TEST_ASSERT_EQUAL(2, m_transport_control_tx_template_init_stub_cnt);
+}
+
 /** Indirect TEST: Timed trigger (publication) functionality test, when period is longer
  * than HEARTBEAT_PUBLISH_SUB_INTERVAL_S seconds.
  */
@@ -833,7 +914,7 @@ void test_heartbeat_functionality_periodic_publish_long(void)
             nrf_mesh_opt_get_ExpectAndReturn(NRF_MESH_OPT_NET_RELAY_ENABLE, NULL, NRF_SUCCESS);
             nrf_mesh_opt_get_IgnoreArg_p_opt();
             nrf_mesh_opt_get_ReturnThruPtr_p_opt(&relay_opt);
-            transport_control_tx_StubWithCallback(transport_control_tx_stub);
+            helper_transport_control_tx_stub_set();
 
             // Add slight jitter (+ i) to timestamp, to ensure that logic works even if timestamps are
             // slighly further than expected
@@ -39,6 +39,8 @@
 #include <stdbool.h>
 #include "unity.h"
 #include "msg_cache.h"
+#include "packet_mesh.h"
+#include "nordic_common.h"
 
 
 void setUp(void)
@@ -181,3 +183,116 @@ void test_clear(void)
     msg_cache_clear();
     TEST_ASSERT_EQUAL(false, msg_cache_entry_exists(src, seq));
 }
+
+void test_eviction_order(void)
+{
+    /* Reference model of the cache contents, in the order they were added. */
+    static struct
+    {
+        uint16_t src;
+        uint32_t seq;
+    } added[MSG_CACHE_ENTRY_COUNT * 4];
+
+    /* Use few source addresses and nearby sequence numbers to make the entries collide in the
+     * hash index, if enabled. */
+    for (uint32_t i = 0; i < MSG_CACHE_ENTRY_COUNT * 4; ++i)
+    {
+        added[i].src = 0x0001 + (i % 3);
+        added[i].seq = (i * 7) & 0xFFFFFF;
+        msg_cache_entry_add(added[i].src, added[i].seq);
+
+        /* Only the MSG_CACHE_ENTRY_COUNT most recent entries should be in the cache. */
+        for (uint32_t j = 0; j <= i; ++j)
+        {
+            TEST_ASSERT_EQUAL(j + MSG_CACHE_ENTRY_COUNT > i, msg_cache_entry_exists(added[j].src, added[j].seq));
+        }
+    }
+
+    msg_cache_clear();
+    for (uint32_t i = 0; i < MSG_CACHE_ENTRY_COUNT * 4; ++i)
+    {
+        TEST_ASSERT_FALSE(msg_cache_entry_exists(added[i].src, added[i].seq));
+    }
+}
+
+void test_fingerprint(void)
+{
+    uint8_t packets[MSG_CACHE_FINGERPRINT_COUNT + 1][PACKET_MESH_NET_MAX_SIZE];
+    const uint32_t length = 18;
+    for (uint32_t i = 0; i < ARRAY_SIZE(packets); ++i)
+    {
+        memset(packets[i], 0xAB, sizeof(packets[i]));
+        packets[i][2] = i;
+    }
+
+    TEST_ASSERT_FALSE(msg_cache_fingerprint_exists(packets[0], length));
+    msg_cache_fingerprint_add(packets[0], length);
+    TEST_ASSERT_TRUE(msg_cache_fingerprint_exists(packets[0], length));
+
+    /* Fingerprints are separate from the SRC+SEQ entries: */
+    TEST_ASSERT_FALSE(msg_cache_entry_exists(0xABAB, 0xABAB00));
+
+    /* The length, the header and the end of the MIC are all part of the fingerprint: */
+    TEST_ASSERT_FALSE(msg_cache_fingerprint_exists(packets[0], length + 1));
+    uint8_t changed[PACKET_MESH_NET_MAX_SIZE];
+    memcpy(changed, packets[0], sizeof(changed));
+    changed[0] ^= 0x80;
+    TEST_ASSERT_FALSE(msg_cache_fingerprint_exists(changed, length));
+    memcpy(changed, packets[0], sizeof(changed));
+    changed[length - 1] ^= 0x01;
+    TEST_ASSERT_FALSE(msg_cache_fingerprint_exists(changed, length));
+
+    /* Bytes between the header and the end of the MIC aren't: */
+    memcpy(changed, packets[0], sizeof(changed));
+    changed[PACKET_MESH_NET_PDU_OFFSET] ^= 0x01;
+    TEST_ASSERT_TRUE(msg_cache_fingerprint_exists(changed, length));
+
+    /* Packets too short to hold a MIC are never cached: */
+    msg_cache_fingerprint_add(packets[1], PACKET_MESH_NET_PDU_OFFSET + 3);
+    TEST_ASSERT_FALSE(msg_cache_fingerprint_exists(packets[1], PACKET_MESH_NET_PDU_OFFSET + 3));
+
+    /* The oldest fingerprint is overwritten when the cache is full: */
+    for (uint32_t i = 1; i < ARRAY_SIZE(packets); ++i)
+    {
+        msg_cache_fingerprint_add(packets[i], length);
+    }
+    TEST_ASSERT_FALSE(msg_cache_fingerprint_exists(packets[0], length));
+    for (uint32_t i = 1; i < ARRAY_SIZE(packets); ++i)
+    {
+        TEST_ASSERT_TRUE(msg_cache_fingerprint_exists(packets[i], length));
+    }
+
+    msg_cache_clear();
+    for (uint32_t i = 0; i < ARRAY_SIZE(packets); ++i)
+    {
+        TEST_ASSERT_FALSE(msg_cache_fingerprint_exists(packets[i], length));
+    }
+}
+
+void test_fingerprint_eviction_order(void)
+{
+    static uint8_t packets[MSG_CACHE_FINGERPRINT_COUNT * 4][PACKET_MESH_NET_MAX_SIZE];
+    const uint32_t length = 18;
+
+    /* Packets only differing in the last MIC bytes, to make the fingerprints collide in the hash
+     * index, if enabled. */
+    for (uint32_t i = 0; i < ARRAY_SIZE(packets); ++i)
+    {
+        memset(packets[i], 0xAB, sizeof(packets[i]));
+        packets[i][length - 2] = (uint8_t) (i >> 8);
+        packets[i][length - 1] = (uint8_t) i;
+        msg_cache_fingerprint_add(packets[i], length);
+
+        /* Only the MSG_CACHE_FINGERPRINT_COUNT most recent fingerprints should be in the cache. */
+        for (uint32_t j = 0; j <= i; ++j)
+        {
+            TEST_ASSERT_EQUAL(j + MSG_CACHE_FINGERPRINT_COUNT > i, msg_cache_fingerprint_exists(packets[j], length));
+        }
+    }
+
+    msg_cache_clear();
+    for (uint32_t i = 0; i < ARRAY_SIZE(packets); ++i)
+    {
+        TEST_ASSERT_FALSE(msg_cache_fingerprint_exists(packets[i], length));
+    }
+}
@@ -462,6 +462,77 @@ void test_packet_in(void)
     }
 }
 
+void test_relay_encrypt(void)
+{
+    uint8_t pecb_data[NRF_MESH_KEY_SIZE];
+    uint8_t pecb[NRF_MESH_KEY_SIZE];
+    nrf_mesh_network_secmat_t secmat;
+    network_packet_metadata_t metadata;
+    packet_mesh_net_packet_t decrypted_packet;
+    packet_mesh_net_packet_t relay_packet;
+    packet_mesh_net_packet_t expected_header;
+    uint16_t dst = 0x1234;
+    uint8_t len  = 10;
+    memset(secmat.encryption_key, 0xEC, NRF_MESH_KEY_SIZE);
+    memset(secmat.privacy_key, 0x93, NRF_MESH_KEY_SIZE);
+
+    for (uint32_t control = 0; control < 2; ++control)
+    {
+        m_enc_nonce_generate_params.executed = 0;
+        m_enc_nonce_generate_params.calls = 0;
+
+        metadata.dst.value                = dst;
+        metadata.src                      = 0x0001;
+        metadata.ttl                      = 4;
+        metadata.p_security_material      = &secmat;
+        metadata.internal.iv_index        = IV_INDEX;
+        metadata.internal.sequence_number = SEQNUM;
+        metadata.control_packet           = control;
+
+        memset(&decrypted_packet, 0xAB, sizeof(decrypted_packet));
+        packet_mesh_net_ttl_set(&decrypted_packet, metadata.ttl + 1);
+        memset(&relay_packet, 0x00, sizeof(relay_packet));
+        packet_mesh_net_dst_set(&relay_packet, dst);
+        for (uint32_t i = 0; i < NRF_MESH_KEY_SIZE; ++i)
+        {
+            pecb[i] = 137 * i; // arbitrary values
+        }
+
+        /* Encrypts from the decrypted packet into the relay packet: */
+        m_expected_encrypt_ccm.a_len   = 0;
+        m_expected_encrypt_ccm.p_a     = NULL;
+        m_expected_encrypt_ccm.p_key   = secmat.encryption_key;
+        m_expected_encrypt_ccm.p_m     = &decrypted_packet.pdu[7];
+        m_expected_encrypt_ccm.p_out   = &relay_packet.pdu[7];
+        m_expected_encrypt_ccm.p_nonce = m_enc_nonce_generate_params.nonce_return;
+        m_expected_encrypt_ccm.p_mic   = &relay_packet.pdu[9 + len];
+        m_expected_encrypt_ccm.m_len   = 2 + len;
+        m_expected_encrypt_ccm.mic_len = control ? 8 : 4;
+        m_enc_nonce_generate_Expect(&metadata, NET_PACKET_KIND_TRANSPORT);
+        enc_nonce_generate_StubWithCallback(enc_nonce_generate_callback);
+        enc_aes_ccm_encrypt_StubWithCallback(&enc_aes_ccm_encrypt_callback);
+        transfuscate_Expect(&metadata, relay_packet.pdu, pecb, pecb_data);
+
+        net_packet_relay_encrypt(&metadata, len, &decrypted_packet, &relay_packet);
+
+        TEST_ASSERT_EQUAL(0, m_enc_nonce_generate_params.calls);
+        /* The header is the decrypted header with the new TTL, obfuscated with the PECB. */
+        memcpy(&expected_header, &decrypted_packet, 7);
+        packet_mesh_net_ttl_set(&expected_header, metadata.ttl);
+        TEST_ASSERT_EQUAL_HEX8(expected_header.pdu[0], relay_packet.pdu[0]);
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            TEST_ASSERT_EQUAL_HEX8(expected_header.pdu[i + 1] ^ pecb[i], relay_packet.pdu[i + 1]);
+        }
+    }
+
+    /* Invalid params */
+    TEST_NRF_MESH_ASSERT_EXPECT(net_packet_relay_encrypt(NULL, len, &decrypted_packet, &relay_packet));
+    TEST_NRF_MESH_ASSERT_EXPECT(net_packet_relay_encrypt(&metadata, len, NULL, &relay_packet));
+    TEST_NRF_MESH_ASSERT_EXPECT(net_packet_relay_encrypt(&metadata, len, &decrypted_packet, NULL));
+    TEST_NRF_MESH_ASSERT_EXPECT(net_packet_relay_encrypt(&metadata, len, &decrypted_packet, &decrypted_packet));
+}
+
 void test_util_functions(void)
 {
     network_packet_metadata_t net_meta;
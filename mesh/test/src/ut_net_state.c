@@ -378,7 +378,7 @@ void test_iv_seqnum_initiated(void)
     uint32_t seq_expect = 0;
     for (; seq_expect < NETWORK_SEQNUM_FLASH_BLOCK_SIZE * 2; ++seq_expect)
     {
-        for (; seq_expect < allocated_seqnums - NETWORK_SEQNUM_FLASH_BLOCK_THRESHOLD; ++seq_expect) /*lint !e445 Weird, but intentional */
+        for (; seq_expect < allocated_seqnums - NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD; ++seq_expect) /*lint !e445 Weird, but intentional */
         {
             TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_alloc(&seqnum));
             TEST_ASSERT_EQUAL(seq_expect, seqnum);
@@ -399,7 +399,7 @@ void test_iv_seqnum_initiated(void)
     flash_manager_entry_commit_Ignore();
     for (; seq_expect < NETWORK_SEQNUM_IV_UPDATE_START_THRESHOLD;)
     {
-        for (; seq_expect <= allocated_seqnums - NETWORK_SEQNUM_FLASH_BLOCK_THRESHOLD && seq_expect < NETWORK_SEQNUM_IV_UPDATE_START_THRESHOLD; ++seq_expect)
+        for (; seq_expect <= allocated_seqnums - NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD && seq_expect < NETWORK_SEQNUM_IV_UPDATE_START_THRESHOLD; ++seq_expect)
         {
             TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_alloc(&seqnum));
             TEST_ASSERT_EQUAL(seq_expect, seqnum);
@@ -511,6 +511,107 @@ void test_iv_lock(void)
     TEST_ASSERT_EQUAL(NRF_ERROR_FORBIDDEN, net_state_seqnum_alloc(&seqnum));
 }
 
+void test_seqnum_reserve(void)
+{
+    uint32_t seqnum;
+    uint32_t first_seqnum;
+
+    expect_flash_load(0, 0, false);
+    net_state_recover_from_flash();
+    notify_flash_write_complete(mp_expected_seqnum_flash_buffer);
+
+    TEST_NRF_MESH_ASSERT_EXPECT(net_state_seqnum_reserve(1, NULL));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, net_state_seqnum_reserve(0, &first_seqnum));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, net_state_seqnum_reserve(NETWORK_SEQNUM_RESERVE_MAX + 1, &first_seqnum));
+
+    /* Reservations and single allocations share the same sequence number space: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(10, &first_seqnum));
+    TEST_ASSERT_EQUAL(0, first_seqnum);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_alloc(&seqnum));
+    TEST_ASSERT_EQUAL(10, seqnum);
+
+    /* No flash operations until the reservations reach the preallocation threshold: */
+    uint32_t next_seqnum = 11;
+    while (next_seqnum + NETWORK_SEQNUM_RESERVE_MAX + NETWORK_SEQNUM_FLASH_BLOCK_PREALLOCATE_THRESHOLD <= NETWORK_SEQNUM_FLASH_BLOCK_SIZE)
+    {
+        TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(NETWORK_SEQNUM_RESERVE_MAX, &first_seqnum));
+        TEST_ASSERT_EQUAL(next_seqnum, first_seqnum);
+        next_seqnum += NETWORK_SEQNUM_RESERVE_MAX;
+    }
+    flash_manager_mock_Verify();
+
+    /* The flash manager is out of memory when the next block is due. The allocation is retried
+     * once there's memory, not on every reservation: */
+    flash_manager_mem_listener_register_StubWithCallback(flash_manager_mem_listener_register_callback);
+    flash_manager_entry_alloc_ExpectAndReturn(mp_manager, HANDLE_SEQNUM, 4, NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(NETWORK_SEQNUM_RESERVE_MAX, &first_seqnum));
+    TEST_ASSERT_EQUAL(next_seqnum, first_seqnum);
+    next_seqnum += NETWORK_SEQNUM_RESERVE_MAX;
+    TEST_ASSERT_NOT_NULL(mp_listeners[0]);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(NETWORK_SEQNUM_RESERVE_MAX, &first_seqnum));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_alloc(&seqnum));
+    next_seqnum += NETWORK_SEQNUM_RESERVE_MAX + 1;
+    flash_manager_mock_Verify();
+
+    expect_flash_seqnum(2 * NETWORK_SEQNUM_FLASH_BLOCK_SIZE);
+    fire_mem_listeners();
+    flash_manager_mock_Verify();
+
+    /* A reservation that doesn't fit in the stored block is refused without using any sequence
+     * numbers, while the next block is being written: */
+    while (next_seqnum + NETWORK_SEQNUM_RESERVE_MAX <= NETWORK_SEQNUM_FLASH_BLOCK_SIZE)
+    {
+        TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(NETWORK_SEQNUM_RESERVE_MAX, &first_seqnum));
+        TEST_ASSERT_EQUAL(next_seqnum, first_seqnum);
+        next_seqnum += NETWORK_SEQNUM_RESERVE_MAX;
+    }
+    if (next_seqnum < NETWORK_SEQNUM_FLASH_BLOCK_SIZE)
+    {
+        TEST_ASSERT_EQUAL(NRF_ERROR_FORBIDDEN, net_state_seqnum_reserve(NETWORK_SEQNUM_RESERVE_MAX, &first_seqnum));
+        TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(NETWORK_SEQNUM_FLASH_BLOCK_SIZE - next_seqnum, &first_seqnum));
+        TEST_ASSERT_EQUAL(next_seqnum, first_seqnum);
+        next_seqnum = NETWORK_SEQNUM_FLASH_BLOCK_SIZE;
+    }
+    TEST_ASSERT_EQUAL(NRF_ERROR_FORBIDDEN, net_state_seqnum_alloc(&seqnum));
+
+    /* The stored block makes the reservation possible again: */
+    notify_flash_write_complete(mp_expected_seqnum_flash_buffer);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(NETWORK_SEQNUM_RESERVE_MAX, &first_seqnum));
+    TEST_ASSERT_EQUAL(next_seqnum, first_seqnum);
+    flash_manager_mem_listener_register_StubWithCallback(NULL);
+}
+
+void test_seqnum_unreserve(void)
+{
+    uint32_t seqnum;
+    uint32_t first_seqnum;
+
+    expect_flash_load(0, 0, false);
+    net_state_recover_from_flash();
+    notify_flash_write_complete(mp_expected_seqnum_flash_buffer);
+
+    /* The unused end of the last reservation is handed back: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(10, &first_seqnum));
+    TEST_ASSERT_EQUAL(0, first_seqnum);
+    net_state_seqnum_unreserve(4, 6);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_alloc(&seqnum));
+    TEST_ASSERT_EQUAL(4, seqnum);
+
+    /* The whole reservation can be handed back: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(10, &first_seqnum));
+    TEST_ASSERT_EQUAL(5, first_seqnum);
+    net_state_seqnum_unreserve(5, 10);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_reserve(10, &first_seqnum));
+    TEST_ASSERT_EQUAL(5, first_seqnum);
+
+    /* Once a higher sequence number has been allocated, nothing is handed back: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_alloc(&seqnum));
+    TEST_ASSERT_EQUAL(15, seqnum);
+    net_state_seqnum_unreserve(10, 5);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, net_state_seqnum_alloc(&seqnum));
+    TEST_ASSERT_EQUAL(16, seqnum);
+}
+
 void test_iv_beacons(void)
 {
     /* iv index is always 0 at init */
@@ -57,10 +57,15 @@
 #include "net_state_mock.h"
 #include "net_packet_mock.h"
 #include "nrf_mesh_externs_mock.h"
+#include "timer_mock.h"
 
 #define TOKEN 0x12345678U
 #define IV_INDEX 0x87654321U
 #define SEQNUM 0xabcdefU
+#define RX_TIMESTAMP 0x10000U
+#define RELAY_LATENCY_US 500U
+#define RELAY_QUEUE_PACKET_LEN 18
+#define RELAY_QUEUE_MAX_AGE_MS 100
 
 void setUp(void)
 {
@@ -75,6 +80,7 @@ void setUp(void)
     net_state_mock_Init();
     net_packet_mock_Init();
     nrf_mesh_externs_mock_Init();
+    timer_mock_Init();
 }
 
 void tearDown(void)
@@ -97,6 +103,8 @@ void tearDown(void)
     net_packet_mock_Destroy();
     nrf_mesh_externs_mock_Verify();
     nrf_mesh_externs_mock_Destroy();
+    timer_mock_Verify();
+    timer_mock_Destroy();
 }
 /*****************************************************************************
 * Helper functions
@@ -147,11 +155,12 @@ static void relay_Expect(network_packet_metadata_t * p_metadata, uint32_t packet
     memcpy(&relay_meta, p_metadata, sizeof(relay_meta));
     relay_meta.ttl--;
 
+    timer_now_ExpectAndReturn(RX_TIMESTAMP);
     packet_alloc_Expect(&relay_meta, packet_len, (uint8_t **) pp_relay_packet, CORE_TX_ROLE_RELAY, true);
-    net_packet_from_payload_ExpectAndReturn(&(*pp_relay_packet)->pdu[9], *pp_relay_packet);
-    net_packet_header_set_Expect(*pp_relay_packet, &relay_meta);
-    net_packet_encrypt_Expect(&relay_meta, packet_len - 9 - mic_size, *pp_relay_packet, NET_PACKET_KIND_TRANSPORT);
+    net_packet_relay_encrypt_Expect(&relay_meta, packet_len - 9 - mic_size, NULL, *pp_relay_packet);
+    net_packet_relay_encrypt_IgnoreArg_p_net_decrypted_packet();
     core_tx_packet_send_Expect();
+    timer_now_ExpectAndReturn(RX_TIMESTAMP + RELAY_LATENCY_US);
 }
 
 struct
@@ -208,6 +217,86 @@ nrf_mesh_address_type_t nrf_mesh_address_type_get(uint16_t address)
         return types_lookup[(address & NRF_MESH_ADDR_TYPE_BITS_MASK) >> NRF_MESH_ADDR_TYPE_BITS_OFFSET];
     }
 }
+static core_tx_alloc_params_t m_relay_queue_alloc_params[4 * NETWORK_RELAY_QUEUE_SIZE + 8];
+static network_packet_metadata_t m_relay_queue_alloc_meta[4 * NETWORK_RELAY_QUEUE_SIZE + 8];
+static uint32_t m_relay_queue_alloc_count;
+
+/** Expect a relay TX buffer allocation for the given received packet. */
+static void relay_queue_alloc_Expect(const network_packet_metadata_t * p_rx_meta, bool success, uint8_t ** pp_packet)
+{
+    TEST_ASSERT_TRUE(m_relay_queue_alloc_count < ARRAY_SIZE(m_relay_queue_alloc_params));
+    uint32_t i = m_relay_queue_alloc_count++;
+    m_relay_queue_alloc_meta[i] = *p_rx_meta;
+    m_relay_queue_alloc_meta[i].ttl--;
+    m_relay_queue_alloc_params[i].role           = CORE_TX_ROLE_RELAY;
+    m_relay_queue_alloc_params[i].net_packet_len = RELAY_QUEUE_PACKET_LEN;
+    m_relay_queue_alloc_params[i].p_metadata     = &m_relay_queue_alloc_meta[i];
+    m_relay_queue_alloc_params[i].token          = CORE_TX_TOKEN_RELAY;
+
+    core_tx_packet_alloc_ExpectAndReturn(&m_relay_queue_alloc_params[i], NULL, success);
+    core_tx_packet_alloc_IgnoreArg_pp_packet();
+    if (success)
+    {
+        core_tx_packet_alloc_ReturnThruPtr_pp_packet(pp_packet);
+    }
+}
+
+/** Expect the given received packet to be encrypted into the relay queue. */
+static void relay_queue_encrypt_Expect(const network_packet_metadata_t * p_rx_meta)
+{
+    TEST_ASSERT_TRUE(m_relay_queue_alloc_count < ARRAY_SIZE(m_relay_queue_alloc_meta));
+    uint32_t i = m_relay_queue_alloc_count++;
+    m_relay_queue_alloc_meta[i] = *p_rx_meta;
+    m_relay_queue_alloc_meta[i].ttl--;
+
+    net_packet_relay_encrypt_Expect(&m_relay_queue_alloc_meta[i], RELAY_QUEUE_PACKET_LEN - 9 - 4, NULL, NULL);
+    net_packet_relay_encrypt_IgnoreArg_p_net_decrypted_packet();
+    net_packet_relay_encrypt_IgnoreArg_p_net_packet();
+}
+
+/** Receive a packet that should be relayed, the relay expectations must be set up by the caller. */
+static void relay_queue_packet_rx(network_packet_metadata_t * p_meta, timestamp_t timestamp)
+{
+    packet_mesh_net_packet_t net_packet;
+    nrf_mesh_rx_metadata_t rx_meta;
+    memset(&net_packet, 0xAB, sizeof(net_packet));
+    rx_meta.source = NRF_MESH_RX_SOURCE_SCANNER;
+    rx_meta.params.scanner.timestamp = timestamp;
+
+    msg_cache_fingerprint_exists_ExpectAndReturn(net_packet.pdu, RELAY_QUEUE_PACKET_LEN, false);
+    net_packet_obfuscation_start_get_ExpectAndReturn(&net_packet, &net_packet.pdu[1]);
+    net_packet_decrypt_ExpectAndReturn(NULL, RELAY_QUEUE_PACKET_LEN, &net_packet, NULL, NET_PACKET_KIND_TRANSPORT, NRF_SUCCESS);
+    net_packet_decrypt_IgnoreArg_p_net_decrypted_packet();
+    net_packet_decrypt_IgnoreArg_p_net_metadata();
+    net_packet_decrypt_ReturnThruPtr_p_net_metadata(p_meta);
+    msg_cache_fingerprint_add_Expect(net_packet.pdu, RELAY_QUEUE_PACKET_LEN);
+    net_packet_payload_len_get_ExpectAndReturn(p_meta, RELAY_QUEUE_PACKET_LEN, RELAY_QUEUE_PACKET_LEN - 9 - 4);
+    transport_packet_in_ExpectAnyArgsAndReturn(NRF_SUCCESS);
+    msg_cache_entry_add_Expect(p_meta->src, p_meta->internal.sequence_number);
+
+    m_relay_callback_expect.calls  = 1;
+    m_relay_callback_expect.src    = p_meta->src;
+    m_relay_callback_expect.dst    = p_meta->dst.value;
+    m_relay_callback_expect.ttl    = p_meta->ttl;
+    m_relay_callback_expect.retval = true;
+    timer_now_ExpectAndReturn(timestamp);
+
+    network_packet_in(net_packet.pdu, RELAY_QUEUE_PACKET_LEN, &rx_meta);
+
+    TEST_ASSERT_EQUAL(0, m_relay_callback_expect.calls);
+    core_tx_mock_Verify();
+    net_packet_mock_Verify();
+    timer_mock_Verify();
+}
+
+static uint32_t relay_opt_get(nrf_mesh_opt_id_t id)
+{
+    nrf_mesh_opt_t opt;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, network_opt_get(id, &opt));
+    TEST_ASSERT_EQUAL(sizeof(opt.opt.val), opt.len);
+    return opt.opt.val;
+}
+
 /*****************************************************************************
 * Test functions
 *****************************************************************************/
@@ -217,12 +306,14 @@ void test_init(void)
     net_state_recover_from_flash_Expect();
     net_state_init_Expect();
     nrf_mesh_init_params_t init_params = {0};
+    core_tx_relay_complete_cb_set_ExpectAnyArgs();
     network_init(&init_params);
 
     net_beacon_init_Expect();
     net_state_recover_from_flash_Expect();
     net_state_init_Expect();
     init_params.relay_cb = relay_callback;
+    core_tx_relay_complete_cb_set_ExpectAnyArgs();
     network_init(&init_params);
 }
 
@@ -300,8 +391,26 @@ void test_alloc(void)
         net_state_mock_Verify();
         core_tx_mock_Verify();
     }
+
+    /* Packets numbered from a reservation don't allocate a sequence number: */
+    metadata.internal.iv_index = IV_INDEX;
+    metadata.internal.sequence_number = SEQNUM + 1;
+    packet_alloc_Expect(&metadata,
+                        buffer.user_data.payload_len + 9 + (metadata.control_packet ? 8 : 4),
+                        &p_packet,
+                        CORE_TX_ROLE_ORIGINATOR,
+                        true);
+    net_packet_header_set_Expect((packet_mesh_net_packet_t *) p_packet, &metadata);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, network_packet_alloc_reserved(&buffer));
+    TEST_ASSERT_EQUAL_PTR(&payload[9], buffer.p_payload);
+    TEST_ASSERT_EQUAL(SEQNUM + 1, metadata.internal.sequence_number);
+    TEST_ASSERT_EQUAL(IV_INDEX, metadata.internal.iv_index);
+    net_state_mock_Verify();
+    core_tx_mock_Verify();
+
     /* Invalid params not covered by vectors */
     TEST_NRF_MESH_ASSERT_EXPECT(network_packet_alloc(NULL));
+    TEST_NRF_MESH_ASSERT_EXPECT(network_packet_alloc_reserved(NULL));
     metadata.p_security_material = NULL;
     TEST_NRF_MESH_ASSERT_EXPECT(network_packet_alloc(&buffer));
     buffer.user_data.p_metadata = NULL;
@@ -387,6 +496,7 @@ void test_packet_in(void)
     secmat.nid = 0xAF;
     typedef enum {
         STEP_DECRYPTION,
+        STEP_METADATA,
         STEP_DO_RELAY,
         STEP_SUCCESS,
     } step_t;
@@ -399,6 +509,7 @@ void test_packet_in(void)
         {{{NRF_MESH_ADDRESS_TYPE_GROUP, 0xFFFF}, 0x0001, 5, false, {SEQNUM, IV_INDEX}, &secmat}, 18, STEP_SUCCESS}, /* access packet */
         {{{NRF_MESH_ADDRESS_TYPE_GROUP, 0xFFFF}, 0x0001, 5, false, {SEQNUM, IV_INDEX}, &secmat}, 18, STEP_DECRYPTION}, /* access packet */
         {{{NRF_MESH_ADDRESS_TYPE_GROUP, 0xFFFF}, 0x0001, 5, true, {SEQNUM, IV_INDEX}, &secmat}, 18, STEP_SUCCESS}, /* Control packet */
+        {{{NRF_MESH_ADDRESS_TYPE_INVALID, 0x0000}, 0x0001, 5, false, {SEQNUM, IV_INDEX}, &secmat}, 18, STEP_METADATA}, /* Invalid DST, not fingerprinted */
         {{{NRF_MESH_ADDRESS_TYPE_UNICAST, 0x0002}, 0x0001, 5, false, {SEQNUM, IV_INDEX}, &secmat}, 18, STEP_SUCCESS}, /* Unicast DST */
         {{{NRF_MESH_ADDRESS_TYPE_UNICAST, 0x0002}, 0x0001, 5, false, {SEQNUM, IV_INDEX}, &secmat}, 9+4, STEP_SUCCESS}, /* just long enough */
         {{{NRF_MESH_ADDRESS_TYPE_UNICAST, 0x0002}, 0x0001, 5, false, {SEQNUM, IV_INDEX}, &secmat}, 9+7, STEP_SUCCESS}, /* long enough for a data packet */
@@ -408,6 +519,10 @@ void test_packet_in(void)
         {{{NRF_MESH_ADDRESS_TYPE_UNICAST, 0x0002}, 0x0001, 5, false, {SEQNUM, IV_INDEX}, &secmat}, 18, STEP_SUCCESS},
     };
     nrf_mesh_rx_metadata_t rx_meta;
+    rx_meta.source = NRF_MESH_RX_SOURCE_SCANNER;
+    rx_meta.params.scanner.timestamp = RX_TIMESTAMP;
+    uint32_t relay_count = 0;
+    network_relay_stats_reset();
 
     for (uint32_t i = 0; i < ARRAY_SIZE(vector); ++i)
     {
@@ -417,6 +532,7 @@ void test_packet_in(void)
         uint8_t mic_len = vector[i].meta.control_packet ? 8 : 4;
         memset(&net_packet, 0xAB, sizeof(net_packet));
 
+        msg_cache_fingerprint_exists_ExpectAndReturn(net_packet.pdu, vector[i].length, false);
         net_packet_obfuscation_start_get_ExpectAndReturn(&net_packet, &net_packet.pdu[1]);
 
         /* 1: Decrypt */
@@ -435,8 +551,10 @@ void test_packet_in(void)
         net_packet_decrypt_IgnoreArg_p_net_metadata();
         net_packet_decrypt_ReturnThruPtr_p_net_metadata(&vector[i].meta);
 
-        if (vector[i].fail_step > STEP_DECRYPTION)
+        if (vector[i].fail_step > STEP_METADATA)
         {
+            msg_cache_fingerprint_add_Expect(net_packet.pdu, vector[i].length);
+
             /* 2: Send to transport */
             net_packet_payload_len_get_ExpectAndReturn(&vector[i].meta,
                                                        vector[i].length,
@@ -463,6 +581,7 @@ void test_packet_in(void)
                 if (vector[i].fail_step > STEP_DO_RELAY)
                 {
                     relay_Expect(&vector[i].meta, vector[i].length, &p_relay_packet);
+                    relay_count++;
                 }
             }
 
@@ -478,5 +597,255 @@ void test_packet_in(void)
         transport_mock_Verify();
         nrf_mesh_externs_mock_Verify();
         net_packet_mock_Verify();
+        msg_cache_mock_Verify();
+    }
+
+    /* Repeated packets are dropped before decryption: */
+    packet_mesh_net_packet_t net_packet;
+    memset(&net_packet, 0xAB, sizeof(net_packet));
+    msg_cache_fingerprint_exists_ExpectAndReturn(net_packet.pdu, 18, true);
+    TEST_ASSERT_EQUAL(NRF_ERROR_NOT_FOUND, network_packet_in(net_packet.pdu, 18, &rx_meta));
+
+    network_relay_stats_t stats;
+    network_relay_stats_get(&stats);
+    TEST_ASSERT_EQUAL(relay_count, stats.relayed);
+    TEST_ASSERT_EQUAL(0, stats.no_mem);
+    TEST_ASSERT_EQUAL(relay_count, stats.latency_samples);
+    TEST_ASSERT_EQUAL(relay_count * RELAY_LATENCY_US, stats.latency_total_us);
+    TEST_ASSERT_EQUAL(RELAY_LATENCY_US, stats.latency_max_us);
+}
+
+static core_tx_complete_cb_t m_relay_tx_complete_cb;
+
+static void relay_complete_cb_set_callback(core_tx_complete_cb_t tx_complete_callback, int calls)
+{
+    m_relay_tx_complete_cb = tx_complete_callback;
+}
+
+void test_relay_queue(void)
+{
+    nrf_mesh_network_secmat_t secmat;
+    uint8_t tx_buffer[PACKET_MESH_NET_MAX_SIZE];
+    uint8_t * p_tx_buffer = tx_buffer;
+    network_packet_metadata_t meta[NETWORK_RELAY_QUEUE_SIZE + 3];
+    nrf_mesh_opt_t opt;
+
+    net_beacon_init_Expect();
+    net_state_recover_from_flash_Expect();
+    net_state_init_Expect();
+    nrf_mesh_init_params_t init_params = {0};
+    init_params.relay_cb = relay_callback;
+    core_tx_relay_complete_cb_set_StubWithCallback(relay_complete_cb_set_callback);
+    network_init(&init_params);
+    TEST_ASSERT_NOT_NULL(m_relay_tx_complete_cb);
+
+    opt.len = sizeof(opt.opt.val);
+    opt.opt.val = RELAY_QUEUE_MAX_AGE_MS;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, network_opt_set(NRF_MESH_OPT_NET_RELAY_QUEUE_MAX_AGE_MS, &opt));
+    TEST_ASSERT_EQUAL(RELAY_QUEUE_MAX_AGE_MS, relay_opt_get(NRF_MESH_OPT_NET_RELAY_QUEUE_MAX_AGE_MS));
+    opt.opt.val = 0;
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, network_opt_set(NRF_MESH_OPT_NET_RELAY_QUEUE_MAX_AGE_MS, &opt));
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(meta); ++i)
+    {
+        meta[i].dst.type = NRF_MESH_ADDRESS_TYPE_GROUP;
+        meta[i].dst.value = 0xC001;
+        meta[i].dst.p_virtual_uuid = NULL;
+        meta[i].src = 0x0100 + i;
+        meta[i].control_packet = false;
+        meta[i].internal.iv_index = IV_INDEX;
+        meta[i].internal.sequence_number = SEQNUM + i;
+        meta[i].p_security_material = &secmat;
+    }
+    m_relay_queue_alloc_count = 0;
+
+    /* The first packet doesn't fit in the TX buffer, and gets queued. */
+    meta[0].ttl = 5;
+    relay_queue_alloc_Expect(&meta[0], false, NULL);
+    relay_queue_encrypt_Expect(&meta[0]);
+    timer_now_ExpectAndReturn(RX_TIMESTAMP);
+    relay_queue_alloc_Expect(&meta[0], false, NULL);
+    relay_queue_packet_rx(&meta[0], RX_TIMESTAMP);
+
+    /* Fill the queue. The following packets go straight to the queue, and the queue keeps trying
+     * to send its most valuable packet. */
+    for (uint32_t i = 1; i < NETWORK_RELAY_QUEUE_SIZE; ++i)
+    {
+        meta[i].ttl = 3;
+        relay_queue_encrypt_Expect(&meta[i]);
+        timer_now_ExpectAndReturn(RX_TIMESTAMP + i);
+        relay_queue_alloc_Expect(&meta[0], false, NULL);
+        relay_queue_packet_rx(&meta[i], RX_TIMESTAMP + i);
+    }
+
+    /* The queue is full of more valuable packets, the next packet is dropped. */
+    meta[NETWORK_RELAY_QUEUE_SIZE].ttl = 2;
+    relay_queue_packet_rx(&meta[NETWORK_RELAY_QUEUE_SIZE], RX_TIMESTAMP + NETWORK_RELAY_QUEUE_SIZE);
+    TEST_ASSERT_EQUAL(1, relay_opt_get(NRF_MESH_OPT_NET_RELAY_DROPPED_QUEUE_FULL));
+    TEST_ASSERT_EQUAL(0, relay_opt_get(NRF_MESH_OPT_NET_RELAY_DROPPED_EVICTED));
+
+    /* A more valuable packet evicts the oldest of the least valuable packets (meta[1]). */
+    meta[NETWORK_RELAY_QUEUE_SIZE + 1].ttl = 4;
+    relay_queue_encrypt_Expect(&meta[NETWORK_RELAY_QUEUE_SIZE + 1]);
+    timer_now_ExpectAndReturn(RX_TIMESTAMP + NETWORK_RELAY_QUEUE_SIZE + 1);
+    relay_queue_alloc_Expect(&meta[0], false, NULL);
+    relay_queue_packet_rx(&meta[NETWORK_RELAY_QUEUE_SIZE + 1], RX_TIMESTAMP + NETWORK_RELAY_QUEUE_SIZE + 1);
+    TEST_ASSERT_EQUAL(1, relay_opt_get(NRF_MESH_OPT_NET_RELAY_DROPPED_EVICTED));
+
+    /* When the TX buffer frees up, the queue is flushed in order of TTL, then freshness. */
+    timer_now_ExpectAndReturn(RX_TIMESTAMP + 100);
+    uint32_t send_order[NETWORK_RELAY_QUEUE_SIZE];
+    send_order[0] = 0;
+    send_order[1] = NETWORK_RELAY_QUEUE_SIZE + 1;
+    for (uint32_t i = 2; i < NETWORK_RELAY_QUEUE_SIZE; ++i)
+    {
+        send_order[i] = NETWORK_RELAY_QUEUE_SIZE + 1 - i;
+    }
+    for (uint32_t i = 0; i < NETWORK_RELAY_QUEUE_SIZE; ++i)
+    {
+        relay_queue_alloc_Expect(&meta[send_order[i]], true, &p_tx_buffer);
+        core_tx_packet_send_Expect();
+        timer_now_ExpectAndReturn(RX_TIMESTAMP + 100);
+    }
+    m_relay_tx_complete_cb(CORE_TX_ROLE_RELAY, 0, 0, CORE_TX_TOKEN_RELAY);
+
+    network_relay_stats_t stats;
+    network_relay_stats_get(&stats);
+    TEST_ASSERT_EQUAL(NETWORK_RELAY_QUEUE_SIZE, stats.relayed);
+    TEST_ASSERT_EQUAL(1, stats.no_mem);
+    TEST_ASSERT_EQUAL(NETWORK_RELAY_QUEUE_SIZE, stats.latency_samples);
+    TEST_ASSERT_EQUAL(100, stats.latency_max_us);
+
+    /* Packets that have waited for too long are dropped. */
+    meta[NETWORK_RELAY_QUEUE_SIZE + 2].ttl = 5;
+    relay_queue_alloc_Expect(&meta[NETWORK_RELAY_QUEUE_SIZE + 2], false, NULL);
+    relay_queue_encrypt_Expect(&meta[NETWORK_RELAY_QUEUE_SIZE + 2]);
+    timer_now_ExpectAndReturn(RX_TIMESTAMP + 200);
+    relay_queue_alloc_Expect(&meta[NETWORK_RELAY_QUEUE_SIZE + 2], false, NULL);
+    relay_queue_packet_rx(&meta[NETWORK_RELAY_QUEUE_SIZE + 2], RX_TIMESTAMP + 200);
+
+    timer_now_ExpectAndReturn(RX_TIMESTAMP + 200 + MS_TO_US(RELAY_QUEUE_MAX_AGE_MS) + 1);
+    m_relay_tx_complete_cb(CORE_TX_ROLE_RELAY, 0, 0, CORE_TX_TOKEN_RELAY);
+    TEST_ASSERT_EQUAL(1, relay_opt_get(NRF_MESH_OPT_NET_RELAY_DROPPED_AGE));
+
+    /* The drop counters can be reset through the options API. */
+    opt.opt.val = 1;
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, network_opt_set(NRF_MESH_OPT_NET_RELAY_DROPPED_AGE, &opt));
+    opt.opt.val = 0;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, network_opt_set(NRF_MESH_OPT_NET_RELAY_DROPPED_AGE, &opt));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, network_opt_set(NRF_MESH_OPT_NET_RELAY_DROPPED_EVICTED, &opt));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, network_opt_set(NRF_MESH_OPT_NET_RELAY_DROPPED_QUEUE_FULL, &opt));
+    TEST_ASSERT_EQUAL(0, relay_opt_get(NRF_MESH_OPT_NET_RELAY_DROPPED_AGE));
+    TEST_ASSERT_EQUAL(0, relay_opt_get(NRF_MESH_OPT_NET_RELAY_DROPPED_EVICTED));
+    TEST_ASSERT_EQUAL(0, relay_opt_get(NRF_MESH_OPT_NET_RELAY_DROPPED_QUEUE_FULL));
+}
+
+static void rx_batch_secmat_Expect(uint8_t nid, const nrf_mesh_network_secmat_t * p_secmat)
+{
+    static const nrf_mesh_network_secmat_t * p_secmat_returned;
+    p_secmat_returned = p_secmat;
+    nrf_mesh_net_secmat_next_get_Expect(nid, NULL, NULL);
+    nrf_mesh_net_secmat_next_get_IgnoreArg_pp_secmat();
+    nrf_mesh_net_secmat_next_get_IgnoreArg_pp_secmat_secondary();
+    nrf_mesh_net_secmat_next_get_ReturnThruPtr_pp_secmat(&p_secmat_returned);
+}
+
+static uint8_t * rx_batch_obfuscation_start_get(const packet_mesh_net_packet_t * p_net_packet, int calls)
+{
+    return (uint8_t *) &p_net_packet->pdu[1];
+}
+
+static void rx_batch_fingerprint_Expect(const packet_mesh_net_packet_t * p_net_packet, uint32_t length)
+{
+    net_packet_obfuscation_start_get_StubWithCallback(rx_batch_obfuscation_start_get);
+    msg_cache_fingerprint_exists_ExpectAndReturn(p_net_packet->pdu, length, false);
+}
+
+void test_rx_batch(void)
+{
+    nrf_mesh_network_secmat_t secmat;
+    memset(&secmat, 0, sizeof(secmat));
+    secmat.nid = 0x2B;
+    nrf_mesh_rx_metadata_t rx_meta;
+    memset(&rx_meta, 0, sizeof(rx_meta));
+    rx_meta.source = NRF_MESH_RX_SOURCE_SCANNER;
+    /* The batch refers to the packets where they were received, give each its own buffer. */
+    packet_mesh_net_packet_t net_packets[NETWORK_RX_BATCH_SIZE + 1];
+    memset(net_packets, 0xAB, sizeof(net_packets));
+    for (uint32_t i = 0; i < ARRAY_SIZE(net_packets); ++i)
+    {
+        net_packets[i].pdu[0] = secmat.nid;
+    }
+    const uint32_t length = 18;
+
+    net_beacon_init_Expect();
+    net_state_recover_from_flash_Expect();
+    net_state_init_Expect();
+    core_tx_relay_complete_cb_set_ExpectAnyArgs();
+    network_init(NULL);
+
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, network_packet_batch_add(NULL, length));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, network_packet_batch_in(NULL, length, &rx_meta));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, network_packet_batch_in(net_packets[0].pdu, length, NULL));
+
+    /* Dropped packets stay in the batch, and are not processed any further: */
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_LENGTH, network_packet_batch_add(net_packets[0].pdu, PACKET_MESH_NET_PDU_OFFSET + 3));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_LENGTH, network_packet_batch_add(net_packets[1].pdu, PACKET_MESH_NET_MAX_SIZE + 1));
+    rx_batch_secmat_Expect(secmat.nid, NULL);
+    TEST_ASSERT_EQUAL(NRF_ERROR_NOT_FOUND, network_packet_batch_add(net_packets[2].pdu, length));
+    net_packet_mock_Verify();
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_LENGTH, network_packet_batch_in(net_packets[0].pdu, PACKET_MESH_NET_PDU_OFFSET + 3, &rx_meta));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_LENGTH, network_packet_batch_in(net_packets[1].pdu, PACKET_MESH_NET_MAX_SIZE + 1, &rx_meta));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NOT_FOUND, network_packet_batch_in(net_packets[2].pdu, length, &rx_meta));
+    network_packet_batch_clear();
+
+    /* Copies of a packet in the batch are dropped: */
+    rx_batch_secmat_Expect(secmat.nid, &secmat);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, network_packet_batch_add(net_packets[0].pdu, length));
+    rx_batch_secmat_Expect(secmat.nid, &secmat);
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_STATE, network_packet_batch_add(net_packets[1].pdu, length));
+
+    /* Fill the batch with different packets: */
+    for (uint32_t i = 2; i < NETWORK_RX_BATCH_SIZE; ++i)
+    {
+        net_packets[i].pdu[length - 1] = i;
+        rx_batch_secmat_Expect(secmat.nid, &secmat);
+        TEST_ASSERT_EQUAL(NRF_SUCCESS, network_packet_batch_add(net_packets[i].pdu, length));
+    }
+    TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, network_packet_batch_add(net_packets[NETWORK_RX_BATCH_SIZE].pdu, length));
+    net_packet_mock_Verify();
+
+    /* Screened packets are decrypted with the security material found in the screening, without
+     * another NID lookup: */
+    for (uint32_t i = 0; i < NETWORK_RX_BATCH_SIZE; ++i)
+    {
+        if (i == 1)
+        {
+            TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_STATE, network_packet_batch_in(net_packets[i].pdu, length, &rx_meta));
+            continue;
+        }
+        rx_batch_fingerprint_Expect(&net_packets[i], length);
+        net_packet_secmat_decrypt_ExpectAndReturn(NULL, length, &net_packets[i], NULL, NET_PACKET_KIND_TRANSPORT, &secmat, NULL, NRF_ERROR_NOT_FOUND);
+        net_packet_secmat_decrypt_IgnoreArg_p_net_metadata();
+        net_packet_secmat_decrypt_IgnoreArg_p_net_decrypted_packet();
+        TEST_ASSERT_EQUAL(NRF_ERROR_NOT_FOUND, network_packet_batch_in(net_packets[i].pdu, length, &rx_meta));
+        net_packet_mock_Verify();
+        msg_cache_mock_Verify();
     }
+
+    /* Packets that didn't fit in the batch are processed like any other packet: */
+    rx_batch_fingerprint_Expect(&net_packets[NETWORK_RX_BATCH_SIZE], length);
+    net_packet_decrypt_ExpectAndReturn(NULL, length, &net_packets[NETWORK_RX_BATCH_SIZE], NULL, NET_PACKET_KIND_TRANSPORT, NRF_ERROR_NOT_FOUND);
+    net_packet_decrypt_IgnoreArg_p_net_metadata();
+    net_packet_decrypt_IgnoreArg_p_net_decrypted_packet();
+    TEST_ASSERT_EQUAL(NRF_ERROR_NOT_FOUND, network_packet_batch_in(net_packets[NETWORK_RX_BATCH_SIZE].pdu, length, &rx_meta));
+    net_packet_mock_Verify();
+
+    /* Once the batch is cleared, all packets are processed like any other packet: */
+    network_packet_batch_clear();
+    rx_batch_fingerprint_Expect(&net_packets[1], length);
+    net_packet_decrypt_ExpectAndReturn(NULL, length, &net_packets[1], NULL, NET_PACKET_KIND_TRANSPORT, NRF_ERROR_NOT_FOUND);
+    net_packet_decrypt_IgnoreArg_p_net_metadata();
+    net_packet_decrypt_IgnoreArg_p_net_decrypted_packet();
+    TEST_ASSERT_EQUAL(NRF_ERROR_NOT_FOUND, network_packet_batch_in(net_packets[1].pdu, length, &rx_meta));
 }
@@ -424,6 +424,7 @@ void setUp(void)
     net_state_init_Expect();
     net_beacon_init_Expect();
     net_state_recover_from_flash_Expect();
+    core_tx_relay_complete_cb_set_ExpectAnyArgs();
     network_init(&init_params);
 }
 
@@ -466,6 +467,8 @@ void test_packet_in(void)
         get_test_vector(run_testvectors[i], &test_vector);
         __LOG(LOG_SRC_TEST, LOG_LEVEL_INFO, "Running test vector %d\n", run_testvectors[i]);
 
+        msg_cache_fingerprint_exists_IgnoreAndReturn(false);
+        msg_cache_fingerprint_add_Expect(test_vector.p_encrypted_packet, test_vector.lengths.encrypted);
         msg_cache_entry_exists_IgnoreAndReturn(false);
         msg_cache_entry_add_Expect(test_vector.metadata.src, test_vector.metadata.internal.sequence_number);
 
@@ -496,6 +499,8 @@ void test_packet_in(void)
         get_test_vector(run_testvectors[i], &test_vector);
         __LOG(LOG_SRC_TEST, LOG_LEVEL_INFO, "Running test vector %d\n", run_testvectors[i]);
 
+        msg_cache_fingerprint_exists_IgnoreAndReturn(false);
+        msg_cache_fingerprint_add_Expect(test_vector.p_encrypted_packet, test_vector.lengths.encrypted);
         msg_cache_entry_exists_IgnoreAndReturn(false);
         msg_cache_entry_add_Expect(test_vector.metadata.src, test_vector.metadata.internal.sequence_number);
 
@@ -529,6 +534,7 @@ void test_self_receive(void)
         m_rx_address = test_vector.metadata.src;
         m_net_secmat_get_calls_expect = 2; /* One to fetch the secmat that gets cancelled, one to get NULL */
 
+        msg_cache_fingerprint_exists_IgnoreAndReturn(false);
         msg_cache_entry_exists_IgnoreAndReturn(false);
         net_state_rx_iv_index_get_ExpectAndReturn(test_vector.metadata.internal.iv_index & 0x01, test_vector.metadata.internal.iv_index);
 
@@ -607,6 +613,7 @@ void test_invalid_net_key_in(void)
     provision(false);
 
     transport_packet_in_StubWithCallback(transport_packet_in_mock_cb);
+    msg_cache_fingerprint_exists_IgnoreAndReturn(false);
     msg_cache_entry_exists_IgnoreAndReturn(false);
 
     mp_net_secmats = &test_network;
@@ -38,6 +38,9 @@
 #include "log.h"
 
 #include "nrf_mesh.h"
+#include "nrf_mesh_config_core.h"
+#include "nrf_mesh_config_bearer.h"
+#include "nordic_common.h"
 
 #include "unity.h"
 #include "cmock.h"
@@ -71,6 +74,13 @@
 #include "ad_listener_mock.h"
 #include "heartbeat_mock.h"
 
+/* Number of scanner packets processed in one go, see nrf_mesh.c. */
+#if SCANNER_RX_RING_SLOT_COUNT
+#define SCANNER_RX_BATCH_SIZE NETWORK_RX_BATCH_SIZE
+#else
+#define SCANNER_RX_BATCH_SIZE 1
+#endif
+
 static uint32_t m_rx_cb_expect;
 static nrf_mesh_adv_packet_rx_data_t m_adv_packet_rx_data_expect;
 static int m_scanner_init_callback_cnt;
@@ -80,6 +90,9 @@ static scanner_packet_t m_test_packet;
 static nrf_mesh_rx_metadata_t m_metadata;
 static uint8_t m_ad_buffer[32];
 static ble_ad_data_t * mp_ad_data = (ble_ad_data_t *)m_ad_buffer;
+/* Packets handed to the network layer and the beacon module, in the order they got there. */
+static const uint8_t * mp_rx_order[2 * SCANNER_RX_BATCH_SIZE];
+static uint32_t m_rx_order_count;
 
 /*************** Static Helper Functions ***************/
 static uint32_t ad_subscriber_cb(ad_listener_t * p_listener, int num_calls)
@@ -105,6 +118,56 @@ static void ad_listener_process_cb(ble_packet_type_t adv_type,
     mp_listener->handler(mp_ad_data->data, mp_ad_data->length, p_metadata);
 }
 
+static void batch_ad_listener_process_cb(ble_packet_type_t adv_type,
+                                         const uint8_t * p_payload,
+                                         uint32_t payload_size,
+                                         const nrf_mesh_rx_metadata_t * p_metadata,
+                                         int num_calls)
+{
+    const ble_ad_data_t * p_ad_data = (const ble_ad_data_t *) p_payload;
+    mp_listener->handler(p_ad_data->data, p_ad_data->length, p_metadata);
+}
+
+static void rx_order_log(const uint8_t * p_packet)
+{
+    TEST_ASSERT_TRUE(m_rx_order_count < ARRAY_SIZE(mp_rx_order));
+    mp_rx_order[m_rx_order_count++] = p_packet;
+}
+
+static uint32_t network_packet_batch_add_cb(const uint8_t * p_packet, uint32_t net_packet_len, int num_calls)
+{
+    rx_order_log(p_packet);
+    return NRF_SUCCESS;
+}
+
+static uint32_t network_packet_batch_in_cb(const uint8_t * p_packet,
+                                           uint32_t net_packet_len,
+                                           const nrf_mesh_rx_metadata_t * p_rx_metadata,
+                                           int num_calls)
+{
+    TEST_ASSERT_EQUAL(NRF_MESH_RX_SOURCE_SCANNER, p_rx_metadata->source);
+    rx_order_log(p_packet);
+    return NRF_SUCCESS;
+}
+
+static uint32_t beacon_packet_in_cb(const uint8_t * p_beacon_data,
+                                    uint8_t data_len,
+                                    const nrf_mesh_rx_metadata_t * p_packet_meta,
+                                    int num_calls)
+{
+    rx_order_log(p_beacon_data);
+    return NRF_SUCCESS;
+}
+
+/** Expects the end of the scanner packets in a batch of @p count packets. */
+static void scanner_rx_batch_end_Expect(uint32_t count)
+{
+    if (count < SCANNER_RX_BATCH_SIZE)
+    {
+        scanner_rx_ExpectAndReturn(NULL);
+    }
+}
+
 static void scanner_init_callback(bearer_event_flag_callback_t packet_process_cb, int cmock_num_calls)
 {
     m_scanner_init_callback_cnt++;
@@ -311,6 +374,7 @@ void test_scanner_packet_process_cb(void)
 {
     /* No incoming packets ready: */
     scanner_rx_ExpectAndReturn(NULL);
+    network_packet_batch_clear_Expect();
     scanner_rx_pending_ExpectAndReturn(false);
     TEST_ASSERT_EQUAL(true, m_scanner_packet_process_cb());
 
@@ -326,20 +390,39 @@ void test_scanner_packet_process_cb(void)
     m_metadata.source         = NRF_MESH_RX_SOURCE_SCANNER;
     m_metadata.params.scanner = m_test_packet.metadata;
 
-    /* Process a mesh packet: */
+    /* Process a mesh packet, screened before it's processed: */
     mp_ad_data->length = 2;
     mp_ad_data->type = AD_TYPE_MESH;
     mp_ad_data->data[0] = 4;
+    memcpy(m_test_packet.packet.payload, mp_ad_data, 3);
+    m_test_packet.packet.header.type = BLE_PACKET_TYPE_ADV_NONCONN_IND;
     m_test_packet.packet.header.length = BLE_ADV_PACKET_OVERHEAD + 3;
 
     scanner_rx_ExpectAndReturn(&m_test_packet);
+    scanner_rx_batch_end_Expect(1);
+    network_packet_batch_add_ExpectAndReturn(&m_test_packet.packet.payload[2], 1, NRF_SUCCESS);
     ad_listener_process_StubWithCallback(ad_listener_process_cb);
-    network_packet_in_ExpectAndReturn(&mp_ad_data->data[0], 1, &m_metadata, NRF_SUCCESS);
-    network_packet_in_IgnoreArg_p_rx_metadata();
+    network_packet_batch_in_ExpectAndReturn(&mp_ad_data->data[0], 1, &m_metadata, NRF_SUCCESS);
+    network_packet_batch_in_IgnoreArg_p_rx_metadata();
+    network_packet_batch_clear_Expect();
     scanner_packet_release_Expect(&m_test_packet);
     scanner_rx_pending_ExpectAndReturn(false);
     TEST_ASSERT_EQUAL(true, m_scanner_packet_process_cb());
 
+    /* Packets that aren't non-connectable advertisements are not screened: */
+    m_test_packet.packet.header.type = BLE_PACKET_TYPE_ADV_IND;
+    m_test_packet.metadata.adv_type = BLE_PACKET_TYPE_ADV_IND;
+    scanner_rx_ExpectAndReturn(&m_test_packet);
+    scanner_rx_batch_end_Expect(1);
+    ad_listener_process_StubWithCallback(ad_listener_process_cb);
+    network_packet_batch_clear_Expect();
+    scanner_packet_release_Expect(&m_test_packet);
+    scanner_rx_pending_ExpectAndReturn(false);
+    TEST_ASSERT_EQUAL(true, m_scanner_packet_process_cb());
+    m_test_packet.packet.header.type = BLE_PACKET_TYPE_ADV_NONCONN_IND;
+    m_test_packet.metadata.adv_type = BLE_PACKET_TYPE_ADV_NONCONN_IND;
+    memset(m_test_packet.packet.payload, 0, sizeof(m_test_packet.packet.payload));
+
     /* Process a PB-ADV packet: */
     m_test_packet.metadata.adv_type = BLE_PACKET_TYPE_ADV_NONCONN_IND;
     mp_ad_data->length = 2;
@@ -348,9 +431,11 @@ void test_scanner_packet_process_cb(void)
     m_test_packet.packet.header.length = BLE_ADV_PACKET_OVERHEAD + 3;
 
     scanner_rx_ExpectAndReturn(&m_test_packet);
+    scanner_rx_batch_end_Expect(1);
     ad_listener_process_StubWithCallback(ad_listener_process_cb);
     prov_bearer_adv_packet_in_Expect(&mp_ad_data->data[0], 1, &m_metadata);
     prov_bearer_adv_packet_in_IgnoreArg_p_metadata();
+    network_packet_batch_clear_Expect();
     scanner_packet_release_Expect(&m_test_packet);
     scanner_rx_pending_ExpectAndReturn(false);
     TEST_ASSERT_EQUAL(true, m_scanner_packet_process_cb());
@@ -363,9 +448,11 @@ void test_scanner_packet_process_cb(void)
     m_test_packet.packet.header.length = BLE_ADV_PACKET_OVERHEAD + 3;
 
     scanner_rx_ExpectAndReturn(&m_test_packet);
+    scanner_rx_batch_end_Expect(1);
     ad_listener_process_StubWithCallback(ad_listener_process_cb);
     beacon_packet_in_ExpectAndReturn(&mp_ad_data->data[0], 1, &m_metadata, NRF_SUCCESS);
     beacon_packet_in_IgnoreArg_p_packet_meta();
+    network_packet_batch_clear_Expect();
     scanner_packet_release_Expect(&m_test_packet);
     scanner_rx_pending_ExpectAndReturn(false);
     TEST_ASSERT_EQUAL(true, m_scanner_packet_process_cb());
@@ -379,9 +466,11 @@ void test_scanner_packet_process_cb(void)
     m_test_packet.packet.header.length = BLE_ADV_PACKET_OVERHEAD + 4;
 
     scanner_rx_ExpectAndReturn(&m_test_packet);
+    scanner_rx_batch_end_Expect(1);
     ad_listener_process_StubWithCallback(ad_listener_process_cb);
     nrf_mesh_dfu_rx_ExpectAndReturn(&mp_ad_data->data[2], 1, &m_metadata, NRF_SUCCESS);
     nrf_mesh_dfu_rx_IgnoreArg_p_metadata();
+    network_packet_batch_clear_Expect();
     scanner_packet_release_Expect(&m_test_packet);
     scanner_rx_pending_ExpectAndReturn(false);
     TEST_ASSERT_EQUAL(true, m_scanner_packet_process_cb());
@@ -407,11 +496,13 @@ void test_scanner_packet_process_cb(void)
     m_adv_packet_rx_data_expect.p_metadata = &m_metadata;
 
     scanner_rx_ExpectAndReturn(&m_test_packet);
+    scanner_rx_batch_end_Expect(1);
     ad_listener_process_Expect(m_test_packet.packet.header.type,
                                m_test_packet.packet.payload,
                                m_test_packet.packet.header.length - BLE_ADV_PACKET_OVERHEAD,
                                &m_metadata);
     ad_listener_process_Ignore();
+    network_packet_batch_clear_Expect();
     scanner_packet_release_Expect(&m_test_packet);
     scanner_rx_pending_ExpectAndReturn(false);
     TEST_ASSERT_EQUAL(true, m_scanner_packet_process_cb());
@@ -420,16 +511,64 @@ void test_scanner_packet_process_cb(void)
     nrf_mesh_rx_cb_clear();
 
     scanner_rx_ExpectAndReturn(&m_test_packet);
+    scanner_rx_batch_end_Expect(1);
     ad_listener_process_Expect(m_test_packet.packet.header.type,
                                m_test_packet.packet.payload,
                                m_test_packet.packet.header.length - BLE_ADV_PACKET_OVERHEAD,
                                &m_metadata);
     ad_listener_process_Ignore();
+    network_packet_batch_clear_Expect();
     scanner_packet_release_Expect(&m_test_packet);
     scanner_rx_pending_ExpectAndReturn(true);
     TEST_ASSERT_EQUAL(false, m_scanner_packet_process_cb());
 }
 
+void test_scanner_packet_batch(void)
+{
+    /* Alternate mesh packets and beacons, with one more packet than fits in a batch: */
+    scanner_packet_t packets[SCANNER_RX_BATCH_SIZE + 1];
+    memset(packets, 0, sizeof(packets));
+    for (uint32_t i = 0; i < ARRAY_SIZE(packets); ++i)
+    {
+        packets[i].metadata.adv_type = BLE_PACKET_TYPE_ADV_NONCONN_IND;
+        packets[i].packet.header.type = BLE_PACKET_TYPE_ADV_NONCONN_IND;
+        packets[i].packet.header.length = BLE_ADV_PACKET_OVERHEAD + 3;
+        packets[i].packet.payload[0] = 2;
+        packets[i].packet.payload[1] = (i % 2 == 0) ? AD_TYPE_MESH : AD_TYPE_BEACON;
+        packets[i].packet.payload[2] = i;
+    }
+
+    m_rx_order_count = 0;
+    for (uint32_t i = 0; i < SCANNER_RX_BATCH_SIZE; ++i)
+    {
+        scanner_rx_ExpectAndReturn(&packets[i]);
+    }
+    network_packet_batch_add_StubWithCallback(network_packet_batch_add_cb);
+    network_packet_batch_in_StubWithCallback(network_packet_batch_in_cb);
+    beacon_packet_in_StubWithCallback(beacon_packet_in_cb);
+    ad_listener_process_StubWithCallback(batch_ad_listener_process_cb);
+    network_packet_batch_clear_Expect();
+    for (uint32_t i = 0; i < SCANNER_RX_BATCH_SIZE; ++i)
+    {
+        scanner_packet_release_Expect(&packets[i]);
+    }
+    scanner_rx_pending_ExpectAndReturn(true);
+    TEST_ASSERT_EQUAL(false, m_scanner_packet_process_cb());
+
+    /* All mesh packets are screened before any packet is processed, and the packets are processed
+     * in the order they were received, regardless of their type: */
+    uint32_t index = 0;
+    for (uint32_t i = 0; i < SCANNER_RX_BATCH_SIZE; i += 2)
+    {
+        TEST_ASSERT_EQUAL_PTR(&packets[i].packet.payload[2], mp_rx_order[index++]);
+    }
+    for (uint32_t i = 0; i < SCANNER_RX_BATCH_SIZE; ++i)
+    {
+        TEST_ASSERT_EQUAL_PTR(&packets[i].packet.payload[2], mp_rx_order[index++]);
+    }
+    TEST_ASSERT_EQUAL(index, m_rx_order_count);
+}
+
 void test_evt_handler_add(void)
 {
     nrf_mesh_evt_handler_t event_handler = {};
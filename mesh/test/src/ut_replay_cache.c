@@ -44,6 +44,9 @@
 
 #include "replay_cache.h"
 #include "nrf_mesh_config_core.h"
+#include "nrf_mesh_events.h"
+
+#include "event_mock.h"
 
 #define SRC_BASE   0x0100
 #define SEQNO_BASE 0x0000
@@ -51,44 +54,51 @@
 
 void setUp(void)
 {
+    event_mock_Init();
     replay_cache_init();
 }
 
 void tearDown(void)
 {
+    event_mock_Verify();
+    event_mock_Destroy();
 }
 
-void test_cache(void)
+static void cache_fill(uint8_t ivi)
 {
-    uint8_t ivi = IVI_BASE;
-
     for (int i = 0; i < REPLAY_CACHE_ENTRIES; ++i)
     {
         TEST_ASSERT_EQUAL(NRF_SUCCESS, replay_cache_add(SRC_BASE + i,
                                                         SEQNO_BASE,
                                                         ivi));
     }
+}
+
+void test_cache(void)
+{
+    uint8_t ivi = IVI_BASE;
 
+    cache_fill(ivi);
+
+#if REPLAY_CACHE_OVERFLOW_POLICY == REPLAY_CACHE_OVERFLOW_POLICY_REJECT
     /* Cache full. */
     TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, replay_cache_add(SRC_BASE + REPLAY_CACHE_ENTRIES,
                                                          SEQNO_BASE,
                                                          ivi));
+#endif
 
     replay_cache_on_iv_update();
 
     /* Update IV index bit... */
     ivi = (ivi + 1) & 0x01;
-    for (int i = 0; i < REPLAY_CACHE_ENTRIES; ++i)
-    {
-        TEST_ASSERT_EQUAL(NRF_SUCCESS, replay_cache_add(SRC_BASE + i,
-                                                        SEQNO_BASE,
-                                                        ivi));
-    }
+    cache_fill(ivi);
 
+#if REPLAY_CACHE_OVERFLOW_POLICY == REPLAY_CACHE_OVERFLOW_POLICY_REJECT
     /* Cache full. */
     TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, replay_cache_add(SRC_BASE + REPLAY_CACHE_ENTRIES,
                                                          SEQNO_BASE,
                                                          ivi));
+#endif
 
     for (int i = 0; i < REPLAY_CACHE_ENTRIES; ++i)
     {
@@ -125,3 +135,80 @@ void test_cache(void)
                                                        ivi));
     }
 }
+
+void test_unordered_sources(void)
+{
+    const uint8_t ivi = IVI_BASE;
+
+    /* Add the sources in a scrambled order, to exercise insertion in the sorted table. */
+    for (uint32_t i = 0; i < REPLAY_CACHE_ENTRIES; ++i)
+    {
+        uint16_t src = SRC_BASE + ((i * 7) % REPLAY_CACHE_ENTRIES);
+        TEST_ASSERT_FALSE(replay_cache_has_elem(src, SEQNO_BASE + i, ivi));
+        TEST_ASSERT_EQUAL(NRF_SUCCESS, replay_cache_add(src, SEQNO_BASE + i, ivi));
+    }
+
+    for (uint32_t i = 0; i < REPLAY_CACHE_ENTRIES; ++i)
+    {
+        uint16_t src = SRC_BASE + ((i * 7) % REPLAY_CACHE_ENTRIES);
+        TEST_ASSERT_TRUE(replay_cache_has_elem(src, SEQNO_BASE + i, ivi));
+        TEST_ASSERT_TRUE(replay_cache_has_elem(src, SEQNO_BASE, ivi));
+        TEST_ASSERT_FALSE(replay_cache_has_elem(src, SEQNO_BASE + i + 1, ivi));
+    }
+
+    /* Addresses outside the range of the added sources: */
+    TEST_ASSERT_FALSE(replay_cache_has_elem(SRC_BASE - 1, SEQNO_BASE, ivi));
+    TEST_ASSERT_FALSE(replay_cache_has_elem(SRC_BASE + REPLAY_CACHE_ENTRIES, SEQNO_BASE, ivi));
+
+    /* Updating an existing source does not take up more room. */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, replay_cache_add(SRC_BASE, SEQNO_BASE + 1000, ivi));
+    TEST_ASSERT_TRUE(replay_cache_has_elem(SRC_BASE, SEQNO_BASE + 1000, ivi));
+    TEST_ASSERT_FALSE(replay_cache_has_elem(SRC_BASE, SEQNO_BASE + 1001, ivi));
+}
+
+void test_overflow(void)
+{
+    const uint8_t ivi = IVI_BASE;
+#if REPLAY_CACHE_OVERFLOW_POLICY == REPLAY_CACHE_OVERFLOW_POLICY_REJECT
+    cache_fill(ivi);
+
+    /* New sources are rejected, existing ones can still be updated. */
+    TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, replay_cache_add(SRC_BASE + REPLAY_CACHE_ENTRIES, SEQNO_BASE, ivi));
+    TEST_ASSERT_FALSE(replay_cache_has_elem(SRC_BASE + REPLAY_CACHE_ENTRIES, SEQNO_BASE, ivi));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, replay_cache_add(SRC_BASE, SEQNO_BASE + 1, ivi));
+    TEST_ASSERT_TRUE(replay_cache_has_elem(SRC_BASE, SEQNO_BASE + 1, ivi));
+#else
+    nrf_mesh_evt_t evt;
+    memset(&evt, 0, sizeof(evt));
+    evt.type = NRF_MESH_EVT_REPLAY_CACHE_EVICTED;
+    evt.params.replay_cache_evicted.ivi = ivi;
+
+    cache_fill(ivi);
+
+    /* Refresh the first source, so the second becomes the least recently used. */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, replay_cache_add(SRC_BASE, SEQNO_BASE + 1, ivi));
+
+    evt.params.replay_cache_evicted.src = SRC_BASE + 1;
+    event_handle_Expect(&evt);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, replay_cache_add(SRC_BASE + REPLAY_CACHE_ENTRIES, SEQNO_BASE, ivi));
+    TEST_ASSERT_TRUE(replay_cache_has_elem(SRC_BASE + REPLAY_CACHE_ENTRIES, SEQNO_BASE, ivi));
+    TEST_ASSERT_TRUE(replay_cache_has_elem(SRC_BASE, SEQNO_BASE + 1, ivi));
+    TEST_ASSERT_FALSE(replay_cache_has_elem(SRC_BASE + 1, SEQNO_BASE, ivi));
+
+    /* The next one out is the third source. A source with a lower address than all others ends up
+     * first in the table. */
+    evt.params.replay_cache_evicted.src = SRC_BASE + 2;
+    event_handle_Expect(&evt);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, replay_cache_add(SRC_BASE - 1, SEQNO_BASE, ivi));
+    TEST_ASSERT_TRUE(replay_cache_has_elem(SRC_BASE - 1, SEQNO_BASE, ivi));
+    TEST_ASSERT_FALSE(replay_cache_has_elem(SRC_BASE + 2, SEQNO_BASE, ivi));
+
+    for (int i = 3; i < REPLAY_CACHE_ENTRIES; ++i)
+    {
+        TEST_ASSERT_TRUE(replay_cache_has_elem(SRC_BASE + i, SEQNO_BASE, ivi));
+    }
+
+    /* The other IV index generation is unaffected. */
+    cache_fill(ivi ^ 0x01);
+#endif
+}
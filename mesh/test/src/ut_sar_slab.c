@@ -0,0 +1,301 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+
+#include "nordic_common.h"
+#include "sar_slab.h"
+#include "test_assert.h"
+
+/** Slab counts of each class, smallest first. */
+static const uint16_t m_counts[SAR_SLAB_CLASS_COUNT] =
+{
+    TRANSPORT_SAR_SLAB_COUNT_12,
+    TRANSPORT_SAR_SLAB_COUNT_48,
+    TRANSPORT_SAR_SLAB_COUNT_96,
+    TRANSPORT_SAR_SLAB_COUNT_192,
+    TRANSPORT_SAR_SLAB_COUNT_384
+};
+static const uint16_t m_sizes[SAR_SLAB_CLASS_COUNT] = {12, 48, 96, 192, 384};
+
+/** Total number of slabs. */
+#define SLAB_COUNT_TOTAL (TRANSPORT_SAR_SLAB_COUNT_12 + TRANSPORT_SAR_SLAB_COUNT_48 + \
+                          TRANSPORT_SAR_SLAB_COUNT_96 + TRANSPORT_SAR_SLAB_COUNT_192 + \
+                          TRANSPORT_SAR_SLAB_COUNT_384)
+
+void setUp(void)
+{
+    sar_slab_init();
+}
+
+void tearDown(void)
+{
+}
+
+/*****************************************************************************
+* Helper functions
+*****************************************************************************/
+
+static uint32_t class_in_use_get(uint32_t class_index)
+{
+    sar_slab_stats_t stats;
+    sar_slab_stats_get(&stats);
+    return stats.classes[class_index].in_use;
+}
+
+/*****************************************************************************
+* Tests
+*****************************************************************************/
+
+void test_init_stats(void)
+{
+    sar_slab_stats_t stats;
+    sar_slab_stats_get(&stats);
+
+    for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        TEST_ASSERT_EQUAL(m_sizes[i], stats.classes[i].size);
+        TEST_ASSERT_EQUAL(m_counts[i], stats.classes[i].count);
+        TEST_ASSERT_EQUAL(0, stats.classes[i].in_use);
+        TEST_ASSERT_EQUAL(0, stats.classes[i].in_use_peak);
+        TEST_ASSERT_EQUAL(0, stats.classes[i].allocs);
+        TEST_ASSERT_EQUAL(0, stats.classes[i].spills);
+    }
+    TEST_ASSERT_EQUAL(0, stats.requested_bytes);
+    TEST_ASSERT_EQUAL(0, stats.reserved_bytes);
+    TEST_ASSERT_EQUAL(0, stats.reserved_bytes_peak);
+    TEST_ASSERT_EQUAL(0, stats.alloc_failures);
+}
+
+void test_alloc_size_classes(void)
+{
+    /* Each request is served by the smallest class that fits it: */
+    const struct
+    {
+        uint16_t size;
+        uint32_t class_index;
+    } cases[] =
+    {
+        {1, 0},
+        {12, 0},
+        {13, 1},
+        {48, 1},
+        {49, 2},
+        {96, 2},
+        {97, 3},
+        {192, 3},
+        {193, 4},
+        {384, 4},
+    };
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(cases); ++i)
+    {
+        sar_slab_init();
+        uint8_t * p_buffer = sar_slab_alloc(cases[i].size);
+        TEST_ASSERT_NOT_NULL(p_buffer);
+        TEST_ASSERT_EQUAL(0, (uintptr_t) p_buffer % sizeof(uint32_t));
+        TEST_ASSERT_EQUAL(1, class_in_use_get(cases[i].class_index));
+        memset(p_buffer, 0xAB, cases[i].size);
+        sar_slab_release(p_buffer);
+        TEST_ASSERT_EQUAL(0, class_in_use_get(cases[i].class_index));
+    }
+
+    /* Invalid sizes fail: */
+    TEST_ASSERT_NULL(sar_slab_alloc(0));
+    TEST_ASSERT_NULL(sar_slab_alloc(SAR_SLAB_SIZE_MAX + 1));
+
+    sar_slab_stats_t stats;
+    sar_slab_stats_get(&stats);
+    TEST_ASSERT_EQUAL(2, stats.alloc_failures);
+
+    /* Releasing NULL is allowed, like free(NULL): */
+    sar_slab_release(NULL);
+}
+
+void test_exhaust_and_spill(void)
+{
+    void * p_buffers[SLAB_COUNT_TOTAL];
+    sar_slab_stats_t stats;
+
+    /* Single byte requests use up the small slabs first, then spill into the larger classes: */
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        for (uint32_t j = 0; j < m_counts[i]; ++j)
+        {
+            p_buffers[count] = sar_slab_alloc(1);
+            TEST_ASSERT_NOT_NULL(p_buffers[count]);
+            TEST_ASSERT_EQUAL(j + 1, class_in_use_get(i));
+            count++;
+        }
+    }
+    TEST_ASSERT_EQUAL(SLAB_COUNT_TOTAL, count);
+
+    sar_slab_stats_get(&stats);
+    TEST_ASSERT_EQUAL(0, stats.classes[0].spills);
+    for (uint32_t i = 1; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        TEST_ASSERT_EQUAL(m_counts[i], stats.classes[i].spills);
+        TEST_ASSERT_EQUAL(m_counts[i], stats.classes[i].in_use_peak);
+    }
+    TEST_ASSERT_EQUAL(0, stats.alloc_failures);
+
+    /* The pool is exhausted: */
+    TEST_ASSERT_NULL(sar_slab_alloc(1));
+    TEST_ASSERT_NULL(sar_slab_alloc(SAR_SLAB_SIZE_MAX));
+    sar_slab_stats_get(&stats);
+    TEST_ASSERT_EQUAL(2, stats.alloc_failures);
+
+    /* No two buffers overlap: */
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        for (uint32_t j = i + 1; j < count; ++j)
+        {
+            TEST_ASSERT_NOT_EQUAL(p_buffers[i], p_buffers[j]);
+        }
+    }
+
+    /* A released slab is handed out again for the next request that fits it: */
+    void * p_large = p_buffers[count - 1];
+    sar_slab_release(p_large);
+    TEST_ASSERT_NULL(sar_slab_alloc(SAR_SLAB_SIZE_MAX + 1));
+    TEST_ASSERT_EQUAL_PTR(p_large, sar_slab_alloc(SAR_SLAB_SIZE_MAX));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        sar_slab_release(p_buffers[i]);
+    }
+
+    sar_slab_stats_get(&stats);
+    for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        TEST_ASSERT_EQUAL(0, stats.classes[i].in_use);
+    }
+    TEST_ASSERT_EQUAL(0, stats.requested_bytes);
+    TEST_ASSERT_EQUAL(0, stats.reserved_bytes);
+}
+
+void test_buffers_are_separate(void)
+{
+    uint8_t * p_buffers[SLAB_COUNT_TOTAL];
+    uint32_t count = 0;
+
+    /* Fill every slab to its full size with a pattern unique to the slab: */
+    for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        for (uint32_t j = 0; j < m_counts[i]; ++j)
+        {
+            p_buffers[count] = sar_slab_alloc(m_sizes[i]);
+            TEST_ASSERT_NOT_NULL(p_buffers[count]);
+            memset(p_buffers[count], count, m_sizes[i]);
+            count++;
+        }
+    }
+
+    count = 0;
+    for (uint32_t i = 0; i < SAR_SLAB_CLASS_COUNT; ++i)
+    {
+        for (uint32_t j = 0; j < m_counts[i]; ++j)
+        {
+            for (uint32_t k = 0; k < m_sizes[i]; ++k)
+            {
+                TEST_ASSERT_EQUAL_HEX8(count, p_buffers[count][k]);
+            }
+            sar_slab_release(p_buffers[count]);
+            count++;
+        }
+    }
+}
+
+void test_fragmentation_stats(void)
+{
+    sar_slab_stats_t stats;
+
+    /* A 5 segment message occupies a 96 byte slab, and a 20 byte message a 48 byte slab: */
+    void * p_first = sar_slab_alloc(60);
+    void * p_second = sar_slab_alloc(20);
+
+    sar_slab_stats_get(&stats);
+    TEST_ASSERT_EQUAL(80, stats.requested_bytes);
+    TEST_ASSERT_EQUAL(144, stats.reserved_bytes);
+    TEST_ASSERT_EQUAL(144, stats.reserved_bytes_peak);
+    TEST_ASSERT_EQUAL(1, stats.classes[1].allocs);
+    TEST_ASSERT_EQUAL(1, stats.classes[2].allocs);
+
+    sar_slab_release(p_first);
+    sar_slab_stats_get(&stats);
+    TEST_ASSERT_EQUAL(20, stats.requested_bytes);
+    TEST_ASSERT_EQUAL(48, stats.reserved_bytes);
+    TEST_ASSERT_EQUAL(144, stats.reserved_bytes_peak);
+    TEST_ASSERT_EQUAL(1, stats.classes[2].in_use_peak);
+
+    /* Resetting the statistics keeps the current usage: */
+    TEST_ASSERT_NULL(sar_slab_alloc(0));
+    sar_slab_stats_reset();
+    sar_slab_stats_get(&stats);
+    TEST_ASSERT_EQUAL(20, stats.requested_bytes);
+    TEST_ASSERT_EQUAL(48, stats.reserved_bytes);
+    TEST_ASSERT_EQUAL(48, stats.reserved_bytes_peak);
+    TEST_ASSERT_EQUAL(0, stats.alloc_failures);
+    TEST_ASSERT_EQUAL(1, stats.classes[1].in_use);
+    TEST_ASSERT_EQUAL(1, stats.classes[1].in_use_peak);
+    TEST_ASSERT_EQUAL(0, stats.classes[1].allocs);
+    TEST_ASSERT_EQUAL(0, stats.classes[2].in_use_peak);
+
+    sar_slab_release(p_second);
+}
+
+void test_release_invalid(void)
+{
+    uint8_t * p_buffer = sar_slab_alloc(48);
+    TEST_ASSERT_NOT_NULL(p_buffer);
+
+    /* Buffers outside the pool: */
+    uint32_t outside;
+    TEST_NRF_MESH_ASSERT_EXPECT(sar_slab_release(&outside));
+
+    /* Pointers into the middle of a slab: */
+    TEST_NRF_MESH_ASSERT_EXPECT(sar_slab_release(p_buffer + 4));
+
+    /* Double release: */
+    sar_slab_release(p_buffer);
+    TEST_NRF_MESH_ASSERT_EXPECT(sar_slab_release(p_buffer));
+
+    TEST_NRF_MESH_ASSERT_EXPECT(sar_slab_stats_get(NULL));
+}
@@ -0,0 +1,409 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <unity.h>
+#include <cmock.h>
+
+#include "scan_duty_cycle.h"
+#include "nordic_common.h"
+#include "utils.h"
+#include "test_assert.h"
+
+#include "scanner_mock.h"
+#include "advertiser_mock.h"
+#include "timer_mock.h"
+#include "timer_scheduler_mock.h"
+
+#define INTERVAL_US         MS_TO_US(100)
+#define WINDOW_MIN_US       MS_TO_US(10)
+#define WINDOW_MAX_US       INTERVAL_US
+#define SAMPLE_INTERVAL_US  MS_TO_US(SCAN_DUTY_CYCLE_SAMPLE_INTERVAL_MS)
+
+/** One phase of a traffic trace. */
+typedef struct
+{
+    uint32_t periods;        /**< Number of sample periods the phase lasts. */
+    uint32_t rx_rate;        /**< Number of packets per second on air. */
+    uint32_t tx_queue_depth; /**< Number of packets in the advertiser queues. */
+} trace_phase_t;
+
+static timestamp_t m_now;
+static timer_event_t * mp_timer;
+static scanner_stats_t m_scanner_stats;
+static scan_duty_cycle_timing_t m_scanner_timing;
+static uint32_t m_scanner_timing_set_count;
+static uint32_t m_tx_queue_depth;
+
+static scan_duty_cycle_sample_t m_policy_sample;
+static scan_duty_cycle_timing_t m_policy_timing;
+static uint32_t m_policy_call_count;
+
+static scan_duty_cycle_default_config_t m_default_config =
+{
+    .scan_interval_us = INTERVAL_US,
+    .window_min_us    = WINDOW_MIN_US,
+    .window_max_us    = WINDOW_MAX_US,
+    .busy_rx_rate     = 100,
+    .quiet_rx_rate    = 10,
+    .tx_queue_deep    = 8
+};
+
+/******** Mock callbacks ********/
+static timestamp_t timer_now_cb(int count)
+{
+    return m_now;
+}
+
+static void timer_sch_schedule_cb(timer_event_t * p_timer_evt, int count)
+{
+    TEST_ASSERT_EQUAL(SAMPLE_INTERVAL_US, p_timer_evt->interval);
+    TEST_ASSERT_EQUAL(m_now + SAMPLE_INTERVAL_US, p_timer_evt->timestamp);
+    TEST_ASSERT_NOT_NULL(p_timer_evt->cb);
+    mp_timer = p_timer_evt;
+}
+
+static void timer_sch_abort_cb(timer_event_t * p_timer_evt, int count)
+{
+    TEST_ASSERT_EQUAL_PTR(mp_timer, p_timer_evt);
+    mp_timer = NULL;
+}
+
+static const scanner_stats_t * scanner_stats_get_cb(int count)
+{
+    return &m_scanner_stats;
+}
+
+static void scanner_config_scan_time_set_cb(uint32_t scan_interval_us, uint32_t scan_window_us, int count)
+{
+    m_scanner_timing.scan_interval_us = scan_interval_us;
+    m_scanner_timing.scan_window_us = scan_window_us;
+    m_scanner_timing_set_count++;
+}
+
+static uint32_t advertiser_queue_depth_get_cb(int count)
+{
+    return m_tx_queue_depth;
+}
+
+static void policy_cb(const scan_duty_cycle_sample_t * p_sample,
+                      scan_duty_cycle_timing_t * p_timing,
+                      void * p_context)
+{
+    TEST_ASSERT_EQUAL_PTR(&m_policy_timing, p_context);
+    m_policy_sample = *p_sample;
+    m_policy_call_count++;
+    *p_timing = m_policy_timing;
+}
+
+/******** Helper functions ********/
+static void sample_period_run(uint32_t rx_packets)
+{
+    TEST_ASSERT_NOT_NULL(mp_timer);
+    m_now += SAMPLE_INTERVAL_US;
+    m_scanner_stats.successful_receives += rx_packets;
+    mp_timer->cb(m_now, mp_timer->p_context);
+}
+
+/** Number of packets the scanner receives out of @p rx_rate packets per second on air. */
+static uint32_t rx_packets_get(uint32_t rx_rate)
+{
+    return (uint32_t) (((uint64_t) rx_rate * SAMPLE_INTERVAL_US * m_scanner_timing.scan_window_us) /
+                       ((uint64_t) SEC_TO_US(1) * m_scanner_timing.scan_interval_us));
+}
+
+/** Replays a traffic trace, returns the time spent scanning in microseconds. */
+static uint64_t trace_replay(const trace_phase_t * p_trace, uint32_t phase_count)
+{
+    uint64_t scan_time_us = 0;
+    for (uint32_t i = 0; i < phase_count; ++i)
+    {
+        m_tx_queue_depth = p_trace[i].tx_queue_depth;
+        for (uint32_t j = 0; j < p_trace[i].periods; ++j)
+        {
+            scan_time_us += ((uint64_t) SAMPLE_INTERVAL_US * m_scanner_timing.scan_window_us) /
+                            m_scanner_timing.scan_interval_us;
+            sample_period_run(rx_packets_get(p_trace[i].rx_rate));
+        }
+    }
+    return scan_time_us;
+}
+
+/******** Setup and Tear Down ********/
+void setUp(void)
+{
+    scanner_mock_Init();
+    advertiser_mock_Init();
+    timer_mock_Init();
+    timer_scheduler_mock_Init();
+
+    m_now = 1000;
+    mp_timer = NULL;
+    memset(&m_scanner_stats, 0, sizeof(m_scanner_stats));
+    memset(&m_scanner_timing, 0, sizeof(m_scanner_timing));
+    m_scanner_timing_set_count = 0;
+    m_tx_queue_depth = 0;
+    m_policy_call_count = 0;
+
+    timer_now_StubWithCallback(timer_now_cb);
+    timer_sch_schedule_StubWithCallback(timer_sch_schedule_cb);
+    timer_sch_abort_StubWithCallback(timer_sch_abort_cb);
+    scanner_stats_get_StubWithCallback(scanner_stats_get_cb);
+    scanner_config_scan_time_set_StubWithCallback(scanner_config_scan_time_set_cb);
+    advertiser_queue_depth_get_StubWithCallback(advertiser_queue_depth_get_cb);
+}
+
+void tearDown(void)
+{
+    scan_duty_cycle_timing_t timing;
+    if (scan_duty_cycle_timing_get(&timing) == NRF_SUCCESS)
+    {
+        TEST_ASSERT_EQUAL(NRF_SUCCESS, scan_duty_cycle_stop());
+    }
+
+    scanner_mock_Verify();
+    scanner_mock_Destroy();
+    advertiser_mock_Verify();
+    advertiser_mock_Destroy();
+    timer_mock_Verify();
+    timer_mock_Destroy();
+    timer_scheduler_mock_Verify();
+    timer_scheduler_mock_Destroy();
+}
+
+/******** Tests ********/
+void test_start_stop(void)
+{
+    scan_duty_cycle_timing_t timing = {INTERVAL_US, WINDOW_MAX_US};
+    scan_duty_cycle_timing_t timing_out;
+
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, scan_duty_cycle_start(NULL, NULL, &timing));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, scan_duty_cycle_start(policy_cb, &m_policy_timing, NULL));
+
+    timing.scan_window_us = INTERVAL_US + 1;
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, scan_duty_cycle_start(policy_cb, &m_policy_timing, &timing));
+    timing.scan_window_us = MS_TO_US(BEARER_SCAN_WIN_MIN_MS) - 1;
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, scan_duty_cycle_start(policy_cb, &m_policy_timing, &timing));
+    timing.scan_interval_us = MS_TO_US(BEARER_SCAN_INT_MAX_MS) + 1;
+    timing.scan_window_us = WINDOW_MAX_US;
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, scan_duty_cycle_start(policy_cb, &m_policy_timing, &timing));
+
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_STATE, scan_duty_cycle_stop());
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_STATE, scan_duty_cycle_timing_get(&timing_out));
+    TEST_ASSERT_EQUAL(0, m_scanner_timing_set_count);
+    TEST_ASSERT_NULL(mp_timer);
+
+    timing.scan_interval_us = INTERVAL_US;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, scan_duty_cycle_start(policy_cb, &m_policy_timing, &timing));
+    TEST_ASSERT_EQUAL(1, m_scanner_timing_set_count);
+    TEST_ASSERT_EQUAL_MEMORY(&timing, &m_scanner_timing, sizeof(timing));
+    TEST_ASSERT_NOT_NULL(mp_timer);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, scan_duty_cycle_timing_get(&timing_out));
+    TEST_ASSERT_EQUAL_MEMORY(&timing, &timing_out, sizeof(timing));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_STATE, scan_duty_cycle_start(policy_cb, &m_policy_timing, &timing));
+    TEST_NRF_MESH_ASSERT_EXPECT(scan_duty_cycle_timing_get(NULL));
+
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, scan_duty_cycle_stop());
+    TEST_ASSERT_NULL(mp_timer);
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_STATE, scan_duty_cycle_stop());
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_STATE, scan_duty_cycle_timing_get(&timing_out));
+    TEST_ASSERT_EQUAL(0, m_policy_call_count);
+}
+
+void test_policy(void)
+{
+    scan_duty_cycle_timing_t timing = {INTERVAL_US, WINDOW_MAX_US};
+    m_scanner_stats.successful_receives = 1000;
+    m_policy_timing = timing;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, scan_duty_cycle_start(policy_cb, &m_policy_timing, &timing));
+    TEST_ASSERT_EQUAL(1, m_scanner_timing_set_count);
+
+    /* The policy gets the packets received during the period, and the current TX queue depth. */
+    m_tx_queue_depth = 3;
+    sample_period_run(17);
+    TEST_ASSERT_EQUAL(1, m_policy_call_count);
+    TEST_ASSERT_EQUAL(SAMPLE_INTERVAL_US, m_policy_sample.period_us);
+    TEST_ASSERT_EQUAL(17, m_policy_sample.rx_packets);
+    TEST_ASSERT_EQUAL(3, m_policy_sample.tx_queue_depth);
+
+    /* The scanner is left alone as long as the timing doesn't change. */
+    TEST_ASSERT_EQUAL(1, m_scanner_timing_set_count);
+
+    m_policy_timing.scan_window_us = WINDOW_MIN_US;
+    m_tx_queue_depth = 0;
+    sample_period_run(0);
+    TEST_ASSERT_EQUAL(2, m_policy_call_count);
+    TEST_ASSERT_EQUAL(0, m_policy_sample.rx_packets);
+    TEST_ASSERT_EQUAL(0, m_policy_sample.tx_queue_depth);
+    TEST_ASSERT_EQUAL(2, m_scanner_timing_set_count);
+    TEST_ASSERT_EQUAL_MEMORY(&m_policy_timing, &m_scanner_timing, sizeof(m_policy_timing));
+
+    scan_duty_cycle_timing_t timing_out;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, scan_duty_cycle_timing_get(&timing_out));
+    TEST_ASSERT_EQUAL_MEMORY(&m_policy_timing, &timing_out, sizeof(timing_out));
+
+    /* The receive counter may wrap around. */
+    m_scanner_stats.successful_receives = UINT32_MAX - 1;
+    sample_period_run(0);
+    sample_period_run(5);
+    TEST_ASSERT_EQUAL(5, m_policy_sample.rx_packets);
+    TEST_ASSERT_EQUAL(2, m_scanner_timing_set_count);
+
+    /* The policy must pick a valid timing. */
+    m_policy_timing.scan_window_us = INTERVAL_US + 1;
+    m_now += SAMPLE_INTERVAL_US;
+    TEST_NRF_MESH_ASSERT_EXPECT(mp_timer->cb(m_now, mp_timer->p_context));
+}
+
+void test_policy_default(void)
+{
+    scan_duty_cycle_sample_t sample = {SEC_TO_US(1), 0, 0};
+    scan_duty_cycle_timing_t timing = {INTERVAL_US, MS_TO_US(40)};
+
+    /* 10 packets in 400ms of scanning is busy, the window is doubled. */
+    sample.rx_packets = 40;
+    scan_duty_cycle_policy_default(&sample, &timing, &m_default_config);
+    TEST_ASSERT_EQUAL(INTERVAL_US, timing.scan_interval_us);
+    TEST_ASSERT_EQUAL(MS_TO_US(80), timing.scan_window_us);
+
+    /* Limited to the max window. */
+    sample.rx_packets = 80;
+    scan_duty_cycle_policy_default(&sample, &timing, &m_default_config);
+    TEST_ASSERT_EQUAL(WINDOW_MAX_US, timing.scan_window_us);
+
+    /* Between the thresholds, the window stays. */
+    sample.rx_packets = 50;
+    scan_duty_cycle_policy_default(&sample, &timing, &m_default_config);
+    TEST_ASSERT_EQUAL(WINDOW_MAX_US, timing.scan_window_us);
+
+    /* Quiet, the window is shortened by a quarter. */
+    sample.rx_packets = 10;
+    scan_duty_cycle_policy_default(&sample, &timing, &m_default_config);
+    TEST_ASSERT_EQUAL(MS_TO_US(75), timing.scan_window_us);
+
+    /* A deep TX queue halves the window, even on a busy channel. */
+    sample.rx_packets = 1000;
+    sample.tx_queue_depth = m_default_config.tx_queue_deep;
+    scan_duty_cycle_policy_default(&sample, &timing, &m_default_config);
+    TEST_ASSERT_EQUAL(MS_TO_US(75) / 2, timing.scan_window_us);
+
+    /* Limited to the min window. */
+    timing.scan_window_us = WINDOW_MIN_US + 1;
+    scan_duty_cycle_policy_default(&sample, &timing, &m_default_config);
+    TEST_ASSERT_EQUAL(WINDOW_MIN_US, timing.scan_window_us);
+
+    /* The configured interval is always used. */
+    timing.scan_interval_us = MS_TO_US(200);
+    timing.scan_window_us = MS_TO_US(200);
+    sample.rx_packets = 0;
+    sample.tx_queue_depth = 0;
+    scan_duty_cycle_policy_default(&sample, &timing, &m_default_config);
+    TEST_ASSERT_EQUAL(INTERVAL_US, timing.scan_interval_us);
+    TEST_ASSERT_EQUAL(WINDOW_MAX_US, timing.scan_window_us);
+
+    /* An empty sample period counts as quiet. */
+    sample.period_us = 0;
+    scan_duty_cycle_policy_default(&sample, &timing, &m_default_config);
+    TEST_ASSERT_EQUAL(MS_TO_US(75), timing.scan_window_us);
+
+    TEST_NRF_MESH_ASSERT_EXPECT(scan_duty_cycle_policy_default(&sample, &timing, NULL));
+    scan_duty_cycle_default_config_t config = m_default_config;
+    config.quiet_rx_rate = config.busy_rx_rate;
+    TEST_NRF_MESH_ASSERT_EXPECT(scan_duty_cycle_policy_default(&sample, &timing, &config));
+
+    /* The window limits must make valid scanner timings. */
+    config = m_default_config;
+    config.window_min_us = MS_TO_US(BEARER_SCAN_WIN_MIN_MS) - 1;
+    TEST_NRF_MESH_ASSERT_EXPECT(scan_duty_cycle_policy_default(&sample, &timing, &config));
+    config = m_default_config;
+    config.window_min_us = config.window_max_us + 1;
+    TEST_NRF_MESH_ASSERT_EXPECT(scan_duty_cycle_policy_default(&sample, &timing, &config));
+    config = m_default_config;
+    config.window_max_us = config.scan_interval_us + 1;
+    TEST_NRF_MESH_ASSERT_EXPECT(scan_duty_cycle_policy_default(&sample, &timing, &config));
+    config = m_default_config;
+    config.scan_interval_us = MS_TO_US(BEARER_SCAN_INT_MAX_MS) + 1;
+    config.window_max_us = config.scan_interval_us;
+    TEST_NRF_MESH_ASSERT_EXPECT(scan_duty_cycle_policy_default(&sample, &timing, &config));
+}
+
+void test_trace_replay(void)
+{
+    const trace_phase_t quiet[]       = {{30, 2, 0}};
+    const trace_phase_t busy[]        = {{10, 500, 0}};
+    const trace_phase_t tx_burst[]    = {{10, 500, 20}};
+    const trace_phase_t tx_drained[]  = {{10, 500, 0}};
+    const trace_phase_t day[] =
+    {
+        {60,   1, 0},
+        { 5, 300, 0},
+        { 5, 300, 12},
+        {20, 300, 0},
+        {60,   5, 1},
+        {10, 800, 2},
+        {60,   0, 0},
+    };
+
+    scan_duty_cycle_timing_t timing = {INTERVAL_US, WINDOW_MAX_US};
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, scan_duty_cycle_start(scan_duty_cycle_policy_default, &m_default_config, &timing));
+
+    /* A quiet channel backs the scanner off to the shortest window. */
+    (void) trace_replay(quiet, ARRAY_SIZE(quiet));
+    TEST_ASSERT_EQUAL(WINDOW_MIN_US, m_scanner_timing.scan_window_us);
+    TEST_ASSERT_EQUAL(INTERVAL_US, m_scanner_timing.scan_interval_us);
+
+    /* Traffic picking up opens the window again. */
+    (void) trace_replay(busy, ARRAY_SIZE(busy));
+    TEST_ASSERT_EQUAL(WINDOW_MAX_US, m_scanner_timing.scan_window_us);
+
+    /* A deep TX queue makes room for the advertiser, even though the channel is busy. */
+    (void) trace_replay(tx_burst, 1);
+    TEST_ASSERT_EQUAL(WINDOW_MIN_US, m_scanner_timing.scan_window_us);
+    (void) trace_replay(tx_drained, 1);
+    TEST_ASSERT_EQUAL(WINDOW_MAX_US, m_scanner_timing.scan_window_us);
+
+    /* Over a mostly quiet day, the scanner is on for a fraction of the time, while never
+     * scanning less than the minimum duty cycle. */
+    uint32_t periods = 0;
+    for (uint32_t i = 0; i < ARRAY_SIZE(day); ++i)
+    {
+        periods += day[i].periods;
+    }
+    uint64_t scan_time_us = trace_replay(day, ARRAY_SIZE(day));
+    uint64_t continuous_scan_time_us = (uint64_t) periods * SAMPLE_INTERVAL_US;
+    TEST_ASSERT_TRUE(scan_time_us < continuous_scan_time_us / 2);
+    TEST_ASSERT_TRUE(scan_time_us >= (continuous_scan_time_us * WINDOW_MIN_US) / INTERVAL_US);
+    TEST_ASSERT_EQUAL(WINDOW_MIN_US, m_scanner_timing.scan_window_us);
+}
@@ -519,6 +519,7 @@ void test_radio_start_IN_WINDOW_BUFFER_RESERVE_FAILED(void)
     TEST_ASSERT_EQUAL(0, m_radio.TASKS_RXEN);
     TEST_ASSERT_EQUAL(0, m_radio.PACKETPTR);
     TEST_ASSERT_EQUAL(true, m_scanner.waiting_for_memory);
+    TEST_ASSERT_EQUAL_UINT32(1, scanner_stats_get()->rx_buffer_stalls);
 }
 
 void test_radio_stop(void)
@@ -605,6 +606,42 @@ void test_radio_irq_handler_END_EVENT_LENGTH_ERROR(void)
     TEST_ASSERT_EQUAL_UINT32(1, scanner_stats_get()->length_out_of_bounds);
 }
 
+void test_radio_irq_handler_END_EVENT_LENGTH_SHORT(void)
+{
+    packet_buffer_packet_t * p_packet_buffer_packet =
+        (packet_buffer_packet_t *)m_scanner.packet_buffer_data;
+    scanner_packet_t * p_scanner_packet = (scanner_packet_t *)p_packet_buffer_packet->packet;
+
+    scanner_start_helper();
+
+    /* Set up radio */
+    m_radio.EVENTS_END = 1;
+    NRF_RADIO->STATE   = RADIO_STATE_STATE_RxIdle;
+    m_radio.CRCSTATUS  = RADIO_CRCSTATUS_CRCSTATUS_CRCOk;
+
+    p_scanner_packet->packet.header.length = BLE_GAP_ADDR_LEN - 1;
+
+    /* Set up radio_handle_end_event() */
+    packet_buffer_free_Expect(&m_scanner.packet_buffer, m_scanner.p_buffer_packet);
+
+    /* Set up radio_setup_next_operation() */
+    packet_buffer_reserve_ExpectAndReturn(&m_scanner.packet_buffer,
+                                          &m_scanner.p_buffer_packet,
+                                          sizeof(scanner_packet_t),
+                                          NRF_SUCCESS);
+    packet_buffer_reserve_ReturnThruPtr_pp_packet(&p_packet_buffer_packet);
+
+    scanner_radio_irq_handler();
+
+    /* Verify resulting state */
+    TEST_ASSERT_EQUAL(0, m_radio.EVENTS_END);
+    TEST_ASSERT_NOT_NULL(m_scanner.p_buffer_packet);
+    TEST_ASSERT_EQUAL(SCAN_WINDOW_STATE_ON, m_scanner.window_state);
+    TEST_ASSERT_EQUAL_UINT32(0, scanner_stats_get()->successful_receives);
+    TEST_ASSERT_EQUAL_UINT32(0, scanner_stats_get()->crc_failures);
+    TEST_ASSERT_EQUAL_UINT32(1, scanner_stats_get()->length_out_of_bounds);
+}
+
 void test_radio_irq_handler_END_EVENT_SUCCESSFUL(void)
 {
     packet_buffer_packet_t * p_packet_buffer_packet =
@@ -621,12 +658,13 @@ void test_radio_irq_handler_END_EVENT_SUCCESSFUL(void)
     m_radio.DATAWHITEIV = DATAWHITEIV_VALUE;
     m_radio.STATE       = RADIO_STATE_STATE_RxIdle;
 
-    p_scanner_packet->packet.header.length = 2;
+    p_scanner_packet->packet.header.length = BLE_GAP_ADDR_LEN + 2;
 
     m_timer0.CC[SCANNER_TIMER_INDEX] = TIME_UNTIL_END_EVENT;
 
     /* Set up radio_handle_end_event() */
     timeslot_start_time_get_ExpectAndReturn(TIME_NOW);
+    fen_compiled_filters_apply_ExpectAndReturn(p_scanner_packet, false);
     packet_buffer_commit_Expect(&m_scanner.packet_buffer,
                                 m_scanner.p_buffer_packet,
                                 SCANNER_PACKET_OVERHEAD +
@@ -656,6 +694,50 @@ void test_radio_irq_handler_END_EVENT_SUCCESSFUL(void)
     TEST_ASSERT_EQUAL_UINT32(0, scanner_stats_get()->length_out_of_bounds);
 }
 
+void test_radio_irq_handler_END_EVENT_FILTERED(void)
+{
+    packet_buffer_packet_t * p_packet_buffer_packet =
+        (packet_buffer_packet_t *)m_scanner.packet_buffer_data;
+    scanner_packet_t * p_scanner_packet = (scanner_packet_t *)p_packet_buffer_packet->packet;
+
+    scanner_window_started_helper();
+
+    /* Set up radio */
+    m_radio.EVENTS_END  = 1;
+    m_radio.CRCSTATUS   = RADIO_CRCSTATUS_CRCSTATUS_CRCOk;
+    m_radio.RSSISAMPLE  = RSSISAMPLE_VALUE;
+    m_radio.RXMATCH     = RXMATCH_VALUE;
+    m_radio.DATAWHITEIV = DATAWHITEIV_VALUE;
+    m_radio.STATE       = RADIO_STATE_STATE_RxIdle;
+
+    p_scanner_packet->packet.header.length = BLE_GAP_ADDR_LEN + 2;
+
+    m_timer0.CC[SCANNER_TIMER_INDEX] = TIME_UNTIL_END_EVENT;
+
+    /* Set up radio_handle_end_event(), the packet is rejected by the compiled filter and must be
+     * released without being committed to the RX queue. */
+    timeslot_start_time_get_ExpectAndReturn(TIME_NOW);
+    fen_compiled_filters_apply_ExpectAndReturn(p_scanner_packet, true);
+    packet_buffer_free_Expect(&m_scanner.packet_buffer, m_scanner.p_buffer_packet);
+
+    /* Set up radio_setup_next_operation() */
+    packet_buffer_reserve_ExpectAndReturn(&m_scanner.packet_buffer,
+                                          &m_scanner.p_buffer_packet, sizeof(scanner_packet_t),
+                                          NRF_SUCCESS);
+    packet_buffer_reserve_ReturnThruPtr_pp_packet(&p_packet_buffer_packet);
+
+    scanner_radio_irq_handler();
+
+    /* Verify resulting state */
+    TEST_ASSERT_EQUAL(0, m_radio.EVENTS_END);
+    TEST_ASSERT_EQUAL_INT8(-RSSISAMPLE_VALUE, p_scanner_packet->metadata.rssi);
+    TEST_ASSERT_NOT_NULL(m_scanner.p_buffer_packet);
+    TEST_ASSERT_EQUAL(SCAN_WINDOW_STATE_ON, m_scanner.window_state);
+    TEST_ASSERT_EQUAL_UINT32(1, scanner_stats_get()->successful_receives);
+    TEST_ASSERT_EQUAL_UINT32(0, scanner_stats_get()->crc_failures);
+    TEST_ASSERT_EQUAL_UINT32(0, scanner_stats_get()->length_out_of_bounds);
+}
+
 static void packet_buffer_free_callback_AFTER_WINDOW_START(packet_buffer_t* const p_buffer, packet_buffer_packet_t* const p_packet, int cmock_num_calls)
 {
     packet_buffer_free_callback_cnt++;
@@ -760,12 +842,13 @@ void test_radio_irq_handler_WINDOW_END_AFTER_RX(void)
     m_radio.DATAWHITEIV = DATAWHITEIV_VALUE;
     m_radio.STATE       = RADIO_STATE_STATE_RxIdle;
 
-    p_scanner_packet->packet.header.length = 2;
+    p_scanner_packet->packet.header.length = BLE_GAP_ADDR_LEN + 2;
 
     m_timer0.CC[SCANNER_TIMER_INDEX] = TIME_UNTIL_END_EVENT;
 
     /* Set up radio_handle_end_event() */
     timeslot_start_time_get_ExpectAndReturn(TIME_NOW);
+    fen_compiled_filters_apply_ExpectAndReturn(p_scanner_packet, false);
     packet_buffer_commit_Expect(&m_scanner.packet_buffer,
                                 m_scanner.p_buffer_packet,
                                 SCANNER_PACKET_OVERHEAD +
@@ -0,0 +1,294 @@
+/* Copyright (c) 2010 - 2018, Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scanner.h"
+
+#include <unity.h>
+#include <cmock.h>
+
+#include "nordic_common.h"
+#include "test_assert.h"
+
+#include "bearer_event_mock.h"
+#include "filter_engine_mock.h"
+#include "nrf_mesh_cmsis_mock_mock.h"
+#include "radio_config_mock.h"
+#include "timer_mock.h"
+#include "timer_scheduler_mock.h"
+#include "timeslot_mock.h"
+
+/* Include module to be tested (to get access to internal state) */
+#include "../../bearer/src/scanner.c"
+
+#if SCANNER_RX_RING_SLOT_COUNT != 4
+#error "The test assumes an RX ring of 4 slots."
+#endif
+
+/* Initialize the RADIO peripheral, it will be externed by the headers. */
+NRF_RADIO_Type * NRF_RADIO;
+static NRF_RADIO_Type m_radio;
+NRF_PPI_Type * NRF_PPI;
+static NRF_PPI_Type m_ppi;
+NRF_TIMER_Type * NRF_TIMER0;
+static NRF_TIMER_Type m_timer0;
+
+#define TIME_NOW                (123)
+#define RSSISAMPLE_VALUE        (50)
+#define BEARER_EVENT_FLAG       (7)
+
+/******** Helper functions ********/
+static bool scanner_packet_process_callback(void)
+{
+    return true;
+}
+
+static void scanner_start_helper(void)
+{
+    bearer_event_flag_add_ExpectAndReturn(scanner_packet_process_callback, BEARER_EVENT_FLAG);
+    scanner_init(scanner_packet_process_callback);
+
+    timer_now_ExpectAndReturn(TIME_NOW);
+    timer_sch_abort_Expect(&m_scanner.timer_window_end);
+    timer_sch_reschedule_Expect(&m_scanner.timer_window_start, TIME_NOW);
+    scanner_enable();
+
+    radio_config_reset_Expect();
+    radio_config_config_Expect(&m_scanner.config.radio_config);
+    radio_config_access_addr_set_Expect(BEARER_ACCESS_ADDR_DEFAULT, 0);
+    radio_config_channel_set_Expect(m_scanner.config.channels[0]);
+    scanner_radio_start();
+
+    TEST_ASSERT_EQUAL(1, m_radio.TASKS_RXEN);
+    NRF_RADIO->STATE = RADIO_STATE_STATE_RxIdle;
+}
+
+/** Simulates the END event of a packet received into the armed slot. */
+static void end_event_helper(bool crc_ok, bool filtered)
+{
+    scanner_packet_t * p_packet = m_scanner.p_rx_packet;
+
+    TEST_ASSERT_NOT_NULL(p_packet);
+    TEST_ASSERT_EQUAL((uint32_t) &p_packet->packet, m_radio.PACKETPTR);
+
+    p_packet->packet.header.length = BLE_ADV_PACKET_OVERHEAD;
+    m_radio.EVENTS_END  = 1;
+    m_radio.CRCSTATUS   = crc_ok ? RADIO_CRCSTATUS_CRCSTATUS_CRCOk : 0;
+    m_radio.RSSISAMPLE  = RSSISAMPLE_VALUE;
+    m_radio.TASKS_START = 0;
+
+    if (crc_ok)
+    {
+        timeslot_start_time_get_ExpectAndReturn(TIME_NOW);
+        fen_compiled_filters_apply_ExpectAndReturn(p_packet, filtered);
+        if (!filtered && p_packet != &m_scanner.rx_ring.overflow)
+        {
+            bearer_event_flag_set_Expect(BEARER_EVENT_FLAG);
+        }
+    }
+
+    scanner_radio_irq_handler();
+
+    /* The radio is always armed again right away. */
+    TEST_ASSERT_EQUAL(0, m_radio.EVENTS_END);
+    TEST_ASSERT_EQUAL(1, m_radio.TASKS_START);
+    TEST_ASSERT_EQUAL(false, m_scanner.waiting_for_memory);
+}
+
+/******** CUnit callbacks ********/
+void setUp(void)
+{
+    timer_mock_Init();
+    timer_scheduler_mock_Init();
+    radio_config_mock_Init();
+    timeslot_mock_Init();
+    nrf_mesh_cmsis_mock_mock_Init();
+    filter_engine_mock_Init();
+    bearer_event_mock_Init();
+
+    memset(&m_radio,  0, sizeof(NRF_RADIO_Type));
+    memset(&m_ppi,    0, sizeof(NRF_PPI_Type));
+    memset(&m_timer0, 0, sizeof(NRF_TIMER_Type));
+
+    NRF_RADIO           = (NRF_RADIO_Type*) &m_radio;
+    NRF_PPI             = (NRF_PPI_Type*) &m_ppi;
+    NRF_TIMER0          = (NRF_TIMER_Type*) &m_timer0;
+}
+
+void tearDown(void)
+{
+    timer_mock_Verify();
+    timer_mock_Destroy();
+    timer_scheduler_mock_Verify();
+    timer_scheduler_mock_Destroy();
+    radio_config_mock_Verify();
+    radio_config_mock_Destroy();
+    timeslot_mock_Verify();
+    timeslot_mock_Destroy();
+    nrf_mesh_cmsis_mock_mock_Verify();
+    nrf_mesh_cmsis_mock_mock_Destroy();
+    filter_engine_mock_Verify();
+    filter_engine_mock_Destroy();
+    bearer_event_mock_Verify();
+    bearer_event_mock_Destroy();
+}
+
+/******** Tests ********/
+void test_receive(void)
+{
+    scanner_start_helper();
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[0], m_scanner.p_rx_packet);
+
+    /* Packets that are not accepted leave the slot armed. */
+    end_event_helper(false, false);
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[0], m_scanner.p_rx_packet);
+    end_event_helper(true, true);
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[0], m_scanner.p_rx_packet);
+    TEST_ASSERT_FALSE(scanner_rx_pending());
+
+    end_event_helper(true, false);
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[1], m_scanner.p_rx_packet);
+    TEST_ASSERT_TRUE(scanner_rx_pending());
+
+    /* The consumer gets the slot itself. */
+    fen_filters_apply_ExpectAndReturn(&m_scanner.rx_ring.slots[0], false);
+    const scanner_packet_t * p_packet = scanner_rx();
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[0], p_packet);
+    TEST_ASSERT_EQUAL_INT8(-RSSISAMPLE_VALUE, p_packet->metadata.rssi);
+    TEST_ASSERT_EQUAL_UINT32(TIME_NOW, p_packet->metadata.timestamp);
+    TEST_ASSERT_FALSE(scanner_rx_pending());
+    TEST_ASSERT_NULL(scanner_rx());
+
+    scanner_packet_release(p_packet);
+    TEST_ASSERT_EQUAL_UINT32(1, m_scanner.rx_ring.free);
+
+    TEST_ASSERT_EQUAL_UINT32(2, scanner_stats_get()->successful_receives);
+    TEST_ASSERT_EQUAL_UINT32(1, scanner_stats_get()->crc_failures);
+    TEST_ASSERT_EQUAL_UINT32(0, scanner_stats_get()->rx_buffer_drops);
+
+    /* Stopping the radio leaves the armed slot to the radio. */
+    scanner_radio_stop();
+    TEST_ASSERT_NULL(m_scanner.p_rx_packet);
+    TEST_ASSERT_EQUAL_UINT32(1, m_scanner.rx_ring.write);
+}
+
+void test_ring_full(void)
+{
+    scanner_start_helper();
+
+    for (uint32_t i = 0; i < SCANNER_RX_RING_SLOT_COUNT; i++)
+    {
+        end_event_helper(true, false);
+    }
+
+    /* Packets are received and dropped while the ring is full. */
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.overflow, m_scanner.p_rx_packet);
+    end_event_helper(true, false);
+    end_event_helper(true, false);
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.overflow, m_scanner.p_rx_packet);
+    TEST_ASSERT_EQUAL_UINT32(2, scanner_stats_get()->rx_buffer_drops);
+    TEST_ASSERT_EQUAL_UINT32(0, scanner_stats_get()->rx_buffer_stalls);
+
+    /* Filtered packets would never have taken up a slot, and aren't counted. */
+    end_event_helper(true, true);
+    TEST_ASSERT_EQUAL_UINT32(2, scanner_stats_get()->rx_buffer_drops);
+
+    fen_filters_apply_ExpectAndReturn(&m_scanner.rx_ring.slots[0], false);
+    scanner_packet_release(scanner_rx());
+
+    /* The released slot is used from the next packet on. */
+    end_event_helper(true, false);
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[0], m_scanner.p_rx_packet);
+    end_event_helper(true, false);
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.overflow, m_scanner.p_rx_packet);
+    TEST_ASSERT_EQUAL_UINT32(3, scanner_stats_get()->rx_buffer_drops);
+    TEST_ASSERT_EQUAL_UINT32(5, m_scanner.rx_ring.write);
+}
+
+void test_release_out_of_order(void)
+{
+    const scanner_packet_t * p_packets[SCANNER_RX_RING_SLOT_COUNT];
+
+    scanner_start_helper();
+
+    for (uint32_t i = 0; i < SCANNER_RX_RING_SLOT_COUNT; i++)
+    {
+        end_event_helper(true, false);
+    }
+
+    /* Packets rejected by the filters are released by the scanner. */
+    fen_filters_apply_ExpectAndReturn(&m_scanner.rx_ring.slots[0], true);
+    fen_filters_apply_ExpectAndReturn(&m_scanner.rx_ring.slots[1], false);
+    p_packets[1] = scanner_rx();
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[1], p_packets[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, m_scanner.rx_ring.free);
+
+    for (uint32_t i = 2; i < SCANNER_RX_RING_SLOT_COUNT; i++)
+    {
+        fen_filters_apply_ExpectAndReturn(&m_scanner.rx_ring.slots[i], false);
+        p_packets[i] = scanner_rx();
+        TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[i], p_packets[i]);
+    }
+
+    /* The slots are handed back once all slots before them have been released. */
+    scanner_packet_release(p_packets[3]);
+    scanner_packet_release(p_packets[2]);
+    TEST_ASSERT_EQUAL_UINT32(1, m_scanner.rx_ring.free);
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.overflow, m_scanner.p_rx_packet);
+
+    /* Releasing twice, or releasing a packet the consumer doesn't own, asserts. */
+    TEST_NRF_MESH_ASSERT_EXPECT(scanner_packet_release(p_packets[3]));
+    TEST_NRF_MESH_ASSERT_EXPECT(scanner_packet_release(&m_scanner.rx_ring.slots[0]));
+    TEST_NRF_MESH_ASSERT_EXPECT(scanner_packet_release(&m_scanner.rx_ring.overflow));
+    TEST_NRF_MESH_ASSERT_EXPECT(scanner_packet_release(NULL));
+
+    scanner_packet_release(p_packets[1]);
+    TEST_ASSERT_EQUAL_UINT32(SCANNER_RX_RING_SLOT_COUNT, m_scanner.rx_ring.free);
+
+    /* The ring wraps around. */
+    end_event_helper(true, false);
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[0], m_scanner.p_rx_packet);
+    end_event_helper(true, false);
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[1], m_scanner.p_rx_packet);
+
+    fen_filters_apply_ExpectAndReturn(&m_scanner.rx_ring.slots[0], false);
+    p_packets[0] = scanner_rx();
+    TEST_ASSERT_EQUAL_PTR(&m_scanner.rx_ring.slots[0], p_packets[0]);
+    TEST_NRF_MESH_ASSERT_EXPECT(scanner_packet_release(&m_scanner.rx_ring.slots[3]));
+    scanner_packet_release(p_packets[0]);
+    TEST_ASSERT_EQUAL_UINT32(SCANNER_RX_RING_SLOT_COUNT + 1, m_scanner.rx_ring.free);
+    TEST_ASSERT_EQUAL_UINT32(1, scanner_stats_get()->rx_buffer_drops);
+}
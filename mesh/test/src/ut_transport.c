@@ -316,3 +316,1264 @@ void test_control_tx(void)
     TEST_ASSERT_EQUAL_HEX8(control_packet.opcode, network_packet_buffer[0]); /* opcode */
     TEST_ASSERT_EQUAL_HEX8_ARRAY(control_packet_buffer, &network_packet_buffer[1], control_packet.data_len); /* payload */
 }
+
+void test_control_tx_template(void)
+{
+    expect_init();
+    transport_init(NULL);
+    uint8_t control_packet_buffer[PACKET_MESH_TRS_UNSEG_CONTROL_PDU_MAX_SIZE + 1];
+
+    for (uint32_t i = 0; i < sizeof(control_packet_buffer); ++i)
+    {
+        control_packet_buffer[i] = i;
+    }
+
+    uint8_t network_packet_buffer[64] = {0};
+    transport_control_packet_t control_packet;
+    nrf_mesh_network_secmat_t net_secmat;
+    transport_control_tx_template_t tx_template;
+
+    control_packet.data_len           = PACKET_MESH_TRS_CONTROL_HEARTBEAT_SIZE;
+    control_packet.dst.p_virtual_uuid = NULL;
+    control_packet.dst.value          = 0xC001;
+    control_packet.dst.type           = NRF_MESH_ADDRESS_TYPE_GROUP;
+    control_packet.opcode             = TRANSPORT_CONTROL_OPCODE_HEARTBEAT;
+    control_packet.p_data             = (const packet_mesh_trs_control_packet_t *) control_packet_buffer;
+    control_packet.p_net_secmat       = &net_secmat;
+    control_packet.reliable           = false;
+    control_packet.src                = 0x0002;
+    control_packet.ttl                = 9;
+
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, transport_control_tx_template_init(NULL, &control_packet));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, transport_control_tx_template_init(&tx_template, NULL));
+
+    /* Templates are only for unsegmented messages: */
+    control_packet.reliable = true;
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, transport_control_tx_template_init(&tx_template, &control_packet));
+    control_packet.reliable = false;
+    control_packet.data_len = PACKET_MESH_TRS_UNSEG_CONTROL_PDU_MAX_SIZE + 1;
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_LENGTH, transport_control_tx_template_init(&tx_template, &control_packet));
+    control_packet.data_len = PACKET_MESH_TRS_CONTROL_HEARTBEAT_SIZE;
+
+    /* Same validation as transport_control_tx(): */
+    control_packet.src = 0xC002;
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_ADDR, transport_control_tx_template_init(&tx_template, &control_packet));
+    control_packet.src = 0x0002;
+    control_packet.ttl = NRF_MESH_TTL_MAX + 1;
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, transport_control_tx_template_init(&tx_template, &control_packet));
+    control_packet.ttl = 9;
+
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_control_tx_template_init(&tx_template, &control_packet));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, transport_control_tx_template_send(NULL, control_packet.p_data, TX_TOKEN));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NULL, transport_control_tx_template_send(&tx_template, NULL, TX_TOKEN));
+
+    m_expect_network_packet_alloc.net_meta.control_packet      = true;
+    m_expect_network_packet_alloc.net_meta.dst                 = control_packet.dst;
+    m_expect_network_packet_alloc.net_meta.src                 = control_packet.src;
+    m_expect_network_packet_alloc.net_meta.ttl                 = control_packet.ttl;
+    m_expect_network_packet_alloc.net_meta.p_security_material = control_packet.p_net_secmat;
+    m_expect_network_packet_alloc.payload_len                  = 1 + control_packet.data_len;
+    m_expect_network_packet_alloc.p_buffer                     = network_packet_buffer;
+    network_packet_alloc_StubWithCallback(network_packet_alloc_callback);
+
+    /* The template is reused for every send, with new data and token each time: */
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        m_expect_network_packet_alloc.calls    = 1;
+        m_expect_network_packet_alloc.tx_token = TX_TOKEN + i;
+        TEST_ASSERT_EQUAL(NRF_SUCCESS,
+                          transport_control_tx_template_send(&tx_template,
+                                                             (const packet_mesh_trs_control_packet_t *) &control_packet_buffer[i],
+                                                             TX_TOKEN + i));
+        TEST_ASSERT_EQUAL(0, m_expect_network_packet_alloc.calls);
+
+        TEST_ASSERT_EQUAL_HEX8(control_packet.opcode, network_packet_buffer[0]); /* opcode, unsegmented */
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(&control_packet_buffer[i], &network_packet_buffer[1], control_packet.data_len);
+    }
+
+    /* Allocation failures are passed on: */
+    network_packet_alloc_StubWithCallback(NULL);
+    network_packet_alloc_ExpectAnyArgsAndReturn(NRF_ERROR_NO_MEM);
+    TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, transport_control_tx_template_send(&tx_template, control_packet.p_data, TX_TOKEN));
+}
+
+static uint8_t m_sar_buffers[TRANSPORT_SAR_SESSIONS_MAX][64];
+static uint32_t m_sar_buffers_allocated;
+
+static void * sar_buffer_alloc(size_t size)
+{
+    TEST_ASSERT_TRUE(size <= sizeof(m_sar_buffers[0]));
+    TEST_ASSERT_TRUE(m_sar_buffers_allocated < TRANSPORT_SAR_SESSIONS_MAX);
+    return m_sar_buffers[m_sar_buffers_allocated++];
+}
+
+static void sar_buffer_release(void * p_buffer)
+{
+}
+
+static uint32_t sar_session_opt_get(nrf_mesh_opt_id_t id)
+{
+    nrf_mesh_opt_t opt;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_opt_get(id, &opt));
+    return opt.opt.val;
+}
+
+static uint32_t sar_session_opt_set(nrf_mesh_opt_id_t id, uint32_t val)
+{
+    nrf_mesh_opt_t opt;
+    opt.len = sizeof(opt.opt.val);
+    opt.opt.val = val;
+    return transport_opt_set(id, &opt);
+}
+
+static uint32_t sar_session_tx_len(uint16_t dst, uint32_t len)
+{
+    static uint8_t data[64];
+    static nrf_mesh_network_secmat_t net_secmat;
+    TEST_ASSERT_TRUE(len <= sizeof(data));
+    transport_control_packet_t control_packet;
+    control_packet.data_len           = len;
+    control_packet.dst.p_virtual_uuid = NULL;
+    control_packet.dst.value          = dst;
+    control_packet.dst.type           = NRF_MESH_ADDRESS_TYPE_UNICAST;
+    control_packet.opcode             = TRANSPORT_CONTROL_OPCODE_HEARTBEAT;
+    control_packet.p_data             = (const packet_mesh_trs_control_packet_t *) data;
+    control_packet.p_net_secmat       = &net_secmat;
+    control_packet.reliable           = true;
+    control_packet.src                = 0x0100;
+    control_packet.ttl                = 9;
+    return transport_control_tx(&control_packet, TX_TOKEN);
+}
+
+static uint32_t sar_session_tx(uint16_t dst)
+{
+    return sar_session_tx_len(dst, 16);
+}
+
+void test_sar_session_admission(void)
+{
+    TEST_ASSERT_TRUE(TRANSPORT_SAR_SESSIONS_MAX >= 3);
+
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_buffer_alloc, sar_buffer_release));
+    m_sar_buffers_allocated = 0;
+
+    /* The sessions are created, but the segments can't be sent yet: */
+    net_state_iv_index_lock_Ignore();
+    net_state_seqnum_reserve_IgnoreAndReturn(NRF_SUCCESS);
+    net_state_seqnum_unreserve_Ignore();
+    net_state_tx_iv_index_get_IgnoreAndReturn(0);
+    network_packet_alloc_reserved_IgnoreAndReturn(NRF_ERROR_NO_MEM);
+    timer_now_IgnoreAndReturn(0);
+    timer_sch_reschedule_Ignore();
+
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_SESSIONS_PER_PEER_MAX_DEFAULT, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_PER_PEER_MAX));
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_SESSIONS_RX_RESERVED_DEFAULT, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_RX_RESERVED));
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_PER_PEER_MAX, 0));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_PER_PEER_MAX, TRANSPORT_SAR_SESSIONS_MAX + 1));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_RX_RESERVED, TRANSPORT_SAR_SESSIONS_MAX));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE, 0));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_QUOTA, 1));
+
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_PER_PEER_MAX, 1));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_RX_RESERVED, 1));
+
+    /* Only one session per peer: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0001));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, sar_session_tx(0x0001));
+    TEST_ASSERT_EQUAL(1, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+    TEST_ASSERT_EQUAL(1, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_QUOTA));
+
+    /* TX can't take the last session: */
+    for (uint32_t i = 1; i < TRANSPORT_SAR_SESSIONS_MAX - 1; ++i)
+    {
+        TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0001 + i));
+    }
+    TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, sar_session_tx(0x0001 + TRANSPORT_SAR_SESSIONS_MAX));
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_SESSIONS_MAX - 1, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+    TEST_ASSERT_EQUAL(2, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_QUOTA));
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_NO_MEM));
+
+    /* Without the reservation, TX can use all sessions: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_RX_RESERVED, 0));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0001 + TRANSPORT_SAR_SESSIONS_MAX));
+    TEST_ASSERT_EQUAL(NRF_ERROR_NO_MEM, sar_session_tx(0x0002 + TRANSPORT_SAR_SESSIONS_MAX));
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_SESSIONS_MAX, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_SESSIONS_MAX, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_PEAK));
+    TEST_ASSERT_EQUAL(1, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_NO_MEM));
+
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_NO_MEM, 0));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_QUOTA, 0));
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_NO_MEM));
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_REJECTED_QUOTA));
+
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_SESSIONS_MAX, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_PEAK));
+
+    /* Reinitializing frees all sessions: */
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_buffer_alloc, sar_buffer_release));
+    m_sar_buffers_allocated = 0;
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_PEAK));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0001));
+    TEST_ASSERT_EQUAL(1, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+}
+
+static timestamp_t m_time_now;
+static timer_event_t * mp_retry_timer;
+static uint32_t m_next_seqnum;
+static uint32_t m_seqnum_reservations;
+static uint32_t m_segments_sent;
+static core_tx_bearer_bitmap_t m_segment_bearers = 0x1;
+
+static timestamp_t timer_now_callback(int calls)
+{
+    return m_time_now;
+}
+
+static void timer_sch_reschedule_callback(timer_event_t * p_timer_evt, timestamp_t new_timeout, int calls)
+{
+    mp_retry_timer = p_timer_evt;
+}
+
+static uint32_t seqnum_reserve_callback(uint32_t count, uint32_t * p_first_seqnum, int calls)
+{
+    TEST_ASSERT_TRUE(count > 0 && count <= NETWORK_SEQNUM_RESERVE_MAX);
+    *p_first_seqnum = m_next_seqnum;
+    m_next_seqnum += count;
+    m_seqnum_reservations++;
+    return NRF_SUCCESS;
+}
+
+static void seqnum_unreserve_callback(uint32_t first_seqnum, uint32_t count, int calls)
+{
+    TEST_ASSERT_EQUAL(m_next_seqnum, first_seqnum + count);
+    m_next_seqnum = first_seqnum;
+}
+
+static uint32_t sar_segment_no_mem_callback(network_tx_packet_buffer_t * p_buf, int calls)
+{
+    return NRF_ERROR_NO_MEM;
+}
+
+static uint32_t sar_segment_alloc_callback(network_tx_packet_buffer_t * p_buf, int calls)
+{
+    static uint8_t network_packet_buffer[32];
+    /* Segments are numbered from the reservation, in order: */
+    TEST_ASSERT_TRUE(p_buf->user_data.p_metadata->internal.sequence_number < m_next_seqnum);
+    p_buf->role      = CORE_TX_ROLE_ORIGINATOR;
+    p_buf->p_payload = network_packet_buffer;
+    p_buf->bearers   = m_segment_bearers;
+    m_segments_sent++;
+    return NRF_SUCCESS;
+}
+
+static void sar_segack_rx_from(uint16_t src, uint16_t seq_zero, uint32_t block_ack)
+{
+    packet_mesh_trs_packet_t transport_packet;
+    memset(&transport_packet, 0, sizeof(transport_packet));
+    packet_mesh_trs_common_seg_set(&transport_packet, false);
+    packet_mesh_trs_control_opcode_set(&transport_packet, TRANSPORT_CONTROL_OPCODE_SEGACK);
+    packet_mesh_trs_control_packet_t * p_segack =
+        (packet_mesh_trs_control_packet_t *) packet_mesh_trs_unseg_payload_get(&transport_packet);
+    packet_mesh_trs_control_segack_seqzero_set(p_segack, seq_zero);
+    packet_mesh_trs_control_segack_block_ack_set(p_segack, block_ack);
+
+    nrf_mesh_address_t dst = {NRF_MESH_ADDRESS_TYPE_UNICAST, 0x0100, NULL};
+    network_packet_metadata_t net_meta;
+    memset(&net_meta, 0, sizeof(net_meta));
+    net_meta.dst = dst;
+    net_meta.src = src;
+    net_meta.ttl = 9;
+    net_meta.control_packet = true;
+    net_meta.p_security_material = &m_net_secmat;
+
+    nrf_mesh_rx_address_get_ExpectAndReturn(0x0100, NULL, true);
+    nrf_mesh_rx_address_get_IgnoreArg_p_address();
+    nrf_mesh_rx_address_get_ReturnThruPtr_p_address(&dst);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS,
+                      transport_packet_in(&transport_packet,
+                                          PACKET_MESH_TRS_UNSEG_PDU_OFFSET + PACKET_MESH_TRS_CONTROL_SEGACK_SIZE,
+                                          &net_meta,
+                                          &m_rx_meta));
+}
+
+static void sar_segack_rx(uint16_t seq_zero, uint32_t block_ack)
+{
+    sar_segack_rx_from(0x0002, seq_zero, block_ack);
+}
+
+void test_sar_tx_adaptive_retry(void)
+{
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_buffer_alloc, sar_buffer_release));
+    m_sar_buffers_allocated = 0;
+
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_TX_RETRY_ADAPTIVE_DEFAULT, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_TX_RETRY_ADAPTIVE));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_TX_RETRY_ADAPTIVE, 2));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_TX_RETRY_ADAPTIVE, 1));
+
+    net_state_iv_index_lock_Ignore();
+    replay_cache_has_elem_IgnoreAndReturn(false);
+    replay_cache_add_IgnoreAndReturn(NRF_SUCCESS);
+    net_state_seqnum_reserve_StubWithCallback(seqnum_reserve_callback);
+    net_state_tx_iv_index_get_IgnoreAndReturn(0);
+    network_packet_alloc_reserved_StubWithCallback(sar_segment_alloc_callback);
+    network_packet_send_Ignore();
+    timer_now_StubWithCallback(timer_now_callback);
+    timer_sch_reschedule_StubWithCallback(timer_sch_reschedule_callback);
+    timer_sch_abort_Ignore();
+    event_handle_Ignore();
+
+    /* Without any samples, the timeout is based on the TTL: */
+    m_time_now = 1000;
+    m_next_seqnum = 0x10;
+    m_seqnum_reservations = 0;
+    m_segments_sent = 0;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0002));
+    TEST_ASSERT_EQUAL(2, m_segments_sent);
+    /* Both segments are numbered from a single reservation: */
+    TEST_ASSERT_EQUAL(1, m_seqnum_reservations);
+    TEST_ASSERT_EQUAL(0x12, m_next_seqnum);
+    TEST_ASSERT_NOT_NULL(mp_retry_timer);
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_TX_RETRY_BASE_TIMEOUT_DEFAULT_US +
+                      9 * TRANSPORT_SAR_TX_RETRY_PER_HOP_ADDITION_DEFAULT_US,
+                      mp_retry_timer->interval);
+
+    /* The first ack gives an RTT sample of 300 ms, and the lost segment is retransmitted: */
+    m_time_now += MS_TO_US(300);
+    sar_segack_rx(0x10, 0x1);
+    TEST_ASSERT_EQUAL(3, m_segments_sent);
+    TEST_ASSERT_EQUAL(MS_TO_US(300) + 4 * MS_TO_US(150), mp_retry_timer->interval);
+
+    /* An ack that doesn't report any progress right after the retransmission is ignored: */
+    m_time_now += MS_TO_US(10);
+    sar_segack_rx(0x10, 0x1);
+    TEST_ASSERT_EQUAL(3, m_segments_sent);
+
+    m_time_now += MS_TO_US(100);
+    sar_segack_rx(0x10, 0x3);
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+
+    /* The next session to the same destination starts out with the estimated timeout, and backs
+     * off on every retry: */
+    m_next_seqnum = 0x20;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0002));
+    TEST_ASSERT_EQUAL(5, m_segments_sent);
+    TEST_ASSERT_EQUAL(MS_TO_US(900), mp_retry_timer->interval);
+    mp_retry_timer->cb(m_time_now, mp_retry_timer->p_context);
+    TEST_ASSERT_EQUAL(7, m_segments_sent);
+    TEST_ASSERT_EQUAL(MS_TO_US(1800), mp_retry_timer->interval);
+    mp_retry_timer->cb(m_time_now, mp_retry_timer->p_context);
+    TEST_ASSERT_EQUAL(MS_TO_US(3600), mp_retry_timer->interval);
+    mp_retry_timer->cb(m_time_now, mp_retry_timer->p_context);
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_TX_RETRY_ADAPTIVE_MAX_US, mp_retry_timer->interval);
+
+    /* Samples from retransmitted segments are ambiguous, and don't update the estimate: */
+    m_time_now += MS_TO_US(50);
+    sar_segack_rx(0x20, 0x3);
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+    m_next_seqnum = 0x30;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0002));
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_TX_RETRY_ADAPTIVE_MAX_US, mp_retry_timer->interval);
+
+    /* Other destinations aren't affected: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0003));
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_TX_RETRY_BASE_TIMEOUT_DEFAULT_US +
+                      9 * TRANSPORT_SAR_TX_RETRY_PER_HOP_ADDITION_DEFAULT_US,
+                      mp_retry_timer->interval);
+}
+
+void test_sar_tx_adaptive_retry_enabled_mid_session(void)
+{
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_buffer_alloc, sar_buffer_release));
+    m_sar_buffers_allocated = 0;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_TX_RETRY_ADAPTIVE, 0));
+
+    net_state_iv_index_lock_Ignore();
+    replay_cache_has_elem_IgnoreAndReturn(false);
+    replay_cache_add_IgnoreAndReturn(NRF_SUCCESS);
+    net_state_seqnum_reserve_StubWithCallback(seqnum_reserve_callback);
+    net_state_tx_iv_index_get_IgnoreAndReturn(0);
+    network_packet_alloc_reserved_StubWithCallback(sar_segment_alloc_callback);
+    network_packet_send_Ignore();
+    timer_now_StubWithCallback(timer_now_callback);
+    timer_sch_reschedule_StubWithCallback(timer_sch_reschedule_callback);
+    timer_sch_abort_Ignore();
+    event_handle_Ignore();
+
+    m_time_now = MS_TO_US(5000);
+    m_next_seqnum = 0x40;
+    m_seqnum_reservations = 0;
+    m_segments_sent = 0;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0004));
+    TEST_ASSERT_EQUAL(2, m_segments_sent);
+
+    /* The ack for a session started before adaptive mode was enabled still gives the right sample: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_TX_RETRY_ADAPTIVE, 1));
+    m_time_now += MS_TO_US(200);
+    uint32_t sessions_active = sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE);
+    sar_segack_rx_from(0x0004, 0x40, 0x3);
+    TEST_ASSERT_EQUAL(sessions_active - 1, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+
+    m_next_seqnum = 0x50;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0004));
+    TEST_ASSERT_EQUAL(MS_TO_US(200) + 4 * MS_TO_US(100), mp_retry_timer->interval);
+}
+
+void test_sar_tx_no_mem_seqnum(void)
+{
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_buffer_alloc, sar_buffer_release));
+    m_sar_buffers_allocated = 0;
+
+    net_state_iv_index_lock_Ignore();
+    net_state_seqnum_reserve_StubWithCallback(seqnum_reserve_callback);
+    net_state_seqnum_unreserve_StubWithCallback(seqnum_unreserve_callback);
+    net_state_tx_iv_index_get_IgnoreAndReturn(0);
+    network_packet_alloc_reserved_StubWithCallback(sar_segment_no_mem_callback);
+    network_packet_send_Ignore();
+    timer_now_StubWithCallback(timer_now_callback);
+    timer_sch_reschedule_StubWithCallback(timer_sch_reschedule_callback);
+
+    /* The TX queue is full, so the reserved sequence numbers are all handed back: */
+    m_time_now = 1000;
+    m_next_seqnum = 0x10;
+    m_seqnum_reservations = 0;
+    m_segments_sent = 0;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0002));
+    TEST_ASSERT_EQUAL(1, m_seqnum_reservations);
+    TEST_ASSERT_EQUAL(0x10, m_next_seqnum);
+
+    mp_retry_timer->cb(m_time_now, mp_retry_timer->p_context);
+    TEST_ASSERT_EQUAL(2, m_seqnum_reservations);
+    TEST_ASSERT_EQUAL(0x10, m_next_seqnum);
+
+    /* Once there's room, the segments are numbered from where the reservations started: */
+    network_packet_alloc_reserved_StubWithCallback(sar_segment_alloc_callback);
+    mp_retry_timer->cb(m_time_now, mp_retry_timer->p_context);
+    TEST_ASSERT_EQUAL(2, m_segments_sent);
+    TEST_ASSERT_EQUAL(0x12, m_next_seqnum);
+}
+
+static uint32_t m_critical_section_depth;
+
+static void critical_section_begin_callback(int calls)
+{
+    m_critical_section_depth++;
+}
+
+static void critical_section_end_callback(int calls)
+{
+    TEST_ASSERT_TRUE(m_critical_section_depth > 0);
+    m_critical_section_depth--;
+}
+
+static uint32_t sar_segment_critical_alloc_callback(network_tx_packet_buffer_t * p_buf, int calls)
+{
+    TEST_ASSERT_TRUE(m_critical_section_depth > 0);
+    return sar_segment_alloc_callback(p_buf, calls);
+}
+
+void test_sar_tx_critical_section(void)
+{
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_buffer_alloc, sar_buffer_release));
+    m_sar_buffers_allocated = 0;
+
+    bearer_event_critical_section_begin_StubWithCallback(critical_section_begin_callback);
+    bearer_event_critical_section_end_StubWithCallback(critical_section_end_callback);
+    net_state_iv_index_lock_Ignore();
+    replay_cache_has_elem_IgnoreAndReturn(false);
+    replay_cache_add_IgnoreAndReturn(NRF_SUCCESS);
+    net_state_seqnum_reserve_StubWithCallback(seqnum_reserve_callback);
+    net_state_tx_iv_index_get_IgnoreAndReturn(0);
+    network_packet_alloc_reserved_StubWithCallback(sar_segment_critical_alloc_callback);
+    network_packet_send_Ignore();
+    timer_now_StubWithCallback(timer_now_callback);
+    timer_sch_reschedule_StubWithCallback(timer_sch_reschedule_callback);
+
+    /* Segments sent from the application can't interleave with the SAR processing in the bearer
+     * event handler: */
+    m_critical_section_depth = 0;
+    m_next_seqnum = 0x60;
+    m_segments_sent = 0;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx(0x0005));
+    TEST_ASSERT_EQUAL(2, m_segments_sent);
+    TEST_ASSERT_EQUAL(0, m_critical_section_depth);
+
+    mp_retry_timer->cb(m_time_now, mp_retry_timer->p_context);
+    TEST_ASSERT_EQUAL(4, m_segments_sent);
+    TEST_ASSERT_EQUAL(0, m_critical_section_depth);
+}
+
+static core_tx_complete_cb_t m_tx_complete_cb;
+static bearer_event_flag_callback_t m_sar_process_cb;
+static uint16_t m_sent_segment_dsts[16];
+static nrf_mesh_tx_token_t m_sent_segment_token;
+
+static void core_tx_complete_cb_set_callback(core_tx_complete_cb_t tx_complete_callback, int calls)
+{
+    m_tx_complete_cb = tx_complete_callback;
+}
+
+static bearer_event_flag_t bearer_event_flag_add_callback(bearer_event_flag_callback_t callback, int calls)
+{
+    m_sar_process_cb = callback;
+    return BEARER_FLAG;
+}
+
+static uint32_t sar_segment_record_alloc_callback(network_tx_packet_buffer_t * p_buf, int calls)
+{
+    TEST_ASSERT_TRUE(m_segments_sent < ARRAY_SIZE(m_sent_segment_dsts));
+    m_sent_segment_dsts[m_segments_sent] = p_buf->user_data.p_metadata->dst.value;
+    m_sent_segment_token = p_buf->user_data.token;
+    return sar_segment_alloc_callback(p_buf, calls);
+}
+
+static void sar_segments_complete(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_tx_complete_cb(CORE_TX_ROLE_ORIGINATOR, 0, 0, m_sent_segment_token);
+    }
+    TEST_ASSERT_TRUE(m_sar_process_cb());
+}
+
+void test_sar_tx_window(void)
+{
+    replay_cache_init_Expect();
+    bearer_event_flag_add_StubWithCallback(bearer_event_flag_add_callback);
+    core_tx_complete_cb_set_StubWithCallback(core_tx_complete_cb_set_callback);
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_buffer_alloc, sar_buffer_release));
+    m_sar_buffers_allocated = 0;
+
+    bearer_event_flag_set_Ignore();
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_TX_WINDOW_DEFAULT, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_TX_WINDOW));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_TX_WINDOW, 0));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_TX_WINDOW, 32 * TRANSPORT_SAR_SESSIONS_MAX + 1));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_TX_WINDOW, 2));
+
+    net_state_iv_index_lock_Ignore();
+    net_state_seqnum_reserve_StubWithCallback(seqnum_reserve_callback);
+    net_state_tx_iv_index_get_IgnoreAndReturn(0);
+    network_packet_alloc_reserved_StubWithCallback(sar_segment_record_alloc_callback);
+    network_packet_send_Ignore();
+    timer_now_IgnoreAndReturn(0);
+    timer_sch_reschedule_Ignore();
+    m_next_seqnum = 0x10;
+    m_segments_sent = 0;
+
+    /* The first session fills the window, and the second one has to wait: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx_len(0x0002, 32));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx_len(0x0003, 32));
+    TEST_ASSERT_EQUAL(2, m_segments_sent);
+
+    /* The sessions take turns as the segments are sent: */
+    sar_segments_complete(2);
+    TEST_ASSERT_EQUAL(4, m_segments_sent);
+    sar_segments_complete(1);
+    TEST_ASSERT_EQUAL(5, m_segments_sent);
+    sar_segments_complete(1);
+    TEST_ASSERT_EQUAL(6, m_segments_sent);
+    sar_segments_complete(2);
+    TEST_ASSERT_EQUAL(8, m_segments_sent);
+    sar_segments_complete(2);
+    TEST_ASSERT_EQUAL(8, m_segments_sent);
+
+    const uint16_t expected_dsts[] = {0x0002, 0x0002, 0x0002, 0x0003, 0x0002, 0x0003, 0x0003, 0x0003};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected_dsts, m_sent_segment_dsts, ARRAY_SIZE(expected_dsts));
+
+    /* TX completes from bearers the segments weren't queued on don't open the window: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx_len(0x0004, 32));
+    TEST_ASSERT_EQUAL(10, m_segments_sent);
+    m_tx_complete_cb(CORE_TX_ROLE_ORIGINATOR, 1, 0, m_sent_segment_token);
+    m_tx_complete_cb(CORE_TX_ROLE_ORIGINATOR, 1, 0, m_sent_segment_token);
+    TEST_ASSERT_TRUE(m_sar_process_cb());
+    TEST_ASSERT_EQUAL(10, m_segments_sent);
+    sar_segments_complete(2);
+    TEST_ASSERT_EQUAL(12, m_segments_sent);
+
+    /* With two bearers, a segment is only done once both of them have sent it: */
+    m_segment_bearers = 0x3;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_tx_len(0x0005, 32));
+    sar_segments_complete(2);
+    TEST_ASSERT_EQUAL(14, m_segments_sent);
+    sar_segments_complete(2);
+    TEST_ASSERT_EQUAL(14, m_segments_sent);
+    m_tx_complete_cb(CORE_TX_ROLE_ORIGINATOR, 1, 0, m_sent_segment_token);
+    TEST_ASSERT_TRUE(m_sar_process_cb());
+    TEST_ASSERT_EQUAL(15, m_segments_sent);
+    m_segment_bearers = 0x1;
+}
+
+static void * sar_rx_buffer_alloc(size_t size)
+{
+    /* Large enough for a control message with the maximum number of segments. */
+    static uint8_t buffer[32 * PACKET_MESH_TRS_SEG_CONTROL_PDU_MAX_SIZE];
+    TEST_ASSERT_TRUE(size <= sizeof(buffer));
+    return buffer;
+}
+
+static bool rx_address_get_group_callback(uint16_t address, nrf_mesh_address_t * p_address, int calls)
+{
+    p_address->type = NRF_MESH_ADDRESS_TYPE_GROUP;
+    p_address->value = address;
+    p_address->p_virtual_uuid = NULL;
+    return true;
+}
+
+/* Receive a single segment control message sent to a group address. */
+static void sar_segment_rx(uint16_t src, uint32_t iv_index, uint32_t seqnum, uint16_t seq_zero)
+{
+    packet_mesh_trs_packet_t transport_packet;
+    memset(&transport_packet, 0, sizeof(transport_packet));
+    packet_mesh_trs_common_seg_set(&transport_packet, true);
+    packet_mesh_trs_control_opcode_set(&transport_packet, TRANSPORT_CONTROL_OPCODE_HEARTBEAT);
+    packet_mesh_trs_seg_seqzero_set(&transport_packet, seq_zero);
+    packet_mesh_trs_seg_sego_set(&transport_packet, 0);
+    packet_mesh_trs_seg_segn_set(&transport_packet, 0);
+
+    network_packet_metadata_t net_meta;
+    memset(&net_meta, 0, sizeof(net_meta));
+    net_meta.dst.type = NRF_MESH_ADDRESS_TYPE_GROUP;
+    net_meta.dst.value = 0xC001;
+    net_meta.src = src;
+    net_meta.ttl = 9;
+    net_meta.control_packet = true;
+    net_meta.internal.iv_index = iv_index;
+    net_meta.internal.sequence_number = seqnum;
+    net_meta.p_security_material = &m_net_secmat;
+
+    TEST_ASSERT_EQUAL(NRF_SUCCESS,
+                      transport_packet_in(&transport_packet,
+                                          PACKET_MESH_TRS_SEG_PDU_OFFSET + 4,
+                                          &net_meta,
+                                          &m_rx_meta));
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+}
+
+static void sar_rx_cache_counters_check(uint32_t hits, uint32_t misses)
+{
+    TEST_ASSERT_EQUAL(hits, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_RX_CACHE_HITS));
+    TEST_ASSERT_EQUAL(misses, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_RX_CACHE_MISSES));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_RX_CACHE_HITS, 0));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_RX_CACHE_MISSES, 0));
+}
+
+void test_sar_rx_cache(void)
+{
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_rx_buffer_alloc, sar_buffer_release));
+
+    replay_cache_has_elem_IgnoreAndReturn(false);
+    replay_cache_add_IgnoreAndReturn(NRF_SUCCESS);
+    nrf_mesh_rx_address_get_StubWithCallback(rx_address_get_group_callback);
+    net_state_iv_index_lock_Ignore();
+    timer_now_IgnoreAndReturn(0);
+    timer_sch_reschedule_Ignore();
+    timer_sch_abort_Ignore();
+
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_RX_CACHE_HITS, 1));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_RX_CACHE_MISSES, 1));
+
+    /* Retransmitted segments of a completed session hit the cache: */
+    sar_segment_rx(0x0004, 0, 0x100, 0x100);
+    sar_rx_cache_counters_check(0, 1);
+    sar_segment_rx(0x0004, 0, 0x101, 0x100);
+    sar_segment_rx(0x0004, 0, 0x102, 0x100);
+    sar_rx_cache_counters_check(2, 0);
+
+    /* The IV index is compared in full, not just the IVI bit: */
+    sar_segment_rx(0x0004, 2, 0x101, 0x100);
+    sar_rx_cache_counters_check(0, 1);
+
+    /* Fill the cache: */
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_rx_buffer_alloc, sar_buffer_release));
+    for (uint32_t i = 0; i < TRANSPORT_SAR_RX_CACHE_LEN; ++i)
+    {
+        sar_segment_rx(0x0010 + i, 0, 0x100, 0x100);
+    }
+    sar_rx_cache_counters_check(0, TRANSPORT_SAR_RX_CACHE_LEN);
+
+    /* A session that's far enough ahead of the last one from the same source expires it, and takes
+     * its place without evicting the oldest session: */
+    const uint16_t last_src = 0x0010 + TRANSPORT_SAR_RX_CACHE_LEN - 1;
+    const uint32_t next_seqnum = 0x100 + TRANSPORT_SAR_SEQNUM_DIFF_MAX + 1;
+    sar_segment_rx(last_src, 0, next_seqnum, next_seqnum & TRANSPORT_SAR_SEQNUM_DIFF_MAX);
+    sar_rx_cache_counters_check(0, 1);
+    for (uint32_t i = 0; i < TRANSPORT_SAR_RX_CACHE_LEN - 1; ++i)
+    {
+        sar_segment_rx(0x0010 + i, 0, 0x101, 0x100);
+    }
+    sar_segment_rx(last_src, 0, next_seqnum + 1, next_seqnum & TRANSPORT_SAR_SEQNUM_DIFF_MAX);
+    sar_rx_cache_counters_check(TRANSPORT_SAR_RX_CACHE_LEN, 0);
+
+    /* Without expired sessions, a new session evicts the oldest one: */
+    sar_segment_rx(0x0100, 0, 0x100, 0x100);
+    sar_segment_rx(0x0010, 0, 0x102, 0x100);
+    sar_rx_cache_counters_check(0, 2);
+    sar_segment_rx(0x0100, 0, 0x101, 0x100);
+    sar_rx_cache_counters_check(1, 0);
+}
+
+#define STREAM_MESSAGE_LEN  (37)
+#define STREAM_KEYSTREAM    (0x5A)
+
+static nrf_mesh_application_secmat_t m_stream_app_secmat;
+static uint32_t m_keystream_calls;
+static uint16_t m_keystream_offsets[4];
+static uint16_t m_keystream_lengths[4];
+
+static void app_secmat_next_get_single_callback(const nrf_mesh_network_secmat_t * p_network_secmat,
+                                                uint8_t aid,
+                                                const nrf_mesh_application_secmat_t ** pp_app_secmat,
+                                                int calls)
+{
+    TEST_ASSERT_EQUAL(m_stream_app_secmat.aid, aid);
+    *pp_app_secmat = (*pp_app_secmat == NULL) ? &m_stream_app_secmat : NULL;
+}
+
+static void keystream_apply_callback(const ccm_soft_data_t * const p_ccm_data,
+                                     uint16_t offset,
+                                     ccm_soft_keystream_t * p_keystream,
+                                     int calls)
+{
+    TEST_ASSERT_TRUE(m_keystream_calls < ARRAY_SIZE(m_keystream_offsets));
+    TEST_ASSERT_EQUAL_PTR(m_stream_app_secmat.key, p_ccm_data->p_key);
+    m_keystream_offsets[m_keystream_calls] = offset;
+    m_keystream_lengths[m_keystream_calls] = p_ccm_data->m_len;
+    m_keystream_calls++;
+    for (uint32_t i = 0; i < p_ccm_data->m_len; ++i)
+    {
+        p_ccm_data->p_out[i] = p_ccm_data->p_m[i] ^ STREAM_KEYSTREAM;
+    }
+}
+
+static void decrypted_authenticate_callback(const ccm_soft_data_t * const p_ccm_data, bool * const p_mic_passed, int calls)
+{
+    TEST_ASSERT_EQUAL(STREAM_MESSAGE_LEN, p_ccm_data->m_len);
+    TEST_ASSERT_EQUAL(PACKET_MESH_TRS_TRANSMIC_SMALL_SIZE, p_ccm_data->mic_len);
+    TEST_ASSERT_EQUAL_PTR(&p_ccm_data->p_m[STREAM_MESSAGE_LEN], p_ccm_data->p_mic);
+    for (uint32_t i = 0; i < p_ccm_data->m_len; ++i)
+    {
+        TEST_ASSERT_EQUAL_HEX8(i, p_ccm_data->p_m[i]);
+    }
+    *p_mic_passed = true;
+}
+
+static void message_received_callback(const nrf_mesh_evt_t * p_evt, int calls)
+{
+    TEST_ASSERT_EQUAL(NRF_MESH_EVT_MESSAGE_RECEIVED, p_evt->type);
+    TEST_ASSERT_EQUAL(STREAM_MESSAGE_LEN, p_evt->params.message.length);
+    TEST_ASSERT_EQUAL_PTR(&m_stream_app_secmat, p_evt->params.message.secmat.p_app);
+    for (uint32_t i = 0; i < STREAM_MESSAGE_LEN; ++i)
+    {
+        TEST_ASSERT_EQUAL_HEX8(i, p_evt->params.message.p_buffer[i]);
+    }
+}
+
+static void access_segment_rx(uint8_t segment_offset, uint8_t last_segment, uint32_t message_len)
+{
+    packet_mesh_trs_packet_t transport_packet;
+    memset(&transport_packet, 0, sizeof(transport_packet));
+    packet_mesh_trs_common_seg_set(&transport_packet, true);
+    packet_mesh_trs_access_akf_set(&transport_packet, true);
+    packet_mesh_trs_access_aid_set(&transport_packet, m_stream_app_secmat.aid);
+    packet_mesh_trs_seg_szmic_set(&transport_packet, 0);
+    packet_mesh_trs_seg_seqzero_set(&transport_packet, 0x100);
+    packet_mesh_trs_seg_sego_set(&transport_packet, segment_offset);
+    packet_mesh_trs_seg_segn_set(&transport_packet, last_segment);
+
+    /* The encrypted message is the byte index XORed with the keystream, and the MIC is left as is: */
+    uint32_t total_len = message_len + PACKET_MESH_TRS_TRANSMIC_SMALL_SIZE;
+    uint32_t segment_len = 0;
+    for (uint32_t i = segment_offset * 12; i < total_len && segment_len < 12; ++i, ++segment_len)
+    {
+        transport_packet.pdu[PACKET_MESH_TRS_SEG_PDU_OFFSET + segment_len] =
+            (i < message_len) ? (i ^ STREAM_KEYSTREAM) : 0xFF;
+    }
+
+    network_packet_metadata_t net_meta;
+    memset(&net_meta, 0, sizeof(net_meta));
+    net_meta.dst.type = NRF_MESH_ADDRESS_TYPE_GROUP;
+    net_meta.dst.value = 0xC001;
+    net_meta.src = 0x0004;
+    net_meta.ttl = 9;
+    net_meta.control_packet = false;
+    net_meta.internal.sequence_number = 0x100 + segment_offset;
+    net_meta.p_security_material = &m_net_secmat;
+
+    TEST_ASSERT_EQUAL(NRF_SUCCESS,
+                      transport_packet_in(&transport_packet,
+                                          PACKET_MESH_TRS_SEG_PDU_OFFSET + segment_len,
+                                          &net_meta,
+                                          &m_rx_meta));
+}
+
+void test_sar_rx_decrypt_streaming(void)
+{
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_rx_buffer_alloc, sar_buffer_release));
+
+    replay_cache_has_elem_IgnoreAndReturn(false);
+    replay_cache_add_IgnoreAndReturn(NRF_SUCCESS);
+    nrf_mesh_rx_address_get_StubWithCallback(rx_address_get_group_callback);
+    net_state_iv_index_lock_Ignore();
+    timer_now_IgnoreAndReturn(0);
+    timer_sch_reschedule_Ignore();
+    timer_sch_abort_Ignore();
+
+    m_stream_app_secmat.aid = 0x15;
+    m_keystream_calls = 0;
+    nrf_mesh_app_secmat_next_get_StubWithCallback(app_secmat_next_get_single_callback);
+    enc_nonce_generate_ExpectAnyArgs();
+    enc_aes_ccm_keystream_apply_StubWithCallback(keystream_apply_callback);
+
+    /* All but the last two segments are decrypted as they arrive: */
+    const uint8_t last_segment = (STREAM_MESSAGE_LEN + PACKET_MESH_TRS_TRANSMIC_SMALL_SIZE - 1) / 12;
+    TEST_ASSERT_EQUAL(3, last_segment);
+    access_segment_rx(1, last_segment, STREAM_MESSAGE_LEN);
+    TEST_ASSERT_EQUAL(1, m_keystream_calls);
+    access_segment_rx(0, last_segment, STREAM_MESSAGE_LEN);
+    TEST_ASSERT_EQUAL(2, m_keystream_calls);
+    access_segment_rx(3, last_segment, STREAM_MESSAGE_LEN);
+    TEST_ASSERT_EQUAL(2, m_keystream_calls);
+
+    /* The rest is decrypted and authenticated when the message is complete: */
+    enc_aes_ccm_decrypted_authenticate_StubWithCallback(decrypted_authenticate_callback);
+    event_handle_StubWithCallback(message_received_callback);
+    access_segment_rx(2, last_segment, STREAM_MESSAGE_LEN);
+    TEST_ASSERT_EQUAL(3, m_keystream_calls);
+
+    const uint16_t expected_offsets[] = {12, 0, 24};
+    const uint16_t expected_lengths[] = {12, 12, STREAM_MESSAGE_LEN - 24};
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected_offsets, m_keystream_offsets, ARRAY_SIZE(expected_offsets));
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected_lengths, m_keystream_lengths, ARRAY_SIZE(expected_lengths));
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+}
+
+#define TRIAL_AID           (0x2C)
+#define TRIAL_APP_KEY_COUNT (3)
+/* More labels with the same virtual address hash than fit in one batch in the transport layer. */
+#define TRIAL_LABEL_COUNT   (6)
+#define TRIAL_VIRTUAL_ADDR  (0x8123)
+
+static nrf_mesh_application_secmat_t m_trial_app_secmats[TRIAL_APP_KEY_COUNT];
+static uint8_t m_trial_labels[TRIAL_LABEL_COUNT][NRF_MESH_UUID_SIZE];
+static const nrf_mesh_application_secmat_t * mp_trial_app_secmat_match;
+static const uint8_t * mp_trial_label_match;
+static uint32_t m_trial_decrypt_calls;
+static uint32_t m_trial_label_counts[TRIAL_APP_KEY_COUNT * TRIAL_LABEL_COUNT];
+static uint32_t m_trial_messages;
+
+/* Returns the application keys with the AID one by one, like the AID index in the DSM. */
+static void app_secmat_next_get_trial_callback(const nrf_mesh_network_secmat_t * p_network_secmat,
+                                               uint8_t aid,
+                                               const nrf_mesh_application_secmat_t ** pp_app_secmat,
+                                               int calls)
+{
+    TEST_ASSERT_EQUAL_PTR(&m_net_secmat, p_network_secmat);
+    TEST_ASSERT_EQUAL_HEX8(TRIAL_AID, aid);
+
+    uint32_t next = 0;
+    if (*pp_app_secmat != NULL)
+    {
+        next = (*pp_app_secmat - &m_trial_app_secmats[0]) + 1;
+    }
+    *pp_app_secmat = (next < TRIAL_APP_KEY_COUNT) ? &m_trial_app_secmats[next] : NULL;
+}
+
+/* Returns the labels with the virtual address hash one by one. */
+static bool rx_address_get_virtual_callback(uint16_t address, nrf_mesh_address_t * p_address, int calls)
+{
+    TEST_ASSERT_EQUAL_HEX16(TRIAL_VIRTUAL_ADDR, address);
+
+    uint32_t next = 0;
+    if (p_address->p_virtual_uuid != NULL)
+    {
+        next = (p_address->p_virtual_uuid - m_trial_labels[0]) / NRF_MESH_UUID_SIZE + 1;
+    }
+    if (next >= TRIAL_LABEL_COUNT)
+    {
+        return false;
+    }
+
+    p_address->type = NRF_MESH_ADDRESS_TYPE_VIRTUAL;
+    p_address->value = address;
+    p_address->p_virtual_uuid = m_trial_labels[next];
+    return true;
+}
+
+static uint32_t decrypt_ad_candidates_trial_callback(ccm_soft_data_t * const p_ccm_data,
+                                                     const uint8_t * const * pp_a,
+                                                     uint32_t a_count,
+                                                     int calls)
+{
+    TEST_ASSERT_TRUE(m_trial_decrypt_calls < ARRAY_SIZE(m_trial_label_counts));
+    TEST_ASSERT_EQUAL(NRF_MESH_UUID_SIZE, p_ccm_data->a_len);
+    /* Every batch of labels is tried with all the keys, in the order the DSM returns them: */
+    TEST_ASSERT_EQUAL_PTR(m_trial_app_secmats[m_trial_decrypt_calls % TRIAL_APP_KEY_COUNT].key, p_ccm_data->p_key);
+    m_trial_label_counts[m_trial_decrypt_calls++] = a_count;
+
+    for (uint32_t i = 0; i < a_count; ++i)
+    {
+        if (mp_trial_app_secmat_match != NULL &&
+            p_ccm_data->p_key == mp_trial_app_secmat_match->key &&
+            pp_a[i] == mp_trial_label_match)
+        {
+            return i;
+        }
+    }
+    return a_count;
+}
+
+static void decrypt_trial_callback(ccm_soft_data_t * const p_ccm_data, bool * const p_mic_passed, int calls)
+{
+    TEST_ASSERT_TRUE(m_trial_decrypt_calls < TRIAL_APP_KEY_COUNT);
+    TEST_ASSERT_EQUAL(0, p_ccm_data->a_len);
+    TEST_ASSERT_EQUAL_PTR(m_trial_app_secmats[m_trial_decrypt_calls].key, p_ccm_data->p_key);
+    m_trial_decrypt_calls++;
+    *p_mic_passed = (p_ccm_data->p_key == mp_trial_app_secmat_match->key);
+}
+
+static void trial_message_received_callback(const nrf_mesh_evt_t * p_evt, int calls)
+{
+    TEST_ASSERT_EQUAL(NRF_MESH_EVT_MESSAGE_RECEIVED, p_evt->type);
+    TEST_ASSERT_EQUAL_PTR(mp_trial_app_secmat_match, p_evt->params.message.secmat.p_app);
+    if (p_evt->params.message.dst.type == NRF_MESH_ADDRESS_TYPE_VIRTUAL)
+    {
+        TEST_ASSERT_EQUAL_PTR(mp_trial_label_match, p_evt->params.message.dst.p_virtual_uuid);
+    }
+    m_trial_messages++;
+}
+
+static void trial_access_packet_rx(uint16_t dst, uint32_t seqnum)
+{
+    packet_mesh_trs_packet_t transport_packet;
+    memset(&transport_packet, 0, sizeof(transport_packet));
+    packet_mesh_trs_common_seg_set(&transport_packet, false);
+    packet_mesh_trs_access_akf_set(&transport_packet, true);
+    packet_mesh_trs_access_aid_set(&transport_packet, TRIAL_AID);
+
+    network_packet_metadata_t net_meta;
+    memset(&net_meta, 0, sizeof(net_meta));
+    net_meta.dst.type = nrf_mesh_address_type_get(dst);
+    net_meta.dst.value = dst;
+    net_meta.src = 0x0004;
+    net_meta.ttl = 9;
+    net_meta.control_packet = false;
+    net_meta.internal.sequence_number = seqnum;
+    net_meta.p_security_material = &m_net_secmat;
+
+    /* Four bytes of access payload and a small MIC: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS,
+                      transport_packet_in(&transport_packet,
+                                          PACKET_MESH_TRS_UNSEG_PDU_OFFSET + 4 + PACKET_MESH_TRS_TRANSMIC_SMALL_SIZE,
+                                          &net_meta,
+                                          &m_rx_meta));
+}
+
+static void trial_decrypt_setup(void)
+{
+    expect_init();
+    transport_init(NULL);
+
+    replay_cache_has_elem_IgnoreAndReturn(false);
+    replay_cache_add_IgnoreAndReturn(NRF_SUCCESS);
+    enc_nonce_generate_Ignore();
+    nrf_mesh_app_secmat_next_get_StubWithCallback(app_secmat_next_get_trial_callback);
+    event_handle_StubWithCallback(trial_message_received_callback);
+
+    for (uint32_t i = 0; i < TRIAL_APP_KEY_COUNT; ++i)
+    {
+        memset(m_trial_app_secmats[i].key, i, NRF_MESH_KEY_SIZE);
+        m_trial_app_secmats[i].aid = TRIAL_AID;
+    }
+    for (uint32_t i = 0; i < TRIAL_LABEL_COUNT; ++i)
+    {
+        memset(m_trial_labels[i], 0x10 + i, NRF_MESH_UUID_SIZE);
+    }
+    m_trial_messages = 0;
+}
+
+void test_virtual_dst_decrypt_batched(void)
+{
+    trial_decrypt_setup();
+    nrf_mesh_rx_address_get_StubWithCallback(rx_address_get_virtual_callback);
+    enc_aes_ccm_decrypt_ad_candidates_StubWithCallback(decrypt_ad_candidates_trial_callback);
+
+    /* The second key authenticates with a label in the first batch, the rest of the keys and
+     * labels are not tried: */
+    mp_trial_app_secmat_match = &m_trial_app_secmats[1];
+    mp_trial_label_match = m_trial_labels[2];
+    m_trial_decrypt_calls = 0;
+    trial_access_packet_rx(TRIAL_VIRTUAL_ADDR, 0x200);
+    TEST_ASSERT_EQUAL(2, m_trial_decrypt_calls);
+    TEST_ASSERT_EQUAL(4, m_trial_label_counts[0]);
+    TEST_ASSERT_EQUAL(4, m_trial_label_counts[1]);
+    TEST_ASSERT_EQUAL(1, m_trial_messages);
+
+    /* The match is only in the second batch of labels, after all keys have failed the first: */
+    mp_trial_app_secmat_match = &m_trial_app_secmats[2];
+    mp_trial_label_match = m_trial_labels[TRIAL_LABEL_COUNT - 1];
+    m_trial_decrypt_calls = 0;
+    trial_access_packet_rx(TRIAL_VIRTUAL_ADDR, 0x201);
+    const uint32_t expected_counts[] = {4, 4, 4, 2, 2, 2};
+    TEST_ASSERT_EQUAL(ARRAY_SIZE(expected_counts), m_trial_decrypt_calls);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expected_counts, m_trial_label_counts, ARRAY_SIZE(expected_counts));
+    TEST_ASSERT_EQUAL(2, m_trial_messages);
+
+    /* No key authenticates with any of the labels, all combinations are tried once: */
+    mp_trial_app_secmat_match = NULL;
+    mp_trial_label_match = NULL;
+    m_trial_decrypt_calls = 0;
+    trial_access_packet_rx(TRIAL_VIRTUAL_ADDR, 0x202);
+    TEST_ASSERT_EQUAL(ARRAY_SIZE(expected_counts), m_trial_decrypt_calls);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expected_counts, m_trial_label_counts, ARRAY_SIZE(expected_counts));
+    TEST_ASSERT_EQUAL(2, m_trial_messages);
+}
+
+void test_app_key_aid_candidates(void)
+{
+    trial_decrypt_setup();
+    nrf_mesh_rx_address_get_StubWithCallback(rx_address_get_group_callback);
+    enc_aes_ccm_decrypt_StubWithCallback(decrypt_trial_callback);
+
+    /* Only the keys with the packet's AID are tried, in order, until one authenticates: */
+    mp_trial_app_secmat_match = &m_trial_app_secmats[TRIAL_APP_KEY_COUNT - 1];
+    mp_trial_label_match = NULL;
+    m_trial_decrypt_calls = 0;
+    trial_access_packet_rx(0xC001, 0x300);
+    TEST_ASSERT_EQUAL(TRIAL_APP_KEY_COUNT, m_trial_decrypt_calls);
+    TEST_ASSERT_EQUAL(1, m_trial_messages);
+
+    mp_trial_app_secmat_match = &m_trial_app_secmats[0];
+    m_trial_decrypt_calls = 0;
+    trial_access_packet_rx(0xC001, 0x301);
+    TEST_ASSERT_EQUAL(1, m_trial_decrypt_calls);
+    TEST_ASSERT_EQUAL(2, m_trial_messages);
+}
+
+static uint32_t m_segacks_sent;
+static uint32_t m_segack_block_ack;
+
+static bool rx_address_get_unicast_callback(uint16_t address, nrf_mesh_address_t * p_address, int calls)
+{
+    p_address->type = NRF_MESH_ADDRESS_TYPE_UNICAST;
+    p_address->value = address;
+    p_address->p_virtual_uuid = NULL;
+    return true;
+}
+
+static uint32_t segack_alloc_callback(network_tx_packet_buffer_t * p_buf, int calls)
+{
+    static uint8_t network_packet_buffer[32];
+    TEST_ASSERT_EQUAL(PACKET_MESH_TRS_UNSEG_PDU_OFFSET + PACKET_MESH_TRS_CONTROL_SEGACK_SIZE,
+                      p_buf->user_data.payload_len);
+    TEST_ASSERT_EQUAL_HEX16(0x0004, p_buf->user_data.p_metadata->dst.value);
+    p_buf->role      = CORE_TX_ROLE_ORIGINATOR;
+    p_buf->p_payload = network_packet_buffer;
+    return NRF_SUCCESS;
+}
+
+static void segack_send_callback(const network_tx_packet_buffer_t * p_buffer, int calls)
+{
+    const packet_mesh_trs_control_packet_t * p_segack =
+        (const packet_mesh_trs_control_packet_t *) &p_buffer->p_payload[PACKET_MESH_TRS_UNSEG_PDU_OFFSET];
+    m_segack_block_ack = packet_mesh_trs_control_segack_block_ack_get(p_segack);
+    m_segacks_sent++;
+}
+
+/* Receive a segment of a segmented control message from 0x0004, sent to a unicast address. */
+static void unicast_segment_rx(uint32_t seqnum, uint16_t seq_zero, uint8_t segment_offset, uint8_t last_segment)
+{
+    packet_mesh_trs_packet_t transport_packet;
+    memset(&transport_packet, 0, sizeof(transport_packet));
+    packet_mesh_trs_common_seg_set(&transport_packet, true);
+    packet_mesh_trs_control_opcode_set(&transport_packet, TRANSPORT_CONTROL_OPCODE_HEARTBEAT);
+    packet_mesh_trs_seg_seqzero_set(&transport_packet, seq_zero);
+    packet_mesh_trs_seg_sego_set(&transport_packet, segment_offset);
+    packet_mesh_trs_seg_segn_set(&transport_packet, last_segment);
+
+    network_packet_metadata_t net_meta;
+    memset(&net_meta, 0, sizeof(net_meta));
+    net_meta.dst.type = NRF_MESH_ADDRESS_TYPE_UNICAST;
+    net_meta.dst.value = 0x0100;
+    net_meta.src = 0x0004;
+    net_meta.ttl = 9;
+    net_meta.control_packet = true;
+    net_meta.internal.sequence_number = seqnum;
+    net_meta.p_security_material = &m_net_secmat;
+
+    uint32_t segment_len = (segment_offset == last_segment) ? 4 : PACKET_MESH_TRS_SEG_CONTROL_PDU_MAX_SIZE;
+    TEST_ASSERT_EQUAL(NRF_SUCCESS,
+                      transport_packet_in(&transport_packet,
+                                          PACKET_MESH_TRS_SEG_PDU_OFFSET + segment_len,
+                                          &net_meta,
+                                          &m_rx_meta));
+}
+
+/* Fire the ack timer, which is the last timer scheduled when a segment arrives at an idle session. */
+static void sar_ack_timer_fire(void)
+{
+    TEST_ASSERT_NOT_NULL(mp_retry_timer);
+    timer_event_t * p_ack_timer = mp_retry_timer;
+    mp_retry_timer = NULL;
+    p_ack_timer->cb(m_time_now, p_ack_timer->p_context);
+}
+
+void test_sar_segack_coalescing(void)
+{
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_rx_buffer_alloc, sar_buffer_release));
+
+    replay_cache_has_elem_IgnoreAndReturn(false);
+    replay_cache_add_IgnoreAndReturn(NRF_SUCCESS);
+    nrf_mesh_rx_address_get_StubWithCallback(rx_address_get_unicast_callback);
+    net_state_iv_index_lock_Ignore();
+    network_packet_alloc_StubWithCallback(segack_alloc_callback);
+    network_packet_send_StubWithCallback(segack_send_callback);
+    timer_now_StubWithCallback(timer_now_callback);
+    timer_sch_reschedule_StubWithCallback(timer_sch_reschedule_callback);
+    timer_sch_abort_Ignore();
+
+    TEST_ASSERT_EQUAL(TRANSPORT_SAR_SEGACK_COALESCE_WINDOW_DEFAULT_US,
+                      sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SEGACK_COALESCE_WINDOW));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM,
+                      sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SEGACK_COALESCE_WINDOW,
+                                          TRANSPORT_SAR_SEGACK_COALESCE_WINDOW_MAX + 1));
+    TEST_ASSERT_EQUAL(NRF_ERROR_INVALID_PARAM, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SEGACK_SUPPRESSED, 1));
+    const timestamp_t window = TRANSPORT_SAR_SEGACK_COALESCE_WINDOW_DEFAULT_US;
+
+    m_segacks_sent = 0;
+    m_time_now = 1000;
+    mp_retry_timer = NULL;
+
+    /* The first ack timeout acks the first segment: */
+    unicast_segment_rx(0x100, 0x100, 0, 1);
+    sar_ack_timer_fire();
+    TEST_ASSERT_EQUAL(1, m_segacks_sent);
+    TEST_ASSERT_EQUAL_HEX32(0x1, m_segack_block_ack);
+
+    /* A retransmission of the segment restarts the ack timer, but the unchanged ack is suppressed
+     * while the sender can't have reacted to the previous one: */
+    m_time_now += window / 2;
+    unicast_segment_rx(0x102, 0x100, 0, 1);
+    sar_ack_timer_fire();
+    TEST_ASSERT_EQUAL(1, m_segacks_sent);
+    TEST_ASSERT_EQUAL(1, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SEGACK_SUPPRESSED));
+
+    /* After the window, the sender is retransmitting because it lost the ack: */
+    m_time_now += window;
+    unicast_segment_rx(0x103, 0x100, 0, 1);
+    sar_ack_timer_fire();
+    TEST_ASSERT_EQUAL(2, m_segacks_sent);
+
+    /* An ack with new segments is always sent: */
+    m_time_now += 1000;
+    unicast_segment_rx(0x104, 0x100, 1, 1);
+    TEST_ASSERT_EQUAL(3, m_segacks_sent);
+    TEST_ASSERT_EQUAL_HEX32(0x3, m_segack_block_ack);
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+
+    /* Retransmitted segments of the completed session are acked once per window: */
+    m_time_now += 1000;
+    unicast_segment_rx(0x105, 0x100, 0, 1);
+    unicast_segment_rx(0x106, 0x100, 1, 1);
+    TEST_ASSERT_EQUAL(3, m_segacks_sent);
+    TEST_ASSERT_EQUAL(3, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SEGACK_SUPPRESSED));
+    m_time_now += window;
+    unicast_segment_rx(0x107, 0x100, 0, 1);
+    TEST_ASSERT_EQUAL(4, m_segacks_sent);
+
+    /* Once the sender has completed a later session, it has moved on, and late segments of the
+     * earlier session aren't acked: */
+    m_time_now += window;
+    unicast_segment_rx(0x200, 0x200, 0, 1);
+    sar_ack_timer_fire();
+    unicast_segment_rx(0x201, 0x200, 1, 1);
+    TEST_ASSERT_EQUAL(6, m_segacks_sent);
+    m_time_now += window;
+    unicast_segment_rx(0x108, 0x100, 1, 1);
+    TEST_ASSERT_EQUAL(6, m_segacks_sent);
+    TEST_ASSERT_EQUAL(4, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SEGACK_SUPPRESSED));
+
+    /* With the window set to 0, every ack is sent: */
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SEGACK_COALESCE_WINDOW, 0));
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, sar_session_opt_set(NRF_MESH_OPT_TRS_SAR_SEGACK_SUPPRESSED, 0));
+    unicast_segment_rx(0x202, 0x200, 0, 1);
+    unicast_segment_rx(0x203, 0x200, 0, 1);
+    TEST_ASSERT_EQUAL(8, m_segacks_sent);
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SEGACK_SUPPRESSED));
+}
+
+void test_sar_rx_max_segments(void)
+{
+    expect_init();
+    transport_init(NULL);
+    TEST_ASSERT_EQUAL(NRF_SUCCESS, transport_sar_mem_funcs_set(sar_rx_buffer_alloc, sar_buffer_release));
+
+    replay_cache_has_elem_IgnoreAndReturn(false);
+    replay_cache_add_IgnoreAndReturn(NRF_SUCCESS);
+    nrf_mesh_rx_address_get_StubWithCallback(rx_address_get_unicast_callback);
+    net_state_iv_index_lock_Ignore();
+    network_packet_alloc_StubWithCallback(segack_alloc_callback);
+    network_packet_send_StubWithCallback(segack_send_callback);
+    timer_now_StubWithCallback(timer_now_callback);
+    timer_sch_reschedule_StubWithCallback(timer_sch_reschedule_callback);
+    timer_sch_abort_Ignore();
+
+    m_segacks_sent = 0;
+    m_time_now = 1000;
+    mp_retry_timer = NULL;
+
+    /* Receive the first 31 segments. The ack timer started by the first segment fires halfway
+     * through, as later segments only restart the abort timer: */
+    const uint8_t last_segment = 31;
+    timer_event_t * p_ack_timer = NULL;
+    for (uint8_t i = 0; i < last_segment; ++i)
+    {
+        m_time_now += 1000;
+        unicast_segment_rx(0x300 + i, 0x300, i, last_segment);
+        if (i == 0)
+        {
+            p_ack_timer = mp_retry_timer;
+        }
+        else if (i == 16)
+        {
+            mp_retry_timer = p_ack_timer;
+            sar_ack_timer_fire();
+        }
+    }
+    TEST_ASSERT_EQUAL(1, m_segacks_sent);
+    TEST_ASSERT_EQUAL_HEX32(0x0001FFFF, m_segack_block_ack);
+    TEST_ASSERT_EQUAL(1, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+
+    /* The last segment completes the session, and all 32 bits are set in the block ack: */
+    unicast_segment_rx(0x300 + last_segment, 0x300, last_segment, last_segment);
+    TEST_ASSERT_EQUAL(2, m_segacks_sent);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, m_segack_block_ack);
+    TEST_ASSERT_EQUAL(0, sar_session_opt_get(NRF_MESH_OPT_TRS_SAR_SESSIONS_ACTIVE));
+
+    /* A retransmitted segment of the completed session is acked with the full block ack: */
+    m_time_now += TRANSPORT_SAR_SEGACK_COALESCE_WINDOW_DEFAULT_US;
+    unicast_segment_rx(0x320, 0x300, 0, last_segment);
+    TEST_ASSERT_EQUAL(3, m_segacks_sent);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, m_segack_block_ack);
+}